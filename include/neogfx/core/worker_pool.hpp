@@ -0,0 +1,67 @@
+// worker_pool.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace neogfx
+{
+    // A fixed set of worker threads, started once and reused, for splitting work done every frame (vertex baking,
+    // text shaping) without paying thread start-up costs on each call. One call to run() is serviced at a time; a
+    // call made while the pool is busy, or from one of its own workers, runs its tasks on the calling thread.
+    class worker_pool
+    {
+    public:
+        typedef std::function<void(std::size_t)> task;
+    public:
+        worker_pool(uint32_t aThreads = std::max(1u, std::thread::hardware_concurrency()) - 1u);
+        ~worker_pool();
+    public:
+        uint32_t thread_count() const;
+        // Calls aTask with every index in [0, aCount) on the workers and the calling thread and returns once all calls
+        // have returned; the first exception thrown by a call is rethrown.
+        void run(std::size_t aCount, task const& aTask);
+    private:
+        void worker();
+        void work();
+    private:
+        std::mutex iRunMutex;
+        std::mutex iMutex;
+        std::condition_variable iWorkAvailable;
+        std::condition_variable iWorkFinished;
+        uint64_t iGeneration;
+        std::size_t iPending;
+        task const* iTask;
+        std::size_t iCount;
+        std::atomic<std::size_t> iNext;
+        std::exception_ptr iError;
+        bool iStopping;
+        std::vector<std::thread> iThreads;
+    };
+}
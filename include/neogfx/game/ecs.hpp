@@ -21,6 +21,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <neogfx/gfx/i_vertex_provider.hpp>
+#include <neogfx/game/entity_draw_lists.hpp>
 #include <neolib/ecs/ecs.hpp>
 
 namespace neogfx
@@ -39,10 +40,21 @@ namespace neogfx
             bool run_threaded(const system_id& aSystemId) const override;
         public:
             void destroy_entity(entity_id aEntityId, bool aNotify = true) override;
+        public:
+            // Incremental defragmentation: invalidates the render cache of up to aMaxRelocations entities occupying the
+            // top of the vertex buffer when a reclaimed hole can hold them, so that their next render moves them lower.
+            std::size_t compact_vertex_buffer(std::size_t aMaxRelocations = 1u);
+        public:
+            const entity_draw_lists& draw_lists() const;
+            entity_draw_lists& draw_lists();
         public:
             bool cacheable() const override;
             const game::component<game::mesh_render_cache>& cache() const override;
             game::component<game::mesh_render_cache>& cache() override;
+        private:
+            void reclaim(mesh_render_cache const& aCacheEntry);
+        private:
+            entity_draw_lists iDrawLists;
         };
 
         template <typename... Systems>
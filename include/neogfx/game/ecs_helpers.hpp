@@ -120,6 +120,9 @@ namespace neogfx
             return {};
         case blurring_algorithm::Gaussian:
             return game::filter{ shader_filter::GaussianBlur, aParameter1, aParameter2 };
+        case blurring_algorithm::SeparableGaussian:
+        case blurring_algorithm::DualKawase:
+            throw std::logic_error("neogfx::to_ecs_component: blurring algorithm requires multiple passes (use i_graphics_context::blur)");
         default:
             return {};
         }
@@ -134,7 +137,7 @@ namespace neogfx
             aTexture.sampling(),
             aTexture.dpi_scale_factor(),
             aTexture.extents().to_vec2(),
-            aTexture.type() == texture_type::Texture ? optional_aabb_2d{} : aTexture.as_sub_texture().atlas_location().to_aabb_2d()
+            optional_aabb_2d{} // atlas locations are looked up at draw time as a repack can move a sub-texture
         };
     }
 
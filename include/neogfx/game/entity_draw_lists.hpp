@@ -0,0 +1,71 @@
+// entity_draw_lists.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <unordered_map>
+#include <neogfx/game/i_ecs.hpp>
+
+namespace neogfx::game
+{
+    // Per-layer lists of renderable entities maintained across frames so that rendering a frame only has to
+    // look at entities that were added, removed or changed. The cached component flags of each entry are
+    // re-validated by every update() as components may be attached to or detached from an entity at any time.
+    // All member functions require the caller to hold the mesh_render_cache component lock.
+    class entity_draw_lists
+    {
+    public:
+        struct entry
+        {
+            entity_id entity;
+            bool hasMeshFilter; // if not the mesh comes from the current animation frame
+            bool hasAnimationFilter;
+            bool hasRigidBody;
+            optional_aabb_2d bounds; // world space bounds as of the last time the entity's render cache was rebuilt
+            std::size_t slot; // position of the entity's record in the mesh_renderer component
+        };
+        typedef std::vector<entry> draw_list;
+    public:
+        entity_draw_lists(i_ecs& aEcs);
+    public:
+        void update();
+        void invalidate();
+        void remove(entity_id aEntity);
+        // moves an entity whose mesh_renderer layer has changed to the list for its new layer
+        void set_layer(entity_id aEntity, int32_t aLayer);
+    public:
+        int32_t max_layer() const;
+        draw_list& layer(int32_t aLayer);
+    private:
+        void rebuild();
+        bool refresh();
+        void add(entity_id aEntity, std::size_t aSlot);
+        void add(entity_id aEntity, int32_t aLayer, entry const& aEntry);
+        void compact(int32_t aLayer);
+    private:
+        i_ecs& iEcs;
+        std::vector<draw_list> iLayers;
+        std::vector<std::size_t> iTombstones;
+        std::unordered_map<entity_id, std::pair<int32_t, std::size_t>> iIndex;
+        std::vector<std::pair<std::size_t, entity_id>> iFreedSlots; // (slot, entity removed from it)
+        std::size_t iSyncedRenderers;
+        bool iResync;
+    };
+}
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <atomic>
 #include <neolib/core/uuid.hpp>
 #include <neolib/core/string.hpp>
 #include <neogfx/core/numerical.hpp>
@@ -28,11 +29,18 @@
 
 namespace neogfx::game
 {
+    inline uint64_t next_mesh_generation()
+    {
+        static std::atomic<uint64_t> sGeneration;
+        return ++sGeneration;
+    }
+
     struct mesh
     {
         vertices vertices; // todo: neolib::vector not std::vector (modify neolib::vector copy ctor to make plugin compatible; use ref_ptr<i_vector> here?)
         vertices_2d uv; // todo: neolib::vector not std::vector (modify neolib::vector copy ctor to make plugin compatible; use ref_ptr<i_vector> here?)
         faces faces; // todo: neolib::vector not std::vector (modify neolib::vector copy ctor to make plugin compatible; use ref_ptr<i_vector> here?)
+        uint64_t generation = next_mesh_generation(); // identifies the content; copies share it, see touch()
 
         struct meta : i_component_data::meta
         {
@@ -77,6 +85,13 @@ namespace neogfx::game
         };
     };
 
+    // Code modifying a mesh in place must call this so that caches keyed on the mesh generation (such as the
+    // uploaded copies of shared meshes drawn instanced) pick up the change.
+    inline void touch(mesh& aMesh)
+    {
+        aMesh.generation = next_mesh_generation();
+    }
+
     inline mesh operator*(const mat44& aLhs, const mesh& aRhs)
     {
         return mesh{ aLhs * aRhs.vertices, aRhs.uv, aRhs.faces };
@@ -87,7 +102,7 @@ namespace neogfx::game
         if (aVertices.empty())
             return rect{};
         point topLeft{ aTransformation * aVertices[0] };
-        point bottomRight;
+        point bottomRight = topLeft;
         for (auto const& v : aVertices)
         {
             auto const tv = aTransformation * v;
@@ -105,7 +120,7 @@ namespace neogfx::game
         if (aVertices.empty())
             return rect{};
         point topLeft{ aTransformation * aVertices[0].xyz };
-        point bottomRight;
+        point bottomRight = topLeft;
         for (auto const& v : aVertices)
         {
             auto const tv = aTransformation * v.xyz;
@@ -39,6 +39,8 @@ namespace neogfx::game
         mutable cache_state state;
         mutable vec2u32 meshVertexArrayIndices;
         mutable std::vector<vec2u32> patchVertexArrayIndices;
+        mutable vec2u32 meshIndexArrayIndices;
+        mutable std::vector<vec2u32> patchIndexArrayIndices;
 
         struct meta : i_component_data::meta
         {
@@ -54,7 +56,7 @@ namespace neogfx::game
             }
             static uint32_t field_count()
             {
-                return 3;
+                return 5;
             }
             static component_data_field_type field_type(uint32_t aFieldIndex)
             {
@@ -66,6 +68,10 @@ namespace neogfx::game
                     return component_data_field_type::Vec2u32 | component_data_field_type::Internal;
                 case 2:
                     return component_data_field_type::Vec2u32 | component_data_field_type::Array | component_data_field_type::Internal;
+                case 3:
+                    return component_data_field_type::Vec2u32 | component_data_field_type::Internal;
+                case 4:
+                    return component_data_field_type::Vec2u32 | component_data_field_type::Array | component_data_field_type::Internal;
                 default:
                     throw invalid_field_index();
                 }
@@ -76,7 +82,9 @@ namespace neogfx::game
                 {
                     "State",
                     "Mesh Vertex Array Indices",
-                    "Patch Vertex Array Indices"
+                    "Patch Vertex Array Indices",
+                    "Mesh Index Array Indices",
+                    "Patch Index Array Indices"
                 };
                 return sFieldNames[aFieldIndex];
             }
@@ -152,13 +152,14 @@ namespace neogfx::game
                             {
                                 auto const& glyphFont = glyphText.glyphText.glyph_font(glyph);
                                 auto const& glyphTexture = glyphText.glyphText.glyph_texture(glyph);
+                                glyphFont.glyph_texture_drawn(glyph);
                                 vec3 glyphOrigin(
                                     pos.x + glyphTexture.placement().x,
                                     aGc.logical_coordinates().is_game_orientation() ?
                                         pos.y + (glyphTexture.placement().y + -glyphFont.descender()) :
-                                        pos.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.texture().extents().cy,
+                                        pos.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.extents().cy,
                                     0.0);
-                                add_patch(*mf.mesh, mr, rect{ glyphOrigin, glyphTexture.texture().extents() }, 0.0, glyphTexture.texture());
+                                add_patch(*mf.mesh, mr, rect{ glyphOrigin, glyphTexture.extents() }, 0.0, glyphTexture.texture());
                                 mr.patches.back().material = material{ aMaterial.color, aMaterial.gradient, aMaterial.sharedTexture, mr.patches.back().material.texture, aMaterial.shaderEffect };
                             }
                             pos.x += advance(glyph).cx;
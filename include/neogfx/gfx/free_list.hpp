@@ -0,0 +1,141 @@
+// free_list.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <array>
+#include <map>
+#include <set>
+#include <optional>
+#include <algorithm>
+
+namespace neogfx
+{
+    // Coalescing free list of element ranges within a buffer. Free blocks are indexed by start (for coalescing
+    // with neighbours) and by power-of-two size class (for best fit in logarithmic time).
+    class free_list
+    {
+    public:
+        typedef std::size_t size_type;
+    private:
+        static constexpr std::size_t Buckets = 32u;
+        typedef std::pair<size_type, size_type> free_block; // (length, start)
+    public:
+        // Takes aCount elements from the start of the smallest free block that can hold them.
+        std::optional<size_type> allocate(size_type aCount)
+        {
+            if (aCount == 0)
+                return {};
+            for (auto bucket = bucket_of(aCount); bucket < Buckets; ++bucket)
+            {
+                auto& freeList = iBuckets[bucket];
+                auto existing = freeList.lower_bound(free_block{ aCount, 0 });
+                if (existing != freeList.end())
+                {
+                    auto const [length, start] = *existing;
+                    remove(start, start + length);
+                    if (length > aCount)
+                        add(start + aCount, start + length);
+                    return start;
+                }
+            }
+            return {};
+        }
+        // Frees [aStart, aEnd), merging it with adjacent free blocks. A merged block reaching aTop (the end of the
+        // allocated space) is not kept; the new top is returned so that the caller can give that space back.
+        size_type release(size_type aStart, size_type aEnd, size_type aTop)
+        {
+            if (aEnd == aStart)
+                return aTop;
+            auto start = aStart;
+            auto end = aEnd;
+            auto next = iBlocks.lower_bound(start);
+            if (next != iBlocks.end() && next->first == end)
+            {
+                end = next->second;
+                remove(next->first, next->second);
+                ++iCoalesces;
+            }
+            auto previous = iBlocks.lower_bound(start);
+            if (previous != iBlocks.begin() && (--previous)->second == start)
+            {
+                start = previous->first;
+                remove(previous->first, previous->second);
+                ++iCoalesces;
+            }
+            if (end == aTop)
+                return start;
+            add(start, end);
+            return aTop;
+        }
+        void clear()
+        {
+            iBlocks.clear();
+            for (auto& bucket : iBuckets)
+                bucket.clear();
+            iFreeElements = 0;
+        }
+    public:
+        size_type free_elements() const
+        {
+            return iFreeElements;
+        }
+        size_type free_blocks() const
+        {
+            return iBlocks.size();
+        }
+        size_type largest_block() const
+        {
+            for (auto bucket = Buckets; bucket-- > 0;)
+                if (!iBuckets[bucket].empty())
+                    return iBuckets[bucket].rbegin()->first;
+            return 0;
+        }
+        uint32_t coalesces() const
+        {
+            return iCoalesces;
+        }
+    private:
+        static std::size_t bucket_of(size_type aLength)
+        {
+            std::size_t bucket = 0;
+            while (aLength >>= 1)
+                ++bucket;
+            return std::min(bucket, Buckets - 1);
+        }
+        void add(size_type aStart, size_type aEnd)
+        {
+            iBlocks.emplace(aStart, aEnd);
+            iBuckets[bucket_of(aEnd - aStart)].emplace(aEnd - aStart, aStart);
+            iFreeElements += (aEnd - aStart);
+        }
+        void remove(size_type aStart, size_type aEnd)
+        {
+            iBlocks.erase(aStart);
+            iBuckets[bucket_of(aEnd - aStart)].erase(free_block{ aEnd - aStart, aStart });
+            iFreeElements -= (aEnd - aStart);
+        }
+    private:
+        std::map<size_type, size_type> iBlocks; // start -> end
+        std::array<std::set<free_block>, Buckets> iBuckets;
+        size_type iFreeElements = 0;
+        uint32_t iCoalesces = 0;
+    };
+}
@@ -21,6 +21,8 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_set>
+#include <unordered_map>
+#include <list>
 #include <neogfx/gfx/shader_array.hpp>
 #include <neogfx/gfx/gradient.hpp>
 #include <neogfx/gfx/i_gradient_manager.hpp>
@@ -102,9 +104,21 @@ namespace neogfx
         typedef ref_ptr<i_gradient> gradient_pointer;
         typedef neolib::pair<gradient_pointer, uint32_t> gradient_list_entry;
         typedef neolib::jar<gradient_list_entry> gradient_list;
-        typedef std::pair<gradient::color_stop_list, gradient::alpha_stop_list> sampler_key_t;
-        typedef std::map<sampler_key_t, gradient_sampler> sampler_map_t;
-        typedef std::map<scalar, gradient_filter> filter_map_t;
+        // samplers are keyed on the stops fingerprint; the stops are kept so debug builds can detect the (unlikely) collision
+        struct sampler_entry
+        {
+            gradient::color_stop_list colorStops;
+            gradient::alpha_stop_list alphaStops;
+            gradient_sampler sampler;
+            std::list<uint64_t>::iterator queuePosition;
+        };
+        typedef std::unordered_map<uint64_t, sampler_entry> sampler_map_t;
+        struct filter_entry
+        {
+            gradient_filter filter;
+            std::list<scalar>::iterator queuePosition;
+        };
+        typedef std::unordered_map<scalar, filter_entry> filter_map_t;
         // constants
     public:
         static constexpr uint32_t MaxSamplers = 1024;
@@ -145,15 +159,16 @@ namespace neogfx
         shader_array<avec4u8>& samplers();
         std::vector<gradient_sampler>& free_samplers();
         std::vector<gradient_filter>& free_filters();
+        void update_sampler(sampler_entry& aEntry, i_gradient const& aGradient);
         void cleanup();
     private:
         gradient_list iGradients;
         std::optional<shader_array<avec4u8>> iSamplers;
         sampler_map_t iAllocatedSamplers;
         std::optional<std::vector<gradient_sampler>> iFreeSamplers;
-        std::deque<sampler_map_t::const_iterator> iSamplerQueue;
+        std::list<uint64_t> iSamplerQueue; // least recently used first
         filter_map_t iAllocatedFilters;
         std::optional<std::vector<gradient_filter>> iFreeFilters;
-        std::deque<filter_map_t::const_iterator> iFilterQueue;
+        std::list<scalar> iFilterQueue; // least recently used first
     };
 }
\ No newline at end of file
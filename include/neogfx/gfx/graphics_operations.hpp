@@ -21,6 +21,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <vector>
+#include <optional>
 #include <neolib/core/variant.hpp>
 #include <neogfx/core/geometrical.hpp>
 #include <neogfx/gfx/primitives.hpp>
@@ -379,10 +380,16 @@ namespace neogfx
 
         std::string to_string(operation_type aOpType);
 
+        typedef std::vector<operation> queue;
+        typedef std::pair<operation const*, operation const*> batch;
+
         bool batchable(const operation& aLeft, const operation& aRight);
         bool batchable(i_glyph_text const& lhsText, i_glyph_text const& rhsText, glyph const& lhs, glyph const& rhs);
 
-        typedef std::vector<operation> queue;
-        typedef std::pair<operation const*, operation const*> batch;
+        // The area a drawing operation can touch; std::nullopt for state changes and operations of unknown extent.
+        std::optional<rect> bounding_rect(const operation& aOperation);
+        // Moves drawing operations that do not overlap any operation they are moved past next to earlier
+        // batchable operations; state changes are never crossed. Returns the number of operations moved.
+        std::size_t reorder_for_batching(queue& aQueue, std::size_t aSearchWindow = 64u);
     }
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+// graphics_operations_archive.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <optional>
+#include <vector>
+#include <neogfx/gfx/graphics_operations.hpp>
+#include <neogfx/gfx/i_rendering_context.hpp>
+
+namespace neogfx
+{
+    namespace graphics_operation
+    {
+        // Binary archive of graphics operation queues ("frames") for offline replay of flush().
+        //
+        // An archive is a header followed by records. Fonts, textures and gradients referenced by id (glyph fonts,
+        // texture brushes, material textures and material gradients) are written once, as a resource record
+        // preceding the first frame that uses them; frames refer to them by their original id and the reader
+        // remaps these ids to resources it recreates. Values are written in host byte order.
+        //
+        // draw_entities operations refer to a live ECS and are not recorded; shared material textures are
+        // recorded as (unshared) material textures.
+
+        constexpr uint32_t ArchiveMagic = 0x51584647u; // "GFXQ"
+        constexpr uint32_t ArchiveVersion = 3u; // 2: paths record their fill rule; 3: pens record their join and cap
+
+        struct frame
+        {
+            size extents;
+            logical_coordinate_system logicalCoordinateSystem = logical_coordinate_system::AutomaticGui;
+            queue operations;
+        };
+
+        class queue_writer
+        {
+        public:
+            struct bad_stream : std::runtime_error { bad_stream() : std::runtime_error("neogfx::graphics_operation::queue_writer::bad_stream") {} };
+            struct capture_active : std::logic_error { capture_active() : std::logic_error("neogfx::graphics_operation::queue_writer::capture_active") {} };
+        public:
+            queue_writer(std::ostream& aOutput);
+            ~queue_writer();
+        public:
+            void write(i_rendering_context const& aContext);
+            void write(frame const& aFrame);
+        public:
+            uint32_t frames_written() const;
+            uint32_t operations_skipped() const;
+        public:
+            // While capturing, rendering contexts write each queue they flush to this writer.
+            void begin_capture(std::optional<uint32_t> const& aFrameLimit = {});
+            void end_capture();
+            static queue_writer* capture();
+        private:
+            void write_font(font_id aFont);
+            void write_texture(i_texture const& aTexture);
+            void write_gradient(gradient_id aGradient);
+        private:
+            std::ostream& iOutput;
+            std::set<font_id> iFonts;
+            std::set<texture_id> iTextures;
+            std::set<gradient_id> iGradients;
+            uint32_t iFramesWritten;
+            uint32_t iOperationsSkipped;
+            std::optional<uint32_t> iFrameLimit;
+        };
+
+        class queue_reader
+        {
+        public:
+            struct bad_archive : std::runtime_error { bad_archive() : std::runtime_error("neogfx::graphics_operation::queue_reader::bad_archive") {} };
+            struct unsupported_version : std::runtime_error { unsupported_version() : std::runtime_error("neogfx::graphics_operation::queue_reader::unsupported_version") {} };
+            struct resource_not_found : std::runtime_error { resource_not_found() : std::runtime_error("neogfx::graphics_operation::queue_reader::resource_not_found") {} };
+        public:
+            queue_reader(std::istream& aInput);
+            ~queue_reader();
+        public:
+            // Reads the next frame, recreating any resources recorded before it; returns false at end of archive.
+            bool read(frame& aFrame);
+            std::vector<frame> read_all();
+        public:
+            uint32_t version() const;
+            font const& mapped_font(font_id aFont) const;
+            i_texture const& mapped_texture(texture_id aTexture) const;
+            gradient const& mapped_gradient(gradient_id aGradient) const;
+        private:
+            void read_font();
+            void read_texture();
+            void read_gradient();
+        private:
+            std::istream& iInput;
+            uint32_t iVersion;
+            std::map<font_id, font> iFonts;
+            std::map<texture_id, texture> iTextures;
+            std::map<gradient_id, gradient> iGradients;
+        };
+    }
+}
@@ -479,4 +479,25 @@ namespace neogfx
             kernel[mean][mean] = static_cast<ValueType>(1.0);
         return kernel;
     }
+
+    template <typename ValueType = double>
+    inline std::vector<ValueType> separable_gaussian_filter(uint32_t aKernelSize = 5, ValueType aSigma = 1.0)
+    {
+        const int32_t mean = static_cast<int32_t>(aKernelSize / 2);
+        std::vector<ValueType> kernel(aKernelSize);
+        if (aSigma != 0)
+        {
+            ValueType sum = 0.0;
+            for (int32_t x = -mean; x <= mean; ++x)
+            {
+                kernel[x + mean] = static_cast<ValueType>(std::exp(-((x * x) / (2.0 * aSigma * aSigma))));
+                sum += kernel[x + mean];
+            }
+            for (uint32_t x = 0; x < aKernelSize; ++x)
+                kernel[x] /= sum;
+        }
+        else
+            kernel[mean] = static_cast<ValueType>(1.0);
+        return kernel;
+    }
 }
\ No newline at end of file
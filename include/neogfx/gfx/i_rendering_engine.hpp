@@ -20,6 +20,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <chrono>
 #include <neogfx/core/numerical.hpp>
 #include <neogfx/core/geometrical.hpp>
 #include <neogfx/gui/window/window_bits.hpp>
@@ -50,6 +51,21 @@ namespace neogfx
         None
     };
 
+    // Counters accumulated by rendering contexts as they flush their graphics operation queues.
+    struct rendering_statistics
+    {
+        uint64_t flushes = 0;
+        uint64_t operations = 0;
+        uint64_t batches = 0;
+        uint64_t reorderedOperations = 0;
+        uint64_t drawCalls = 0;
+        uint64_t vertices = 0;
+        uint64_t fenceStalls = 0;
+        std::chrono::nanoseconds fenceStallTime = {};
+        uint64_t textureUploads = 0;
+        uint64_t textureUploadBatches = 0;
+    };
+
     class i_rendering_engine : public i_service
     {
         // events
@@ -165,6 +181,9 @@ namespace neogfx
         virtual bool is_subpixel_rendering_on() const = 0;
         virtual void subpixel_rendering_on() = 0;
         virtual void subpixel_rendering_off() = 0;
+        virtual bool is_operation_reordering_on() const = 0;
+        virtual void operation_reordering_on() = 0;
+        virtual void operation_reordering_off() = 0;
     public:
         virtual void render_now() = 0;
         virtual bool frame_rate_limited() const = 0;
@@ -178,6 +197,10 @@ namespace neogfx
         virtual void register_frame_counter(i_widget& aWidget, uint32_t aDuration) = 0;
         virtual void unregister_frame_counter(i_widget& aWidget, uint32_t aDuration) = 0;
         virtual uint32_t frame_counter(uint32_t aDuration) const = 0;
+    public:
+        virtual rendering_statistics const& statistics() const = 0;
+        virtual rendering_statistics& statistics() = 0;
+        virtual void reset_statistics() = 0;
     public:
         static uuid const& iid() { static uuid const sIid{ 0x692d5ef5, 0xe7b0, 0x497c, 0xaea6, { 0x3f, 0x39, 0xc9, 0xec, 0xef, 0xb4 } }; return sIid; }
     };
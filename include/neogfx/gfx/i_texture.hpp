@@ -56,7 +56,8 @@ namespace neogfx
         // todo: add remaining GL texture data formats
         RGBA        = 0x01,
         Red         = 0x02,
-        SubPixel    = 0x03
+        SubPixel    = 0x03,
+        DistanceField = 0x04    // single channel signed distance field; 0.5 on the edge, greater inside
     };
 
     enum class texture_data_type : uint32_t
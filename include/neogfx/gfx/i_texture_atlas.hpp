@@ -25,11 +25,26 @@
 
 namespace neogfx
 {
+    struct atlas_page_statistics
+    {
+        size extents;
+        dimension usedArea;
+        std::size_t subTextures;
+        std::size_t freeRects;
+
+        double occupancy() const
+        {
+            auto const area = extents.cx * extents.cy;
+            return area != 0.0 ? usedArea / area : 0.0;
+        }
+    };
+
     class i_texture_atlas
     {
     public:
         struct sub_texture_not_found : std::logic_error { sub_texture_not_found() : std::logic_error("neogfx::i_texture_atlas::sub_texture_not_found") {} };
         struct texture_too_big_for_atlas : std::logic_error { texture_too_big_for_atlas() : std::logic_error("neogfx::i_texture_atlas::texture_too_big_for_atlas") {} };
+        struct page_not_found : std::logic_error { page_not_found() : std::logic_error("neogfx::i_texture_atlas::page_not_found") {} };
     public:
         virtual ~i_texture_atlas() = default;
     public:
@@ -39,5 +54,11 @@ namespace neogfx
         virtual i_sub_texture& create_sub_texture(const i_image& aImage) = 0;
         virtual i_sub_texture& create_sub_texture(const i_image& aImage, const rect& aImagePart) = 0;
         virtual void destroy_sub_texture(i_sub_texture& aSubTexture) = 0;
+    public:
+        virtual std::size_t page_count() const = 0;
+        virtual atlas_page_statistics page_statistics(std::size_t aPageIndex) const = 0;
+        // Lays out the page's sub-textures afresh on a worker thread; once the layout is ready the next call to the atlas 
+        // copies the pixels to a new page texture and updates the sub-textures' atlas locations.
+        virtual void repack_page(std::size_t aPageIndex) = 0;
     };
 }
\ No newline at end of file
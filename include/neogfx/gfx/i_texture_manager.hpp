@@ -64,6 +64,8 @@ namespace neogfx
         }
         virtual void create_texture(i_image const& aImage, const rect& aImagePart, texture_data_format aDataFormat, texture_data_type aDataType, i_ref_ptr<i_texture>& aResult) = 0;
         virtual void clear_textures() = 0;
+        // submits writes queued by i_native_texture::queue_pixels in a single staging buffer transfer
+        virtual void flush_uploads() = 0;
     public:
         virtual std::unique_ptr<i_texture_atlas> create_texture_atlas(const size& aSize = size{ 1024.0, 1024.0 }) = 0;
     private:
@@ -84,6 +84,23 @@ namespace neogfx
         return static_cast<vertex_buffer_type>(static_cast<uint32_t>(aLhs) & static_cast<uint32_t>(aRhs));
     }
 
+    struct buffer_allocation_statistics
+    {
+        std::size_t size = 0u;
+        std::size_t capacity = 0u;
+        std::size_t freeElements = 0u;
+        std::size_t freeBlocks = 0u;
+        std::size_t largestFreeBlock = 0u;
+        uint32_t grows = 0u;
+        uint32_t coalesces = 0u;
+
+        // 0.0 when all free space is one block; approaches 1.0 as free space splinters into small holes
+        double fragmentation() const
+        {
+            return freeElements != 0u ? 1.0 - static_cast<double>(largestFreeBlock) / freeElements : 0.0;
+        }
+    };
+
     // todo
     class i_vertex_buffer
     {
@@ -100,5 +117,8 @@ namespace neogfx
         virtual void detach_shader() = 0;
     public:
         virtual void reclaim(std::size_t aStartIndex, std::size_t aEndIndex) = 0;
+        virtual void reclaim_indices(std::size_t aStartIndex, std::size_t aEndIndex) = 0;
+        virtual buffer_allocation_statistics vertex_statistics() const = 0;
+        virtual buffer_allocation_statistics index_statistics() const = 0;
     };
 }
\ No newline at end of file
@@ -82,6 +82,10 @@ namespace neogfx
         void* pixels() override;
         color get_pixel(const point& aPoint) const override;
         void set_pixel(const point& aPoint, const color& aColor) override;
+    public:
+        // Separable Gaussian blur of the pixel data, treating everything outside the image as transparent; touches only
+        // this image so can be used to precompute shadows off the render thread. The default sigma is a third of the radius.
+        void blur(dimension aRadius, std::optional<scalar> const& aSigma = {});
     private:
         bool has_resource() const;
         const i_resource& resource() const;
@@ -31,7 +31,14 @@ namespace neogfx
         Lines,
         LineLoop,
         LineStrip,
-        ConvexPolygon
+        ConvexPolygon,
+        Polygon     // all sub paths form one region under the path's fill rule; may be concave, self-intersecting or have holes
+    };
+
+    enum class fill_rule : uint32_t
+    {
+        NonZero,
+        EvenOdd
     };
 
     template <typename PointType>
@@ -105,6 +112,14 @@ namespace neogfx
         { 
             iShape = aShape; 
         }
+        neogfx::fill_rule fill_rule() const
+        {
+            return iFillRule;
+        }
+        void set_fill_rule(neogfx::fill_rule aFillRule)
+        {
+            iFillRule = aFillRule;
+        }
         point_type position() const 
         { 
             return iPosition; 
@@ -153,7 +168,7 @@ namespace neogfx
                         break;
                     }
                 }
-                if (iShape == path_shape::LineLoop && aPath[0] == aPath[aPath.size() - 1])
+                if ((iShape == path_shape::LineLoop || iShape == path_shape::Polygon) && aPath[0] == aPath[aPath.size() - 1])
                 {
                     result.pop_back();
                 }
@@ -235,6 +250,7 @@ namespace neogfx
         // attributes
     private:
         path_shape iShape;
+        neogfx::fill_rule iFillRule = neogfx::fill_rule::NonZero;
         point_type iPosition;
         std::optional<point_type> iPointFrom;
         sub_paths_type iSubPaths;
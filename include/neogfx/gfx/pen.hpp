@@ -25,6 +25,20 @@
 
 namespace neogfx
 {
+    enum class line_join : uint32_t
+    {
+        Miter,
+        Round,
+        Bevel
+    };
+
+    enum class line_cap : uint32_t
+    {
+        Butt,
+        Square,
+        Round
+    };
+
     class pen
     {
     public:
@@ -42,10 +56,19 @@ namespace neogfx
         const color_or_gradient& color() const { return iColor; }
         dimension width() const { return iWidth; }
         bool anti_aliased() const { return iAntiAliased; }
+        neogfx::line_join line_join() const { return iLineJoin; }
+        pen& set_line_join(neogfx::line_join aLineJoin) { iLineJoin = aLineJoin; return *this; }
+        neogfx::line_cap line_cap() const { return iLineCap; }
+        pen& set_line_cap(neogfx::line_cap aLineCap) { iLineCap = aLineCap; return *this; }
+        scalar miter_limit() const { return iMiterLimit; }
+        pen& set_miter_limit(scalar aMiterLimit) { iMiterLimit = aMiterLimit; return *this; }
     private:
         color_or_gradient iColor;
         dimension iWidth;
         bool iAntiAliased;
+        neogfx::line_join iLineJoin = neogfx::line_join::Miter;
+        neogfx::line_cap iLineCap = neogfx::line_cap::Square;
+        scalar iMiterLimit = 4.0;
     };
 
     typedef std::optional<pen> optional_pen;
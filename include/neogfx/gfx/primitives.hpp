@@ -72,8 +72,11 @@ namespace neogfx
 
     enum class shader_filter
     {
-        None            = 0,
-        GaussianBlur    = 1
+        None                    = 0,
+        GaussianBlur            = 1,
+        SeparableGaussianBlur   = 2,
+        KawaseDownsample        = 3,
+        KawaseUpsample          = 4
     };
 
     enum class shader_shape
@@ -86,7 +89,9 @@ namespace neogfx
     enum class blurring_algorithm
     {
         None,
-        Gaussian
+        Gaussian,           // full 2D kernel; one pass per unit of radius
+        SeparableGaussian,  // one horizontal and one vertical 1D pass of equivalent variance
+        DualKawase          // downsample/upsample pyramid; cost largely independent of radius
     };
 
     typedef neolib::variant<color, gradient, texture, std::pair<texture, rect>, sub_texture, std::pair<sub_texture, rect>> brush;
@@ -1,6 +1,7 @@
 // rect_pack.hpp
 /*
- *  Based on public domain code @ http://blackpawn.com/texts/lightmaps/default.html.
+ *  Maximal rectangles (MaxRects) bin packing as described by Jukka Jylanki in
+ *  "A Thousand Ways to Pack the Bin".
  *
  *  This implementation written by Leigh Johnston.
  *
@@ -34,7 +35,7 @@
 */
 
 #include <neogfx/neogfx.hpp>
-#include <boost/pool/pool_alloc.hpp>
+#include <vector>
 #include <neogfx/core/geometrical.hpp>
 
 #pragma once
@@ -43,51 +44,26 @@ namespace neogfx
 {
     class rect_pack
     {
-    private:
-        class node
-        {
-        public:
-            typedef boost::fast_pool_allocator<node, boost::default_user_allocator_new_delete, boost::details::pool::null_mutex> allocator_type;
-        public:
-            node(const rect& aRect, allocator_type& aAllocator) :
-                iAllocator{ aAllocator }, iInUse { false }, iChildren{}, iRect{ aRect }
-            {
-            }
-            ~node()
-            {
-                if (iChildren[0] != nullptr)
-                {
-                    iAllocator.destroy(iChildren[0]);
-                    iAllocator.deallocate(iChildren[0]);
-                }
-                if (iChildren[1] != nullptr)
-                {
-                    iAllocator.destroy(iChildren[1]);
-                    iAllocator.deallocate(iChildren[1]);
-                }
-            }
-        public:
-            bool is_leaf() const 
-            {
-                return iChildren[0] == nullptr;
-            }
-            const neogfx::rect& rect() const
-            {
-                return iRect;
-            }
-            node* insert(const size& aElementSize);
-        private:
-            allocator_type& iAllocator;
-            bool iInUse;
-            std::array<node*, 2> iChildren;
-            neogfx::rect iRect;
-        };
     public:
         rect_pack(const size& aDimensions);
     public:
+        const size& dimensions() const;
         bool insert(const size& aElementSize, rect& aResult);
+        bool insert(const std::vector<size>& aElementSizes, std::vector<rect>& aResults);
+        void remove(const rect& aElement);
+        void clear();
+    public:
+        dimension used_area() const;
+        double occupancy() const;
+        std::size_t free_rect_count() const;
+    private:
+        void split_free_rects(const rect& aUsed);
+        rect merge_free_rects(const rect& aFreed);
+        void prune_free_rects(std::size_t aFirstNew);
     private:
-        node::allocator_type iAllocator;
-        node iRoot;
+        size iDimensions;
+        std::vector<rect> iFreeRects;
+        std::vector<rect> iSplitRects;
+        dimension iUsedArea;
     };
 }
\ No newline at end of file
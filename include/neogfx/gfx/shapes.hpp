@@ -79,6 +79,14 @@ namespace neogfx
         calc_rect_vertices(result, aRect, aType, aZpos, aTransformation);
         return result;
     };
+    // Maximum distance between a generated arc's chords and the true arc, in the same (logical) units as the radius;
+    // callers drawing at a DPI scale factor should divide the tolerance by it to keep the error within device pixels.
+    scalar constexpr DefaultArcTolerance = 0.25;
+    // Segments per full circle needed to keep within aTolerance of a circle of aRadius; always a multiple of four
+    // and at most 4096.
+    uint32_t arc_segments_per_circle(dimension aRadius, scalar aTolerance = DefaultArcTolerance);
+    // An aArcSegments of zero picks the segment count for DefaultArcTolerance at aRadius. Outline and TriangleFan arcs
+    // include both end points.
     vertices arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, uint32_t aArcSegments = 0);
     vertices circle_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, uint32_t aArcSegments = 0);
     vertices rounded_rect_vertices(const rect& aRect, dimension aRadius, mesh_type aType, uint32_t aArcSegments = 0);
@@ -0,0 +1,104 @@
+// software_render_target.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/core/event.hpp>
+#include <neogfx/gfx/i_render_target.hpp>
+#include <neogfx/gfx/i_image.hpp>
+
+namespace neogfx
+{
+    class software_rasterizer;
+
+    struct software_render_statistics
+    {
+        uint64_t flushes = 0;
+        uint64_t operations = 0;
+        uint64_t batches = 0;
+        uint64_t parallelBatches = 0;
+        uint64_t triangles = 0;
+        uint64_t spans = 0;
+        uint64_t pixels = 0;
+        uint64_t flushTime = 0; // microseconds
+    };
+
+    // An RGBA8 image in main memory used as a render target. Graphics contexts created for it consume
+    // the same graphics operation queue as the OpenGL backend but rasterize it on the CPU.
+    class software_render_target : public i_render_target
+    {
+    public:
+        define_declared_event(TargetActivating, target_activating)
+        define_declared_event(TargetActivated, target_activated)
+        define_declared_event(TargetDeactivating, target_deactivating)
+        define_declared_event(TargetDeactivated, target_deactivated)
+    public:
+        struct no_target_texture : std::logic_error { no_target_texture() : std::logic_error("neogfx::software_render_target::no_target_texture") {} };
+    public:
+        software_render_target(i_image& aImage, neogfx::logical_coordinate_system aLogicalCoordinateSystem = neogfx::logical_coordinate_system::AutomaticGui);
+        ~software_render_target();
+    public:
+        i_image& image() const;
+        software_rasterizer& rasterizer() const;
+        uint32_t max_threads() const;
+        void set_max_threads(uint32_t aMaxThreads);
+        software_render_statistics const& statistics() const;
+        void reset_statistics();
+    public:
+        dimension horizontal_dpi() const override;
+        dimension vertical_dpi() const override;
+        dimension ppi() const override;
+        bool metrics_available() const override;
+        size extents() const override;
+        dimension em_size() const override;
+    public:
+        render_target_type target_type() const override;
+        void* target_handle() const override;
+        void* target_device_handle() const override;
+        pixel_format_t pixel_format() const override;
+        const i_texture& target_texture() const override;
+        point target_origin() const override;
+        size target_extents() const override;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const override;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem) override;
+        neogfx::logical_coordinates logical_coordinates() const override;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) override;
+    public:
+        rect_i32 viewport() const override;
+        rect_i32 set_viewport(const rect_i32& aViewport) const override;
+    public:
+        bool target_active() const override;
+        void activate_target() const override;
+        void deactivate_target() const override;
+    public:
+        neogfx::color_space color_space() const override;
+        color read_pixel(const point& aPosition) const override;
+    public:
+        std::unique_ptr<i_rendering_context> create_graphics_context(blending_mode aBlendingMode = blending_mode::Default) const override;
+    private:
+        i_image& iImage;
+        std::unique_ptr<software_rasterizer> iRasterizer;
+        neogfx::logical_coordinate_system iLogicalCoordinateSystem;
+        std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
+        mutable rect_i32 iViewport;
+        mutable bool iActive;
+    };
+}
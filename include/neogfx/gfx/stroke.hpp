@@ -0,0 +1,33 @@
+// stroke.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <vector>
+#include <neogfx/core/geometrical.hpp>
+#include <neogfx/gfx/pen.hpp>
+
+namespace neogfx
+{
+    // Appends the triangles of a polyline stroked with aPen's width, join and cap to aTriangles. A closed polyline
+    // is joined back to its first point and has no caps; a repeated closing point is ignored. A polyline of zero
+    // length is drawn as a dot shaped by the pen's cap (round or square; nothing for a butt cap).
+    void stroke_polyline(const vertices& aPolyline, bool aClosed, const pen& aPen, std::vector<vec3f>& aTriangles);
+}
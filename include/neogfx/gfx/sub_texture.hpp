@@ -21,6 +21,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <optional>
+#include <memory>
 #include <neogfx/gfx/i_image.hpp>
 #include <neogfx/gfx/i_sub_texture.hpp>
 
@@ -67,11 +68,13 @@ namespace neogfx
         texture_id atlas_id() const override;
         i_texture& atlas_texture() const override;
         const rect& atlas_location() const override;
+    public:
+        void set_atlas_location(const rect& aAtlasLocation);
         // attributes
     private:
         texture_id iAtlasId;
         i_texture* iAtlasTexture;
-        rect iAtlasLocation;
+        std::shared_ptr<rect> iAtlasLocation; // shared by copies so they follow the atlas entry when its page is repacked
         size iStorageExtents;
         size iExtents;
     };
@@ -0,0 +1,73 @@
+// tessellator.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <memory>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <neogfx/core/geometrical.hpp>
+#include <neogfx/gfx/path.hpp>
+
+namespace neogfx
+{
+    // Triangulates the closed contours of all sub paths of a path as a single region under its fill rule; contours
+    // may be concave, self-intersecting or nested (holes). The result is a triangle list in path coordinates, i.e.
+    // the path's position is not applied.
+    vertices tessellate(const path& aPath);
+
+    // Thread-safe LRU of tessellated path meshes keyed by a hash of the path's fill rule and contours; a hit is
+    // confirmed by comparing contours so a hash collision replaces the colliding entry rather than returning it.
+    class path_mesh_cache
+    {
+    public:
+        typedef uint64_t(*hash_function)(const path& aPath);
+    public:
+        static constexpr std::size_t DefaultCapacity = 256;
+    private:
+        struct entry
+        {
+            neogfx::fill_rule fillRule;
+            path::sub_paths_type subPaths;
+            std::shared_ptr<const vertices> mesh;
+            std::list<uint64_t>::iterator queuePosition;
+        };
+    public:
+        path_mesh_cache(std::size_t aCapacity = DefaultCapacity, hash_function aHash = &content_hash);
+    public:
+        std::shared_ptr<const vertices> find(const path& aPath);
+        std::size_t size() const;
+    public:
+        static uint64_t content_hash(const path& aPath);
+    private:
+        static bool same_content(entry const& aEntry, const path& aPath);
+    private:
+        std::size_t const iCapacity;
+        hash_function const iHash;
+        mutable std::mutex iMutex;
+        std::unordered_map<uint64_t, entry> iEntries;
+        std::list<uint64_t> iQueue;
+    };
+
+    // As tessellate() but the result is cached by path content so unchanged paths are only tessellated once;
+    // may be called from any thread.
+    std::shared_ptr<const vertices> tessellated(const path& aPath);
+}
@@ -242,6 +242,7 @@ namespace neogfx
         point_size fixed_size(uint32_t aFixedSizeIndex) const;
     public:
         const i_glyph_texture& glyph_texture(const glyph& aGlyph) const;
+        void glyph_texture_drawn(const glyph& aGlyph) const;
     public:
         bool operator==(const font& aRhs) const;
         bool operator!=(const font& aRhs) const;
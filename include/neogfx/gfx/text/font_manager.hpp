@@ -21,18 +21,21 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
+#include <map>
 #include <set>
 #include <neolib/core/jar.hpp>
 #include <neolib/core/string_ci.hpp>
 #include <neogfx/gfx/texture_atlas.hpp>
 #include <neogfx/gfx/text/emoji_atlas.hpp>
 #include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/text/glyph_cache.hpp>
 
 typedef struct FT_LibraryRec_* FT_Library;
 
 namespace neogfx
 {
     class native_font;
+    class glyph_rasterizer;
 
     class fallback_font_info : public i_fallback_font_info
     {
@@ -68,6 +71,7 @@ namespace neogfx
         i_native_font_face& create_default_font(const i_device_resolution& aDevice) override;
         bool has_fallback_font(const i_native_font_face& aExistingFont) const override;
         i_native_font_face& create_fallback_font(const i_native_font_face& aExistingFont) override;
+        std::optional<uint32_t> fallback_coverage(i_native_font_face& aFace, char32_t aCodePoint) override;
         i_native_font_face& create_font(i_string const& aFamilyName, neogfx::font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice) override;
         i_native_font_face& create_font(i_string const& aFamilyName, i_string const& aStyleName, font::point_size aSize, const i_device_resolution& aDevice) override;
         i_native_font_face& create_font(const font_info& aInfo, const i_device_resolution& aDevice) override;
@@ -97,6 +101,20 @@ namespace neogfx
         i_texture_atlas& glyph_atlas() override;
         const i_emoji_atlas& emoji_atlas() const override;
         i_emoji_atlas& emoji_atlas() override;
+    public:
+        std::size_t glyph_cache_budget() const override;
+        void set_glyph_cache_budget(std::size_t aBudget) override;
+        neogfx::glyph_cache_statistics glyph_cache_statistics() const override;
+        void next_glyph_cache_frame() override;
+        neogfx::glyph_rasterization_policy glyph_rasterization_policy() const override;
+        void set_glyph_rasterization_policy(neogfx::glyph_rasterization_policy aPolicy) override;
+        void upload_rasterized_glyphs() override;
+        uint64_t placeholder_glyphs_issued() const override;
+        optional_dimension const& distance_field_glyph_threshold() const override;
+        void set_distance_field_glyph_threshold(optional_dimension const& aPixelSize) override;
+    private:
+        neogfx::glyph_cache& glyph_cache() override;
+        neogfx::glyph_rasterizer& glyph_rasterizer() override;
     protected:
         void add_ref(font_id aId) override;
         void release(font_id aId) override;
@@ -110,6 +128,7 @@ namespace neogfx
     private:
         mutable std::unordered_map<system_font_role, optional<font_info>> iDefaultSystemFontInfo;
         mutable std::optional<fallback_font_info> iDefaultFallbackFontInfo;
+        std::map<std::pair<i_native_font const*, std::string>, std::unordered_map<char32_t, std::optional<uint32_t>>> iFallbackCoverage;
         FT_Library iFontLib;
         native_font_list iNativeFonts;
         font_family_list iFontFamilies;
@@ -117,6 +136,9 @@ namespace neogfx
         id_cache iIdCache;
         std::unique_ptr<i_glyph_text_factory> iGlyphTextFactory;
         texture_atlas iGlyphAtlas;
+        neogfx::glyph_cache iGlyphCache;
+        std::unique_ptr<neogfx::glyph_rasterizer> iGlyphRasterizer;
+        optional_dimension iDistanceFieldGlyphThreshold;
         neogfx::emoji_atlas iEmojiAtlas;
     };
 }
\ No newline at end of file
@@ -520,6 +520,16 @@ namespace neogfx
         function_type iSelectorFunction;
     };
 
+    struct glyph_text_cache_statistics
+    {
+        std::size_t budget;
+        std::size_t bytes;
+        std::size_t entries;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
     class i_glyph_text_factory
     {
     public:
@@ -528,6 +538,25 @@ namespace neogfx
         virtual glyph_text create_glyph_text(font const& aFont) = 0;
         virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector) = 0;
         virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, i_font_selector const& aFontSelector) = 0;
+        // single font text is shaped once and then served from a least recently used cache
+        virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, font const& aFont) = 0;
+        virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, font const& aFont) = 0;
+        // independent paragraphs are shaped concurrently; the font selector is given the paragraph index and the character position within it
+        virtual std::vector<glyph_text> to_glyph_text(i_graphics_context const& aContext, std::vector<std::u32string_view> const& aParagraphs, std::function<font(std::size_t, std::size_t)> const& aFontSelector) = 0;
+    public:
+        virtual std::size_t cache_budget() const = 0;
+        virtual void set_cache_budget(std::size_t aBudget) = 0;
+        virtual glyph_text_cache_statistics const& cache_statistics() const = 0;
+        virtual void clear_cache() = 0;
+    public:
+        glyph_text to_glyph_text(i_graphics_context const& aContext, std::u32string_view const& aString, font const& aFont)
+        {
+            return to_glyph_text(aContext, aString.data(), aString.data() + aString.size(), aFont);
+        }
+        glyph_text to_glyph_text(i_graphics_context const& aContext, std::string_view const& aString, font const& aFont)
+        {
+            return to_glyph_text(aContext, aString.data(), aString.data() + aString.size(), aFont);
+        }
     public:
         glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, std::function<font(std::size_t)> aFontSelector)
         {
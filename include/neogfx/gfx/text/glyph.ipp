@@ -243,7 +243,7 @@ namespace neogfx
             else
             {
                 auto const& glyphTexture = glyph_texture(aGlyph);
-                aGlyph.extents = neogfx::size{ static_cast<float>(offset(aGlyph).x + glyphTexture.placement().x + glyphTexture.texture().extents().cx), glyphFont.height() };
+                aGlyph.extents = neogfx::size{ static_cast<float>(offset(aGlyph).x + glyphTexture.placement().x + glyphTexture.extents().cx), glyphFont.height() };
             }
         }
         return aGlyph.extents;
@@ -0,0 +1,81 @@
+// glyph_cache.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <list>
+#include <atomic>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+
+namespace neogfx
+{
+    // Implemented by whatever holds the glyph textures (font faces); evict_glyph() must release the glyph and call
+    // glyph_cache::remove().
+    class i_glyph_cache_owner
+    {
+    public:
+        virtual ~i_glyph_cache_owner() = default;
+    public:
+        virtual void evict_glyph(uint32_t aGlyph) const = 0;
+    };
+
+    // Least recently used bookkeeping for the rasterized glyphs held by font faces; the faces own the glyph textures and
+    // the cache tells them when to give them (and their atlas space) up. Entries are only stamped when their glyph is
+    // drawn (use()) and only glyphs not drawn since the last call to next_frame() are ever evicted so glyph textures
+    // handed out for drawing during the current frame stay valid. Each rendering engine's font manager has its own
+    // cache and the engine advances its frame once per engine frame rather than once per window.
+    class glyph_cache
+    {
+    public:
+        struct entry
+        {
+            i_glyph_cache_owner const* owner;
+            uint32_t glyph;
+            std::size_t bytes;
+            uint64_t frame;
+        };
+        typedef std::list<entry> entry_list;
+        typedef entry_list::iterator handle;
+    public:
+        glyph_cache(std::size_t aBudget);
+    public:
+        std::size_t budget() const;
+        void set_budget(std::size_t aBudget);
+        neogfx::glyph_cache_statistics statistics() const;
+        void next_frame();
+    public:
+        handle add(i_glyph_cache_owner const& aOwner, uint32_t aGlyph, std::size_t aBytes);
+        void use(handle aEntry);
+        void remove(handle aEntry);
+        // lookups can come from shaping threads so these only touch the counters
+        void hit();
+        void miss();
+    private:
+        void evict();
+    private:
+        entry_list iEntries; // most recently drawn first
+        uint64_t iFrame;
+        std::size_t iBudget;
+        std::size_t iBytes;
+        std::atomic<uint64_t> iHits;
+        std::atomic<uint64_t> iMisses;
+        std::atomic<uint64_t> iEvictions;
+    };
+}
@@ -33,6 +33,8 @@ namespace neogfx
 
     class i_texture_atlas;
     class i_emoji_atlas;
+    class glyph_cache;
+    class glyph_rasterizer;
 
     enum class system_font_role : uint32_t
     {
@@ -52,9 +54,27 @@ namespace neogfx
         virtual i_string const& fallback_for(i_string const& aFontFamilyName) const = 0;
     };
 
+    enum class glyph_rasterization_policy : uint32_t
+    {
+        Synchronous,    // rasterize on the render thread when a glyph is first drawn
+        WaitForFrame,   // rasterize in the background once shaped; drawing waits for glyphs not yet finished
+        Placeholder     // as WaitForFrame but draw nothing for unfinished glyphs and redraw when they arrive
+    };
+
+    struct glyph_cache_statistics
+    {
+        std::size_t budget;
+        std::size_t bytes;
+        std::size_t glyphs;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
     class i_font_manager : public neolib::i_small_cookie_consumer, public i_service
     {
         friend class native_font;
+        friend class native_font_face;
     public:
         struct bad_font_family_index : std::logic_error { bad_font_family_index() : std::logic_error("neogfx::i_font_manager::bad_font_family_index") {} };
         struct bad_font_style_index : std::logic_error { bad_font_style_index() : std::logic_error("neogfx::i_font_manager::bad_font_style_index") {} };
@@ -68,6 +88,8 @@ namespace neogfx
         virtual i_native_font_face& create_default_font(const i_device_resolution& aDevice) = 0;
         virtual bool has_fallback_font(i_native_font_face const& aExistingFont) const = 0;
         virtual i_native_font_face& create_fallback_font(i_native_font_face const& aExistingFont) = 0;
+        // index of the first face in the fallback chain (zero being the face itself) with a glyph for the code point
+        virtual std::optional<uint32_t> fallback_coverage(i_native_font_face& aFace, char32_t aCodePoint) = 0;
         virtual i_native_font_face& create_font(i_string const& aFamilyName, neogfx::font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice) = 0;
         virtual i_native_font_face& create_font(i_string const& aFamilyName, i_string const& aStyleName, font::point_size aSize, const i_device_resolution& aDevice) = 0;
         virtual i_native_font_face& create_font(const font_info& aInfo, const i_device_resolution& aDevice) = 0;
@@ -97,6 +119,23 @@ namespace neogfx
         virtual i_texture_atlas& glyph_atlas() = 0;
         virtual const i_emoji_atlas& emoji_atlas() const = 0;
         virtual i_emoji_atlas& emoji_atlas() = 0;
+    public:
+        virtual std::size_t glyph_cache_budget() const = 0;
+        virtual void set_glyph_cache_budget(std::size_t aBudget) = 0;
+        virtual neogfx::glyph_cache_statistics glyph_cache_statistics() const = 0;
+        // glyphs drawn since the previous call are protected from eviction; called by the rendering engine once per frame
+        virtual void next_glyph_cache_frame() = 0;
+        virtual neogfx::glyph_rasterization_policy glyph_rasterization_policy() const = 0;
+        virtual void set_glyph_rasterization_policy(neogfx::glyph_rasterization_policy aPolicy) = 0;
+        // uploads glyphs finished by the background rasterizer; requires the rendering context to be current
+        virtual void upload_rasterized_glyphs() = 0;
+        virtual uint64_t placeholder_glyphs_issued() const = 0;
+        // faces at or above this pixel size draw distance field glyphs shared by every size; disabled if std::nullopt
+        virtual optional_dimension const& distance_field_glyph_threshold() const = 0;
+        virtual void set_distance_field_glyph_threshold(optional_dimension const& aPixelSize) = 0;
+    private:
+        virtual neogfx::glyph_cache& glyph_cache() = 0;
+        virtual neogfx::glyph_rasterizer& glyph_rasterizer() = 0;
     public:
         bool has_font(std::string const& aFamily, std::string const& aStyle) const
         {
@@ -44,6 +44,8 @@ namespace neogfx
         virtual ~i_glyph_texture() = default;
     public:
         virtual const i_sub_texture& texture() const = 0;
+        // the size the glyph is drawn at; distance field textures are shared by every font size so differ from this
+        virtual const size& extents() const = 0;
         virtual bool subpixel() const = 0;
         virtual const point& placement() const = 0;
         virtual glyph_pixel_mode pixel_mode() const = 0;
@@ -21,8 +21,11 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
-#include <set>
-#include <tuple>
+#include <vector>
+#include <optional>
+#include <future>
+#include <atomic>
+#include <memory>
 #include "i_texture_atlas.hpp"
 #include "i_texture_manager.hpp"
 #include "texture.hpp"
@@ -38,32 +41,41 @@ namespace neogfx
     private:
         struct fragments
         {
-            struct fragment_less_than
-            {
-                bool operator()(const rect& aLhs, const rect& aRhs) const
-                {
-                    return std::forward_as_tuple(aLhs.width() * aLhs.height(), aLhs.top_left()) <
-                        std::forward_as_tuple(aRhs.width() * aRhs.height(), aRhs.top_left());
-                }
-            };
             rect_pack pack;
-            std::set<rect, fragment_less_than> used;
-            std::set<rect, fragment_less_than> freed; // todo: use this when bin pack is full
+            std::size_t subTextures = 0u;
+            uint32_t generation = 0u; // changes whenever a sub-texture is added to or removed from the page
             bool insert(const size& aSize, rect& aResult)
             {
-                if (pack.insert(aSize, aResult))
-                {
-                    used.insert(aResult);
-                    return true;
-                }
-                else
+                if (!pack.insert(aSize, aResult))
                     return false;
+                ++subTextures;
+                ++generation;
+                return true;
+            }
+            void remove(const rect& aSpace)
+            {
+                pack.remove(aSpace);
+                --subTextures;
+                ++generation;
             }
         };
         typedef std::pair<texture, fragments> page;
         typedef std::list<page> pages;
         typedef std::pair<pages::iterator, neogfx::sub_texture> entry;
         typedef std::unordered_map<texture_id, entry> entries;
+        struct repack_layout
+        {
+            rect_pack pack;
+            std::vector<std::pair<texture_id, rect>> spaces;
+        };
+        struct pending_repack
+        {
+            pages::iterator page;
+            uint32_t generation;
+            std::shared_ptr<std::atomic<bool>> cancelled;
+            std::future<std::optional<repack_layout>> layout;
+        };
+        typedef std::vector<pending_repack> pending_repacks;
     public:
         texture_atlas(const size& aPageSize);
     public:
@@ -73,14 +85,24 @@ namespace neogfx
         i_sub_texture& create_sub_texture(const i_image& aImage) override;
         i_sub_texture& create_sub_texture(const i_image& aImage, const rect& aImagePart) override;
         void destroy_sub_texture(i_sub_texture& aSubTexture) override;
+    public:
+        std::size_t page_count() const override;
+        atlas_page_statistics page_statistics(std::size_t aPageIndex) const override;
+        void repack_page(std::size_t aPageIndex) override;
     private:
         const size& page_size() const;
+        pages::const_iterator page(std::size_t aPageIndex) const;
+        pages::iterator page(std::size_t aPageIndex);
         pages::iterator create_page(dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat);
+        void destroy_page(pages::iterator aPage);
         std::pair<pages::iterator, rect> allocate_space(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat);
+        void complete_repacks();
+        void apply_repack(pages::iterator aPage, repack_layout& aLayout);
     private:
         i_texture_manager& iTextureManager;
         size iPageSize;
         pages iPages;
         entries iEntries;
+        pending_repacks iPendingRepacks;
     };
 }
\ No newline at end of file
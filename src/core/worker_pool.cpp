@@ -0,0 +1,120 @@
+// worker_pool.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neolib/core/scoped.hpp>
+#include <neogfx/core/worker_pool.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        // set on workers and on a thread inside run() so that nested calls run inline rather than deadlock
+        thread_local bool tInPool = false;
+    }
+
+    worker_pool::worker_pool(uint32_t aThreads) :
+        iGeneration{ 0u }, iPending{ 0u }, iTask{ nullptr }, iCount{ 0u }, iNext{ 0u }, iStopping{ false }
+    {
+        iThreads.reserve(aThreads);
+        for (uint32_t t = 0u; t < aThreads; ++t)
+            iThreads.emplace_back([this]() { worker(); });
+    }
+
+    worker_pool::~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ iMutex };
+            iStopping = true;
+        }
+        iWorkAvailable.notify_all();
+        for (auto& thread : iThreads)
+            thread.join();
+    }
+
+    uint32_t worker_pool::thread_count() const
+    {
+        return static_cast<uint32_t>(iThreads.size());
+    }
+
+    void worker_pool::run(std::size_t aCount, task const& aTask)
+    {
+        std::unique_lock<std::mutex> runLock{ iRunMutex, std::defer_lock };
+        if (aCount <= 1u || iThreads.empty() || tInPool || !runLock.try_lock())
+        {
+            for (std::size_t index = 0u; index < aCount; ++index)
+                aTask(index);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock{ iMutex };
+            iTask = &aTask;
+            iCount = aCount;
+            iNext = 0u;
+            iError = nullptr;
+            iPending = iThreads.size();
+            ++iGeneration;
+        }
+        iWorkAvailable.notify_all();
+        neolib::scoped_flag inPool{ tInPool };
+        work();
+        std::unique_lock<std::mutex> lock{ iMutex };
+        // every worker must have seen this generation before the next run() can reuse the task state
+        iWorkFinished.wait(lock, [&]() { return iPending == 0u; });
+        iTask = nullptr;
+        if (iError)
+            std::rethrow_exception(std::exchange(iError, nullptr));
+    }
+
+    void worker_pool::worker()
+    {
+        tInPool = true;
+        uint64_t generation = 0u;
+        std::unique_lock<std::mutex> lock{ iMutex };
+        for (;;)
+        {
+            iWorkAvailable.wait(lock, [&]() { return iStopping || iGeneration != generation; });
+            if (iStopping)
+                return;
+            generation = iGeneration;
+            lock.unlock();
+            work();
+            lock.lock();
+            if (--iPending == 0u)
+                iWorkFinished.notify_all();
+        }
+    }
+
+    void worker_pool::work()
+    {
+        for (auto index = iNext++; index < iCount; index = iNext++)
+        {
+            try
+            {
+                (*iTask)(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{ iMutex };
+                if (!iError)
+                    iError = std::current_exception();
+            }
+        }
+    }
+}
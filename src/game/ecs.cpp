@@ -33,7 +33,7 @@ namespace neogfx
 {
     namespace game
     {
-        ecs::ecs(ecs_flags aCreationFlags) : base_type{ aCreationFlags }
+        ecs::ecs(ecs_flags aCreationFlags) : base_type{ aCreationFlags }, iDrawLists{ *this }
         {
             service<i_rendering_engine>().allocate_vertex_buffer(*this, vertex_buffer_type::DefaultECS);
         }
@@ -59,13 +59,79 @@ namespace neogfx
             if (component<mesh_render_cache>().has_entity_record(aEntityId) && service<i_rendering_engine>().vertex_buffer_allocated(*this))
             {
                 auto const& cacheEntry = component<mesh_render_cache>().entity_record(aEntityId);
-                service<i_rendering_engine>().vertex_buffer(*this).reclaim(cacheEntry.meshVertexArrayIndices[0], cacheEntry.meshVertexArrayIndices[1]);
-                for (auto& indices : cacheEntry.patchVertexArrayIndices)
-                    service<i_rendering_engine>().vertex_buffer(*this).reclaim(indices[0], indices[1]);
+                if (cacheEntry.state != cache_state::Invalid) // an invalid cache entry owns no buffer space
+                    reclaim(cacheEntry);
             }
+            iDrawLists.remove(aEntityId);
             base_type::destroy_entity(aEntityId, aNotify);
         }
 
+        std::size_t ecs::compact_vertex_buffer(std::size_t aMaxRelocations)
+        {
+            if (!service<i_rendering_engine>().vertex_buffer_allocated(*this))
+                return 0u;
+            auto& vertexBuffer = service<i_rendering_engine>().vertex_buffer(*this);
+            scoped_component_lock<mesh_render_cache> lock{ *this };
+            auto& cache = component<mesh_render_cache>();
+            std::size_t relocations = 0u;
+            while (relocations < aMaxRelocations)
+            {
+                auto const statistics = vertexBuffer.vertex_statistics();
+                if (statistics.freeBlocks == 0u)
+                    break;
+                // the entity with the highest vertex range is invalidated so that its next render bakes it into a lower hole
+                entity_id highestEntity = null_entity;
+                vec2u32 highestRange;
+                for (auto entity : cache.entities())
+                {
+                    if (entity == null_entity)
+                        continue;
+                    auto const& cacheEntry = cache.entity_record_no_lock(entity);
+                    if (cacheEntry.state == cache_state::Invalid)
+                        continue;
+                    auto consider = [&](vec2u32 const& aRange)
+                    {
+                        if (aRange[1] != aRange[0] && (highestEntity == null_entity || aRange[1] > highestRange[1]))
+                        {
+                            highestEntity = entity;
+                            highestRange = aRange;
+                        }
+                    };
+                    consider(cacheEntry.meshVertexArrayIndices);
+                    for (auto const& range : cacheEntry.patchVertexArrayIndices)
+                        consider(range);
+                }
+                if (highestEntity == null_entity || highestRange[1] - highestRange[0] > statistics.largestFreeBlock)
+                    break;
+                auto& cacheEntry = cache.entity_record_no_lock(highestEntity);
+                reclaim(cacheEntry);
+                cacheEntry.state = cache_state::Invalid;
+                ++relocations;
+            }
+            return relocations;
+        }
+
+        const entity_draw_lists& ecs::draw_lists() const
+        {
+            return iDrawLists;
+        }
+
+        entity_draw_lists& ecs::draw_lists()
+        {
+            return iDrawLists;
+        }
+
+        void ecs::reclaim(mesh_render_cache const& aCacheEntry)
+        {
+            auto& vertexBuffer = service<i_rendering_engine>().vertex_buffer(*this);
+            vertexBuffer.reclaim(aCacheEntry.meshVertexArrayIndices[0], aCacheEntry.meshVertexArrayIndices[1]);
+            for (auto& indices : aCacheEntry.patchVertexArrayIndices)
+                vertexBuffer.reclaim(indices[0], indices[1]);
+            vertexBuffer.reclaim_indices(aCacheEntry.meshIndexArrayIndices[0], aCacheEntry.meshIndexArrayIndices[1]);
+            for (auto& indices : aCacheEntry.patchIndexArrayIndices)
+                vertexBuffer.reclaim_indices(indices[0], indices[1]);
+        }
+
         bool ecs::cacheable() const
         {
             return true;
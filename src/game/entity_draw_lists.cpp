@@ -0,0 +1,197 @@
+// entity_draw_lists.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/game/entity_draw_lists.hpp>
+#include <neogfx/game/mesh_renderer.hpp>
+#include <neogfx/game/mesh_filter.hpp>
+#include <neogfx/game/animation_filter.hpp>
+#include <neogfx/game/rigid_body.hpp>
+#include <neogfx/game/mesh_render_cache.hpp>
+
+namespace neogfx::game
+{
+    entity_draw_lists::entity_draw_lists(i_ecs& aEcs) :
+        iEcs{ aEcs }, iSyncedRenderers{ 0u }, iResync{ true }
+    {
+    }
+
+    void entity_draw_lists::update()
+    {
+        auto const& meshRenderers = iEcs.component<mesh_renderer>();
+        auto const& entities = meshRenderers.entities();
+        // new mesh renderer records either reuse the slot of a removed entity's record or are appended
+        if (iResync || entities.size() < iSyncedRenderers)
+            rebuild();
+        else
+        {
+            for (auto freed = iFreedSlots.begin(); freed != iFreedSlots.end();)
+            {
+                auto const [slot, removedEntity] = *freed;
+                auto const entity = slot < entities.size() ? entities[slot] : null_entity;
+                if (entity != null_entity && entity != removedEntity)
+                {
+                    add(entity, slot);
+                    *freed = iFreedSlots.back();
+                    iFreedSlots.pop_back();
+                }
+                else
+                    ++freed;
+            }
+            for (auto slot = iSyncedRenderers; slot < entities.size(); ++slot)
+                add(entities[slot], slot);
+            if (!refresh())
+                rebuild();
+        }
+        iSyncedRenderers = entities.size();
+        iResync = false;
+    }
+
+    void entity_draw_lists::invalidate()
+    {
+        iResync = true;
+    }
+
+    void entity_draw_lists::remove(entity_id aEntity)
+    {
+        auto existing = iIndex.find(aEntity);
+        if (existing == iIndex.end())
+            return;
+        auto const [layer, index] = existing->second;
+        iIndex.erase(existing);
+        // the removed entity's mesh renderer record may be recycled by the next entity created
+        iFreedSlots.emplace_back(iLayers[layer][index].slot, aEntity);
+        iLayers[layer][index].entity = null_entity;
+        if (++iTombstones[layer] > iLayers[layer].size() / 2u)
+            compact(layer);
+    }
+
+    void entity_draw_lists::set_layer(entity_id aEntity, int32_t aLayer)
+    {
+        auto existing = iIndex.find(aEntity);
+        if (existing == iIndex.end() || existing->second.first == aLayer)
+            return;
+        auto const [layer, index] = existing->second;
+        auto const moved = iLayers[layer][index];
+        iIndex.erase(existing);
+        iLayers[layer][index].entity = null_entity;
+        if (++iTombstones[layer] > iLayers[layer].size() / 2u)
+            compact(layer);
+        add(aEntity, aLayer, moved);
+    }
+
+    int32_t entity_draw_lists::max_layer() const
+    {
+        return static_cast<int32_t>(iLayers.size()) - 1;
+    }
+
+    entity_draw_lists::draw_list& entity_draw_lists::layer(int32_t aLayer)
+    {
+        if (iLayers.size() <= static_cast<std::size_t>(aLayer))
+        {
+            iLayers.resize(aLayer + 1);
+            iTombstones.resize(aLayer + 1);
+        }
+        return iLayers[aLayer];
+    }
+
+    void entity_draw_lists::rebuild()
+    {
+        auto const previousLayers = std::move(iLayers);
+        auto const previousIndex = std::move(iIndex);
+        iLayers.clear();
+        iTombstones.clear();
+        iIndex.clear();
+        iFreedSlots.clear();
+        auto const& entities = iEcs.component<mesh_renderer>().entities();
+        for (std::size_t slot = 0u; slot < entities.size(); ++slot)
+        {
+            auto const entity = entities[slot];
+            add(entity, slot);
+            // keep the bounds of surviving entities so that clean entities can still be culled
+            auto const previous = previousIndex.find(entity);
+            auto const current = iIndex.find(entity);
+            if (previous != previousIndex.end() && current != iIndex.end())
+                iLayers[current->second.first][current->second.second].bounds = 
+                    previousLayers[previous->second.first][previous->second.second].bounds;
+        }
+    }
+
+    bool entity_draw_lists::refresh()
+    {
+        auto const& entities = iEcs.component<mesh_renderer>().entities();
+        auto const& meshFilters = iEcs.component<mesh_filter>();
+        auto const& animationFilters = iEcs.component<animation_filter>();
+        auto const& rigidBodies = iEcs.component<rigid_body>();
+        auto& cache = iEcs.component<mesh_render_cache>();
+        for (auto& list : iLayers)
+            for (auto& entry : list)
+            {
+                if (entry.entity == null_entity)
+                    continue;
+                // a record moved by the removal of another component record invalidates the cached slots
+                if (entry.slot >= entities.size() || entities[entry.slot] != entry.entity)
+                    return false;
+                bool const hasMeshFilter = meshFilters.has_entity_record_no_lock(entry.entity);
+                bool const hasAnimationFilter = animationFilters.has_entity_record_no_lock(entry.entity);
+                bool const hasRigidBody = rigidBodies.has_entity_record_no_lock(entry.entity);
+                if (hasMeshFilter == entry.hasMeshFilter && hasAnimationFilter == entry.hasAnimationFilter && hasRigidBody == entry.hasRigidBody)
+                    continue;
+                // the entity's transformation or mesh has changed so its cached bounds and render cache are stale
+                entry.hasMeshFilter = hasMeshFilter;
+                entry.hasAnimationFilter = hasAnimationFilter;
+                entry.hasRigidBody = hasRigidBody;
+                entry.bounds = std::nullopt;
+                if (cache.has_entity_record_no_lock(entry.entity))
+                    set_render_cache_dirty_no_lock(cache, entry.entity);
+            }
+        return true;
+    }
+
+    void entity_draw_lists::add(entity_id aEntity, std::size_t aSlot)
+    {
+        if (aEntity == null_entity || iIndex.find(aEntity) != iIndex.end())
+            return;
+        add(aEntity, iEcs.component<mesh_renderer>().entity_record_no_lock(aEntity).layer, entry
+            { 
+                aEntity, 
+                iEcs.component<mesh_filter>().has_entity_record_no_lock(aEntity),
+                iEcs.component<animation_filter>().has_entity_record_no_lock(aEntity),
+                iEcs.component<rigid_body>().has_entity_record_no_lock(aEntity),
+                {},
+                aSlot
+            });
+    }
+
+    void entity_draw_lists::add(entity_id aEntity, int32_t aLayer, entry const& aEntry)
+    {
+        auto& list = layer(aLayer);
+        iIndex[aEntity] = std::make_pair(aLayer, list.size());
+        list.push_back(aEntry);
+    }
+
+    void entity_draw_lists::compact(int32_t aLayer)
+    {
+        auto& list = iLayers[aLayer];
+        list.erase(std::remove_if(list.begin(), list.end(), [](entry const& aEntry) { return aEntry.entity == null_entity; }), list.end());
+        for (std::size_t index = 0u; index < list.size(); ++index)
+            iIndex[list[index].entity].second = index;
+        iTombstones[aLayer] = 0u;
+    }
+}
@@ -317,6 +317,12 @@ namespace neogfx
                 "    case 3:\n" // SubPixel
                 "        texel = vec4(1.0, 1.0, 1.0, (texel.r + texel.g + texel.b) / 3.0);\n"
                 "        break;\n"
+                "    case 4:\n" // DistanceField
+                "        {\n"
+                "            float w = max(fwidth(texel.r), 1.0 / 255.0);\n"
+                "            texel = vec4(1.0, 1.0, 1.0, smoothstep(0.5 - w, 0.5 + w, texel.r));\n"
+                "        }\n"
+                "        break;\n"
                 "    }\n"
                 "    return texel;\n"
                 "}\n"
@@ -454,6 +460,41 @@ namespace neogfx
                 "               }\n"
                 "            }\n"
                 "            break;\n"
+                "        case 2:\n" // effect: SeparableGaussianBlur (direction in third argument)
+                "            {\n"
+                "                int d = uFilterKernelSize / 2;\n"
+                "                vec2 step = (uFilterArguments.z == 0.0 ? vec2(1.0, 0.0) : vec2(0.0, 1.0)) / uTextureExtents;\n"
+                "                vec4 sum = vec4(0.0, 0.0, 0.0, 0.0);\n"
+                "                for (int f = -d; f <= d; ++f)\n"
+                "                    sum += (texel_at(TexCoord + step * float(f)) * texelFetch(uFilterKernel, ivec2(f + d, 0)).r);\n"
+                "                color = sum;\n"
+                "            }\n"
+                "            break;\n"
+                "        case 3:\n" // effect: KawaseDownsample
+                "            {\n"
+                "                vec2 o = uFilterArguments.x * 0.5 / uTextureExtents;\n"
+                "                vec4 sum = texel_at(TexCoord) * 4.0;\n"
+                "                sum += texel_at(TexCoord - o);\n"
+                "                sum += texel_at(TexCoord + o);\n"
+                "                sum += texel_at(TexCoord + vec2(o.x, -o.y));\n"
+                "                sum += texel_at(TexCoord - vec2(o.x, -o.y));\n"
+                "                color = sum / 8.0;\n"
+                "            }\n"
+                "            break;\n"
+                "        case 4:\n" // effect: KawaseUpsample
+                "            {\n"
+                "                vec2 o = uFilterArguments.x * 0.5 / uTextureExtents;\n"
+                "                vec4 sum = texel_at(TexCoord + vec2(-o.x * 2.0, 0.0));\n"
+                "                sum += texel_at(TexCoord + vec2(-o.x, o.y)) * 2.0;\n"
+                "                sum += texel_at(TexCoord + vec2(0.0, o.y * 2.0));\n"
+                "                sum += texel_at(TexCoord + vec2(o.x, o.y)) * 2.0;\n"
+                "                sum += texel_at(TexCoord + vec2(o.x * 2.0, 0.0));\n"
+                "                sum += texel_at(TexCoord + vec2(o.x, -o.y)) * 2.0;\n"
+                "                sum += texel_at(TexCoord + vec2(0.0, -o.y * 2.0));\n"
+                "                sum += texel_at(TexCoord + vec2(-o.x, -o.y)) * 2.0;\n"
+                "                color = sum / 12.0;\n"
+                "            }\n"
+                "            break;\n"
                 "        }\n"
                 "    }\n"
                 "}\n"_s
@@ -476,20 +517,33 @@ namespace neogfx
         uFilterType = aFilter;
         auto const arguments = vec4{ aArgument1, aArgument2, aArgument3, aArgument4 };
         uFilterArguments = arguments.as<float>();
-        auto kernel = iFilterKernel.find(std::make_pair(aFilter, arguments));
+        uFilterKernel = sampler2DRect{ 5 };
+        if (aFilter != shader_filter::GaussianBlur && aFilter != shader_filter::SeparableGaussianBlur)
+        {
+            uFilterKernelSize = 0;
+            return;
+        }
+        // both directions of a separable blur share one kernel
+        auto const key = std::make_pair(aFilter, aFilter == shader_filter::SeparableGaussianBlur ? vec4{ aArgument1, aArgument2, 0.0, 0.0 } : arguments);
+        auto kernel = iFilterKernel.find(key);
         if (kernel == iFilterKernel.end())
         {
+            kernel = iFilterKernel.emplace(key, std::optional<shader_array<float>>{}).first;
             if (aFilter == shader_filter::GaussianBlur)
             {
-                kernel = iFilterKernel.emplace(std::make_pair(aFilter, arguments), std::optional<shader_array<float>>{}).first;
                 auto const kernelValues = dynamic_gaussian_filter<float>(static_cast<uint32_t>(aArgument1), static_cast<float>(aArgument2));
                 kernel->second.emplace(size{ aArgument1, aArgument1 });
                 kernel->second->data().set_pixels(rect{ point{0.0, 0.0}, size{aArgument1, aArgument1} }, &kernelValues[0][0]);
             }
+            else
+            {
+                auto const kernelValues = separable_gaussian_filter<float>(static_cast<uint32_t>(aArgument1), static_cast<float>(aArgument2));
+                kernel->second.emplace(size{ aArgument1, 1.0 });
+                kernel->second->data().set_pixels(rect{ point{0.0, 0.0}, size{aArgument1, 1.0} }, &kernelValues[0]);
+            }
         }
         uFilterKernelSize = static_cast<i32>(kernel->second->data().extents().cx);
         kernel->second->data().bind(5);
-        uFilterKernel = sampler2DRect{ 5 };
     }
 
     standard_glyph_shader::standard_glyph_shader(std::string const& aName) :
@@ -551,6 +605,11 @@ namespace neogfx
                 "        else\n"
                 "        {\n"
                 "            a = texture(tex, TexCoord).r;\n"
+                "            if (uGlyphDistanceField)\n"
+                "            {\n"
+                "                float w = max(fwidth(a), 1.0 / 255.0);\n"
+                "                a = smoothstep(0.5 - w, 0.5 + w, a);\n"
+                "            }\n"
                 "            if (a == 0)\n"
                 "                discard;\n"
                 "            color = vec4(color.xyz, color.a * a);\n"
@@ -579,6 +638,7 @@ namespace neogfx
         uGlyphGuiCoordinates = aContext.logical_coordinates().is_gui_orientation();
         uGlyphRenderOutput = sampler2DMS{ 7 };
         uGlyphSubpixel = aText.glyph_texture(aGlyph).subpixel();
+        uGlyphDistanceField = aText.glyph_texture(aGlyph).texture().data_format() == texture_data_format::DistanceField;
         uGlyphSubpixelFormat = subpixelRender ? aContext.subpixel_format() : subpixel_format::None;
         uGlyphEnabled = true;
     }
@@ -168,6 +168,12 @@ namespace neogfx
         return object().alpha_stops();
     }
 
+    template <gradient_sharing Sharing>
+    uint64_t basic_gradient<Sharing>::stops_fingerprint() const
+    {
+        return object().stops_fingerprint();
+    }
+
     template <gradient_sharing Sharing>
     typename basic_gradient<Sharing>::abstract_color_stop_list::const_iterator basic_gradient<Sharing>::find_color_stop(scalar aPos, bool aToInsert) const
     {
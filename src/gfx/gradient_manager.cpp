@@ -18,8 +18,10 @@
 */
 
 #include <neogfx/neogfx.hpp>
+#include <cstring>
 #include <neogfx/gfx/i_graphics_context.hpp>
 #include <neogfx/gfx/gradient_manager.hpp>
+#include "native/i_native_texture.hpp"
 
 std::unique_ptr<neogfx::i_gradient_manager> sGradientManager;
 
@@ -196,6 +198,7 @@ namespace neogfx
                 iSampler->release(id());
                 iSampler = nullptr;
             }
+            iStopsFingerprint = std::nullopt;
             if (!iInFixer)
             {
                 iFixer();
@@ -215,6 +218,7 @@ namespace neogfx
                 iSampler->release(id());
                 iSampler = nullptr;
             }
+            iStopsFingerprint = std::nullopt;
             if (!iInFixer)
             {
                 iFixer();
@@ -222,6 +226,40 @@ namespace neogfx
             }
             return iAlphaStops;
         }
+        uint64_t stops_fingerprint() const override
+        {
+            iFixer();
+            if (iStopsFingerprint == std::nullopt)
+            {
+                // 64-bit FNV-1a over the stop positions and values
+                uint64_t hash = 14695981039346656037ull;
+                auto mix = [&hash](uint64_t aValue)
+                {
+                    for (uint32_t byte = 0u; byte < 8u; ++byte, aValue >>= 8u)
+                        hash = (hash ^ (aValue & 0xFFu)) * 1099511628211ull;
+                };
+                auto position = [](scalar aPosition)
+                {
+                    uint64_t bits;
+                    std::memcpy(&bits, &aPosition, sizeof(bits));
+                    return bits;
+                };
+                mix(iColorStops.size());
+                for (auto const& stop : iColorStops)
+                {
+                    mix(position(stop.first()));
+                    mix(stop.second().as_argb());
+                }
+                mix(iAlphaStops.size());
+                for (auto const& stop : iAlphaStops)
+                {
+                    mix(position(stop.first()));
+                    mix(stop.second());
+                }
+                iStopsFingerprint = hash;
+            }
+            return *iStopsFingerprint;
+        }
         color_stop_list::const_iterator find_color_stop(scalar aPos, bool aToInsert = false) const override
         {
             auto colorStop = std::lower_bound(color_stops().begin(), color_stops().end(), color_stop{ aPos, sRGB_color{} },
@@ -556,6 +594,7 @@ namespace neogfx
         scalar iSmoothness = 0.0;
         optional_rect iBoundingBox;
         mutable const i_gradient_sampler* iSampler = nullptr;
+        mutable std::optional<uint64_t> iStopsFingerprint;
         mutable bool iColorStopsNeedFixing = true;
         mutable bool iAlphaStopsNeedFixing = true;
         bool iInFixer = false;
@@ -576,41 +615,61 @@ namespace neogfx
         gradients().clear();
     }
 
+    namespace
+    {
+#ifndef NDEBUG
+        template <typename ColorStops, typename AlphaStops>
+        bool same_stops(ColorStops const& aColorStops, AlphaStops const& aAlphaStops, i_gradient const& aGradient)
+        {
+            auto const& colorStops = aGradient.color_stops();
+            auto const& alphaStops = aGradient.alpha_stops();
+            if (aColorStops.size() != colorStops.size() || aAlphaStops.size() != alphaStops.size())
+                return false;
+            for (std::size_t i = 0u; i < colorStops.size(); ++i)
+                if (aColorStops[i].first() != colorStops[i].first() || !(aColorStops[i].second() == sRGB_color{ colorStops[i].second() }))
+                    return false;
+            for (std::size_t i = 0u; i < alphaStops.size(); ++i)
+                if (aAlphaStops[i].first() != alphaStops[i].first() || aAlphaStops[i].second() != alphaStops[i].second())
+                    return false;
+            return true;
+        }
+#endif
+    }
+
     i_gradient_sampler const& gradient_manager::sampler(i_gradient const& aGradient)
     {
-        thread_local std::pair<gradient::color_stop_list, gradient::alpha_stop_list> key;
-        key.first = aGradient.color_stops();
-        key.second = aGradient.alpha_stops();
+        auto const key = aGradient.stops_fingerprint();
         auto allocated = iAllocatedSamplers.find(key);
         if (allocated == iAllocatedSamplers.end())
         {
+            std::optional<gradient_sampler> sampler;
             if (!free_samplers().empty())
             {
-                allocated = iAllocatedSamplers.insert(std::make_pair(key, free_samplers().back())).first;
+                sampler.emplace(free_samplers().back());
                 free_samplers().pop_back();
             }
             else
             {
-                allocated = iAllocatedSamplers.insert(std::make_pair(key, iSamplerQueue.front()->second)).first;
-                iAllocatedSamplers.erase(iSamplerQueue.front());
+                auto leastRecentlyUsed = iAllocatedSamplers.find(iSamplerQueue.front());
+                sampler.emplace(leastRecentlyUsed->second.sampler);
                 iSamplerQueue.pop_front();
+                iAllocatedSamplers.erase(leastRecentlyUsed);
             }
-            allocated->second.release_all();
-            avec4u8 colorValues[i_gradient::MaxStops];
-            auto const cx = static_cast<uint32_t>(samplers().data().extents().cx);
-            for (uint32_t x = 0u; x < cx; ++x)
-            {
-                auto const color = aGradient.at(x, 0u, cx - 1u);
-                colorValues[x] = avec4u8{ color.red(), color.green(), color.blue(), color.alpha() };
-            }
-            samplers().data().set_pixels(rect{ basic_point<uint32_t>{ 0u, allocated->second.sampler_row() }, size_u32{ i_gradient::MaxStops, 1u } }, &colorValues[0]);
-        }
-        auto existingQueueEntry = std::find(iSamplerQueue.begin(), iSamplerQueue.end(), allocated);
-        if (existingQueueEntry != iSamplerQueue.end())
-            iSamplerQueue.erase(existingQueueEntry);
-        iSamplerQueue.push_back(allocated);
-        allocated->second.add_ref(aGradient.id());
-        return allocated->second;
+            allocated = iAllocatedSamplers.emplace(key, 
+                sampler_entry{ {}, {}, *sampler, iSamplerQueue.insert(iSamplerQueue.end(), key) }).first;
+            update_sampler(allocated->second, aGradient);
+        }
+        else
+        {
+            // a 64-bit fingerprint makes a collision vanishingly unlikely so the O(stops) comparison is a debug-only check
+#ifndef NDEBUG
+            if (!same_stops(allocated->second.colorStops, allocated->second.alphaStops, aGradient))
+                update_sampler(allocated->second, aGradient);
+#endif
+            iSamplerQueue.splice(iSamplerQueue.end(), iSamplerQueue, allocated->second.queuePosition);
+        }
+        allocated->second.sampler.add_ref(aGradient.id());
+        return allocated->second.sampler;
     }
 
     i_gradient_filter const& gradient_manager::filter(i_gradient const& aGradient)
@@ -619,25 +678,27 @@ namespace neogfx
         auto allocated = iAllocatedFilters.find(key);
         if (allocated == iAllocatedFilters.end())
         {
+            std::optional<gradient_filter> filter;
             if (!free_filters().empty())
             {
-                allocated = iAllocatedFilters.insert(std::make_pair(key, free_filters().back())).first;
+                filter.emplace(free_filters().back());
                 free_filters().pop_back();
             }
             else
             {
-                allocated = iAllocatedFilters.insert(std::make_pair(key, iFilterQueue.front()->second)).first;
-                iAllocatedFilters.erase(iFilterQueue.front());
+                auto leastRecentlyUsed = iAllocatedFilters.find(iFilterQueue.front());
+                filter.emplace(leastRecentlyUsed->second.filter);
                 iFilterQueue.pop_front();
+                iAllocatedFilters.erase(leastRecentlyUsed);
             }
+            allocated = iAllocatedFilters.emplace(key, filter_entry{ *filter, iFilterQueue.insert(iFilterQueue.end(), key) }).first;
             auto const filterValues = static_gaussian_filter<float, GRADIENT_FILTER_SIZE>(static_cast<float>(aGradient.smoothness() * 10.0));
-            allocated->second.sampler().data().set_pixels(rect{ point{}, size_u32{ GRADIENT_FILTER_SIZE, GRADIENT_FILTER_SIZE } }, &filterValues[0][0]);
+            static_cast<i_native_texture&>(allocated->second.filter.sampler().data().native_texture()).queue_pixels(
+                rect{ point{}, size_u32{ GRADIENT_FILTER_SIZE, GRADIENT_FILTER_SIZE } }, &filterValues[0][0]);
         }
-        auto existingQueueEntry = std::find(iFilterQueue.begin(), iFilterQueue.end(), allocated);
-        if (existingQueueEntry != iFilterQueue.end())
-            iFilterQueue.erase(existingQueueEntry);
-        iFilterQueue.push_back(allocated);
-        return allocated->second;
+        else
+            iFilterQueue.splice(iFilterQueue.end(), iFilterQueue, allocated->second.queuePosition);
+        return allocated->second.filter;
     }
 
     void gradient_manager::add_ref(gradient_id aId)
@@ -755,7 +816,7 @@ namespace neogfx
         if (iFreeSamplers == std::nullopt)
         {
             iFreeSamplers.emplace();
-            for (uint32_t row = 0; row < MaxSamplers; ++row)
+            for (uint32_t row = MaxSamplers; row-- > 0u;)
                 free_samplers().emplace_back(samplers(), row);
         }
         return *iFreeSamplers;
@@ -772,6 +833,23 @@ namespace neogfx
         return *iFreeFilters;
     }
 
+    void gradient_manager::update_sampler(sampler_entry& aEntry, i_gradient const& aGradient)
+    {
+        aEntry.colorStops = aGradient.color_stops();
+        aEntry.alphaStops = aGradient.alpha_stops();
+        aEntry.sampler.release_all();
+        avec4u8 colorValues[i_gradient::MaxStops];
+        auto const cx = static_cast<uint32_t>(samplers().data().extents().cx);
+        for (uint32_t x = 0u; x < cx; ++x)
+        {
+            auto const color = aGradient.at(x, 0u, cx - 1u);
+            colorValues[x] = avec4u8{ color.red(), color.green(), color.blue(), color.alpha() };
+        }
+        // rows are handed out in ascending order so rows regenerated in the same frame coalesce into a single upload
+        static_cast<i_native_texture&>(samplers().data().native_texture()).queue_pixels(
+            rect{ basic_point<uint32_t>{ 0u, aEntry.sampler.sampler_row() }, size_u32{ i_gradient::MaxStops, 1u } }, &colorValues[0]);
+    }
+
     void gradient_manager::cleanup()
     {
         for (auto i = gradients().begin(); i != gradients().end();)
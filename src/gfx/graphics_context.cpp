@@ -894,7 +894,7 @@ namespace neogfx
         draw_texture(aDestinationRect, aSource.render_target().target_texture(), aSourceRect);
     }
 
-    void blur(const i_graphics_context& aDestination, const rect& aDestinationRect, const i_graphics_context& aSource, const rect& aSourceRect, blurring_algorithm aAlgorithm, scalar aParameter1, scalar aParameter2)
+    void filter(const i_graphics_context& aDestination, const rect& aDestinationRect, const i_graphics_context& aSource, const rect& aSourceRect, std::optional<game::filter> const& aFilter)
     {
         scoped_render_target srt{ aDestination };
         auto mesh = aDestination.logical_coordinate_system() == logical_coordinate_system::AutomaticGui ?
@@ -913,7 +913,12 @@ namespace neogfx
                 shader_effect::Filter
             },
             optional_mat44{},
-            to_ecs_component(aAlgorithm, aParameter1, aParameter2));
+            aFilter);
+    }
+
+    void blur(const i_graphics_context& aDestination, const rect& aDestinationRect, const i_graphics_context& aSource, const rect& aSourceRect, blurring_algorithm aAlgorithm, scalar aParameter1, scalar aParameter2)
+    {
+        filter(aDestination, aDestinationRect, aSource, aSourceRect, to_ecs_component(aAlgorithm, aParameter1, aParameter2));
     }
 
     void graphics_context::blur(const rect& aDestinationRect, const i_graphics_context& aSource, const rect& aSourceRect, dimension aRadius, blurring_algorithm aAlgorithm, scalar aParameter1, scalar aParameter2) const
@@ -927,12 +932,64 @@ namespace neogfx
         int32_t passes = static_cast<int32_t>(aRadius);
         if (passes % 2 == 0)
             ++passes;
-        for (int32_t pass = 0; pass < passes; ++pass)
+        switch (aAlgorithm)
         {
-            if (pass % 2 == 0)
-                neogfx::blur(*this, aDestinationRect, aSource, aSourceRect, aAlgorithm, aParameter1, aParameter2);
-            else
-                neogfx::blur(aSource, aSourceRect, *this, aDestinationRect, aAlgorithm, aParameter1, aParameter2);
+        case blurring_algorithm::SeparableGaussian:
+            {
+                // a single 1D pass in each direction with the variance of 'passes' iterated 2D passes, capped at their reach
+                scalar const sigma = aParameter2 * std::sqrt(static_cast<scalar>(passes));
+                scalar const reach = std::min(std::ceil(sigma * 3.0), static_cast<scalar>(passes * (static_cast<int32_t>(aParameter1) / 2)));
+                scalar const kernelSize = reach * 2.0 + 1.0;
+                neogfx::filter(*this, aDestinationRect, aSource, aSourceRect, game::filter{ shader_filter::SeparableGaussianBlur, kernelSize, sigma, 0.0 });
+                neogfx::filter(aSource, aSourceRect, *this, aDestinationRect, game::filter{ shader_filter::SeparableGaussianBlur, kernelSize, sigma, 1.0 });
+                scoped_render_target srt{ *this };
+                blit(aDestinationRect, aSource, aSourceRect);
+            }
+            break;
+        case blurring_algorithm::DualKawase:
+            {
+                // each level halves the resolution of the previous one so the total work is bounded by a third of
+                // the source area whatever the radius; odd levels live in this context and even levels in the source
+                auto const levelBuffer = [&](std::size_t aLevel) -> i_graphics_context const& { return aLevel % 2 == 0 ? aSource : *this; };
+                std::vector<rect> levels{ aSourceRect };
+                uint32_t const iterations = std::max(1u, static_cast<uint32_t>(std::log2(std::max(aRadius, 2.0))));
+                while (levels.size() <= iterations && levels.back().cx >= 4.0 && levels.back().cy >= 4.0)
+                {
+                    auto const origin = levels.size() % 2 == 0 ? aSourceRect.top_left() : aDestinationRect.top_left();
+                    levels.emplace_back(origin, size{ std::ceil(levels.back().cx / 2.0), std::ceil(levels.back().cy / 2.0) });
+                }
+                // texels just beyond a level are stale data from a larger level so are cleared before being sampled
+                auto const clearMargin = [&](std::size_t aLevel)
+                {
+                    auto const& r = levels[aLevel];
+                    scoped_render_target srt{ levelBuffer(aLevel) };
+                    levelBuffer(aLevel).fill_rect(rect{ r.top_right(), size{ 2.0, r.cy + 2.0 } }, color{ vec4{ 0.0, 0.0, 0.0, 0.0 } });
+                    levelBuffer(aLevel).fill_rect(rect{ r.bottom_left(), size{ r.cx, 2.0 } }, color{ vec4{ 0.0, 0.0, 0.0, 0.0 } });
+                };
+                for (std::size_t level = 1; level < levels.size(); ++level)
+                {
+                    neogfx::filter(levelBuffer(level), levels[level], levelBuffer(level - 1), levels[level - 1], game::filter{ shader_filter::KawaseDownsample, aParameter2 });
+                    clearMargin(level);
+                }
+                for (std::size_t level = levels.size() - 1; level > 0; --level)
+                {
+                    neogfx::filter(levelBuffer(level - 1), levels[level - 1], levelBuffer(level), levels[level], game::filter{ shader_filter::KawaseUpsample, aParameter2 });
+                    if (level - 1 > 0)
+                        clearMargin(level - 1);
+                }
+                scoped_render_target srt{ *this };
+                blit(aDestinationRect, aSource, aSourceRect);
+            }
+            break;
+        default:
+            for (int32_t pass = 0; pass < passes; ++pass)
+            {
+                if (pass % 2 == 0)
+                    neogfx::blur(*this, aDestinationRect, aSource, aSourceRect, aAlgorithm, aParameter1, aParameter2);
+                else
+                    neogfx::blur(aSource, aSourceRect, *this, aDestinationRect, aAlgorithm, aParameter1, aParameter2);
+            }
+            break;
         }
     }
 
@@ -943,7 +1000,7 @@ namespace neogfx
 
     glyph_text graphics_context::to_glyph_text(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, const font& aFont) const
     {
-        return to_glyph_text(aTextBegin, aTextEnd, [&aFont](std::size_t) { return aFont; });
+        return service<i_font_manager>().glyph_text_factory().to_glyph_text(*this, std::string_view{ aTextBegin, aTextEnd }, aFont);
     }
 
     glyph_text graphics_context::to_glyph_text(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, std::function<font(std::size_t)> aFontSelector) const
@@ -958,7 +1015,7 @@ namespace neogfx
 
     glyph_text graphics_context::to_glyph_text(std::u32string::const_iterator aTextBegin, std::u32string::const_iterator aTextEnd, const font& aFont) const
     {
-        return to_glyph_text(aTextBegin, aTextEnd, [&aFont](std::size_t) { return aFont; });
+        return service<i_font_manager>().glyph_text_factory().to_glyph_text(*this, std::u32string_view{ aTextBegin, aTextEnd }, aFont);
     }
 
     glyph_text graphics_context::to_glyph_text(std::u32string::const_iterator aTextBegin, std::u32string::const_iterator aTextEnd, std::function<font(std::size_t)> aFontSelector) const
@@ -21,6 +21,8 @@
 
 #include <neogfx/neogfx.hpp>
 #include <neogfx/gfx/graphics_operations.hpp>
+#include <neogfx/gfx/text/font.hpp>
+#include <neogfx/gfx/text/i_glyph_texture.hpp>
 #include "native/i_native_texture.hpp"
 
 namespace neogfx
@@ -178,5 +180,249 @@ namespace neogfx
                 return false;
             }
         }
+
+        namespace
+        {
+            rect points_rect(std::initializer_list<point> aPoints)
+            {
+                point topLeft = *aPoints.begin();
+                point bottomRight = topLeft;
+                for (auto const& p : aPoints)
+                {
+                    topLeft = topLeft.min(p);
+                    bottomRight = bottomRight.max(p);
+                }
+                return rect{ topLeft, bottomRight };
+            }
+
+            rect mesh_rect(const game::mesh& aMesh, const vec3& aPosition)
+            {
+                if (aMesh.vertices.empty())
+                    return rect{ point{ aPosition }, size{} };
+                point minimum{ aMesh.vertices[0] };
+                point maximum = minimum;
+                for (auto const& v : aMesh.vertices)
+                {
+                    minimum = minimum.min(point{ v });
+                    maximum = maximum.max(point{ v });
+                }
+                return rect{ minimum + point{ aPosition }, maximum + point{ aPosition } };
+            }
+
+            rect stroked(const rect& aRect, const pen& aPen)
+            {
+                // allow for pen width and anti-aliasing fringe
+                return aRect.inflated(aPen.width() / 2.0 + 1.0, aPen.width() / 2.0 + 1.0);
+            }
+
+            std::optional<rect> glyphs_rect(const draw_glyphs& aDrawGlyphs)
+            {
+                // Glyphs not yet measured during layout have no texture so their extent is unknown; measuring here would
+                // rasterize glyphs on every flush. Measured glyphs are placed exactly as the rendering contexts place them.
+                auto const& glyphText = aDrawGlyphs.glyphText.content();
+                point const origin{ aDrawGlyphs.point.x, aDrawGlyphs.point.y };
+                scalar x = 0.0;
+                std::optional<rect> result;
+                for (auto g = aDrawGlyphs.begin; g != aDrawGlyphs.end; ++g)
+                {
+                    auto const& glyph = *g;
+                    if (!is_whitespace(glyph) && glyph.extents == basic_size<float>{})
+                        return {};
+                    auto const glyphAdvance = advance(glyph).cx;
+                    font const& glyphFont = glyphText.glyph_font(glyph);
+                    // the glyph's cell, which paper and underlines fill
+                    rect glyphRect{ origin + point{ x, 0.0 }, size{ glyphAdvance, glyphFont.height() } };
+                    if (is_emoji(glyph))
+                        glyphRect.combine(rect{ origin + point{ x, 0.0 } + glyph.offset.as<scalar>(), size{ glyphAdvance, glyphFont.height() } });
+                    else if (!is_whitespace(glyph))
+                    {
+                        auto const& glyphTexture = glyphText.glyph_texture(glyph);
+                        auto const glyphLeft = origin.x + x + glyphTexture.placement().x + glyph.offset.x;
+                        // the vertical placement depends on the logical coordinate system of the target so allow for both
+                        auto const gameTop = origin.y + (glyphTexture.placement().y + -glyphFont.descender()) + glyph.offset.y;
+                        auto const guiTop = origin.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - 
+                            glyphTexture.extents().cy + glyph.offset.y;
+                        glyphRect.combine(rect{ point{ glyphLeft, gameTop }, glyphTexture.extents() });
+                        glyphRect.combine(rect{ point{ glyphLeft, guiTop }, glyphTexture.extents() });
+                    }
+                    if (result == std::nullopt)
+                        result = glyphRect;
+                    else
+                        result->combine(glyphRect);
+                    x += glyphAdvance;
+                }
+                if (result == std::nullopt)
+                    return rect{ origin, size{} }.inflated(1.0, 1.0);
+                if (aDrawGlyphs.appearance.effect())
+                {
+                    auto const effectMargin = aDrawGlyphs.appearance.effect()->width() + aDrawGlyphs.appearance.effect()->aux1();
+                    result->inflate(effectMargin, effectMargin);
+                }
+                return result->inflated(1.0, 1.0);
+            }
+
+            bool overlapping(const rect& lhs, const rect& rhs)
+            {
+                return lhs.x < rhs.x + rhs.cx && rhs.x < lhs.x + lhs.cx &&
+                    lhs.y < rhs.y + rhs.cy && rhs.y < lhs.y + lhs.cy;
+            }
+        }
+
+        std::optional<rect> bounding_rect(const operation& aOperation)
+        {
+            switch (static_cast<operation_type>(aOperation.index()))
+            {
+            case operation_type::SetPixel:
+                return rect{ static_variant_cast<const set_pixel&>(aOperation).point, size{ 1.0, 1.0 } };
+            case operation_type::DrawPixel:
+                return rect{ static_variant_cast<const draw_pixel&>(aOperation).point, size{ 1.0, 1.0 } };
+            case operation_type::DrawLine:
+            {
+                auto& op = static_variant_cast<const draw_line&>(aOperation);
+                return stroked(points_rect({ op.from, op.to }), op.pen);
+            }
+            case operation_type::DrawRect:
+            {
+                auto& op = static_variant_cast<const draw_rect&>(aOperation);
+                return stroked(op.rect, op.pen);
+            }
+            case operation_type::DrawRoundedRect:
+            {
+                auto& op = static_variant_cast<const draw_rounded_rect&>(aOperation);
+                return stroked(op.rect, op.pen);
+            }
+            case operation_type::DrawCircle:
+            {
+                auto& op = static_variant_cast<const draw_circle&>(aOperation);
+                return stroked(rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }, op.pen);
+            }
+            case operation_type::DrawArc:
+            {
+                auto& op = static_variant_cast<const draw_arc&>(aOperation);
+                return stroked(rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }, op.pen);
+            }
+            case operation_type::DrawCubicBezier:
+            {
+                // a cubic bezier lies within the convex hull of its control points
+                auto& op = static_variant_cast<const draw_cubic_bezier&>(aOperation);
+                return stroked(points_rect({ op.p0, op.p1, op.p2, op.p3 }), op.pen);
+            }
+            case operation_type::DrawPath:
+            {
+                auto& op = static_variant_cast<const draw_path&>(aOperation);
+                return stroked(op.path.bounding_rect(), op.pen);
+            }
+            case operation_type::DrawShape:
+            {
+                auto& op = static_variant_cast<const draw_shape&>(aOperation);
+                return stroked(mesh_rect(op.mesh, op.position), op.pen);
+            }
+            case operation_type::FillRect:
+                return static_variant_cast<const fill_rect&>(aOperation).rect;
+            case operation_type::FillRoundedRect:
+                return static_variant_cast<const fill_rounded_rect&>(aOperation).rect.inflated(1.0, 1.0);
+            case operation_type::FillCheckerRect:
+                return static_variant_cast<const fill_checker_rect&>(aOperation).rect;
+            case operation_type::FillCircle:
+            {
+                auto& op = static_variant_cast<const fill_circle&>(aOperation);
+                return rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }.inflated(1.0, 1.0);
+            }
+            case operation_type::FillArc:
+            {
+                auto& op = static_variant_cast<const fill_arc&>(aOperation);
+                return rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }.inflated(1.0, 1.0);
+            }
+            case operation_type::FillPath:
+                return static_variant_cast<const fill_path&>(aOperation).path.bounding_rect().inflated(1.0, 1.0);
+            case operation_type::FillShape:
+            {
+                auto& op = static_variant_cast<const fill_shape&>(aOperation);
+                return mesh_rect(op.mesh, op.position).inflated(1.0, 1.0);
+            }
+            case operation_type::DrawGlyph:
+                return glyphs_rect(static_variant_cast<const draw_glyphs&>(aOperation));
+            default:
+                return {};
+            }
+        }
+
+        std::size_t reorder_for_batching(queue& aQueue, std::size_t aSearchWindow)
+        {
+            // Operations are collected into runs; an operation joins the nearest earlier run it is batchable
+            // with provided it does not overlap any operation in the runs after it (which it would then be
+            // drawn before). Runs are emitted when an operation without bounds (a state change or an operation
+            // of unknown extent) is reached, so no operation crosses a state change.
+            struct run
+            {
+                std::vector<std::size_t> operations;
+                rect bounds;
+            };
+
+            thread_local std::vector<run> tRuns;
+            thread_local std::vector<std::optional<rect>> tBounds;
+            thread_local std::vector<std::size_t> tOrder;
+
+            tRuns.clear();
+            tBounds.clear();
+            tOrder.clear();
+            tBounds.reserve(aQueue.size());
+            tOrder.reserve(aQueue.size());
+
+            std::size_t moved = 0u;
+            auto emit_runs = [&]()
+            {
+                for (auto& r : tRuns)
+                    tOrder.insert(tOrder.end(), r.operations.begin(), r.operations.end());
+                tRuns.clear();
+            };
+
+            for (std::size_t i = 0u; i < aQueue.size(); ++i)
+            {
+                tBounds.push_back(bounding_rect(aQueue[i]));
+                auto const& bounds = tBounds.back();
+                if (bounds == std::nullopt)
+                {
+                    emit_runs();
+                    tOrder.push_back(i);
+                    continue;
+                }
+                std::optional<std::size_t> target;
+                std::size_t searched = 0u;
+                for (auto r = tRuns.size(); r-- > 0u && searched++ < aSearchWindow;)
+                {
+                    auto const& candidate = tRuns[r];
+                    if (batchable(aQueue[candidate.operations.back()], aQueue[i]))
+                    {
+                        target = r;
+                        break;
+                    }
+                    if (overlapping(candidate.bounds, *bounds) && std::any_of(candidate.operations.begin(), candidate.operations.end(),
+                        [&](std::size_t j) { return overlapping(*tBounds[j], *bounds); }))
+                        break;
+                }
+                if (target != std::nullopt)
+                {
+                    auto& targetRun = tRuns[*target];
+                    targetRun.operations.push_back(i);
+                    targetRun.bounds.combine(*bounds);
+                    if (*target != tRuns.size() - 1u)
+                        ++moved;
+                }
+                else
+                    tRuns.push_back(run{ { i }, *bounds });
+            }
+            emit_runs();
+
+            if (moved != 0u)
+            {
+                queue result;
+                result.reserve(aQueue.size());
+                for (auto i : tOrder)
+                    result.push_back(std::move(aQueue[i]));
+                aQueue.swap(result);
+            }
+            return moved;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,1418 @@
+// graphics_operations_archive.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <neogfx/gfx/i_render_target.hpp>
+#include <neogfx/gfx/i_texture_manager.hpp>
+#include <neogfx/gfx/i_gradient_manager.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/graphics_operations_archive.hpp>
+
+namespace neogfx
+{
+    namespace graphics_operation
+    {
+        namespace
+        {
+            enum class record_type : uint8_t
+            {
+                Font        = 0x01,
+                Texture     = 0x02,
+                Gradient    = 0x03,
+                Frame       = 0x04
+            };
+
+            queue_writer* sCapture;
+
+            // Serializes operations into a frame buffer and collects the resources they reference.
+            class operation_writer
+            {
+            public:
+                operation_writer(std::ostream& aOutput) :
+                    iOutput{ aOutput }
+                {
+                }
+            public:
+                template <typename T>
+                void put(T const& aValue) requires(std::is_arithmetic_v<T>)
+                {
+                    iOutput.write(reinterpret_cast<char const*>(&aValue), sizeof(T));
+                }
+                template <typename T>
+                void put(T const& aValue) requires(std::is_enum_v<T>)
+                {
+                    put(static_cast<std::underlying_type_t<T>>(aValue));
+                }
+                template <typename T>
+                void put(std::optional<T> const& aValue)
+                {
+                    put(aValue != std::nullopt);
+                    if (aValue != std::nullopt)
+                        put(*aValue);
+                }
+                template <typename T>
+                void put(neolib::optional<T> const& aValue)
+                {
+                    put(aValue != std::nullopt);
+                    if (aValue != std::nullopt)
+                        put(*aValue);
+                }
+                void put(std::string const& aValue)
+                {
+                    put(static_cast<uint32_t>(aValue.size()));
+                    iOutput.write(aValue.data(), aValue.size());
+                }
+                void put(vec2 const& aValue)
+                {
+                    put(aValue.x);
+                    put(aValue.y);
+                }
+                void put(vec3 const& aValue)
+                {
+                    put(aValue.x);
+                    put(aValue.y);
+                    put(aValue.z);
+                }
+                void put(vec4 const& aValue)
+                {
+                    for (std::size_t i = 0; i < 4; ++i)
+                        put(aValue[i]);
+                }
+                void put(mat44 const& aValue)
+                {
+                    for (std::size_t c = 0; c < 4; ++c)
+                        for (std::size_t r = 0; r < 4; ++r)
+                            put(aValue[c][r]);
+                }
+                void put(point const& aValue)
+                {
+                    put(aValue.x);
+                    put(aValue.y);
+                }
+                void put(size const& aValue)
+                {
+                    put(aValue.cx);
+                    put(aValue.cy);
+                }
+                void put(rect const& aValue)
+                {
+                    put(aValue.position());
+                    put(aValue.extents());
+                }
+                void put(aabb_2d const& aValue)
+                {
+                    put(aValue.min);
+                    put(aValue.max);
+                }
+                void put(logical_coordinates const& aValue)
+                {
+                    put(aValue.bottomLeft);
+                    put(aValue.topRight);
+                }
+                void put(color const& aValue)
+                {
+                    put(aValue.red());
+                    put(aValue.green());
+                    put(aValue.blue());
+                    put(aValue.alpha());
+                }
+                void put(gradient const& aValue)
+                {
+                    put(static_cast<uint32_t>(aValue.color_stops().size()));
+                    for (auto const& stop : aValue.color_stops())
+                    {
+                        put(stop.first());
+                        put(sRGB_color{ stop.second() });
+                    }
+                    put(static_cast<uint32_t>(aValue.alpha_stops().size()));
+                    for (auto const& stop : aValue.alpha_stops())
+                    {
+                        put(stop.first());
+                        put(stop.second());
+                    }
+                    put(aValue.direction());
+                    put(std::holds_alternative<corner>(aValue.orientation()));
+                    if (std::holds_alternative<corner>(aValue.orientation()))
+                        put(std::get<corner>(aValue.orientation()));
+                    else
+                        put(std::get<scalar>(aValue.orientation()));
+                    put(aValue.shape());
+                    put(aValue.size());
+                    put(aValue.exponents());
+                    put(aValue.center());
+                    put(aValue.tile() != std::nullopt);
+                    if (aValue.tile() != std::nullopt)
+                    {
+                        put(aValue.tile()->extents);
+                        put(aValue.tile()->aligned);
+                    }
+                    put(aValue.smoothness());
+                    put(aValue.bounding_box());
+                }
+                void put(color_or_gradient const& aValue)
+                {
+                    if (std::holds_alternative<color>(aValue))
+                    {
+                        put(uint8_t{ 1u });
+                        put(std::get<color>(aValue));
+                    }
+                    else if (std::holds_alternative<gradient>(aValue))
+                    {
+                        put(uint8_t{ 2u });
+                        put(std::get<gradient>(aValue));
+                    }
+                    else
+                        put(uint8_t{ 0u });
+                }
+                void put(text_color const& aValue)
+                {
+                    put(static_cast<color_or_gradient const&>(aValue));
+                }
+                void put(pen const& aValue)
+                {
+                    put(aValue.color());
+                    put(aValue.width());
+                    put(aValue.anti_aliased());
+                    put(aValue.line_join());
+                    put(aValue.line_cap());
+                    put(aValue.miter_limit());
+                }
+                void put_texture(i_texture const& aValue)
+                {
+                    auto const& native = aValue.native_texture();
+                    put(native.id());
+                    iTextures.emplace(native.id(), &native);
+                }
+                void put(brush const& aValue)
+                {
+                    if (std::holds_alternative<color>(aValue))
+                    {
+                        put(uint8_t{ 1u });
+                        put(std::get<color>(aValue));
+                    }
+                    else if (std::holds_alternative<gradient>(aValue))
+                    {
+                        put(uint8_t{ 2u });
+                        put(std::get<gradient>(aValue));
+                    }
+                    else if (std::holds_alternative<texture>(aValue))
+                    {
+                        put(uint8_t{ 3u });
+                        put_texture(std::get<texture>(aValue));
+                    }
+                    else if (std::holds_alternative<std::pair<texture, rect>>(aValue))
+                    {
+                        put(uint8_t{ 4u });
+                        put_texture(std::get<std::pair<texture, rect>>(aValue).first);
+                        put(std::get<std::pair<texture, rect>>(aValue).second);
+                    }
+                    else if (std::holds_alternative<sub_texture>(aValue))
+                    {
+                        put(uint8_t{ 5u });
+                        put(std::get<sub_texture>(aValue));
+                    }
+                    else if (std::holds_alternative<std::pair<sub_texture, rect>>(aValue))
+                    {
+                        put(uint8_t{ 6u });
+                        put(std::get<std::pair<sub_texture, rect>>(aValue).first);
+                        put(std::get<std::pair<sub_texture, rect>>(aValue).second);
+                    }
+                    else
+                        put(uint8_t{ 0u });
+                }
+                void put(sub_texture const& aValue)
+                {
+                    put_texture(aValue.atlas_texture());
+                    put(aValue.atlas_location());
+                    put(aValue.extents());
+                }
+                void put(path const& aValue)
+                {
+                    put(aValue.shape());
+                    put(aValue.fill_rule());
+                    put(aValue.position());
+                    put(static_cast<uint32_t>(aValue.sub_paths().size()));
+                    for (auto const& subPath : aValue.sub_paths())
+                    {
+                        put(static_cast<uint32_t>(subPath.size()));
+                        for (auto const& p : subPath)
+                            put(p);
+                    }
+                }
+                void put(game::mesh const& aValue)
+                {
+                    put(static_cast<uint32_t>(aValue.vertices.size()));
+                    for (auto const& v : aValue.vertices)
+                        put(v);
+                    put(static_cast<uint32_t>(aValue.uv.size()));
+                    for (auto const& uv : aValue.uv)
+                        put(uv);
+                    put(static_cast<uint32_t>(aValue.faces.size()));
+                    for (auto const& f : aValue.faces)
+                    {
+                        put(f[0]);
+                        put(f[1]);
+                        put(f[2]);
+                    }
+                }
+                void put(game::texture const& aValue)
+                {
+                    auto const texture = service<i_texture_manager>().find_texture(aValue.id.cookie());
+                    put_texture(*texture);
+                    put(aValue.type);
+                    put(aValue.sampling);
+                    put(aValue.dpiScalingFactor);
+                    put(aValue.extents);
+                    put(aValue.subTexture);
+                }
+                void put(game::material const& aValue)
+                {
+                    put(aValue.color != std::nullopt);
+                    if (aValue.color != std::nullopt)
+                        put(aValue.color->rgba);
+                    put(aValue.gradient != std::nullopt);
+                    if (aValue.gradient != std::nullopt)
+                    {
+                        put(static_cast<gradient_id>(aValue.gradient->id.cookie()));
+                        put(aValue.gradient->boundingBox);
+                        iGradients.insert(static_cast<gradient_id>(aValue.gradient->id.cookie()));
+                    }
+                    std::optional<game::texture> materialTexture = aValue.texture;
+                    if (materialTexture == std::nullopt && aValue.sharedTexture != std::nullopt)
+                        materialTexture = *aValue.sharedTexture->ptr;
+                    put(materialTexture);
+                    put(aValue.shaderEffect);
+                    put(aValue.subpixel);
+                }
+                void put(game::filter const& aValue)
+                {
+                    put(aValue.type);
+                    put(aValue.arg1);
+                    put(aValue.arg2);
+                    put(aValue.arg3);
+                    put(aValue.arg4);
+                    put(aValue.boundingBox);
+                }
+                void put(glyph const& aValue)
+                {
+                    put(aValue.type.category);
+                    put(aValue.type.direction);
+                    put(aValue.value);
+                    put(aValue.flags);
+                    put(aValue.source.first);
+                    put(aValue.source.second);
+                    put(static_cast<uint32_t>(aValue.font));
+                    put(aValue.advance.cx);
+                    put(aValue.advance.cy);
+                    put(aValue.offset.x);
+                    put(aValue.offset.y);
+                    put(aValue.extents.cx);
+                    put(aValue.extents.cy);
+                    if (aValue.font != font_id{})
+                        iFonts.insert(aValue.font);
+                }
+                void put(text_effect const& aValue)
+                {
+                    put(aValue.type());
+                    put(aValue.color());
+                    put(aValue.width());
+                    put(aValue.aux1());
+                    put(aValue.ignore_emoji());
+                }
+                void put(text_appearance const& aValue)
+                {
+                    put(aValue.ink());
+                    put(aValue.paper());
+                    put(aValue.ignore_emoji());
+                    put(aValue.effect());
+                    put(aValue.only_calculate_effect());
+                    put(aValue.being_filtered());
+                }
+                void put(graphics_operation::draw_glyphs const& aValue)
+                {
+                    put(aValue.point);
+                    auto const& content = aValue.glyphText.content();
+                    auto existing = iGlyphTexts.find(&content);
+                    if (existing == iGlyphTexts.end())
+                    {
+                        // first use of this glyph text in the frame: write it inline
+                        existing = iGlyphTexts.emplace(&content, static_cast<uint32_t>(iGlyphTexts.size())).first;
+                        put(existing->second);
+                        put(static_cast<uint32_t>(content.glyph_font().id()));
+                        iFonts.insert(content.glyph_font().id());
+                        put(static_cast<uint32_t>(content.size()));
+                        for (auto const& g : content)
+                            put(g);
+                    }
+                    else
+                        put(existing->second);
+                    put(static_cast<uint32_t>(aValue.begin - content.cbegin()));
+                    put(static_cast<uint32_t>(aValue.end - content.cbegin()));
+                    put(aValue.appearance);
+                    put(aValue.showMnemonics);
+                }
+                bool put(operation const& aOperation)
+                {
+                    if (aOperation.index() == operation_type::DrawEntities || aOperation.index() == operation_type::Invalid)
+                        return false;
+                    put(static_cast<uint8_t>(aOperation.index()));
+                    switch (aOperation.index())
+                    {
+                    case operation_type::SetLogicalCoordinateSystem:
+                        put(std::get<set_logical_coordinate_system>(aOperation).system);
+                        break;
+                    case operation_type::SetLogicalCoordinates:
+                        put(std::get<set_logical_coordinates>(aOperation).coordinates);
+                        break;
+                    case operation_type::SetOrigin:
+                        put(std::get<set_origin>(aOperation).origin);
+                        break;
+                    case operation_type::SetViewport:
+                        put(std::get<set_viewport>(aOperation).rect);
+                        break;
+                    case operation_type::ScissorOn:
+                        put(std::get<scissor_on>(aOperation).rect);
+                        break;
+                    case operation_type::SetOpacity:
+                        put(std::get<set_opacity>(aOperation).opacity);
+                        break;
+                    case operation_type::SetBlendingMode:
+                        put(std::get<set_blending_mode>(aOperation).blendingMode);
+                        break;
+                    case operation_type::SetSmoothingMode:
+                        put(std::get<set_smoothing_mode>(aOperation).smoothingMode);
+                        break;
+                    case operation_type::PushLogicalOperation:
+                        put(std::get<push_logical_operation>(aOperation).logicalOperation);
+                        break;
+                    case operation_type::LineStippleOn:
+                        {
+                            auto const& op = std::get<line_stipple_on>(aOperation);
+                            put(op.factor);
+                            put(op.pattern);
+                            put(op.position);
+                        }
+                        break;
+                    case operation_type::Clear:
+                        put(std::get<clear>(aOperation).color);
+                        break;
+                    case operation_type::SetGradient:
+                        put(std::get<set_gradient>(aOperation).gradient);
+                        break;
+                    case operation_type::SetPixel:
+                        put(std::get<set_pixel>(aOperation).point);
+                        put(std::get<set_pixel>(aOperation).color);
+                        break;
+                    case operation_type::DrawPixel:
+                        put(std::get<draw_pixel>(aOperation).point);
+                        put(std::get<draw_pixel>(aOperation).color);
+                        break;
+                    case operation_type::DrawLine:
+                        {
+                            auto const& op = std::get<draw_line>(aOperation);
+                            put(op.from);
+                            put(op.to);
+                            put(op.pen);
+                        }
+                        break;
+                    case operation_type::DrawRect:
+                        put(std::get<draw_rect>(aOperation).rect);
+                        put(std::get<draw_rect>(aOperation).pen);
+                        break;
+                    case operation_type::DrawRoundedRect:
+                        {
+                            auto const& op = std::get<draw_rounded_rect>(aOperation);
+                            put(op.rect);
+                            put(op.radius);
+                            put(op.pen);
+                        }
+                        break;
+                    case operation_type::DrawCircle:
+                        {
+                            auto const& op = std::get<draw_circle>(aOperation);
+                            put(op.center);
+                            put(op.radius);
+                            put(op.pen);
+                            put(op.startAngle);
+                        }
+                        break;
+                    case operation_type::DrawArc:
+                        {
+                            auto const& op = std::get<draw_arc>(aOperation);
+                            put(op.center);
+                            put(op.radius);
+                            put(op.startAngle);
+                            put(op.endAngle);
+                            put(op.pen);
+                        }
+                        break;
+                    case operation_type::DrawCubicBezier:
+                        {
+                            auto const& op = std::get<draw_cubic_bezier>(aOperation);
+                            put(op.p0);
+                            put(op.p1);
+                            put(op.p2);
+                            put(op.p3);
+                            put(op.pen);
+                        }
+                        break;
+                    case operation_type::DrawPath:
+                        put(std::get<draw_path>(aOperation).path);
+                        put(std::get<draw_path>(aOperation).pen);
+                        break;
+                    case operation_type::DrawShape:
+                        {
+                            auto const& op = std::get<draw_shape>(aOperation);
+                            put(op.mesh);
+                            put(op.position);
+                            put(op.pen);
+                        }
+                        break;
+                    case operation_type::FillRect:
+                        {
+                            auto const& op = std::get<fill_rect>(aOperation);
+                            put(op.rect);
+                            put(op.fill);
+                            put(op.zpos);
+                        }
+                        break;
+                    case operation_type::FillRoundedRect:
+                        {
+                            auto const& op = std::get<fill_rounded_rect>(aOperation);
+                            put(op.rect);
+                            put(op.radius);
+                            put(op.fill);
+                        }
+                        break;
+                    case operation_type::FillCheckerRect:
+                        {
+                            auto const& op = std::get<fill_checker_rect>(aOperation);
+                            put(op.rect);
+                            put(op.squareSize);
+                            put(op.fill1);
+                            put(op.fill2);
+                            put(op.zpos);
+                        }
+                        break;
+                    case operation_type::FillCircle:
+                        {
+                            auto const& op = std::get<fill_circle>(aOperation);
+                            put(op.center);
+                            put(op.radius);
+                            put(op.fill);
+                        }
+                        break;
+                    case operation_type::FillArc:
+                        {
+                            auto const& op = std::get<fill_arc>(aOperation);
+                            put(op.center);
+                            put(op.radius);
+                            put(op.startAngle);
+                            put(op.endAngle);
+                            put(op.fill);
+                        }
+                        break;
+                    case operation_type::FillPath:
+                        put(std::get<fill_path>(aOperation).path);
+                        put(std::get<fill_path>(aOperation).fill);
+                        break;
+                    case operation_type::FillShape:
+                        {
+                            auto const& op = std::get<fill_shape>(aOperation);
+                            put(op.mesh);
+                            put(op.position);
+                            put(op.fill);
+                        }
+                        break;
+                    case operation_type::DrawGlyph:
+                        put(std::get<draw_glyphs>(aOperation));
+                        break;
+                    case operation_type::DrawMesh:
+                        {
+                            auto const& op = std::get<draw_mesh>(aOperation);
+                            put(op.mesh);
+                            put(op.material);
+                            put(op.transformation);
+                            put(op.filter);
+                        }
+                        break;
+                    default:
+                        // operations without arguments
+                        break;
+                    }
+                    return true;
+                }
+            public:
+                std::set<font_id> iFonts;
+                std::map<texture_id, i_texture const*> iTextures;
+                std::set<gradient_id> iGradients;
+            private:
+                std::ostream& iOutput;
+                std::map<i_glyph_text const*, uint32_t> iGlyphTexts;
+            };
+
+            class operation_reader
+            {
+            public:
+                operation_reader(std::istream& aInput, queue_reader const& aResources) :
+                    iInput{ aInput }, iResources{ aResources }
+                {
+                }
+            public:
+                template <typename T>
+                void get(T& aValue) requires(std::is_arithmetic_v<T>)
+                {
+                    if (!iInput.read(reinterpret_cast<char*>(&aValue), sizeof(T)))
+                        throw queue_reader::bad_archive();
+                }
+                template <typename T>
+                void get(T& aValue) requires(std::is_enum_v<T>)
+                {
+                    std::underlying_type_t<T> value;
+                    get(value);
+                    aValue = static_cast<T>(value);
+                }
+                // a corrupt archive must not yield an enumerator that the renderer would switch on without a case for it
+                template <typename T>
+                void get_enum(T& aValue, T aLast)
+                {
+                    typedef std::make_unsigned_t<std::underlying_type_t<T>> unsigned_type;
+                    std::underlying_type_t<T> value;
+                    get(value);
+                    if (static_cast<unsigned_type>(value) > static_cast<unsigned_type>(aLast))
+                        throw queue_reader::bad_archive();
+                    aValue = static_cast<T>(value);
+                }
+                void get(path_shape& aValue)
+                {
+                    get_enum(aValue, path_shape::Polygon);
+                }
+                void get(fill_rule& aValue)
+                {
+                    get_enum(aValue, fill_rule::EvenOdd);
+                }
+                void get(logical_coordinate_system& aValue)
+                {
+                    get_enum(aValue, logical_coordinate_system::AutomaticGame);
+                }
+                void get(line_join& aValue)
+                {
+                    get_enum(aValue, line_join::Bevel);
+                }
+                void get(line_cap& aValue)
+                {
+                    get_enum(aValue, line_cap::Round);
+                }
+                template <typename T>
+                T get()
+                {
+                    T value;
+                    get(value);
+                    return value;
+                }
+                template <typename T>
+                void get(std::optional<T>& aValue)
+                {
+                    if (get<bool>())
+                    {
+                        aValue.emplace();
+                        get(*aValue);
+                    }
+                    else
+                        aValue = std::nullopt;
+                }
+                template <typename T>
+                void get(neolib::optional<T>& aValue)
+                {
+                    if (get<bool>())
+                    {
+                        T value;
+                        get(value);
+                        aValue = value;
+                    }
+                    else
+                        aValue = std::nullopt;
+                }
+                void get(std::string& aValue)
+                {
+                    aValue.resize(get<uint32_t>());
+                    if (!iInput.read(aValue.data(), aValue.size()))
+                        throw queue_reader::bad_archive();
+                }
+                void get(vec2& aValue)
+                {
+                    get(aValue.x);
+                    get(aValue.y);
+                }
+                void get(vec3& aValue)
+                {
+                    get(aValue.x);
+                    get(aValue.y);
+                    get(aValue.z);
+                }
+                void get(vec4& aValue)
+                {
+                    for (std::size_t i = 0; i < 4; ++i)
+                        get(aValue[i]);
+                }
+                void get(mat44& aValue)
+                {
+                    for (std::size_t c = 0; c < 4; ++c)
+                        for (std::size_t r = 0; r < 4; ++r)
+                            get(aValue[c][r]);
+                }
+                void get(point& aValue)
+                {
+                    get(aValue.x);
+                    get(aValue.y);
+                }
+                void get(size& aValue)
+                {
+                    get(aValue.cx);
+                    get(aValue.cy);
+                }
+                void get(rect& aValue)
+                {
+                    point position;
+                    size extents;
+                    get(position);
+                    get(extents);
+                    aValue = rect{ position, extents };
+                }
+                void get(aabb_2d& aValue)
+                {
+                    get(aValue.min);
+                    get(aValue.max);
+                }
+                void get(logical_coordinates& aValue)
+                {
+                    get(aValue.bottomLeft);
+                    get(aValue.topRight);
+                }
+                void get(color& aValue)
+                {
+                    auto const r = get<color::component>();
+                    auto const g = get<color::component>();
+                    auto const b = get<color::component>();
+                    auto const a = get<color::component>();
+                    aValue = color{ r, g, b, a };
+                }
+                void get(gradient& aValue)
+                {
+                    gradient::color_stop_list colorStops;
+                    for (auto stops = get<uint32_t>(); stops > 0u; --stops)
+                    {
+                        auto const position = get<scalar>();
+                        color stopColor;
+                        get(stopColor);
+                        colorStops.push_back(gradient::color_stop{ position, stopColor });
+                    }
+                    gradient::alpha_stop_list alphaStops;
+                    for (auto stops = get<uint32_t>(); stops > 0u; --stops)
+                    {
+                        auto const position = get<scalar>();
+                        auto const alpha = get<sRGB_color::view_component>();
+                        alphaStops.push_back(gradient::alpha_stop{ position, alpha });
+                    }
+                    gradient result{ colorStops, alphaStops, get<gradient_direction>() };
+                    if (get<bool>())
+                        result.set_orientation(get<corner>());
+                    else
+                        result.set_orientation(get<scalar>());
+                    result.set_shape(get<gradient_shape>());
+                    result.set_size(get<gradient_size>());
+                    optional_vec2 exponents;
+                    get(exponents);
+                    result.set_exponents(exponents);
+                    optional_point center;
+                    get(center);
+                    result.set_center(center);
+                    if (get<bool>())
+                    {
+                        gradient_tile tile;
+                        get(tile.extents);
+                        get(tile.aligned);
+                        result.set_tile(tile);
+                    }
+                    result.set_smoothness(get<scalar>());
+                    optional_rect boundingBox;
+                    get(boundingBox);
+                    result.set_bounding_box(boundingBox);
+                    aValue = result;
+                }
+                void get(color_or_gradient& aValue)
+                {
+                    switch (get<uint8_t>())
+                    {
+                    case 1u:
+                        aValue = get<color>();
+                        break;
+                    case 2u:
+                        aValue = get<gradient>();
+                        break;
+                    default:
+                        aValue = color_or_gradient{};
+                        break;
+                    }
+                }
+                void get(text_color& aValue)
+                {
+                    get(static_cast<color_or_gradient&>(aValue));
+                }
+                void get(pen& aValue)
+                {
+                    auto const penColor = get<color_or_gradient>();
+                    auto const width = get<dimension>();
+                    auto const antiAliased = get<bool>();
+                    aValue = pen{ penColor, width, antiAliased };
+                    if (iResources.version() >= 3u)
+                    {
+                        aValue.set_line_join(get<line_join>());
+                        aValue.set_line_cap(get<line_cap>());
+                        aValue.set_miter_limit(get<scalar>());
+                    }
+                }
+                i_texture& get_texture()
+                {
+                    return const_cast<i_texture&>(iResources.mapped_texture(get<texture_id>()));
+                }
+                void get(sub_texture& aValue)
+                {
+                    auto& atlasTexture = get_texture();
+                    auto const atlasLocation = get<rect>();
+                    auto const extents = get<size>();
+                    aValue = sub_texture{ atlasTexture.id(), atlasTexture, atlasLocation, extents };
+                }
+                void get(brush& aValue)
+                {
+                    switch (get<uint8_t>())
+                    {
+                    case 1u:
+                        aValue = get<color>();
+                        break;
+                    case 2u:
+                        aValue = get<gradient>();
+                        break;
+                    case 3u:
+                        aValue = texture{ get_texture() };
+                        break;
+                    case 4u:
+                        {
+                            texture const brushTexture{ get_texture() };
+                            aValue = std::make_pair(brushTexture, get<rect>());
+                        }
+                        break;
+                    case 5u:
+                        aValue = get<sub_texture>();
+                        break;
+                    case 6u:
+                        {
+                            auto const brushTexture = get<sub_texture>();
+                            aValue = std::make_pair(brushTexture, get<rect>());
+                        }
+                        break;
+                    default:
+                        aValue = brush{};
+                        break;
+                    }
+                }
+                void get(path& aValue)
+                {
+                    path result{ get<path_shape>() };
+                    if (iResources.version() >= 2u)
+                        result.set_fill_rule(get<fill_rule>());
+                    result.set_position(get<point>());
+                    for (auto subPaths = get<uint32_t>(); subPaths > 0u; --subPaths)
+                    {
+                        result.sub_paths().push_back(path::sub_path_type{});
+                        for (auto points = get<uint32_t>(); points > 0u; --points)
+                            result.sub_paths().back().push_back(get<point>());
+                    }
+                    aValue = result;
+                }
+                void get(game::mesh& aValue)
+                {
+                    aValue.vertices.resize(get<uint32_t>());
+                    for (auto& v : aValue.vertices)
+                        get(v);
+                    aValue.uv.resize(get<uint32_t>());
+                    for (auto& uv : aValue.uv)
+                        get(uv);
+                    aValue.faces.resize(get<uint32_t>());
+                    for (auto& f : aValue.faces)
+                    {
+                        get(f[0]);
+                        get(f[1]);
+                        get(f[2]);
+                    }
+                }
+                void get(game::texture& aValue)
+                {
+                    auto const& mappedTexture = get_texture();
+                    aValue.id = neolib::cookie_ref_ptr{ service<i_texture_manager>(), mappedTexture.id() };
+                    get(aValue.type);
+                    get(aValue.sampling);
+                    get(aValue.dpiScalingFactor);
+                    get(aValue.extents);
+                    get(aValue.subTexture);
+                }
+                void get(game::material& aValue)
+                {
+                    aValue = game::material{};
+                    if (get<bool>())
+                        aValue.color = game::color{ get<vec4>() };
+                    if (get<bool>())
+                    {
+                        auto const& mappedGradient = iResources.mapped_gradient(get<gradient_id>());
+                        std::optional<aabb_2d> boundingBox;
+                        get(boundingBox);
+                        aValue.gradient = game::gradient{ neolib::cookie_ref_ptr{ service<i_gradient_manager>(), mappedGradient.id() }, boundingBox };
+                    }
+                    get(aValue.texture);
+                    get(aValue.shaderEffect);
+                    get(aValue.subpixel);
+                }
+                void get(game::filter& aValue)
+                {
+                    get(aValue.type);
+                    get(aValue.arg1);
+                    get(aValue.arg2);
+                    get(aValue.arg3);
+                    get(aValue.arg4);
+                    get(aValue.boundingBox);
+                }
+                void get(glyph& aValue)
+                {
+                    get(aValue.type.category);
+                    get(aValue.type.direction);
+                    get(aValue.value);
+                    get(aValue.flags);
+                    get(aValue.source.first);
+                    get(aValue.source.second);
+                    auto const fontId = static_cast<font_id>(get<uint32_t>());
+                    aValue.font = fontId != font_id{} ? iResources.mapped_font(fontId).id() : font_id{};
+                    get(aValue.advance.cx);
+                    get(aValue.advance.cy);
+                    get(aValue.offset.x);
+                    get(aValue.offset.y);
+                    get(aValue.extents.cx);
+                    get(aValue.extents.cy);
+                }
+                void get(text_effect& aValue)
+                {
+                    auto const type = get<text_effect_type>();
+                    auto const effectColor = get<text_color>();
+                    auto const width = get<dimension>();
+                    auto const aux1 = get<double>();
+                    auto const ignoreEmoji = get<bool>();
+                    aValue = text_effect{ type, effectColor, width, {}, aux1, ignoreEmoji };
+                }
+                void get(text_appearance& aValue)
+                {
+                    auto const ink = get<text_color>();
+                    optional_text_color paper;
+                    get(paper);
+                    auto const ignoreEmoji = get<bool>();
+                    optional_text_effect effect;
+                    get(effect);
+                    aValue = text_appearance{ ink, paper, effect }.with_emoji_ignored(ignoreEmoji);
+                    if (get<bool>())
+                        aValue = aValue.with_only_effect_calculation();
+                    if (get<bool>())
+                        aValue = aValue.as_being_filtered();
+                }
+                draw_glyphs get_draw_glyphs()
+                {
+                    auto const point = get<vec3>();
+                    auto const index = get<uint32_t>();
+                    if (index == iGlyphTexts.size())
+                    {
+                        auto const& defaultFont = iResources.mapped_font(static_cast<font_id>(get<uint32_t>()));
+                        glyph_text glyphText{ defaultFont };
+                        for (auto glyphs = get<uint32_t>(); glyphs > 0u; --glyphs)
+                        {
+                            auto const g = get<glyph>();
+                            if (g.font != font_id{})
+                                glyphText.content().cache_glyph_font(g.font);
+                            glyphText.content().push_back(g);
+                        }
+                        iGlyphTexts.push_back(glyphText);
+                    }
+                    else if (index > iGlyphTexts.size())
+                        throw queue_reader::bad_archive();
+                    auto const& glyphText = iGlyphTexts[index];
+                    auto const begin = get<uint32_t>();
+                    auto const end = get<uint32_t>();
+                    if (begin > end || end > glyphText.size())
+                        throw queue_reader::bad_archive();
+                    auto const appearance = get<text_appearance>();
+                    auto const showMnemonics = get<bool>();
+                    return draw_glyphs{ point, glyphText, glyphText.cbegin() + begin, glyphText.cbegin() + end, appearance, showMnemonics };
+                }
+                operation get_operation()
+                {
+                    switch (get<uint8_t>())
+                    {
+                    case operation_type::SetLogicalCoordinateSystem:
+                        return set_logical_coordinate_system{ get<logical_coordinate_system>() };
+                    case operation_type::SetLogicalCoordinates:
+                        return set_logical_coordinates{ get<logical_coordinates>() };
+                    case operation_type::SetOrigin:
+                        return set_origin{ get<point>() };
+                    case operation_type::SetViewport:
+                        return set_viewport{ get<std::optional<rect>>() };
+                    case operation_type::ScissorOn:
+                        return scissor_on{ get<rect>() };
+                    case operation_type::ScissorOff:
+                        return scissor_off{};
+                    case operation_type::SnapToPixelOn:
+                        return snap_to_pixel_on{};
+                    case operation_type::SnapToPixelOff:
+                        return snap_to_pixel_off{};
+                    case operation_type::SetOpacity:
+                        return set_opacity{ get<double>() };
+                    case operation_type::SetBlendingMode:
+                        return set_blending_mode{ get<blending_mode>() };
+                    case operation_type::SetSmoothingMode:
+                        return set_smoothing_mode{ get<smoothing_mode>() };
+                    case operation_type::PushLogicalOperation:
+                        return push_logical_operation{ get<logical_operation>() };
+                    case operation_type::PopLogicalOperation:
+                        return pop_logical_operation{};
+                    case operation_type::LineStippleOn:
+                        {
+                            auto const factor = get<scalar>();
+                            auto const pattern = get<uint16_t>();
+                            auto const position = get<scalar>();
+                            return line_stipple_on{ factor, pattern, position };
+                        }
+                    case operation_type::LineStippleOff:
+                        return line_stipple_off{};
+                    case operation_type::SubpixelRenderingOn:
+                        return subpixel_rendering_on{};
+                    case operation_type::SubpixelRenderingOff:
+                        return subpixel_rendering_off{};
+                    case operation_type::Clear:
+                        return clear{ get<color>() };
+                    case operation_type::ClearDepthBuffer:
+                        return clear_depth_buffer{};
+                    case operation_type::ClearStencilBuffer:
+                        return clear_stencil_buffer{};
+                    case operation_type::ClearGradient:
+                        return clear_gradient{};
+                    case operation_type::SetGradient:
+                        return set_gradient{ get<gradient>() };
+                    case operation_type::SetPixel:
+                        {
+                            auto const p = get<point>();
+                            return set_pixel{ p, get<color>() };
+                        }
+                    case operation_type::DrawPixel:
+                        {
+                            auto const p = get<point>();
+                            return draw_pixel{ p, get<color>() };
+                        }
+                    case operation_type::DrawLine:
+                        {
+                            auto const from = get<point>();
+                            auto const to = get<point>();
+                            return draw_line{ from, to, get<pen>() };
+                        }
+                    case operation_type::DrawRect:
+                        {
+                            auto const r = get<rect>();
+                            return draw_rect{ r, get<pen>() };
+                        }
+                    case operation_type::DrawRoundedRect:
+                        {
+                            auto const r = get<rect>();
+                            auto const radius = get<dimension>();
+                            return draw_rounded_rect{ r, radius, get<pen>() };
+                        }
+                    case operation_type::DrawCircle:
+                        {
+                            auto const center = get<point>();
+                            auto const radius = get<dimension>();
+                            auto const circlePen = get<pen>();
+                            return draw_circle{ center, radius, circlePen, get<angle>() };
+                        }
+                    case operation_type::DrawArc:
+                        {
+                            auto const center = get<point>();
+                            auto const radius = get<dimension>();
+                            auto const startAngle = get<angle>();
+                            auto const endAngle = get<angle>();
+                            return draw_arc{ center, radius, startAngle, endAngle, get<pen>() };
+                        }
+                    case operation_type::DrawCubicBezier:
+                        {
+                            auto const p0 = get<point>();
+                            auto const p1 = get<point>();
+                            auto const p2 = get<point>();
+                            auto const p3 = get<point>();
+                            return draw_cubic_bezier{ p0, p1, p2, p3, get<pen>() };
+                        }
+                    case operation_type::DrawPath:
+                        {
+                            auto const p = get<path>();
+                            return draw_path{ p, get<pen>() };
+                        }
+                    case operation_type::DrawShape:
+                        {
+                            auto const mesh = get<game::mesh>();
+                            auto const position = get<vec3>();
+                            return draw_shape{ mesh, position, get<pen>() };
+                        }
+                    case operation_type::FillRect:
+                        {
+                            auto const r = get<rect>();
+                            auto const fill = get<brush>();
+                            return fill_rect{ r, fill, get<scalar>() };
+                        }
+                    case operation_type::FillRoundedRect:
+                        {
+                            auto const r = get<rect>();
+                            auto const radius = get<dimension>();
+                            return fill_rounded_rect{ r, radius, get<brush>() };
+                        }
+                    case operation_type::FillCheckerRect:
+                        {
+                            auto const r = get<rect>();
+                            auto const squareSize = get<size>();
+                            auto const fill1 = get<brush>();
+                            auto const fill2 = get<brush>();
+                            return fill_checker_rect{ r, squareSize, fill1, fill2, get<scalar>() };
+                        }
+                    case operation_type::FillCircle:
+                        {
+                            auto const center = get<point>();
+                            auto const radius = get<dimension>();
+                            return fill_circle{ center, radius, get<brush>() };
+                        }
+                    case operation_type::FillArc:
+                        {
+                            auto const center = get<point>();
+                            auto const radius = get<dimension>();
+                            auto const startAngle = get<angle>();
+                            auto const endAngle = get<angle>();
+                            return fill_arc{ center, radius, startAngle, endAngle, get<brush>() };
+                        }
+                    case operation_type::FillPath:
+                        {
+                            auto const p = get<path>();
+                            return fill_path{ p, get<brush>() };
+                        }
+                    case operation_type::FillShape:
+                        {
+                            auto const mesh = get<game::mesh>();
+                            auto const position = get<vec3>();
+                            return fill_shape{ mesh, position, get<brush>() };
+                        }
+                    case operation_type::DrawGlyph:
+                        return get_draw_glyphs();
+                    case operation_type::DrawMesh:
+                        {
+                            auto const mesh = get<game::mesh>();
+                            auto const material = get<game::material>();
+                            auto const transformation = get<mat44>();
+                            return draw_mesh{ mesh, material, transformation, get<std::optional<game::filter>>() };
+                        }
+                    default:
+                        throw queue_reader::bad_archive();
+                    }
+                }
+            private:
+                std::istream& iInput;
+                queue_reader const& iResources;
+                std::vector<glyph_text> iGlyphTexts;
+            };
+        }
+
+        queue_writer::queue_writer(std::ostream& aOutput) :
+            iOutput{ aOutput },
+            iFramesWritten{ 0u },
+            iOperationsSkipped{ 0u }
+        {
+            operation_writer header{ iOutput };
+            header.put(ArchiveMagic);
+            header.put(ArchiveVersion);
+            if (!iOutput)
+                throw bad_stream();
+        }
+
+        queue_writer::~queue_writer()
+        {
+            if (sCapture == this)
+                sCapture = nullptr;
+        }
+
+        void queue_writer::write(i_rendering_context const& aContext)
+        {
+            if (sCapture == this && iFrameLimit != std::nullopt && iFramesWritten >= *iFrameLimit)
+            {
+                end_capture();
+                return;
+            }
+            // frames share queue storage with the context; copying here keeps the writer independent of flush()
+            write(frame{ aContext.render_target().extents(), aContext.logical_coordinate_system(), aContext.queue() });
+        }
+
+        void queue_writer::write(frame const& aFrame)
+        {
+            std::ostringstream buffer;
+            operation_writer frameWriter{ buffer };
+            frameWriter.put(aFrame.extents);
+            frameWriter.put(aFrame.logicalCoordinateSystem);
+            uint32_t operationCount = 0u;
+            std::ostringstream operations;
+            operation_writer operationWriter{ operations };
+            for (auto const& op : aFrame.operations)
+                if (operationWriter.put(op))
+                    ++operationCount;
+                else
+                    ++iOperationsSkipped;
+            frameWriter.put(operationCount);
+            buffer << operations.str();
+
+            for (auto const& font : operationWriter.iFonts)
+                if (iFonts.insert(font).second)
+                    write_font(font);
+            for (auto const& texture : operationWriter.iTextures)
+                if (iTextures.insert(texture.first).second)
+                    write_texture(*texture.second);
+            for (auto const& gradient : operationWriter.iGradients)
+                if (iGradients.insert(gradient).second)
+                    write_gradient(gradient);
+
+            auto const frameData = buffer.str();
+            operation_writer record{ iOutput };
+            record.put(record_type::Frame);
+            record.put(static_cast<uint64_t>(frameData.size()));
+            iOutput.write(frameData.data(), frameData.size());
+            if (!iOutput)
+                throw bad_stream();
+            ++iFramesWritten;
+        }
+
+        uint32_t queue_writer::frames_written() const
+        {
+            return iFramesWritten;
+        }
+
+        uint32_t queue_writer::operations_skipped() const
+        {
+            return iOperationsSkipped;
+        }
+
+        void queue_writer::begin_capture(std::optional<uint32_t> const& aFrameLimit)
+        {
+            if (sCapture != nullptr && sCapture != this)
+                throw capture_active();
+            iFrameLimit = aFrameLimit != std::nullopt ? std::optional<uint32_t>{ iFramesWritten + *aFrameLimit } : std::nullopt;
+            sCapture = this;
+        }
+
+        void queue_writer::end_capture()
+        {
+            if (sCapture == this)
+                sCapture = nullptr;
+            iOutput.flush();
+        }
+
+        queue_writer* queue_writer::capture()
+        {
+            return sCapture;
+        }
+
+        void queue_writer::write_font(font_id aFont)
+        {
+            auto const& recordedFont = service<i_font_manager>().font_from_id(aFont);
+            operation_writer record{ iOutput };
+            record.put(record_type::Font);
+            record.put(static_cast<uint32_t>(aFont));
+            record.put(recordedFont.family_name().to_std_string());
+            record.put(recordedFont.style());
+            record.put(recordedFont.style_name_available());
+            if (recordedFont.style_name_available())
+                record.put(recordedFont.style_name().to_std_string());
+            record.put(recordedFont.size());
+        }
+
+        void queue_writer::write_texture(i_texture const& aTexture)
+        {
+            operation_writer record{ iOutput };
+            record.put(record_type::Texture);
+            record.put(aTexture.id());
+            record.put(aTexture.extents());
+            record.put(aTexture.dpi_scale_factor());
+            record.put(aTexture.sampling());
+            // texels are written in storage order as RGBA8
+            auto const extents = aTexture.extents().as<uint32_t>();
+            std::vector<uint8_t> texels;
+            texels.reserve(static_cast<std::size_t>(extents.cx) * extents.cy * 4u);
+            for (uint32_t y = 0; y < extents.cy; ++y)
+                for (uint32_t x = 0; x < extents.cx; ++x)
+                {
+                    auto const texel = aTexture.get_pixel(point{ static_cast<coordinate>(x), static_cast<coordinate>(y) });
+                    texels.push_back(texel.red());
+                    texels.push_back(texel.green());
+                    texels.push_back(texel.blue());
+                    texels.push_back(texel.alpha());
+                }
+            iOutput.write(reinterpret_cast<char const*>(texels.data()), texels.size());
+        }
+
+        void queue_writer::write_gradient(gradient_id aGradient)
+        {
+            operation_writer record{ iOutput };
+            record.put(record_type::Gradient);
+            record.put(aGradient);
+            record.put(gradient{ service<i_gradient_manager>().find_gradient(aGradient) });
+        }
+
+        queue_reader::queue_reader(std::istream& aInput) :
+            iInput{ aInput }, iVersion{ 0u }
+        {
+            operation_reader header{ iInput, *this };
+            if (header.get<uint32_t>() != ArchiveMagic)
+                throw bad_archive();
+            iVersion = header.get<uint32_t>();
+            if (iVersion > ArchiveVersion)
+                throw unsupported_version();
+        }
+
+        queue_reader::~queue_reader()
+        {
+        }
+
+        bool queue_reader::read(frame& aFrame)
+        {
+            operation_reader record{ iInput, *this };
+            while (iInput.peek() != std::char_traits<char>::eof())
+            {
+                switch (record.get<record_type>())
+                {
+                case record_type::Font:
+                    read_font();
+                    break;
+                case record_type::Texture:
+                    read_texture();
+                    break;
+                case record_type::Gradient:
+                    read_gradient();
+                    break;
+                case record_type::Frame:
+                    {
+                        record.get<uint64_t>();
+                        operation_reader frameReader{ iInput, *this };
+                        aFrame.extents = frameReader.get<size>();
+                        aFrame.logicalCoordinateSystem = frameReader.get<logical_coordinate_system>();
+                        aFrame.operations.clear();
+                        auto const operationCount = frameReader.get<uint32_t>();
+                        aFrame.operations.reserve(operationCount);
+                        for (uint32_t op = 0; op < operationCount; ++op)
+                            aFrame.operations.push_back(frameReader.get_operation());
+                    }
+                    return true;
+                default:
+                    throw bad_archive();
+                }
+            }
+            return false;
+        }
+
+        std::vector<frame> queue_reader::read_all()
+        {
+            std::vector<frame> result;
+            frame next;
+            while (read(next))
+                result.push_back(std::move(next));
+            return result;
+        }
+
+        uint32_t queue_reader::version() const
+        {
+            return iVersion;
+        }
+
+        font const& queue_reader::mapped_font(font_id aFont) const
+        {
+            auto existing = iFonts.find(aFont);
+            if (existing == iFonts.end())
+                throw resource_not_found();
+            return existing->second;
+        }
+
+        i_texture const& queue_reader::mapped_texture(texture_id aTexture) const
+        {
+            auto existing = iTextures.find(aTexture);
+            if (existing == iTextures.end())
+                throw resource_not_found();
+            return existing->second;
+        }
+
+        gradient const& queue_reader::mapped_gradient(gradient_id aGradient) const
+        {
+            auto existing = iGradients.find(aGradient);
+            if (existing == iGradients.end())
+                throw resource_not_found();
+            return existing->second;
+        }
+
+        void queue_reader::read_font()
+        {
+            operation_reader record{ iInput, *this };
+            auto const id = static_cast<font_id>(record.get<uint32_t>());
+            auto const familyName = record.get<std::string>();
+            auto const style = record.get<font_style>();
+            auto const styleName = record.get<bool>() ? std::optional<std::string>{ record.get<std::string>() } : std::nullopt;
+            auto const pointSize = record.get<font::point_size>();
+            iFonts.insert_or_assign(id, styleName ? font{ familyName, *styleName, pointSize } : font{ familyName, style, pointSize });
+        }
+
+        void queue_reader::read_texture()
+        {
+            operation_reader record{ iInput, *this };
+            auto const id = record.get<texture_id>();
+            auto const extents = record.get<size>();
+            auto const dpiScaleFactor = record.get<dimension>();
+            auto sampling = record.get<texture_sampling>();
+            if (sampling == texture_sampling::Multisample)
+                sampling = texture_sampling::Normal;
+            auto const storage = extents.as<uint32_t>();
+            std::vector<uint8_t> texels(static_cast<std::size_t>(storage.cx) * storage.cy * 4u);
+            if (!iInput.read(reinterpret_cast<char*>(texels.data()), texels.size()))
+                throw bad_archive();
+            texture recreated{ extents, dpiScaleFactor, sampling };
+            if (!texels.empty())
+                recreated.set_pixels(rect{ point{}, extents }, texels.data());
+            iTextures.insert_or_assign(id, recreated);
+        }
+
+        void queue_reader::read_gradient()
+        {
+            operation_reader record{ iInput, *this };
+            auto const id = record.get<gradient_id>();
+            iGradients.insert_or_assign(id, record.get<gradient>());
+        }
+    }
+}
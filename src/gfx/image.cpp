@@ -24,6 +24,7 @@
 #include <neolib/core/string_utils.hpp>
 #include <neogfx/gfx/image.hpp>
 #include <neogfx/app/resource_manager.hpp>
+#include <neogfx/gfx/i_graphics_context.hpp>
 
 namespace neogfx
 {
@@ -322,6 +323,68 @@ namespace neogfx
         }
     }
 
+    namespace
+    {
+        inline void accumulate(float* aAccumulator, float const* aSource, std::size_t aCount, float aWeight)
+        {
+            for (std::size_t i = 0; i < aCount; ++i)
+                aAccumulator[i] += aWeight * aSource[i];
+        }
+    }
+
+    void image::blur(dimension aRadius, std::optional<scalar> const& aSigma)
+    {
+        auto const radius = static_cast<int32_t>(std::ceil(aRadius));
+        auto const width = static_cast<int32_t>(iSize.cx);
+        auto const height = static_cast<int32_t>(iSize.cy);
+        if (radius <= 0 || width <= 0 || height <= 0 || iColorFormat != neogfx::color_format::RGBA8)
+            return;
+        auto const kernel = separable_gaussian_filter<float>(static_cast<uint32_t>(radius * 2 + 1), static_cast<float>(aSigma.value_or(aRadius / 3.0)));
+        std::size_t const stride = static_cast<std::size_t>(width) * 4u;
+        // premultiplied so that transparent texels do not darken their neighbours
+        std::vector<float> pixels(stride * height);
+        for (std::size_t i = 0; i < pixels.size(); i += 4u)
+        {
+            float const alpha = iData[i + 3u] / 255.0f;
+            pixels[i + 0u] = iData[i + 0u] * alpha;
+            pixels[i + 1u] = iData[i + 1u] * alpha;
+            pixels[i + 2u] = iData[i + 2u] * alpha;
+            pixels[i + 3u] = iData[i + 3u];
+        }
+        std::vector<float> horizontal(pixels.size(), 0.0f);
+        for (int32_t y = 0; y < height; ++y)
+        {
+            float const* source = &pixels[y * stride];
+            float* destination = &horizontal[y * stride];
+            for (int32_t k = -radius; k <= radius; ++k)
+            {
+                // destination pixels whose tap k falls inside the row
+                int32_t const first = std::max(0, -k);
+                int32_t const last = std::min(width, width - k);
+                if (first < last)
+                    accumulate(destination + first * 4, source + (first + k) * 4, static_cast<std::size_t>(last - first) * 4u, kernel[k + radius]);
+            }
+        }
+        std::fill(pixels.begin(), pixels.end(), 0.0f);
+        for (int32_t y = 0; y < height; ++y)
+        {
+            int32_t const first = std::max(0, y - radius);
+            int32_t const last = std::min(height - 1, y + radius);
+            for (int32_t sy = first; sy <= last; ++sy)
+                accumulate(&pixels[y * stride], &horizontal[sy * stride], stride, kernel[sy - y + radius]);
+        }
+        for (std::size_t i = 0; i < pixels.size(); i += 4u)
+        {
+            float const alpha = std::clamp(pixels[i + 3u], 0.0f, 255.0f);
+            float const unpremultiply = alpha > 0.0f ? 255.0f / alpha : 0.0f;
+            iData[i + 0u] = static_cast<uint8_t>(std::clamp(pixels[i + 0u] * unpremultiply + 0.5f, 0.0f, 255.0f));
+            iData[i + 1u] = static_cast<uint8_t>(std::clamp(pixels[i + 1u] * unpremultiply + 0.5f, 0.0f, 255.0f));
+            iData[i + 2u] = static_cast<uint8_t>(std::clamp(pixels[i + 2u] * unpremultiply + 0.5f, 0.0f, 255.0f));
+            iData[i + 3u] = static_cast<uint8_t>(alpha + 0.5f);
+        }
+        iHash = std::nullopt;
+    }
+
     bool image::has_resource() const
     {
         return iResource != nullptr;
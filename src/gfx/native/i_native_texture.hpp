@@ -33,6 +33,8 @@ namespace neogfx
     public:
         virtual void* handle() const = 0;
         virtual bool is_resident() const = 0;
+        // like set_pixels but deferred until the texture manager next flushes its uploads
+        virtual void queue_pixels(const rect& aRect, const void* aPixelData, uint32_t aPackAlignment = 4u) = 0;
     public:
         virtual size extents() const = 0;
     public:
@@ -21,7 +21,13 @@
 
 #include <neogfx/neogfx.hpp>
 #include <vector>
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
 #include <neogfx/gfx/color.hpp>
+#include <neogfx/gfx/free_list.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
 #include <neogfx/gfx/i_shader_program.hpp>
@@ -153,19 +159,11 @@ namespace neogfx
         {
             return *std::prev(end());
         }
+        // Returns the start of the smallest reclaimed block that can hold aCount elements or, if there is none,
+        // size() (i.e. the caller appends).
         std::size_t find_space_for(std::size_t aCount)
         {
-             // todo: optimize
-            for (auto space = iReclaimedSpace.begin(); space != iReclaimedSpace.end(); ++space)
-                if (space->second - space->first >= aCount)
-                {
-                    auto result = space->first;
-                    space->first += aCount;
-                    if (space->first == space->second)
-                        iReclaimedSpace.erase(space);
-                    return result;
-                }
-            return size();
+            return iFreeList.allocate(aCount).value_or(size());
         }
         void push_back(const_reference aValue)
         {
@@ -180,13 +178,20 @@ namespace neogfx
             new (map() + iSize) value_type{ std::forward<Args>(aArgs)... };
             ++iSize;
         }
+        // Appends aCount elements without initializing them; for trivially copyable types whose storage is written later.
+        void extend(size_type aCount)
+        {
+            need(aCount);
+            iSize += aCount;
+        }
         void pop_back()
         {
             --iSize;
         }
         void clear()
         {
-            iSize = 0;
+            iSize = iRegionStart;
+            iFreeList.clear();
         }
     public:
         GLuint handle() const
@@ -222,9 +227,25 @@ namespace neogfx
             }
         }
     public:
+        // Writes can be confined to a region of the buffer (see opengl_vertex_buffer::next_region); clear() rewinds
+        // to the start of the region and room() is measured to its end.
+        void set_region(size_type aStart, size_type aEnd)
+        {
+            iRegionStart = aStart;
+            iRegionEnd = aEnd;
+            clear();
+        }
+        size_type region_start() const
+        {
+            return iRegionStart;
+        }
+        size_type region_end() const
+        {
+            return iRegionEnd != 0 ? iRegionEnd : capacity();
+        }
         size_type room() const
         {
-            return capacity() - size();
+            return region_end() - size();
         }
         bool room_for(size_type aExtra) const
         {
@@ -238,8 +259,20 @@ namespace neogfx
     public:
         void reclaim(std::size_t aStartIndex, std::size_t aEndIndex)
         {
-            if (aEndIndex != aStartIndex)
-                iReclaimedSpace.push_back(std::make_pair(aStartIndex, aEndIndex));
+            // trailing free space is given back to the append region
+            iSize = iFreeList.release(aStartIndex, aEndIndex, size());
+        }
+        buffer_allocation_statistics statistics() const
+        {
+            buffer_allocation_statistics result;
+            result.size = size();
+            result.capacity = capacity();
+            result.freeElements = iFreeList.free_elements();
+            result.freeBlocks = iFreeList.free_blocks();
+            result.largestFreeBlock = iFreeList.largest_block();
+            result.grows = iGrows;
+            result.coalesces = iFreeList.coalesces();
+            return result;
         }
     private:
         void grow(size_type aCapacity)
@@ -255,7 +288,8 @@ namespace neogfx
             std::swap(iCapacity, temp.iCapacity);
             std::swap(iSize, temp.iSize);
             std::swap(iMemory, temp.iMemory);
-            std::swap(iReclaimedSpace, temp.iReclaimedSpace);
+            iRegionEnd = 0; // the current region extends to the end of the new storage
+            ++iGrows;
             iOwner->buffer_grown();
         }
     private:
@@ -264,7 +298,10 @@ namespace neogfx
         size_type iSize = 0;
         mutable pointer iMemory = nullptr;
         opengl_buffer_owner* iOwner = nullptr;
-        std::vector<std::pair<std::size_t, std::size_t>> iReclaimedSpace;
+        size_type iRegionStart = 0;
+        size_type iRegionEnd = 0;
+        free_list iFreeList;
+        uint32_t iGrows = 0;
     };
 
     template <typename T>
@@ -276,6 +313,44 @@ namespace neogfx
     template <>
     struct opengl_attrib_data_type<uint8_t> { static constexpr GLenum type = GL_UNSIGNED_BYTE; };
 
+    // IEEE 754 binary16 storage for GL_HALF_FLOAT vertex attributes
+    struct half_float
+    {
+        uint16_t bits = 0u;
+
+        half_float() = default;
+        half_float(float aValue) : bits{ to_bits(aValue) }
+        {
+        }
+
+        static uint16_t to_bits(float aValue)
+        {
+            uint32_t f;
+            std::memcpy(&f, &aValue, sizeof(f));
+            uint32_t const sign = (f >> 16u) & 0x8000u;
+            uint32_t const biasedExponent = (f >> 23u) & 0xFFu;
+            uint32_t mantissa = f & 0x007FFFFFu;
+            if (biasedExponent == 0xFFu)
+                return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0u ? 0x0200u : 0u));
+            int32_t const exponent = static_cast<int32_t>(biasedExponent) - 127 + 15;
+            if (exponent >= 0x1F)
+                return static_cast<uint16_t>(sign | 0x7C00u);
+            if (exponent <= 0)
+            {
+                if (exponent < -10)
+                    return static_cast<uint16_t>(sign);
+                mantissa |= 0x00800000u;
+                auto const shift = static_cast<uint32_t>(14 - exponent);
+                return static_cast<uint16_t>(sign | ((mantissa + (1u << (shift - 1u))) >> shift));
+            }
+            // a rounding carry out of the mantissa correctly increments the exponent
+            return static_cast<uint16_t>(sign | ((static_cast<uint32_t>(exponent) << 10u) + ((mantissa + 0x00001000u) >> 13u)));
+        }
+    };
+
+    template <>
+    struct opengl_attrib_data_type<half_float> { static constexpr GLenum type = GL_HALF_FLOAT; };
+
     template <typename Vertex, typename Attrib>
     class opengl_vertex_attrib_array
     {
@@ -330,6 +405,15 @@ namespace neogfx
         return vec4f{{ aSource[0] / 255.0f, aSource[1] / 255.0f, aSource[2] / 255.0f, aSource[3] / 255.0f }};
     }
 
+    typedef std::array<uint8_t, 4> vertex_color_u8;
+    typedef std::array<half_float, 2> vertex_uv_f16;
+
+    inline vertex_color_u8 vec4f_to_vertex_color(const vec4f& aSource)
+    {
+        auto to_u8 = [](float aComponent) { return static_cast<uint8_t>(std::clamp(aComponent, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        return vertex_color_u8{ to_u8(aSource[0]), to_u8(aSource[1]), to_u8(aSource[2]), to_u8(aSource[3]) };
+    }
+
     struct standard_vertex
     {
         vec3f xyz;
@@ -344,6 +428,9 @@ namespace neogfx
             xyz{ xyz }, rgba{ rgba }, st{ st }, xyzw{ xyzw }
         {
         }
+        static constexpr bool normalized_color = false;
+        static constexpr bool has_uv = true;
+        static constexpr bool has_function = true;
         struct offset
         {
             static constexpr std::size_t xyz = 0u;
@@ -353,13 +440,161 @@ namespace neogfx
         };
     };
 
+    // Compact vertex formats; the color is stored as normalized u8 RGBA and texture coordinates as half floats.
+    // Attributes a format omits are left disabled so the shader sees their default (zero) value.
+
+    struct color_vertex
+    {
+        vec3f xyz;
+        vertex_color_u8 rgba;
+        color_vertex(const vec3f& xyz = vec3f{}) :
+            xyz{ xyz }, rgba{}
+        {
+        }
+        color_vertex(const vec3f& xyz, const vec4f& rgba, const vec2f& = {}, const vec4f& = {}) :
+            xyz{ xyz }, rgba{ vec4f_to_vertex_color(rgba) }
+        {
+        }
+        static constexpr bool normalized_color = true;
+        static constexpr bool has_uv = false;
+        static constexpr bool has_function = false;
+        struct offset
+        {
+            static constexpr std::size_t xyz = 0u;
+            static constexpr std::size_t rgba = xyz + sizeof(decltype(color_vertex::xyz));
+        };
+    };
+
+    struct texture_vertex
+    {
+        vec3f xyz;
+        vertex_color_u8 rgba;
+        vertex_uv_f16 st;
+        texture_vertex(const vec3f& xyz = vec3f{}) :
+            xyz{ xyz }, rgba{}, st{}
+        {
+        }
+        texture_vertex(const vec3f& xyz, const vec4f& rgba, const vec2f& st = {}, const vec4f& = {}) :
+            xyz{ xyz }, rgba{ vec4f_to_vertex_color(rgba) }, st{ half_float{ st.x }, half_float{ st.y } }
+        {
+        }
+        static constexpr bool normalized_color = true;
+        static constexpr bool has_uv = true;
+        static constexpr bool has_function = false;
+        struct offset
+        {
+            static constexpr std::size_t xyz = 0u;
+            static constexpr std::size_t rgba = xyz + sizeof(decltype(texture_vertex::xyz));
+            static constexpr std::size_t st = rgba + sizeof(decltype(texture_vertex::rgba));
+        };
+    };
+
+    struct function_vertex
+    {
+        vec3f xyz;
+        vertex_color_u8 rgba;
+        vec4f xyzw;
+        function_vertex(const vec3f& xyz = vec3f{}) :
+            xyz{ xyz }, rgba{}
+        {
+        }
+        function_vertex(const vec3f& xyz, const vec4f& rgba, const vec2f& = {}, const vec4f& xyzw = {}) :
+            xyz{ xyz }, rgba{ vec4f_to_vertex_color(rgba) }, xyzw{ xyzw }
+        {
+        }
+        static constexpr bool normalized_color = true;
+        static constexpr bool has_uv = false;
+        static constexpr bool has_function = true;
+        struct offset
+        {
+            static constexpr std::size_t xyz = 0u;
+            static constexpr std::size_t rgba = xyz + sizeof(decltype(function_vertex::xyz));
+            static constexpr std::size_t xyzw = rgba + sizeof(decltype(function_vertex::rgba));
+        };
+    };
+
+    template <typename V, bool = V::has_uv>
+    struct vertex_uv_attribute { typedef vec2f type; };
+    template <typename V>
+    struct vertex_uv_attribute<V, true> { typedef decltype(V::st) type; };
+    template <typename V, bool = V::has_function>
+    struct vertex_function_attribute { typedef vec4f type; };
+    template <typename V>
+    struct vertex_function_attribute<V, true> { typedef decltype(V::xyzw) type; };
+
+    // The most compact vertex format providing the attributes a vertex buffer type requires.
+    enum class vertex_format : uint32_t
+    {
+        Standard,
+        Color,
+        Texture,
+        Function
+    };
+
+    inline vertex_format compact_vertex_format(vertex_buffer_type aType)
+    {
+        bool const uv = (aType & vertex_buffer_type::UV) == vertex_buffer_type::UV;
+        bool const function = (aType & vertex_buffer_type::Function) == vertex_buffer_type::Function;
+        if (uv && function)
+            return vertex_format::Standard;
+        else if (uv)
+            return vertex_format::Texture;
+        else if (function)
+            return vertex_format::Function;
+        else
+            return vertex_format::Color;
+    }
+
+    class opengl_vertex_buffer_base : public vertex_buffer
+    {
+    public:
+        using vertex_buffer::vertex_buffer;
+    public:
+        virtual neogfx::vertex_format vertex_format() const = 0;
+        virtual void execute() = 0;
+        virtual void next_region() = 0;
+        virtual void flush() = 0;
+    };
+
     template <typename V = standard_vertex>
-    class opengl_vertex_buffer : public vertex_buffer, private opengl_buffer_owner
+    class opengl_vertex_buffer : public opengl_vertex_buffer_base, private opengl_buffer_owner
     {
+    public:
+        struct wrong_vertex_format : std::logic_error { wrong_vertex_format() : std::logic_error{ "neogfx::opengl_vertex_buffer::wrong_vertex_format" } {} };
     public:
         typedef V vertex_type;
+        static constexpr neogfx::vertex_format format =
+            std::is_same_v<vertex_type, color_vertex> ? vertex_format::Color :
+            std::is_same_v<vertex_type, texture_vertex> ? vertex_format::Texture :
+            std::is_same_v<vertex_type, function_vertex> ? vertex_format::Function :
+            vertex_format::Standard;
     public:
         typedef opengl_buffer<vertex_type> vertex_array;
+        typedef opengl_buffer<uint32_t> index_array;
+        // Per-instance attributes of an instanced draw; see standard_vertex_shader.
+        struct instance_attributes
+        {
+            mat44f transformation;
+            vec4f rgba;
+            vec4f textureRect; // texture coordinate scale (xy) and offset (zw)
+            static constexpr GLuint location = 4u;
+            struct offset
+            {
+                static constexpr std::size_t transformation = 0u;
+                static constexpr std::size_t rgba = transformation + sizeof(decltype(instance_attributes::transformation));
+                static constexpr std::size_t textureRect = rgba + sizeof(decltype(instance_attributes::rgba));
+            };
+        };
+        typedef opengl_buffer<instance_attributes> instance_array;
+        // Untransformed copy of a shared mesh uploaded once for instanced drawing; keyed by the mesh generation (see
+        // game::touch()) so that an edited mesh, or a different mesh at a recycled address, is uploaded afresh.
+        struct shared_mesh
+        {
+            vec2u32 vertexArrayIndices;
+            vec2u32 indexArrayIndices;
+            bool used;
+        };
+        typedef std::unordered_map<uint64_t, shared_mesh> shared_mesh_map;
         class use
         {
         public:
@@ -378,6 +613,14 @@ namespace neogfx
             {
                 return iParent.iBuffer;
             }
+            const index_array& indices() const
+            {
+                return iParent.iIndexBuffer;
+            }
+            index_array& indices()
+            {
+                return iParent.iIndexBuffer;
+            }
             const optional_mat44& transformation() const
             {
                 return iParent.iTransformation;
@@ -390,14 +633,33 @@ namespace neogfx
             {
                 iParent.execute();
             }
+            void enable_instance_attributes(bool aEnable)
+            {
+                iParent.enable_instance_attributes(aEnable);
+            }
+            void next_region()
+            {
+                iParent.next_region();
+            }
         private:
             opengl_vertex_buffer<vertex_type>& iParent;
         };
     public:
         opengl_vertex_buffer(i_vertex_provider& aProvider, vertex_buffer_type aType) :
-            vertex_buffer{ aProvider, aType }, iBuffer{ *this }
+            opengl_vertex_buffer_base{ aProvider, aType }, iBuffer{ *this }, iIndexBuffer{ *this }, iInstanceBuffer{ *this }
         {
         }
+        ~opengl_vertex_buffer()
+        {
+            for (auto& fence : iRegionFences)
+                if (fence != nullptr)
+                    glCheck(glDeleteSync(fence));
+        }
+    public:
+        neogfx::vertex_format vertex_format() const override
+        {
+            return format;
+        }
     public:
         void attach_shader(i_rendering_context& aContext, i_shader_program& aShaderProgram) override
         {
@@ -412,25 +674,27 @@ namespace neogfx
                 aShaderProgram,
                 standard_vertex_attribute_name(vertex_buffer_type::Vertices));
             iVertexColorAttribArray.emplace(
-                false,
+                vertex_type::normalized_color,
                 sizeof(vertex_type),
                 vertex_type::offset::rgba,
                 aShaderProgram,
                 standard_vertex_attribute_name(vertex_buffer_type::Color));
-            if (aShaderProgram.supports(vertex_buffer_type::UV))
-                iVertexTextureCoordAttribArray.emplace(
-                    false,
-                    sizeof(vertex_type),
-                    vertex_type::offset::st,
-                    aShaderProgram,
-                    standard_vertex_attribute_name(vertex_buffer_type::UV));
-            if (aShaderProgram.supports(vertex_buffer_type::Function))
-                iVertexFunctionAttribArray.emplace(
-                    false,
-                    sizeof(vertex_type),
-                    vertex_type::offset::xyzw,
-                    aShaderProgram,
-                    standard_vertex_attribute_name(vertex_buffer_type::Function));
+            if constexpr (vertex_type::has_uv)
+                if (aShaderProgram.supports(vertex_buffer_type::UV))
+                    iVertexTextureCoordAttribArray.emplace(
+                        false,
+                        sizeof(vertex_type),
+                        vertex_type::offset::st,
+                        aShaderProgram,
+                        standard_vertex_attribute_name(vertex_buffer_type::UV));
+            if constexpr (vertex_type::has_function)
+                if (aShaderProgram.supports(vertex_buffer_type::Function))
+                    iVertexFunctionAttribArray.emplace(
+                        false,
+                        sizeof(vertex_type),
+                        vertex_type::offset::xyzw,
+                        aShaderProgram,
+                        standard_vertex_attribute_name(vertex_buffer_type::Function));
             if (aShaderProgram.vertex_shader().has_standard_vertex_matrices())
             {
                 auto& standardMatrices = aShaderProgram.vertex_shader().standard_vertex_matrices();
@@ -448,17 +712,65 @@ namespace neogfx
         {
             vertices().reclaim(aStartIndex, aEndIndex);
         }
+        void reclaim_indices(std::size_t aStartIndex, std::size_t aEndIndex)
+        {
+            indices().reclaim(aStartIndex, aEndIndex);
+        }
+        buffer_allocation_statistics vertex_statistics() const override
+        {
+            return iBuffer.statistics();
+        }
+        buffer_allocation_statistics index_statistics() const override
+        {
+            return iIndexBuffer.statistics();
+        }
     public:
-        void execute()
+        // Waits until the GPU has consumed everything submitted so far. Instance records are only read by the draw
+        // that wrote them so the instance buffer is rewound; as persistent buffers are drained at the end of every
+        // frame each frame starts writing instances from the beginning of the buffer.
+        void execute() override
         {
             GLsync sync;
             glCheck(sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
-            glCheck(glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, ~0ull));
-            glCheck(glDeleteSync(sync));
+            wait(sync);
+            for (auto& fence : iRegionFences)
+                if (fence != nullptr)
+                {
+                    glCheck(glDeleteSync(fence));
+                    fence = nullptr;
+                }
+            iInstanceBuffer.clear();
         }
-        void flush()
+        // Fences the region just written and moves writing to the next region of the ring, waiting only if the GPU
+        // has not yet consumed that region; the index buffer is split into the same regions under the same fences.
+        // Persistent buffers are rewritten in place so are drained and cleared instead.
+        void next_region() override
+        {
+            if ((buffer_type() & vertex_buffer_type::Persist) == vertex_buffer_type::Persist || iRingReset)
+            {
+                execute();
+                iRingReset = false;
+                iRegion = 0u;
+                if ((buffer_type() & vertex_buffer_type::Persist) != vertex_buffer_type::Persist)
+                    set_region();
+                iBuffer.clear();
+                iIndexBuffer.clear();
+                return;
+            }
+            glCheck(iRegionFences[iRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+            iRegion = (iRegion + 1u) % RingRegions;
+            if (iRegionFences[iRegion] != nullptr)
+            {
+                wait(iRegionFences[iRegion]);
+                iRegionFences[iRegion] = nullptr;
+            }
+            set_region();
+        }
+        void flush() override
         {
             flush(vertices().size());
+            iIndexBuffer.flush(iIndexBuffer.size());
+            iInstanceBuffer.flush(iInstanceBuffer.size());
         }
         void flush(std::size_t aElements)
         {
@@ -468,13 +780,92 @@ namespace neogfx
         {
             return iBuffer;
         }
+        index_array& indices()
+        {
+            return iIndexBuffer;
+        }
+        instance_array& instances()
+        {
+            return iInstanceBuffer;
+        }
+        shared_mesh_map& shared_meshes()
+        {
+            return iSharedMeshes;
+        }
+        // Gives back the space of shared meshes not drawn since the last call.
+        void reclaim_unused_shared_meshes()
+        {
+            for (auto sharedMesh = iSharedMeshes.begin(); sharedMesh != iSharedMeshes.end();)
+            {
+                if (!sharedMesh->second.used)
+                {
+                    reclaim(sharedMesh->second.vertexArrayIndices[0], sharedMesh->second.vertexArrayIndices[1]);
+                    reclaim_indices(sharedMesh->second.indexArrayIndices[0], sharedMesh->second.indexArrayIndices[1]);
+                    sharedMesh = iSharedMeshes.erase(sharedMesh);
+                }
+                else
+                {
+                    sharedMesh->second.used = false;
+                    ++sharedMesh;
+                }
+            }
+        }
+        void enable_instance_attributes(bool aEnable)
+        {
+            if (iVao)
+                iVao->bind();
+            auto const location = instance_attributes::location;
+            if (aEnable)
+            {
+                GLint previousBindingHandle;
+                glCheck(glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBindingHandle));
+                glCheck(glBindBuffer(GL_ARRAY_BUFFER, iInstanceBuffer.handle()));
+                auto enable = [](GLuint aLocation, std::size_t aOffset)
+                {
+                    glCheck(glVertexAttribPointer(aLocation, 4, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(sizeof(instance_attributes)), reinterpret_cast<const GLvoid*>(aOffset)));
+                    glCheck(glVertexAttribDivisor(aLocation, 1u));
+                    glCheck(glEnableVertexAttribArray(aLocation));
+                };
+                for (GLuint column = 0u; column < 4u; ++column)
+                    enable(location + column, instance_attributes::offset::transformation + column * sizeof(vec4f));
+                enable(location + 4u, instance_attributes::offset::rgba);
+                enable(location + 5u, instance_attributes::offset::textureRect);
+                glCheck(glBindBuffer(GL_ARRAY_BUFFER, previousBindingHandle));
+            }
+            else
+                for (GLuint attribute = 0u; attribute < 6u; ++attribute)
+                    glCheck(glDisableVertexAttribArray(location + attribute));
+        }
         std::size_t capacity() const
         {
             return iBuffer.capacity();
         }
     private:
+        void set_region()
+        {
+            auto const regionSize = iBuffer.capacity() / RingRegions;
+            iBuffer.set_region(iRegion * regionSize, iRegion + 1u < RingRegions ? (iRegion + 1u) * regionSize : iBuffer.capacity());
+            auto const indexRegionSize = iIndexBuffer.capacity() / RingRegions;
+            iIndexBuffer.set_region(iRegion * indexRegionSize, iRegion + 1u < RingRegions ? (iRegion + 1u) * indexRegionSize : iIndexBuffer.capacity());
+        }
+        void wait(GLsync aSync)
+        {
+            GLenum status;
+            glCheck(status = glClientWaitSync(aSync, GL_SYNC_FLUSH_COMMANDS_BIT, 0u));
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                auto const start = std::chrono::high_resolution_clock::now();
+                glCheck(glClientWaitSync(aSync, GL_SYNC_FLUSH_COMMANDS_BIT, ~0ull));
+                auto& statistics = service<i_rendering_engine>().statistics();
+                ++statistics.fenceStalls;
+                statistics.fenceStallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start);
+            }
+            glCheck(glDeleteSync(aSync));
+        }
         void buffer_grown() override
         {
+            // region boundaries move with the capacity so the ring restarts (after a drain) at the next region switch
+            iRingReset = true;
             update_attrib_arrays();
         }
         void update_attrib_arrays()
@@ -489,17 +880,35 @@ namespace neogfx
                 iVertexTextureCoordAttribArray->update(iBuffer);
             if (iVertexFunctionAttribArray)
                 iVertexFunctionAttribArray->update(iBuffer);
+            if (iVao && iIndexBuffer.handle() != 0)
+                glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iIndexBuffer.handle()));
         }
     private:
+        static constexpr std::size_t RingRegions = 3u;
         opengl_buffer<vertex_type> iBuffer;
+        opengl_buffer<uint32_t> iIndexBuffer;
+        opengl_buffer<instance_attributes> iInstanceBuffer;
+        shared_mesh_map iSharedMeshes;
+        std::array<GLsync, RingRegions> iRegionFences = {};
+        std::size_t iRegion = 0u;
+        bool iRingReset = false;
         optional_mat44 iTransformation;
         std::optional<opengl_vertex_array> iVao;
         std::optional<opengl_vertex_attrib_array<vertex_type, decltype(vertex_type::xyz)>> iVertexPositionAttribArray;
         std::optional<opengl_vertex_attrib_array<vertex_type, decltype(vertex_type::rgba)>> iVertexColorAttribArray;
-        std::optional<opengl_vertex_attrib_array<vertex_type, decltype(vertex_type::st)>> iVertexTextureCoordAttribArray;
-        std::optional<opengl_vertex_attrib_array<vertex_type, decltype(vertex_type::xyzw)>> iVertexFunctionAttribArray;
+        std::optional<opengl_vertex_attrib_array<vertex_type, typename vertex_uv_attribute<vertex_type>::type>> iVertexTextureCoordAttribArray;
+        std::optional<opengl_vertex_attrib_array<vertex_type, typename vertex_function_attribute<vertex_type>::type>> iVertexFunctionAttribArray;
     };
 
+    template <typename V = standard_vertex>
+    inline opengl_vertex_buffer<V>& vertex_buffer_cast(i_vertex_buffer& aVertexBuffer)
+    {
+        auto& base = static_cast<opengl_vertex_buffer_base&>(aVertexBuffer);
+        if (base.vertex_format() != opengl_vertex_buffer<V>::format)
+            throw typename opengl_vertex_buffer<V>::wrong_vertex_format();
+        return static_cast<opengl_vertex_buffer<V>&>(base);
+    }
+
     class use_shader_program
     {
     public:
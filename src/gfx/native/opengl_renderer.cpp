@@ -74,7 +74,8 @@ namespace neogfx
         iRenderer{ aRenderer },
         iLimitFrameRate{ true },
         iFrameRateLimit{ 60u },
-        iSubpixelRendering{ false }
+        iSubpixelRendering{ false },
+        iOperationReordering{ false }
     {
 #ifdef _WIN32
         ::SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
@@ -241,10 +242,26 @@ namespace neogfx
     i_vertex_buffer& opengl_renderer::allocate_vertex_buffer(i_vertex_provider& aProvider, vertex_buffer_type aType)
     {
         auto existing = iVertexBuffers.find(&aProvider);
-        if (existing == iVertexBuffers.end())
-            return iVertexBuffers.try_emplace(&aProvider, aProvider, aType).first->second;
-        else
+        if (existing != iVertexBuffers.end())
             throw consumer_exists();
+        std::unique_ptr<opengl_vertex_buffer_base> newBuffer;
+        switch (compact_vertex_format(aType))
+        {
+        case vertex_format::Color:
+            newBuffer = std::make_unique<opengl_vertex_buffer<color_vertex>>(aProvider, aType);
+            break;
+        case vertex_format::Texture:
+            newBuffer = std::make_unique<opengl_vertex_buffer<texture_vertex>>(aProvider, aType);
+            break;
+        case vertex_format::Function:
+            newBuffer = std::make_unique<opengl_vertex_buffer<function_vertex>>(aProvider, aType);
+            break;
+        case vertex_format::Standard:
+        default:
+            newBuffer = std::make_unique<opengl_vertex_buffer<>>(aProvider, aType);
+            break;
+        }
+        return *iVertexBuffers.try_emplace(&aProvider, std::move(newBuffer)).first->second;
     }
 
     void opengl_renderer::deallocate_vertex_buffer(i_vertex_provider& aProvider)
@@ -267,12 +284,14 @@ namespace neogfx
         {
             if (iLastVertexBufferUsed && iLastVertexBufferUsed != existing)
             {
-                auto& currentBuffer = (**iLastVertexBufferUsed).second;
+                auto& currentBuffer = *(**iLastVertexBufferUsed).second;
                 currentBuffer.flush();
-                currentBuffer.execute();
+                // only persistent buffers are rewritten in place; others are fenced before they are cleared
+                if ((currentBuffer.buffer_type() & vertex_buffer_type::Persist) == vertex_buffer_type::Persist)
+                    currentBuffer.execute();
             }
             iLastVertexBufferUsed = existing;
-            return existing->second;
+            return *existing->second;
         }
         throw consumer_not_found();
     }
@@ -286,9 +305,13 @@ namespace neogfx
     {
         for (auto& vb : iVertexBuffers)
         {
-            auto& buffer = vb.second;
+            auto& buffer = *vb.second;
             buffer.flush();
-            buffer.execute();
+            // streaming buffers move on to their next ring region rather than waiting for the GPU to drain
+            if ((buffer.buffer_type() & vertex_buffer_type::Persist) == vertex_buffer_type::Persist)
+                buffer.execute();
+            else
+                buffer.next_region();
         }
     }
 
@@ -331,6 +354,21 @@ namespace neogfx
         }
     }
 
+    bool opengl_renderer::is_operation_reordering_on() const
+    {
+        return iOperationReordering;
+    }
+
+    void opengl_renderer::operation_reordering_on()
+    {
+        iOperationReordering = true;
+    }
+
+    void opengl_renderer::operation_reordering_off()
+    {
+        iOperationReordering = false;
+    }
+
     bool opengl_renderer::frame_rate_limited() const
     {
         return iLimitFrameRate && neolib::service<neolib::i_power>().green_mode_active(); 
@@ -399,6 +437,21 @@ namespace neogfx
             return iterFrameCounter->second.counter();
         return 0;
     }    
+
+    rendering_statistics const& opengl_renderer::statistics() const
+    {
+        return iStatistics;
+    }
+
+    rendering_statistics& opengl_renderer::statistics()
+    {
+        return iStatistics;
+    }
+
+    void opengl_renderer::reset_statistics()
+    {
+        iStatistics = {};
+    }
     
     i_texture& opengl_renderer::create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, size& aPreviousExtents, texture_sampling aSampling)
     {
@@ -112,6 +112,9 @@ namespace neogfx
         bool is_subpixel_rendering_on() const override;
         void subpixel_rendering_on() override;
         void subpixel_rendering_off() override;
+        bool is_operation_reordering_on() const override;
+        void operation_reordering_on() override;
+        void operation_reordering_off() override;
         bool frame_rate_limited() const override;
         void enable_frame_rate_limiter(bool aEnable) override;
         uint32_t frame_rate_limit() const override;
@@ -122,6 +125,11 @@ namespace neogfx
         void register_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
         void unregister_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
         uint32_t frame_counter(uint32_t aDuration) const override;
+    public:
+        rendering_statistics const& statistics() const override;
+        rendering_statistics& statistics() override;
+        void reset_statistics() override;
+    public:
         i_texture& create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, size& aPreviousExtents, texture_sampling aSampling);
     private:
         neogfx::renderer iRenderer;
@@ -131,10 +139,12 @@ namespace neogfx
         bool iLimitFrameRate;
         uint32_t iFrameRateLimit;
         bool iSubpixelRendering;
-        typedef std::unordered_map<i_vertex_provider*, opengl_vertex_buffer<>> vertex_buffers_map;
+        bool iOperationReordering;
+        typedef std::unordered_map<i_vertex_provider*, std::unique_ptr<opengl_vertex_buffer_base>> vertex_buffers_map;
         mutable vertex_buffers_map iVertexBuffers;
         mutable std::optional<vertex_buffers_map::iterator> iLastVertexBufferUsed;
         std::map<uint32_t, neogfx::frame_counter> iFrameCounters;
+        rendering_statistics iStatistics;
         mutable std::optional<ping_pong_buffers_t> iPingPongBuffer1s;
         mutable std::optional<ping_pong_buffers_t> iPingPongBuffer2s;
         ref_ptr<i_standard_shader_program> iDefaultShaderProgram;
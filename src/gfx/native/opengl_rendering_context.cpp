@@ -18,9 +18,11 @@
 */
 
 #include <neogfx/neogfx.hpp>
+#include <unordered_set>
 #include <boost/math/constants/constants.hpp>
 #include <neolib/core/thread_local.hpp>
 #include <neolib/app/i_power.hpp>
+#include <neogfx/core/worker_pool.hpp>
 #include <neogfx/app/i_basic_services.hpp>
 #include <neogfx/hid/i_surface_manager.hpp>
 #include <neogfx/gfx/text/glyph.hpp>
@@ -28,10 +30,14 @@
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/text/i_glyph_texture.hpp>
 #include <neogfx/gfx/shapes.hpp>
+#include <neogfx/gfx/tessellator.hpp>
+#include <neogfx/gfx/stroke.hpp>
+#include <neogfx/gfx/graphics_operations_archive.hpp>
 #include <neogfx/gui/widget/i_widget.hpp>
 #include <neogfx/game/rectangle.hpp>
 #include <neogfx/game/text_mesh.hpp>
 #include <neogfx/game/ecs_helpers.hpp>
+#include <neogfx/game/ecs.hpp>
 #include <neogfx/hid/i_native_surface.hpp>
 #include "i_native_texture.hpp"
 #include "../text/native/i_native_font_face.hpp"
@@ -132,12 +138,10 @@ namespace neogfx
             auto const vecLine = aEnd - aStart;
             auto const length = vecLine.magnitude();
             auto const halfWidth = aLineWidth / 2.0;
-            auto const v1 = vec3{ -halfWidth, -halfWidth, 0.0 };
-            auto const v2 = vec3{ -halfWidth, halfWidth, 0.0 };
-            auto const v3 = vec3{ length + halfWidth, halfWidth, 0.0 };
-            auto const v4 = vec3{ length + halfWidth, -halfWidth, 0.0 };
-            auto const r = rotation_matrix(vec3{ 1.0, 0.0, 0.0 }, vecLine);
-            return quad{ aStart + r * v1, aStart + r * v2, aStart + r * v3, aStart + r * v4 };
+            // the line's direction and left normal span the quad; no rotation matrix is needed in the plane
+            auto const along = (length != 0.0 ? vecLine / length : vec3{ 1.0, 0.0, 0.0 }) * halfWidth;
+            auto const across = vec3{ -along.y, along.x, 0.0 };
+            return quad{ aStart - along - across, aStart - along + across, aEnd + along + across, aEnd + along - across };
         }
 
         template <typename VerticesIn, typename VerticesOut>
@@ -178,6 +182,8 @@ namespace neogfx
                 return GL_LINE_STRIP;
             case path_shape::ConvexPolygon:
                 return GL_TRIANGLE_FAN;
+            case path_shape::Polygon:
+                return GL_LINE_LOOP; // outlines only; fills are tessellated
             default:
                 return GL_POINTS;
             }
@@ -210,6 +216,173 @@ namespace neogfx
             return vertices;
         }
 
+        // A run of mesh vertices to be transformed and written to a reserved range of a mapped vertex buffer.
+        struct vertex_bake_job
+        {
+            game::mesh const* mesh;
+            std::size_t firstMeshVertex; // into vertex_bake_list::meshVertices
+            std::size_t count;
+            std::size_t destination;
+            bool transformed;
+            std::array<float, 12> transformation; // affine part of the transformation matrix, row major
+            vec4f rgba;
+            vec4f function;
+            bool textured;
+            vec2f uvScale;
+            vec2f uvOffset;
+            std::optional<float> uvGui;
+        };
+
+        struct vertex_bake_list
+        {
+            std::vector<uint32_t> meshVertices;
+            std::vector<vertex_bake_job> jobs;
+            std::size_t vertexCount = 0u;
+        };
+
+        inline std::array<float, 12> to_affine_transformation(mat44 const& aTransformation)
+        {
+            std::array<float, 12> result;
+            for (std::size_t row = 0u; row < 3u; ++row)
+                for (std::size_t column = 0u; column < 4u; ++column)
+                    result[row * 4u + column] = static_cast<float>(aTransformation[column][row]);
+            return result;
+        }
+
+        // One loop per combination of job options so that the per-vertex loop itself is branch free.
+        template <bool Transformed, bool Textured, bool UvGui>
+        void bake_vertices(vertex_bake_job const& aJob, uint32_t const* aMeshVertices, standard_vertex* aDestination)
+        {
+            auto const* sourceVertices = aJob.mesh->vertices.data();
+            auto const* sourceUv = aJob.mesh->uv.data();
+            auto const& m = aJob.transformation;
+            auto const rgba = aJob.rgba;
+            auto const function = aJob.function;
+            auto const uvScale = aJob.uvScale;
+            auto const uvOffset = aJob.uvOffset;
+            float const uvGui = aJob.uvGui.value_or(0.0f);
+            for (std::size_t i = 0u; i < aJob.count; ++i)
+            {
+                auto const& source = sourceVertices[aMeshVertices[i]];
+                float const x = static_cast<float>(source.x);
+                float const y = static_cast<float>(source.y);
+                float const z = static_cast<float>(source.z);
+                auto& out = aDestination[i];
+                if constexpr (Transformed)
+                {
+                    out.xyz.x = m[0] * x + m[1] * y + m[2] * z + m[3];
+                    out.xyz.y = m[4] * x + m[5] * y + m[6] * z + m[7];
+                    out.xyz.z = m[8] * x + m[9] * y + m[10] * z + m[11];
+                }
+                else
+                    out.xyz = vec3f{ x, y, z };
+                out.rgba = rgba;
+                if constexpr (Textured)
+                {
+                    auto const& uv = sourceUv[aMeshVertices[i]];
+                    out.st.x = static_cast<float>(uv.x) * uvScale.x + uvOffset.x;
+                    out.st.y = static_cast<float>(uv.y) * uvScale.y + uvOffset.y;
+                    if constexpr (UvGui)
+                        out.st.y = uvGui - out.st.y;
+                }
+                else
+                    out.st = vec2f{};
+                out.xyzw = function;
+            }
+        }
+
+        void bake_vertices(vertex_bake_list const& aList, std::size_t aFirstJob, std::size_t aLastJob, standard_vertex* aDestination)
+        {
+            for (auto j = aFirstJob; j != aLastJob; ++j)
+            {
+                auto const& job = aList.jobs[j];
+                auto const* meshVertices = &aList.meshVertices[job.firstMeshVertex];
+                auto* destination = aDestination + job.destination;
+                bool const uvGui = job.uvGui != std::nullopt;
+                if (job.transformed)
+                {
+                    if (!job.textured)
+                        bake_vertices<true, false, false>(job, meshVertices, destination);
+                    else if (!uvGui)
+                        bake_vertices<true, true, false>(job, meshVertices, destination);
+                    else
+                        bake_vertices<true, true, true>(job, meshVertices, destination);
+                }
+                else
+                {
+                    if (!job.textured)
+                        bake_vertices<false, false, false>(job, meshVertices, destination);
+                    else if (!uvGui)
+                        bake_vertices<false, true, false>(job, meshVertices, destination);
+                    else
+                        bake_vertices<false, true, true>(job, meshVertices, destination);
+                }
+            }
+        }
+
+        // Bakes the list on the calling thread plus, for large lists, the threads of a persistent worker pool, each
+        // taking a contiguous run of jobs of roughly equal vertex count; jobs write disjoint ranges of the buffer.
+        void bake_vertices(vertex_bake_list const& aList, standard_vertex* aDestination)
+        {
+            std::size_t constexpr VerticesPerThread = 4096u;
+            static worker_pool sPool;
+            auto const threadCount = std::min<std::size_t>(sPool.thread_count() + 1u, aList.vertexCount / VerticesPerThread);
+            if (threadCount <= 1u)
+            {
+                bake_vertices(aList, 0u, aList.jobs.size(), aDestination);
+                return;
+            }
+            thread_local std::vector<std::size_t> splits;
+            splits.assign(1u, 0u);
+            std::size_t vertices = 0u;
+            for (std::size_t j = 0u; j < aList.jobs.size() && splits.size() < threadCount; ++j)
+            {
+                vertices += aList.jobs[j].count;
+                if (vertices >= aList.vertexCount * splits.size() / threadCount)
+                    splits.push_back(j + 1u);
+            }
+            splits.push_back(aList.jobs.size());
+            sPool.run(splits.size() - 1u, [&](std::size_t aSplit)
+            {
+                bake_vertices(aList, splits[aSplit], splits[aSplit + 1u], aDestination);
+            });
+        }
+
+        bool overlaps(aabb_2d const& aViewport, aabb_2d const& aBounds, mat44 const& aTransformation, vec2 const& aOffset)
+        {
+            vec2 min{ std::numeric_limits<scalar>::max(), std::numeric_limits<scalar>::max() };
+            vec2 max{ std::numeric_limits<scalar>::lowest(), std::numeric_limits<scalar>::lowest() };
+            for (auto const& corner : { 
+                vec3{ aBounds.min.x, aBounds.min.y, 0.0 }, vec3{ aBounds.max.x, aBounds.min.y, 0.0 },
+                vec3{ aBounds.min.x, aBounds.max.y, 0.0 }, vec3{ aBounds.max.x, aBounds.max.y, 0.0 } })
+            {
+                auto const transformedCorner = aTransformation * corner;
+                min.x = std::min(min.x, transformedCorner.x + aOffset.x);
+                min.y = std::min(min.y, transformedCorner.y + aOffset.y);
+                max.x = std::max(max.x, transformedCorner.x + aOffset.x);
+                max.y = std::max(max.y, transformedCorner.y + aOffset.y);
+            }
+            return min.x <= aViewport.max.x && max.x >= aViewport.min.x && min.y <= aViewport.max.y && max.y >= aViewport.min.y;
+        }
+
+        // Triangles for a polyline stroked with a pen; a stippled stroke keeps the one quad per segment that
+        // emit_any_stipple expects so has no joins.
+        std::vector<vec3f> const& stroke_triangles(i_rendering_context& aContext, const vertices& aPolyline, bool aClosed, const pen& aPen)
+        {
+            thread_local std::vector<vec3f> tTriangles;
+            tTriangles.clear();
+            if (aContext.rendering_engine().default_shader_program().stipple_shader().stipple_active())
+            {
+                thread_local vec3_list tQuads;
+                tQuads.clear();
+                lines_to_quads(line_loop_to_lines(aPolyline, aClosed), aPen.width(), tQuads);
+                quads_to_triangles(tQuads, tTriangles);
+            }
+            else
+                stroke_polyline(aPolyline, aClosed, aPen, tTriangles);
+            return tTriangles;
+        }
+
         void emit_any_stipple(i_rendering_context& aContext, use_vertex_arrays& aInstance, bool aLoop = false)
         {
             // assumes vertices are quads (as two triangles) created with quads_to_triangles above.
@@ -454,7 +627,18 @@ namespace neogfx
         if (queue().empty())
             return;
 
+        auto& statistics = rendering_engine().statistics();
+        ++statistics.flushes;
+        statistics.operations += queue().size();
+
+        if (graphics_operation::queue_writer::capture() != nullptr)
+            graphics_operation::queue_writer::capture()->write(*this);
+
+        if (rendering_engine().is_operation_reordering_on())
+            statistics.reorderedOperations += graphics_operation::reorder_for_batching(queue());
+
         scoped_render_target srt{ render_target() };
+        rendering_engine().texture_manager().flush_uploads();
         set_blending_mode(blending_mode());
         apply_scissor();
 
@@ -465,6 +649,7 @@ namespace neogfx
                 ++batchEnd;
             graphics_operation::batch const opBatch{ &*batchStart, &*batchStart + (batchEnd - batchStart) };
             batchStart = batchEnd;
+            ++statistics.batches;
             switch (opBatch.first->index())
             {
             case graphics_operation::operation_type::SetLogicalCoordinateSystem:
@@ -927,7 +1112,7 @@ namespace neogfx
         disable_multisample disableMultisample{ *this };
 
         {
-            use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, static_cast<std::size_t>(2u * 3u * (aDrawPixelOps.second - aDrawPixelOps.first)) };
+            basic_use_vertex_arrays<color_vertex> vertexArrays{ as_color_vertex_provider(), *this, GL_TRIANGLES, static_cast<std::size_t>(2u * 3u * (aDrawPixelOps.second - aDrawPixelOps.first)) };
 
             for (auto op = aDrawPixelOps.first; op != aDrawPixelOps.second; ++op)
             {
@@ -959,11 +1144,7 @@ namespace neogfx
             v2 -= vec3{ 0.5, 0.5, 0.0 };
         }
 
-        vec3_array<2> line = { v1, v2 };
-        vec3_array<4> quad;
-        lines_to_quads(line, aPen.width(), quad);
-        vec3_array<6> triangles;
-        quads_to_triangles(quad, triangles);
+        auto const& triangles = stroke_triangles(*this, vertices{ v1, v2 }, false, aPen);
 
         use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, triangles.size() };
 
@@ -1051,15 +1232,7 @@ namespace neogfx
         else
             adjustedRect.inflate(size{ aPen.width() / 2.0 }.floor());
 
-        auto vertices = rounded_rect_vertices(adjustedRect, aRadius, mesh_type::Outline);
-
-        auto lines = line_loop_to_lines(vertices);
-        thread_local vec3_list quads;
-        quads.clear();
-        lines_to_quads(lines, aPen.width(), quads);
-        thread_local vec3_list triangles;
-        triangles.clear();
-        quads_to_triangles(quads, triangles);
+        auto const& triangles = stroke_triangles(*this, rounded_rect_vertices(adjustedRect, aRadius, mesh_type::Outline), true, aPen);
 
         use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, triangles.size() };
 
@@ -1088,15 +1261,7 @@ namespace neogfx
         if (std::holds_alternative<gradient>(aPen.color()))
             rendering_engine().default_shader_program().gradient_shader().set_gradient(*this, static_variant_cast<const neogfx::gradient&>(aPen.color()), iOpacity);
 
-        auto vertices = circle_vertices(aCenter, aRadius, aStartAngle, mesh_type::Outline);
-
-        auto lines = line_loop_to_lines(vertices);
-        thread_local vec3_list quads;
-        quads.clear();
-        lines_to_quads(lines, aPen.width(), quads);
-        thread_local vec3_list triangles;
-        triangles.clear();
-        quads_to_triangles(quads, triangles);
+        auto const& triangles = stroke_triangles(*this, circle_vertices(aCenter, aRadius, aStartAngle, mesh_type::Outline), true, aPen);
 
         use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, triangles.size() };
 
@@ -1125,15 +1290,7 @@ namespace neogfx
         if (std::holds_alternative<gradient>(aPen.color()))
             rendering_engine().default_shader_program().gradient_shader().set_gradient(*this, static_variant_cast<const neogfx::gradient&>(aPen.color()), iOpacity);
 
-        auto vertices = arc_vertices(aCenter, aRadius, aStartAngle, aEndAngle, aCenter, mesh_type::Outline);
-
-        auto lines = line_loop_to_lines(vertices, false);
-        thread_local vec3_list quads;
-        quads.clear();
-        lines_to_quads(lines, aPen.width(), quads);
-        thread_local vec3_list triangles;
-        triangles.clear();
-        quads_to_triangles(quads, triangles);
+        auto const& triangles = stroke_triangles(*this, arc_vertices(aCenter, aRadius, aStartAngle, aEndAngle, aCenter, mesh_type::Outline), false, aPen);
 
         use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, triangles.size() };
 
@@ -1193,9 +1350,27 @@ namespace neogfx
 
         auto const function = to_function(aPen.color(), aPath.bounding_rect());
 
+        bool const polyline = aPath.shape() == path_shape::LineStrip || aPath.shape() == path_shape::LineLoop || aPath.shape() == path_shape::Polygon;
+
         for (auto const& subPath : aPath.sub_paths())
         {
-            if (subPath.size() >= 2)
+            if (subPath.size() >= 2 && polyline)
+            {
+                auto const& triangles = stroke_triangles(*this, aPath.to_vertices(subPath), aPath.shape() != path_shape::LineStrip, aPen);
+
+                use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, triangles.size() };
+                for (auto const& v : triangles)
+                    vertexArrays.push_back({ v, std::holds_alternative<color>(aPen.color()) ?
+                        vec4f{{
+                            static_variant_cast<color>(aPen.color()).red<float>(),
+                            static_variant_cast<color>(aPen.color()).green<float>(),
+                            static_variant_cast<color>(aPen.color()).blue<float>(),
+                            static_variant_cast<color>(aPen.color()).alpha<float>() * static_cast<float>(iOpacity)}} :
+                        vec4f{},
+                        {},
+                        function });
+            }
+            else if (subPath.size() >= 2)
             {
                 GLenum mode;
                 auto vertices = path_vertices(aPath, subPath, aPen.width(), mode);
@@ -1224,22 +1399,14 @@ namespace neogfx
         if (std::holds_alternative<gradient>(aPen.color()))
             rendering_engine().default_shader_program().gradient_shader().set_gradient(*this, static_variant_cast<const neogfx::gradient&>(aPen.color()), iOpacity);
 
-        auto const& vertices = aMesh.vertices;
-
-        auto lines = line_loop_to_lines(vertices);
-        thread_local vec3_list quads;
-        quads.clear();
-        lines_to_quads(lines, aPen.width(), quads);
-        thread_local vec3_list triangles;
-        triangles.clear();
-        quads_to_triangles(quads, triangles);
+        auto const& triangles = stroke_triangles(*this, aMesh.vertices, true, aPen);
 
         use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, triangles.size() };
 
         auto const function = to_function(aPen.color(), bounding_rect(aMesh));
 
         for (auto const& v : triangles)
-            vertexArrays.push_back({ v + aPosition, std::holds_alternative<color>(aPen.color()) ?
+            vertexArrays.push_back({ v + aPosition.as<float>(), std::holds_alternative<color>(aPen.color()) ?
                 vec4f{{
                     static_variant_cast<color>(aPen.color()).red<float>(),
                     static_variant_cast<color>(aPen.color()).green<float>(),
@@ -1274,39 +1441,75 @@ namespace neogfx
             auto const& meshRenderers = aEcs.component<game::mesh_renderer>();
             auto const& meshFilters = aEcs.component<game::mesh_filter>();
             auto const& cache = aEcs.component<game::mesh_render_cache>();
-            for (auto entity : meshRenderers.entities())
+            auto& drawLists = dynamic_cast<game::ecs&>(aEcs).draw_lists();
+            drawLists.update();
+            auto const logicalCoordinates = logical_coordinates();
+            aabb_2d const viewport{
+                vec2{ std::min(logicalCoordinates.bottomLeft.x, logicalCoordinates.topRight.x), std::min(logicalCoordinates.bottomLeft.y, logicalCoordinates.topRight.y) },
+                vec2{ std::max(logicalCoordinates.bottomLeft.x, logicalCoordinates.topRight.x), std::max(logicalCoordinates.bottomLeft.y, logicalCoordinates.topRight.y) } };
+            auto const viewOffset = offset();
+            thread_local std::vector<std::pair<game::entity_id, int32_t>> layerChanges;
+            for (int32_t layer = 0; layer <= drawLists.max_layer(); ++layer)
             {
+                for (auto& entry : drawLists.layer(layer))
+                {
+                    auto const entity = entry.entity;
+                    if (entity == game::null_entity)
+                        continue;
 #if defined(NEOGFX_DEBUG) && !defined(NDEBUG)
-                if (infos.entity_record(entity).debug)
-                    service<debug::logger>() << "Rendering debug::layoutItem entity..." << endl;
+                    if (infos.entity_record(entity).debug)
+                        service<debug::logger>() << "Rendering debug::layoutItem entity..." << endl;
 #endif // NEOGFX_DEBUG
-                auto const& info = infos.entity_record_no_lock(entity);
-                if (info.destroyed)
-                    continue;
-                auto const& meshRenderer = meshRenderers.entity_record_no_lock(entity);
-                maxLayer = std::max(maxLayer, meshRenderer.layer);
-                if (drawables.size() <= maxLayer)
-                    drawables.resize(maxLayer + 1);
-                auto const& meshFilter = meshFilters.has_entity_record_no_lock(entity) ?
-                    meshFilters.entity_record_no_lock(entity) :
-                    game::current_animation_frame(animatedMeshFilters.entity_record_no_lock(entity));
-                drawables[meshRenderer.layer].emplace_back(
-                    meshFilter,
-                    meshRenderer,
-                    optional_mat44{},
-                    entity);
-                if (!game::is_render_cache_clean_no_lock(cache, entity))
-                {
-                    auto const& rigidBodyTransformation = (rigidBodies.has_entity_record_no_lock(entity) ?
-                        to_transformation_matrix(rigidBodies.entity_record_no_lock(entity)) : mat44::identity());
-                    auto const& meshFilterTransformation = (meshFilter.transformation ?
-                        *meshFilter.transformation : mat44::identity());
-                    auto const& animationMeshFilterTransformation = (animatedMeshFilters.has_entity_record_no_lock(entity) ?
-                        to_transformation_matrix(animatedMeshFilters.entity_record_no_lock(entity)) : mat44::identity());
-                    auto const& transformation = rigidBodyTransformation * meshFilterTransformation * animationMeshFilterTransformation;
-                    drawables[meshRenderer.layer].back().transformation = transformation;
+                    auto const& info = infos.entity_record_no_lock(entity);
+                    if (info.destroyed)
+                        continue;
+                    // layer changes are picked up before culling so that entities outside the viewport are moved too
+                    auto const& meshRenderer = meshRenderers.entity_record_no_lock(entity);
+                    if (meshRenderer.layer != layer)
+                        layerChanges.emplace_back(entity, meshRenderer.layer);
+                    bool const clean = game::is_render_cache_clean_no_lock(cache, entity);
+                    if (clean && entry.bounds && !overlaps(viewport, *entry.bounds, aTransformation, viewOffset))
+                        continue;
+                    if (!entry.hasMeshFilter && !entry.hasAnimationFilter)
+                        continue; // nothing to draw until a mesh is attached
+                    auto const& meshFilter = entry.hasMeshFilter ?
+                        meshFilters.entity_record_no_lock(entity) :
+                        game::current_animation_frame(animatedMeshFilters.entity_record_no_lock(entity));
+                    optional_mat44 transformation;
+                    auto entity_transformation = [&]()
+                    {
+                        auto const& rigidBodyTransformation = (entry.hasRigidBody ?
+                            to_transformation_matrix(rigidBodies.entity_record_no_lock(entity)) : mat44::identity());
+                        auto const& meshFilterTransformation = (meshFilter.transformation ?
+                            *meshFilter.transformation : mat44::identity());
+                        auto const& animationMeshFilterTransformation = (entry.hasAnimationFilter ?
+                            to_transformation_matrix(animatedMeshFilters.entity_record_no_lock(entity)) : mat44::identity());
+                        return rigidBodyTransformation * meshFilterTransformation * animationMeshFilterTransformation;
+                    };
+                    if (clean && meshFilter.mesh == std::nullopt && meshFilter.sharedMesh.ptr != nullptr)
+                        transformation = entity_transformation(); // an instanced entity passes its transformation every frame
+                    else if (!clean)
+                    {
+                        transformation = entity_transformation();
+                        auto const& mesh = (meshFilter.mesh != std::nullopt ? *meshFilter.mesh : *meshFilter.sharedMesh.ptr);
+                        entry.bounds = game::bounding_rect(mesh.vertices, *transformation).to_aabb_2d();
+                        // an entity culled here keeps its render cache dirty until it is next visible
+                        if (!overlaps(viewport, *entry.bounds, aTransformation, viewOffset))
+                            continue;
+                    }
+                    maxLayer = std::max(maxLayer, meshRenderer.layer);
+                    if (drawables.size() <= maxLayer)
+                        drawables.resize(maxLayer + 1);
+                    drawables[meshRenderer.layer].emplace_back(
+                        meshFilter,
+                        meshRenderer,
+                        transformation,
+                        entity);
                 }
             }
+            for (auto const& layerChange : layerChanges)
+                drawLists.set_layer(layerChange.first, layerChange.second);
+            layerChanges.clear();
         }
         if (!drawables[aLayer].empty())
             draw_meshes(lock, dynamic_cast<i_vertex_provider&>(aEcs), &*drawables[aLayer].begin(), &*drawables[aLayer].begin() + drawables[aLayer].size(), aTransformation);
@@ -1315,6 +1518,7 @@ namespace neogfx
             maxLayer = 0;
             for (auto& d : drawables)
                 d.clear();
+            static_cast<opengl_vertex_buffer<>&>(service<i_rendering_engine>().vertex_buffer(dynamic_cast<i_vertex_provider&>(aEcs))).reclaim_unused_shared_meshes();
             lock.reset();
         }
     }
@@ -1338,6 +1542,22 @@ namespace neogfx
         if (std::holds_alternative<gradient>(firstOp.fill))
             rendering_engine().default_shader_program().gradient_shader().set_gradient(*this, static_variant_cast<const gradient&>(firstOp.fill), iOpacity);
         
+        if (std::holds_alternative<color>(firstOp.fill))
+        {
+            // only solid color fills are batched together so the whole batch can use the compact vertex format
+            basic_use_vertex_arrays<color_vertex> vertexArrays{ as_color_vertex_provider(), *this, GL_TRIANGLES, static_cast<std::size_t>(2u * 3u * (aFillRectOps.second - aFillRectOps.first))};
+
+            for (auto op = aFillRectOps.first; op != aFillRectOps.second; ++op)
+            {
+                auto& drawOp = static_variant_cast<const graphics_operation::fill_rect&>(*op);
+                auto const& fillColor = static_variant_cast<const color&>(drawOp.fill);
+                auto const rgba = vec4f{{ fillColor.red<float>(), fillColor.green<float>(), fillColor.blue<float>(), fillColor.alpha<float>() * static_cast<float>(iOpacity) }};
+                auto rectVertices = rect_vertices(drawOp.rect, mesh_type::Triangles, drawOp.zpos);
+                for (auto const& v : rectVertices)
+                    vertexArrays.push_back({ v, rgba });
+            }
+        }
+        else
         {
             use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, static_cast<std::size_t>(2u * 3u * (aFillRectOps.second - aFillRectOps.first))};
 
@@ -1347,16 +1567,7 @@ namespace neogfx
                 auto const function = to_function(drawOp.fill, drawOp.rect);
                 auto rectVertices = rect_vertices(drawOp.rect, mesh_type::Triangles, drawOp.zpos);
                 for (auto const& v : rectVertices)
-                    vertexArrays.push_back({ v,
-                        std::holds_alternative<color>(drawOp.fill) ?
-                            vec4f{{
-                                static_variant_cast<const color&>(drawOp.fill).red<float>(),
-                                static_variant_cast<const color&>(drawOp.fill).green<float>(),
-                                static_variant_cast<const color&>(drawOp.fill).blue<float>(),
-                                static_variant_cast<const color&>(drawOp.fill).alpha<float>() * static_cast<float>(iOpacity)}} :
-                            vec4f{},
-                            {},
-                            function });
+                    vertexArrays.push_back({ v, vec4f{}, {}, function });
             }
         }
     }
@@ -1521,6 +1732,32 @@ namespace neogfx
 
         neolib::scoped_flag snap{ iSnapToPixel, false };
 
+        if (aPath.shape() == path_shape::Polygon)
+        {
+            // general polygons are tessellated once per distinct path and drawn from the cached triangles
+            auto const mesh = tessellated(aPath);
+            if (mesh->empty())
+                return;
+
+            if (std::holds_alternative<gradient>(aFill))
+                rendering_engine().default_shader_program().gradient_shader().set_gradient(*this, static_variant_cast<const gradient&>(aFill), iOpacity);
+
+            use_vertex_arrays vertexArrays{ as_vertex_provider(), *this, GL_TRIANGLES, mesh->size() };
+
+            auto const function = to_function(aFill, aPath.bounding_rect());
+            auto const fillColor = std::holds_alternative<color>(aFill) ?
+                vec4f{{
+                    static_variant_cast<const color&>(aFill).red<float>(),
+                    static_variant_cast<const color&>(aFill).green<float>(),
+                    static_variant_cast<const color&>(aFill).blue<float>(),
+                    static_variant_cast<const color&>(aFill).alpha<float>() * static_cast<float>(iOpacity)}} :
+                vec4f{};
+            auto const offset = xyz{ aPath.position().x, aPath.position().y };
+            for (auto const& v : *mesh)
+                vertexArrays.push_back({ v + offset, fillColor, {}, function });
+            return;
+        }
+
         for (auto const& subPath : aPath.sub_paths())
         {
             if (subPath.size() > 2)
@@ -1697,10 +1934,10 @@ namespace neogfx
                         drawOp.point.x + glyphTexture.placement().x,
                         logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame ?
                             drawOp.point.y + (glyphTexture.placement().y + -glyphFont.descender()) :
-                            drawOp.point.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.texture().extents().cy
+                            drawOp.point.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.extents().cy
                     } + glyph.offset.as<scalar>();
                     vec3 const glyphOrigin{ glyphOrigin2D.x, glyphOrigin2D.y, drawOp.point.z };
-                    glyphRect = rect{ point{ glyphOrigin }, glyphTexture.texture().extents() };
+                    glyphRect = rect{ point{ glyphOrigin }, glyphTexture.extents() };
                 }
 
                 if (result == std::nullopt)
@@ -1842,6 +2079,7 @@ namespace neogfx
             case 5: // Glyph render (final pass)
                 {
                     bool updateGlyphShader = true;
+                    bool distanceFieldBatch = false;
 
                     for (auto op = aBegin; op != aEnd; ++op)
                     {
@@ -1855,12 +2093,13 @@ namespace neogfx
                         auto const& glyphTexture = glyphText.glyph_texture(glyph);
 
                         auto const& glyphFont = glyphText.glyph_font(glyph);
+                        glyphFont.glyph_texture_drawn(glyph);
 
                         auto const glyphOrigin2D = point{
                             drawOp.point.x + glyphTexture.placement().x,
                             logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame ?
                                 drawOp.point.y + (glyphTexture.placement().y + -glyphFont.descender()) :
-                                drawOp.point.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.texture().extents().cy
+                                drawOp.point.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.extents().cy
                         } + glyph.offset.as<scalar>();
 
                         vec3 const glyphOrigin{ glyphOrigin2D.x, glyphOrigin2D.y, drawOp.point.z };
@@ -1874,9 +2113,18 @@ namespace neogfx
                                 { 0.0, 0.0, 1.0, 0.0 }, 
                                 { 0.0, 0.0, 0.0, 1.0 } };
 
+                        bool const distanceField = glyphTexture.texture().data_format() == texture_data_format::DistanceField;
+                        if (!updateGlyphShader && distanceField != distanceFieldBatch)
+                        {
+                            // the glyph shader is configured per batch so distance field and bitmap glyphs are drawn separately
+                            draw();
+                            updateGlyphShader = true;
+                        }
+
                         if (updateGlyphShader)
                         {
                             updateGlyphShader = false;
+                            distanceFieldBatch = distanceField;
                             rendering_engine().default_shader_program().glyph_shader().set_first_glyph(*this, glyphText, glyph);
                         }
 
@@ -1893,7 +2141,7 @@ namespace neogfx
                                 {
                                     rect const outputRect = {
                                             point{ glyphOrigin } + offsetOrigin + point{ static_cast<coordinate>(offset % scanlineOffsets), static_cast<coordinate>(offset / scanlineOffsets) },
-                                            glyphTexture.texture().extents() };
+                                            glyphTexture.extents() };
                                     auto mesh = logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui ?
                                         to_ecs_component(
                                             outputRect,
@@ -1924,7 +2172,7 @@ namespace neogfx
                             continue;
                         }
 
-                        rect const outputRect = { point{ glyphOrigin }, glyphTexture.texture().extents() };
+                        rect const outputRect = { point{ glyphOrigin }, glyphTexture.extents() };
                         auto mesh = logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui ?
                             to_ecs_component(
                                 outputRect,
@@ -2034,36 +2282,86 @@ namespace neogfx
         patchDrawable.provider = &aVertexProvider;
         patchDrawable.items.clear();
 
+        constexpr uint32_t UnmappedVertex = ~0u;
+        thread_local std::vector<uint32_t> vertexMap;
+        thread_local vertex_bake_list bakeList;
+        bakeList.meshVertices.clear();
+        bakeList.jobs.clear();
+        bakeList.vertexCount = 0u;
+
         auto cache = aVertexProvider.cacheable() ? &aVertexProvider.cache() : nullptr;
 
+        auto& vertexBuffer = static_cast<opengl_vertex_buffer<>&>(service<i_rendering_engine>().vertex_buffer(aVertexProvider));
+        auto& vertices = vertexBuffer.vertices();
+        auto& indices = vertexBuffer.indices();
+        auto& instances = vertexBuffer.instances();
+        auto& sharedMeshes = vertexBuffer.shared_meshes();
+        thread_local std::unordered_set<uint64_t> countedSharedMeshes;
+        countedSharedMeshes.clear();
+
+        // Entities drawing an untextured-gradient, unpatched shared mesh are drawn instanced: the mesh is uploaded
+        // once and each entity contributes only an instance_attributes record.
+        auto instanceable = [&](mesh_drawable const& aDrawable)
+        {
+            auto const& meshFilter = *aDrawable.filter;
+            auto const& meshRenderer = *aDrawable.renderer;
+            return cache != nullptr &&
+                meshFilter.mesh == std::nullopt &&
+                meshFilter.sharedMesh.ptr != nullptr &&
+                !meshFilter.sharedMesh.ptr->faces.empty() &&
+                meshRenderer.patches.empty() &&
+                !meshRenderer.barrier &&
+                meshRenderer.filter == std::nullopt &&
+                meshRenderer.material.gradient == std::nullopt;
+        };
+
         std::size_t vertexCount = 0;
         std::size_t cachedVertexCount = 0;
+        std::size_t indexCount = 0;
+        std::size_t cachedIndexCount = 0;
+        std::size_t instanceCount = 0;
         for (auto md = aFirst; md != aLast; ++md)
         {
             auto& meshDrawable = *md;
             auto& meshRenderer = *meshDrawable.renderer;
             auto& meshFilter = *meshDrawable.filter;
+            if (instanceable(meshDrawable))
+            {
+                ++instanceCount;
+                auto const& sharedMesh = *meshFilter.sharedMesh.ptr;
+                if (countedSharedMeshes.insert(sharedMesh.generation).second && sharedMeshes.find(sharedMesh.generation) == sharedMeshes.end())
+                {
+                    vertexCount += sharedMesh.vertices.size();
+                    indexCount += sharedMesh.faces.size() * 3;
+                }
+                continue;
+            }
             bool const cached = meshDrawable.entity != null_entity &&
                 game::is_render_cache_valid_no_lock(*cache, meshDrawable.entity);
             auto& mesh = (meshFilter.mesh != std::nullopt ? *meshFilter.mesh : *meshFilter.sharedMesh.ptr);
-            auto const& faces = mesh.faces;
-            vertexCount += faces.size() * 3;
-            if (cached)
-                cachedVertexCount += faces.size() * 3;
-            for (auto const& meshPatch : meshRenderer.patches)
+            auto count = [&](game::faces const& aFaces)
             {
-                vertexCount += meshPatch.faces.size() * 3;
+                // each mesh vertex is written at most once per item
+                auto const itemVertexCount = std::min(aFaces.size() * 3, mesh.vertices.size());
+                vertexCount += itemVertexCount;
+                indexCount += aFaces.size() * 3;
                 if (cached)
-                    cachedVertexCount += meshPatch.faces.size() * 3;
-            }
+                {
+                    cachedVertexCount += itemVertexCount;
+                    cachedIndexCount += aFaces.size() * 3;
+                }
+            };
+            count(mesh.faces);
+            for (auto const& meshPatch : meshRenderer.patches)
+                count(meshPatch.faces);
         }
 
-        auto& vertexBuffer = static_cast<opengl_vertex_buffer<>&>(service<i_rendering_engine>().vertex_buffer(aVertexProvider));
-        auto& vertices = vertexBuffer.vertices();
-        if (!vertices.room_for(vertexCount - cachedVertexCount))
+        if (!vertices.room_for(vertexCount - cachedVertexCount) || !indices.room_for(indexCount - cachedIndexCount))
         {
             vertexBuffer.execute();
             vertices.clear();
+            indices.clear();
+            sharedMeshes.clear();
             for (auto md = aFirst; md != aLast; ++md)
             {
                 auto& meshDrawable = *md;
@@ -2071,12 +2369,143 @@ namespace neogfx
                     game::set_render_cache_invalid_no_lock(*cache, meshDrawable.entity);
             }
         }
+        else if (instanceCount != 0u && !instances.room_for(instanceCount))
+        {
+            // the instance buffer is rewound whenever the GPU is drained (every frame for ECS buffers) so this only
+            // happens when a single frame draws more instances than the buffer holds
+            vertexBuffer.execute();
+        }
+
+        auto upload_shared_mesh = [&](game::mesh const& aMesh) -> opengl_vertex_buffer<>::shared_mesh const&
+        {
+            auto existing = sharedMeshes.find(aMesh.generation);
+            if (existing != sharedMeshes.end())
+            {
+                existing->second.used = true;
+                return existing->second;
+            }
+            vertexMap.assign(aMesh.vertices.size(), UnmappedVertex);
+            auto const firstMeshVertex = bakeList.meshVertices.size();
+            for (auto const& face : aMesh.faces)
+                for (auto faceVertexIndex : face)
+                    if (vertexMap[faceVertexIndex] == UnmappedVertex)
+                    {
+                        vertexMap[faceVertexIndex] = static_cast<uint32_t>(bakeList.meshVertices.size() - firstMeshVertex);
+                        bakeList.meshVertices.push_back(faceVertexIndex);
+                    }
+            auto const meshVertexCount = bakeList.meshVertices.size() - firstMeshVertex;
+            auto const vertexStartIndex = vertices.find_space_for(meshVertexCount);
+            if (vertexStartIndex + meshVertexCount > vertices.size())
+                vertices.extend(vertexStartIndex + meshVertexCount - vertices.size());
+            auto& job = bakeList.jobs.emplace_back();
+            job.mesh = &aMesh;
+            job.firstMeshVertex = firstMeshVertex;
+            job.count = meshVertexCount;
+            job.destination = vertexStartIndex;
+            job.transformed = false;
+            job.rgba = vec4f{ 1.0f, 1.0f, 1.0f, 1.0f };
+            job.function = vec4f{};
+            job.textured = (aMesh.uv.size() == aMesh.vertices.size());
+            job.uvScale = vec2f{ 1.0f, 1.0f };
+            job.uvOffset = vec2f{};
+            bakeList.vertexCount += meshVertexCount;
+            auto const indexStartIndex = indices.find_space_for(aMesh.faces.size() * 3);
+            auto nextElement = indexStartIndex;
+            for (auto const& face : aMesh.faces)
+                for (auto faceVertexIndex : face)
+                {
+                    auto const element = static_cast<uint32_t>(vertexStartIndex + vertexMap[faceVertexIndex]);
+                    if (nextElement == indices.size())
+                        indices.push_back(element);
+                    else
+                        indices[nextElement] = element;
+                    ++nextElement;
+                }
+            auto& uploaded = sharedMeshes[aMesh.generation];
+            uploaded.vertexArrayIndices = vec2u32{ static_cast<uint32_t>(vertexStartIndex), static_cast<uint32_t>(vertexStartIndex + meshVertexCount) };
+            uploaded.indexArrayIndices = vec2u32{ static_cast<uint32_t>(indexStartIndex), static_cast<uint32_t>(nextElement) };
+            uploaded.used = true;
+            return uploaded;
+        };
+
+        auto texture_rect = [&](game::mesh_renderer const& aMeshRenderer, game::material const& aMaterial) -> vec4f
+        {
+            if (!patch_drawable::has_texture(aMeshRenderer, aMaterial))
+                return vec4f{ 1.0f, 1.0f, 0.0f, 0.0f };
+            auto const& materialTexture = patch_drawable::texture(aMeshRenderer, aMaterial);
+            auto const& texture = *service<i_texture_manager>().find_texture(materialTexture.id.cookie());
+            auto const textureStorageExtents = texture.storage_extents().to_vec2();
+            vec2 uvFixupOffset;
+            if (materialTexture.type == texture_type::Texture)
+                uvFixupOffset = vec2{ 1.0, 1.0 };
+            else if (materialTexture.subTexture == std::nullopt)
+                uvFixupOffset = texture.as_sub_texture().atlas_location().top_left().to_vec2() + vec2{ 1.0, 1.0 };
+            else
+                uvFixupOffset = materialTexture.subTexture->min + vec2{ 1.0, 1.0 };
+            auto scale = materialTexture.extents.scale(1.0 / textureStorageExtents).as<float>();
+            auto offset = uvFixupOffset.scale(1.0 / textureStorageExtents).as<float>();
+            if (texture.is_render_target() && texture.as_render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui)
+            {
+                auto const uvGui = static_cast<float>(texture.extents().to_vec2().y / textureStorageExtents.y);
+                scale.y = -scale.y;
+                offset.y = uvGui - offset.y;
+            }
+            return vec4f{ scale.x, scale.y, offset.x, offset.y };
+        };
 
         for (auto md = aFirst; md != aLast; ++md)
         {
             auto& meshDrawable = *md;
             auto& meshFilter = *meshDrawable.filter;
             auto& meshRenderer = *meshDrawable.renderer;
+            if (instanceable(meshDrawable))
+            {
+                // consecutive drawables only, so that painter's order is preserved
+                auto const& sharedMesh = *meshFilter.sharedMesh.ptr;
+                auto const& material = meshRenderer.material;
+                auto runEnd = std::next(md);
+                while (runEnd != aLast && instanceable(*runEnd) && runEnd->filter->sharedMesh.ptr == &sharedMesh &&
+                    game::batchable(runEnd->renderer->material, material))
+                    ++runEnd;
+                auto const& uploaded = upload_shared_mesh(sharedMesh);
+                auto const instanceStart = instances.size();
+                for (auto instance = md; instance != runEnd; ++instance)
+                {
+                    auto const& instanceMaterial = instance->renderer->material;
+                    instances.emplace_back();
+                    auto& attributes = instances.back();
+                    attributes.transformation = instance->transformation ? instance->transformation->as<float>() : mat44f::identity();
+                    attributes.rgba = instanceMaterial.color != std::nullopt ? instanceMaterial.color->rgba.as<float>() : vec4f{ 1.0f, 1.0f, 1.0f, 1.0f };
+                    attributes.rgba[3] *= static_cast<float>(iOpacity);
+                    attributes.textureRect = texture_rect(*instance->renderer, instanceMaterial);
+                    if (instance->entity != null_entity)
+                    {
+                        // space baked for the entity before it was drawn instanced is given back
+                        auto const& instanceCache = cache->entity_record_no_lock(instance->entity, true);
+                        if (instanceCache.state != game::cache_state::Invalid)
+                        {
+                            vertices.reclaim(instanceCache.meshVertexArrayIndices[0], instanceCache.meshVertexArrayIndices[1]);
+                            indices.reclaim(instanceCache.meshIndexArrayIndices[0], instanceCache.meshIndexArrayIndices[1]);
+                            for (auto const& range : instanceCache.patchVertexArrayIndices)
+                                vertices.reclaim(range[0], range[1]);
+                            for (auto const& range : instanceCache.patchIndexArrayIndices)
+                                indices.reclaim(range[0], range[1]);
+                        }
+                        instanceCache.meshVertexArrayIndices = {};
+                        instanceCache.meshIndexArrayIndices = {};
+                        instanceCache.patchVertexArrayIndices.clear();
+                        instanceCache.patchIndexArrayIndices.clear();
+                        instanceCache.state = game::cache_state::Clean;
+                    }
+                }
+                auto& item = patchDrawable.items.emplace_back(meshDrawable, 
+                    uploaded.vertexArrayIndices[0], uploaded.vertexArrayIndices[1], uploaded.indexArrayIndices[0], uploaded.indexArrayIndices[1], 
+                    material, sharedMesh.faces);
+                item.instanceStart = instanceStart;
+                item.instanceCount = static_cast<std::size_t>(runEnd - md);
+                md = std::prev(runEnd);
+                continue;
+            }
             thread_local game::mesh_render_cache ignore;
             ignore = {};
             auto const& meshRenderCache = (meshDrawable.entity != null_entity ? cache->entity_record_no_lock(meshDrawable.entity, true) : ignore);
@@ -2088,7 +2517,7 @@ namespace neogfx
             vec2 uvFixupCoefficient;
             vec2 uvFixupOffset;
             std::optional<neolib::cookie> textureId;
-            auto add_item = [&](vec2u32& cacheIndices, auto const& mesh, auto const& material, auto const& faces)
+            auto add_item = [&](vec2u32& cacheVertexIndices, vec2u32& cacheIndexIndices, auto const& mesh, auto const& material, auto const& faces)
             {
                 auto const function = material.gradient != std::nullopt && material.gradient->boundingBox ?
                     vec4{
@@ -2122,32 +2551,71 @@ namespace neogfx
                                 uvGui = static_cast<float>(texture.extents().to_vec2().y / textureStorageExtents.y);
                         }
                     }
-                    // todo: check vertex count is same as in cache
-                    auto const vertexStartIndex = (meshRenderCache.state != game::cache_state::Invalid ? cacheIndices[0] : vertices.find_space_for(faces.size() * 3));
-                    auto nextIndex = vertexStartIndex;
+                    // each mesh vertex referenced by the faces is written once; the faces become indices into the vertex array
+                    vertexMap.assign(mesh.vertices.size(), UnmappedVertex);
+                    auto const firstMeshVertex = bakeList.meshVertices.size();
+                    for (auto const& face : faces)
+                        for (auto faceVertexIndex : face)
+                            if (vertexMap[faceVertexIndex] == UnmappedVertex)
+                            {
+                                vertexMap[faceVertexIndex] = static_cast<uint32_t>(bakeList.meshVertices.size() - firstMeshVertex);
+                                bakeList.meshVertices.push_back(faceVertexIndex);
+                            }
+                    auto const itemVertexCount = bakeList.meshVertices.size() - firstMeshVertex;
+                    // cached space is rewritten in place only if it is still the right size (an entity previously drawn
+                    // instanced has none)
+                    bool const reuseVertices = meshRenderCache.state != game::cache_state::Invalid &&
+                        cacheVertexIndices[1] - cacheVertexIndices[0] == itemVertexCount;
+                    bool const reuseIndices = meshRenderCache.state != game::cache_state::Invalid &&
+                        cacheIndexIndices[1] - cacheIndexIndices[0] == faces.size() * 3;
+                    if (!reuseVertices && meshRenderCache.state != game::cache_state::Invalid)
+                        vertices.reclaim(cacheVertexIndices[0], cacheVertexIndices[1]);
+                    if (!reuseIndices && meshRenderCache.state != game::cache_state::Invalid)
+                        indices.reclaim(cacheIndexIndices[0], cacheIndexIndices[1]);
+                    auto const vertexStartIndex = (reuseVertices ? cacheVertexIndices[0] : vertices.find_space_for(itemVertexCount));
+                    if (vertexStartIndex + itemVertexCount > vertices.size())
+                        vertices.extend(vertexStartIndex + itemVertexCount - vertices.size());
+                    auto const nextIndex = vertexStartIndex + itemVertexCount;
+                    // the vertices themselves are written by bake_vertices once every item has been placed
+                    auto& job = bakeList.jobs.emplace_back();
+                    job.mesh = &mesh;
+                    job.firstMeshVertex = firstMeshVertex;
+                    job.count = itemVertexCount;
+                    job.destination = vertexStartIndex;
+                    job.transformed = (transformation != std::nullopt);
+                    if (job.transformed)
+                        job.transformation = to_affine_transformation(*transformation);
+                    job.rgba = (material.color != std::nullopt ? material.color->rgba.as<float>() : vec4f{ 1.0f, 1.0f, 1.0f, 1.0f });
+                    job.rgba[3] *= static_cast<float>(iOpacity);
+                    job.function = function;
+                    job.textured = patch_drawable::has_texture(meshRenderer, material);
+                    if (job.textured)
+                    {
+                        job.uvScale = uvFixupCoefficient.scale(1.0 / textureStorageExtents).as<float>();
+                        job.uvOffset = uvFixupOffset.scale(1.0 / textureStorageExtents).as<float>();
+                    }
+                    job.uvGui = uvGui;
+                    bakeList.vertexCount += itemVertexCount;
+                    auto const indexStartIndex = (reuseIndices ? cacheIndexIndices[0] : indices.find_space_for(faces.size() * 3));
+                    auto nextElement = indexStartIndex;
                     for (auto const& face : faces)
                     {
                         for (auto faceVertexIndex : face)
                         {
-                            auto const& xyz = (transformation? *transformation * mesh.vertices[faceVertexIndex] : mesh.vertices[faceVertexIndex]);
-                            auto const& rgba = (material.color != std::nullopt ? material.color->rgba.as<float>() : vec4f{ 1.0f, 1.0f, 1.0f, 1.0f });
-                            auto const& uv = (patch_drawable::has_texture(meshRenderer, material) ?
-                                (mesh.uv[faceVertexIndex].scale(uvFixupCoefficient) + uvFixupOffset).scale(1.0 / textureStorageExtents) : vec2{});
-                            auto const& xyzw = function;
-                            if (nextIndex == vertices.size())
-                                vertices.emplace_back(xyz, rgba, uv, xyzw );
+                            auto const element = static_cast<uint32_t>(vertexStartIndex + vertexMap[faceVertexIndex]);
+                            if (nextElement == indices.size())
+                                indices.push_back(element);
                             else
-                                vertices[nextIndex] = { xyz, rgba, uv, xyzw };
-                            if (uvGui)
-                                vertices[nextIndex].st.y = *uvGui - vertices[nextIndex].st.y;
-                            vertices[nextIndex].rgba[3] *= static_cast<float>(iOpacity);
-                            ++nextIndex;
+                                indices[nextElement] = element;
+                            ++nextElement;
                         }
                     }
-                    cacheIndices[0] = static_cast<uint32_t>(vertexStartIndex);
-                    cacheIndices[1] = static_cast<uint32_t>(nextIndex);
+                    cacheVertexIndices[0] = static_cast<uint32_t>(vertexStartIndex);
+                    cacheVertexIndices[1] = static_cast<uint32_t>(nextIndex);
+                    cacheIndexIndices[0] = static_cast<uint32_t>(indexStartIndex);
+                    cacheIndexIndices[1] = static_cast<uint32_t>(nextElement);
                 }
-                patchDrawable.items.emplace_back(meshDrawable, cacheIndices[0], cacheIndices[1], material, faces);
+                patchDrawable.items.emplace_back(meshDrawable, cacheVertexIndices[0], cacheVertexIndices[1], cacheIndexIndices[0], cacheIndexIndices[1], material, faces);
             };
 #if defined(NEOGFX_DEBUG) && !defined(NDEBUG)
             if (meshDrawable.entity != game::null_entity &&
@@ -2155,17 +2623,21 @@ namespace neogfx
                 service<debug::logger>() << "Adding debug::layoutItem entity drawable..." << endl;
 #endif // NEOGFX_DEBUG
             if (!faces.empty())
-                add_item(meshRenderCache.meshVertexArrayIndices, mesh, material, faces);
+                add_item(meshRenderCache.meshVertexArrayIndices, meshRenderCache.meshIndexArrayIndices, mesh, material, faces);
             auto const patchCount = meshRenderer.patches.size();
             meshRenderCache.patchVertexArrayIndices.resize(patchCount);
+            meshRenderCache.patchIndexArrayIndices.resize(patchCount);
             for (std::size_t patchIndex = 0; patchIndex < patchCount; ++patchIndex)
             {
                 auto& patch = meshRenderer.patches[patchIndex];
-                add_item(meshRenderCache.patchVertexArrayIndices[patchIndex], mesh, patch.material, patch.faces);
+                add_item(meshRenderCache.patchVertexArrayIndices[patchIndex], meshRenderCache.patchIndexArrayIndices[patchIndex], mesh, patch.material, patch.faces);
             }
             meshRenderCache.state = game::cache_state::Clean;
         }
 
+        if (!bakeList.jobs.empty())
+            bake_vertices(bakeList, vertices.begin());
+
         draw_patch(patchDrawable, aTransformation);
     }
 
@@ -2180,6 +2652,8 @@ namespace neogfx
 
         auto& vertexBuffer = static_cast<opengl_vertex_buffer<>&>(service<i_rendering_engine>().vertex_buffer(*aPatch.provider));
         auto& vertices = vertexBuffer.vertices();
+        auto& indices = vertexBuffer.indices();
+        auto& instances = vertexBuffer.instances();
 
         for (auto item = aPatch.items.begin(); item != aPatch.items.end();)
         {
@@ -2188,9 +2662,38 @@ namespace neogfx
             auto const& batchRenderer = *item->meshDrawable->renderer;
             auto const& batchMaterial = *item->material;
 
-            auto calc_bounding_rect = [&vertices, &aPatch](const patch_drawable::item& aItem) -> rect
+            auto calc_bounding_rect = [&vertices, &indices, &instances](const patch_drawable::item& aItem) -> rect
             {
-                return game::bounding_rect(vertices, *aItem.faces, mat44f::identity(), aItem.vertexArrayIndexStart);
+                if (aItem.indexArrayIndexStart == aItem.indexArrayIndexEnd)
+                    return rect{};
+                point topLeft{ vertices[indices[aItem.indexArrayIndexStart]].xyz };
+                point bottomRight = topLeft;
+                for (auto index = aItem.indexArrayIndexStart; index != aItem.indexArrayIndexEnd; ++index)
+                {
+                    point const v{ vertices[indices[index]].xyz };
+                    topLeft = topLeft.min(v);
+                    bottomRight = bottomRight.max(v);
+                }
+                if (aItem.instanceCount == 0u)
+                    return rect{ topLeft, bottomRight };
+                // the vertices of an instanced item are untransformed; its output size is that of its largest instance
+                size largest;
+                for (auto instance = aItem.instanceStart; instance != aItem.instanceStart + aItem.instanceCount; ++instance)
+                {
+                    auto const& transformation = instances[instance].transformation;
+                    point instanceTopLeft;
+                    point instanceBottomRight;
+                    bool first = true;
+                    for (auto const& corner : { topLeft, point{ bottomRight.x, topLeft.y }, bottomRight, point{ topLeft.x, bottomRight.y } })
+                    {
+                        point const v{ transformation * vec3f{ static_cast<float>(corner.x), static_cast<float>(corner.y), 0.0f } };
+                        instanceTopLeft = first ? v : instanceTopLeft.min(v);
+                        instanceBottomRight = first ? v : instanceBottomRight.max(v);
+                        first = false;
+                    }
+                    largest = largest.max(size{ instanceBottomRight.x - instanceTopLeft.x, instanceBottomRight.y - instanceTopLeft.y });
+                }
+                return rect{ topLeft, largest };
             };
 
             auto calc_sampling = [&aPatch, &calc_bounding_rect](const patch_drawable::item& aItem) -> texture_sampling
@@ -2216,7 +2719,8 @@ namespace neogfx
             auto next = std::next(item);
 
             while (next != aPatch.items.end() &&
-                std::prev(next)->vertexArrayIndexEnd == next->vertexArrayIndexStart &&
+                item->instanceCount == 0u && next->instanceCount == 0u &&
+                std::prev(next)->indexArrayIndexEnd == next->indexArrayIndexStart &&
                 game::batchable(*item->material, *next->material) && 
                 sampling == calc_sampling(*next))
             {   
@@ -2224,6 +2728,19 @@ namespace neogfx
                 ++next;
             }
 
+            auto draw_item = [&](std::size_t aFaceCount)
+            {
+                if (item->instanceCount == 0u)
+                {
+                    vertexArrayUsage->draw_elements(item->indexArrayIndexStart, aFaceCount * 3);
+                    return;
+                }
+                auto& vertexMatrices = rendering_engine().default_shader_program().vertex_shader().standard_vertex_matrices();
+                vertexMatrices.set_instanced(true);
+                vertexArrayUsage->draw_elements_instanced(item->indexArrayIndexStart, aFaceCount * 3, item->instanceStart, item->instanceCount);
+                vertexMatrices.set_instanced(false);
+            };
+
             if (item->material->gradient)
                 rendering_engine().default_shader_program().gradient_shader().set_gradient(*this, *item->material->gradient, iOpacity);
             else if (iGradient)
@@ -2243,6 +2760,9 @@ namespace neogfx
             {
                 auto const& texture = *service<i_texture_manager>().find_texture(item->texture().id.cookie());
 
+                // glyphs rasterized since this flush began may still be queued for upload
+                rendering_engine().texture_manager().flush_uploads();
+
                 glCheck(glActiveTexture(sampling != texture_sampling::Multisample ? GL_TEXTURE1 : GL_TEXTURE2));
 
                 previousTexture.emplace(0);
@@ -2275,7 +2795,7 @@ namespace neogfx
                     service<debug::logger>() << "Drawing debug::layoutItem entity (texture)..." << endl;
 
 #endif // NEOGFX_DEBUG
-                vertexArrayUsage->draw(item->vertexArrayIndexStart, faceCount * 3);
+                draw_item(faceCount);
             }
             else
             {
@@ -2290,7 +2810,7 @@ namespace neogfx
                     service<debug::logger>() << "Drawing debug::layoutItem entity (non-texture)..." << endl;
 
 #endif // NEOGFX_DEBUG
-                vertexArrayUsage->draw(item->vertexArrayIndexStart, faceCount * 3);
+                draw_item(faceCount);
             }
 
             item = next;
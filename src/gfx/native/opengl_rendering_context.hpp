@@ -41,12 +41,13 @@ namespace neogfx
     class opengl_rendering_context : public i_rendering_context
     {
     public:
-        class standard_batching : public i_vertex_provider
+        template <vertex_buffer_type Type = vertex_buffer_type::Default>
+        class basic_batching : public i_vertex_provider
         {
         public:
-            standard_batching()
+            basic_batching()
             {
-                static auto& sVertexBuffer = service<i_rendering_engine>().allocate_vertex_buffer(*this);
+                static auto& sVertexBuffer = service<i_rendering_engine>().allocate_vertex_buffer(*this, Type);
             }
         public:
             bool cacheable() const override
@@ -62,6 +63,9 @@ namespace neogfx
                 throw not_cacheable();
             }
         };
+        typedef basic_batching<> standard_batching;
+        // solid color geometry is batched in a separate buffer using the compact color_vertex format
+        typedef basic_batching<vertex_buffer_type::Vertices | vertex_buffer_type::Color> color_batching;
         class scoped_anti_alias
         {
         public:
@@ -228,6 +232,11 @@ namespace neogfx
                 typedef opengl_vertex_buffer<>::vertex_array vertices;
                 vertices::size_type vertexArrayIndexStart;
                 vertices::size_type vertexArrayIndexEnd;
+                typedef opengl_vertex_buffer<>::index_array indices;
+                indices::size_type indexArrayIndexStart = 0;
+                indices::size_type indexArrayIndexEnd = 0;
+                std::size_t instanceStart = 0; // instanced draw of instanceCount records from the instance array, if non-zero
+                std::size_t instanceCount = 0;
                 game::material const* material;
                 game::faces const* faces;
                 item(mesh_drawable& meshDrawable, vertices::size_type vertexArrayIndexStart, vertices::size_type vertexArrayIndexEnd) :
@@ -238,6 +247,8 @@ namespace neogfx
                     meshDrawable{ &meshDrawable }, vertexArrayIndexStart{ vertexArrayIndexStart }, vertexArrayIndexEnd{ vertexArrayIndexEnd }, material{ &material }, faces{ nullptr } {}
                 item(mesh_drawable& meshDrawable, vertices::size_type vertexArrayIndexStart, vertices::size_type vertexArrayIndexEnd, game::material const& material, game::faces const& faces) :
                     meshDrawable{ &meshDrawable }, vertexArrayIndexStart{ vertexArrayIndexStart }, vertexArrayIndexEnd{ vertexArrayIndexEnd }, material{ &material }, faces{ &faces } {}
+                item(mesh_drawable& meshDrawable, vertices::size_type vertexArrayIndexStart, vertices::size_type vertexArrayIndexEnd, indices::size_type indexArrayIndexStart, indices::size_type indexArrayIndexEnd, game::material const& material, game::faces const& faces) :
+                    meshDrawable{ &meshDrawable }, vertexArrayIndexStart{ vertexArrayIndexStart }, vertexArrayIndexEnd{ vertexArrayIndexEnd }, indexArrayIndexStart{ indexArrayIndexStart }, indexArrayIndexEnd{ indexArrayIndexEnd }, material{ &material }, faces{ &faces } {}
                 bool has_texture() const
                 {
                     return patch_drawable::has_texture(*meshDrawable->renderer, *material);
@@ -370,5 +381,10 @@ namespace neogfx
             static standard_batching sProvider;
             return sProvider;
         }
+        static color_batching& as_color_vertex_provider()
+        {
+            static color_batching sProvider;
+            return sProvider;
+        }
     };
 }
\ No newline at end of file
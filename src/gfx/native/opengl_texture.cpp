@@ -24,6 +24,7 @@
 #include "opengl_helpers.hpp"
 #include "opengl_rendering_context.hpp"
 #include "opengl_texture.hpp"
+#include "opengl_texture_manager.hpp"
 
 namespace neogfx
 {
@@ -45,6 +46,7 @@ namespace neogfx
                     throw std::logic_error("neogfx::to_gl_enum: bad data type");
                 }
             case texture_data_format::Red:
+            case texture_data_format::DistanceField:
                 switch (aDataType)
                 {
                 case texture_data_type::UnsignedByte:
@@ -271,6 +273,7 @@ namespace neogfx
     template <typename T>
     opengl_texture<T>::~opengl_texture()
     {
+        manager().cancel_uploads(iHandle);
         if (iFrameBuffer != 0)
         {
             glCheck(glDeleteRenderbuffers(1, &iDepthStencilBuffer));
@@ -403,6 +406,8 @@ namespace neogfx
         auto const adjustedRect = aRect + (sampling() != texture_sampling::Data ? point{ 1.0, 1.0 } : point{ 0.0, 0.0 });
         if (sampling() != texture_sampling::Multisample)
         {
+            // queued writes must land first or they would overwrite this one when flushed
+            flush_pending_uploads();
             GLint previousTexture = bind(1);
             GLint previousPackAlignment;
             glCheck(glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousPackAlignment))
@@ -485,6 +490,17 @@ namespace neogfx
         return resident == GL_TRUE;
     }
 
+    template <typename T>
+    void opengl_texture<T>::queue_pixels(const rect& aRect, const void* aPixelData, uint32_t aPackAlignment)
+    {
+        if (sampling() == texture_sampling::Multisample)
+            throw unsupported_sampling_type_for_function();
+        auto const adjustedRect = aRect + (sampling() != texture_sampling::Data ? point{ 1.0, 1.0 } : point{ 0.0, 0.0 });
+        manager().queue_upload(iHandle, to_gl_enum(sampling()), adjustedRect,
+            std::get<1>(to_gl_enum(iDataFormat, kDataType)), std::get<2>(to_gl_enum(iDataFormat, kDataType)),
+            sizeof(value_type), static_cast<GLint>(aPackAlignment), sampling() == texture_sampling::NormalMipmap, aPixelData);
+    }
+
     template <typename T>
     dimension opengl_texture<T>::horizontal_dpi() const
     {
@@ -524,6 +540,8 @@ namespace neogfx
     template <typename T>
     int32_t opengl_texture<T>::bind(const std::optional<uint32_t>& aTextureUnit) const
     {
+        // textures created or written mid-flush (gradient samplers, glyphs) must be complete before they are sampled
+        flush_pending_uploads();
         if (aTextureUnit != std::nullopt)
             glCheck(glActiveTexture(GL_TEXTURE0 + *aTextureUnit));
         GLint previousTexture = 0;
@@ -738,6 +756,7 @@ namespace neogfx
     {
         if (sampling() != neogfx::texture_sampling::Multisample)
         {
+            flush_pending_uploads();
             scoped_render_target srt{ *this };
             avec4u8 pixel;
             basic_point<GLint> pos{ aPosition };
@@ -748,6 +767,19 @@ namespace neogfx
             throw std::logic_error("neogfx::opengl_texture::read_pixel: not yet implemented for multisample render targets");
     }
 
+    template <typename T>
+    opengl_texture_manager& opengl_texture<T>::manager() const
+    {
+        return static_cast<opengl_texture_manager&>(iManager);
+    }
+
+    template <typename T>
+    void opengl_texture<T>::flush_pending_uploads() const
+    {
+        if (manager().upload_pending(iHandle))
+            manager().flush_uploads();
+    }
+
     template class opengl_texture<uint8_t>;
     template class opengl_texture<float>;
     template class opengl_texture<avec4u8>;
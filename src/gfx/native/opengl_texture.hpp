@@ -29,6 +29,7 @@
 namespace neogfx
 {
     class i_texture_manager;
+    class opengl_texture_manager;
 
     template <typename T>
     class opengl_texture : public reference_counted<i_native_texture>
@@ -75,6 +76,7 @@ namespace neogfx
     public:
         void* handle() const override;
         bool is_resident() const override;
+        void queue_pixels(const rect& aRect, const void* aPixelData, uint32_t aPackAlignment = 4u) override;
     public:
         dimension horizontal_dpi() const override;
         dimension vertical_dpi() const override;
@@ -111,6 +113,9 @@ namespace neogfx
     public:
         neogfx::color_space color_space() const override;
         color read_pixel(const point& aPosition) const override;
+    private:
+        opengl_texture_manager& manager() const;
+        void flush_pending_uploads() const;
     private:
         i_texture_manager& iManager;
         texture_id iId;
@@ -18,11 +18,19 @@
 */
 
 #include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include "opengl_error.hpp"
 #include "opengl_texture_manager.hpp"
 #include "opengl_texture.hpp"
 
 namespace neogfx
 {
+    opengl_texture_manager::~opengl_texture_manager()
+    {
+        if (iStagingBuffer != 0)
+            glCheck(glDeleteBuffers(1, &iStagingBuffer));
+    }
+
     void opengl_texture_manager::create_texture(const neogfx::size& aExtents, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat, texture_data_type aDataType, color_space aColorSpace, const optional_color& aColor, i_ref_ptr<i_texture>& aResult)
     {
         switch (aDataFormat)
@@ -42,6 +50,7 @@ namespace neogfx
             }
             break;
         case texture_data_format::Red:
+        case texture_data_format::DistanceField:
             switch (aDataType)
             {
             case texture_data_type::UnsignedByte:
@@ -81,6 +90,7 @@ namespace neogfx
             }
             break;
         case texture_data_format::Red:
+        case texture_data_format::DistanceField:
             switch (aDataType)
             {
             case texture_data_type::UnsignedByte:
@@ -94,4 +104,110 @@ namespace neogfx
             break;
         }
     }
+
+    void opengl_texture_manager::flush_uploads()
+    {
+        if (iPendingUploads.empty())
+            return;
+        if (iStagingBuffer == 0)
+            glCheck(glGenBuffers(1, &iStagingBuffer));
+        glCheck(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, iStagingBuffer));
+        iStagingBufferCapacity = std::max(iStagingBufferCapacity, iStagingData.size());
+        // orphan the previous contents so that we don't wait on the GPU still reading last frame's uploads
+        glCheck(glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(iStagingBufferCapacity), nullptr, GL_STREAM_DRAW));
+        glCheck(glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(iStagingData.size()), &iStagingData[0]));
+        GLint previousActiveTexture;
+        glCheck(glGetIntegerv(GL_ACTIVE_TEXTURE, &previousActiveTexture));
+        glCheck(glActiveTexture(GL_TEXTURE1));
+        GLint previousTexture2D;
+        GLint previousTextureRectangle;
+        GLint previousAlignment;
+        glCheck(glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture2D));
+        glCheck(glGetIntegerv(GL_TEXTURE_BINDING_RECTANGLE, &previousTextureRectangle));
+        glCheck(glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment));
+        GLint alignment = previousAlignment;
+        std::vector<std::pair<GLenum, GLuint>> mipmapped;
+        for (auto const& upload : iPendingUploads)
+        {
+            if (upload.alignment != alignment)
+            {
+                alignment = upload.alignment;
+                glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, alignment));
+            }
+            glCheck(glBindTexture(upload.target, upload.texture));
+            glCheck(glTexSubImage2D(upload.target, 0, upload.x, upload.y, upload.cx, upload.cy, upload.format, upload.type, reinterpret_cast<const void*>(upload.offset)));
+            // mipmaps are regenerated once per texture after all of its writes have landed
+            if (upload.mipmap && std::find(mipmapped.begin(), mipmapped.end(), std::make_pair(upload.target, upload.texture)) == mipmapped.end())
+                mipmapped.emplace_back(upload.target, upload.texture);
+        }
+        for (auto const& texture : mipmapped)
+        {
+            glCheck(glBindTexture(texture.first, texture.second));
+            glCheck(glGenerateMipmap(texture.first));
+        }
+        glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment));
+        glCheck(glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture2D)));
+        glCheck(glBindTexture(GL_TEXTURE_RECTANGLE, static_cast<GLuint>(previousTextureRectangle)));
+        glCheck(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        glCheck(glActiveTexture(static_cast<GLenum>(previousActiveTexture)));
+        auto& statistics = service<i_rendering_engine>().statistics();
+        ++statistics.textureUploadBatches;
+        statistics.textureUploads += iPendingUploads.size();
+        iPendingUploads.clear();
+        iPendingTextures.clear();
+        iStagingData.clear();
+    }
+
+    void opengl_texture_manager::queue_upload(GLuint aTexture, GLenum aTarget, const rect& aRect, GLenum aFormat, GLenum aType, std::size_t aPixelSize, GLint aAlignment, bool aMipmap, const void* aPixelData)
+    {
+        auto const cx = static_cast<GLsizei>(aRect.cx);
+        auto const cy = static_cast<GLsizei>(aRect.cy);
+        if (cx <= 0 || cy <= 0)
+            return;
+        // rows in the source data are padded to the unpack alignment but the last row need not be
+        auto const alignment = static_cast<std::size_t>(aAlignment);
+        auto const rowSize = static_cast<std::size_t>(cx) * aPixelSize;
+        auto const rowStride = (rowSize + alignment - 1u) / alignment * alignment;
+        auto const dataSize = rowStride * static_cast<std::size_t>(cy - 1) + rowSize;
+        // rows landing directly below the previous upload to the same texture extend it rather than costing another transfer
+        if (!iPendingUploads.empty())
+        {
+            auto& previous = iPendingUploads.back();
+            if (previous.texture == aTexture && previous.target == aTarget && previous.format == aFormat && previous.type == aType &&
+                previous.alignment == aAlignment && previous.mipmap == aMipmap && previous.x == static_cast<GLint>(aRect.x) && previous.cx == cx &&
+                previous.y + previous.cy == static_cast<GLint>(aRect.y))
+            {
+                auto const join = previous.offset + rowStride * static_cast<std::size_t>(previous.cy);
+                iStagingData.resize(join + dataSize);
+                std::copy(static_cast<const uint8_t*>(aPixelData), static_cast<const uint8_t*>(aPixelData) + dataSize, &iStagingData[join]);
+                previous.cy += cy;
+                return;
+            }
+        }
+        // buffer offsets must be a multiple of the pixel component size; keep every upload 16-byte aligned
+        auto const offset = (iStagingData.size() + 15u) & ~std::size_t{ 15u };
+        iStagingData.resize(offset + dataSize);
+        std::copy(static_cast<const uint8_t*>(aPixelData), static_cast<const uint8_t*>(aPixelData) + dataSize, &iStagingData[offset]);
+        iPendingUploads.push_back(pending_upload{ 
+            aTexture, aTarget, 
+            static_cast<GLint>(aRect.x), static_cast<GLint>(aRect.y), cx, cy, 
+            aFormat, aType, aAlignment, offset, aMipmap });
+        iPendingTextures.insert(aTexture);
+    }
+
+    bool opengl_texture_manager::upload_pending(GLuint aTexture) const
+    {
+        return iPendingTextures.find(aTexture) != iPendingTextures.end();
+    }
+
+    void opengl_texture_manager::cancel_uploads(GLuint aTexture)
+    {
+        if (!upload_pending(aTexture))
+            return;
+        iPendingUploads.erase(std::remove_if(iPendingUploads.begin(), iPendingUploads.end(), 
+            [aTexture](pending_upload const& aUpload) { return aUpload.texture == aTexture; }), iPendingUploads.end());
+        iPendingTextures.erase(aTexture);
+        if (iPendingUploads.empty())
+            iStagingData.clear();
+    }
 }
\ No newline at end of file
@@ -20,14 +20,45 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <vector>
+#include <unordered_set>
 #include <neogfx/gfx/texture_manager.hpp>
+#include "opengl.hpp"
 
 namespace neogfx
 {
     class opengl_texture_manager : public texture_manager
     {
+    private:
+        struct pending_upload
+        {
+            GLuint texture;
+            GLenum target;
+            GLint x;
+            GLint y;
+            GLsizei cx;
+            GLsizei cy;
+            GLenum format;
+            GLenum type;
+            GLint alignment;
+            std::size_t offset; // into the staging data
+            bool mipmap;
+        };
+    public:
+        ~opengl_texture_manager();
     public:
         void create_texture(const neogfx::size& aExtents, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat, texture_data_type aDataType, color_space aColorSpace, const optional_color& aColor, i_ref_ptr<i_texture>& aResult) override;
         void create_texture(const i_image& aImage, const rect& aImagePart, texture_data_format aDataFormat, texture_data_type aDataType, i_ref_ptr<i_texture>& aResult) override;
+        void flush_uploads() override;
+    public:
+        void queue_upload(GLuint aTexture, GLenum aTarget, const rect& aRect, GLenum aFormat, GLenum aType, std::size_t aPixelSize, GLint aAlignment, bool aMipmap, const void* aPixelData);
+        bool upload_pending(GLuint aTexture) const;
+        void cancel_uploads(GLuint aTexture);
+    private:
+        std::vector<pending_upload> iPendingUploads;
+        std::unordered_set<GLuint> iPendingTextures;
+        std::vector<uint8_t> iStagingData;
+        GLuint iStagingBuffer = 0;
+        std::size_t iStagingBufferCapacity = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,612 @@
+// software_rasterizer.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <cmath>
+#include <thread>
+#include <future>
+#include "software_rasterizer.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        // shaded span colours and coverage, one channel per row
+        struct span_buffer
+        {
+            std::vector<float> r;
+            std::vector<float> g;
+            std::vector<float> b;
+            std::vector<float> a;
+            std::vector<float> cr;
+            std::vector<float> cg;
+            std::vector<float> cb;
+            void resize(std::size_t aCount)
+            {
+                if (r.size() >= aCount)
+                    return;
+                r.resize(aCount);
+                g.resize(aCount);
+                b.resize(aCount);
+                a.resize(aCount);
+                cr.resize(aCount);
+                cg.resize(aCount);
+                cb.resize(aCount);
+            }
+        };
+
+        thread_local span_buffer tSpan;
+
+        inline float unorm(uint8_t aValue)
+        {
+            return aValue * (1.0f / 255.0f);
+        }
+
+        inline uint8_t to_unorm8(float aValue)
+        {
+            return static_cast<uint8_t>(std::max(0.0f, std::min(aValue, 1.0f)) * 255.0f + 0.5f);
+        }
+
+        inline float ellipse_radius(float aAbX, float aAbY, float aCenterX, float aCenterY, float aX, float aY, vec2f const& aExponents)
+        {
+            float const dx = aX - aCenterX;
+            float const dy = aY - aCenterY;
+            float ratioX = 1.0f;
+            float ratioY = 1.0f;
+            if (aAbX >= aAbY)
+                ratioY = aAbX / aAbY;
+            else
+                ratioX = aAbY / aAbX;
+            float const angle = std::atan2(dy * ratioY, dx * ratioX);
+            float const c = std::cos(angle);
+            float const s = std::sin(angle);
+            float const x = std::pow(std::abs(c), 2.0f / aExponents.x) * (c < 0.0f ? -1.0f : 1.0f) * aAbX;
+            float const y = std::pow(std::abs(s), 2.0f / aExponents.y) * (s < 0.0f ? -1.0f : 1.0f) * aAbY;
+            return std::sqrt(x * x + y * y);
+        }
+
+        inline float distance(float aX1, float aY1, float aX2, float aY2)
+        {
+            return std::sqrt((aX2 - aX1) * (aX2 - aX1) + (aY2 - aY1) * (aY2 - aY1));
+        }
+    }
+
+    float software_rasterizer::gradient_ramp::position(float aX, float aY) const
+    {
+        float const sx = boundingBox[2] - boundingBox[0];
+        float const sy = boundingBox[3] - boundingBox[1];
+        if (sx <= 0.0f || sy <= 0.0f)
+            return 0.0f;
+        float x = std::max(std::min(aX - boundingBox[0], sx - 1.0f), 0.0f);
+        float y = std::max(std::min(aY - boundingBox[1], sy - 1.0f), 0.0f);
+        switch (direction)
+        {
+        case gradient_direction::Vertical:
+            return y / sy;
+        case gradient_direction::Horizontal:
+            return x / sx;
+        case gradient_direction::Diagonal:
+            {
+                float const cx = sx / 2.0f;
+                float const cy = sy / 2.0f;
+                float a;
+                switch (startFrom)
+                {
+                case 0:
+                    a = std::atan2(cy, -cx);
+                    break;
+                case 1:
+                    a = std::atan2(-cy, -cx);
+                    break;
+                case 2:
+                    a = std::atan2(-cy, cx);
+                    break;
+                case 3:
+                    a = std::atan2(cy, cx);
+                    break;
+                default:
+                    a = angle;
+                    break;
+                }
+                if (flipY)
+                    y = sy - y;
+                x -= cx;
+                y -= cy;
+                return (std::sin(a) * x + std::cos(a) * y + cy) / sy;
+            }
+        case gradient_direction::Rectangular:
+            {
+                float vert = y / sy;
+                if (vert > 0.5f)
+                    vert = 1.0f - vert;
+                float horz = x / sx;
+                if (horz > 0.5f)
+                    horz = 1.0f - horz;
+                return std::min(vert, horz) * 2.0f;
+            }
+        case gradient_direction::Radial:
+        default:
+            {
+                float const abx = sx / 2.0f;
+                float const aby = sy / 2.0f;
+                x -= abx;
+                y -= aby;
+                float const cx = abx * center.x;
+                float const cy = aby * center.y;
+                float const d = distance(cx, cy, x, y);
+                float const corners[4][2] = { { -abx, -aby }, { -abx, aby }, { abx, aby }, { abx, -aby } };
+                std::size_t closest = 0;
+                std::size_t farthest = 0;
+                for (std::size_t c = 1; c < 4; ++c)
+                {
+                    if (distance(cx, cy, corners[c][0], corners[c][1]) < distance(cx, cy, corners[closest][0], corners[closest][1]))
+                        closest = c;
+                    if (distance(cx, cy, corners[c][0], corners[c][1]) > distance(cx, cy, corners[farthest][0], corners[farthest][1]))
+                        farthest = c;
+                }
+                float const csx = std::min(std::abs(-abx + cx), std::abs(abx + cx));
+                float const csy = std::min(std::abs(-aby + cy), std::abs(aby + cy));
+                float const fsx = std::max(std::abs(-abx + cx), std::abs(abx + cx));
+                float const fsy = std::max(std::abs(-aby + cy), std::abs(aby + cy));
+                float r;
+                if (shape == gradient_shape::Ellipse)
+                {
+                    switch (size)
+                    {
+                    default:
+                    case gradient_size::ClosestSide:
+                        r = ellipse_radius(csx, csy, cx, cy, x, y, exponents);
+                        break;
+                    case gradient_size::FarthestSide:
+                        r = ellipse_radius(fsx, fsy, cx, cy, x, y, exponents);
+                        break;
+                    case gradient_size::ClosestCorner:
+                        r = ellipse_radius(std::abs(corners[closest][0] - cx), std::abs(corners[closest][1] - cy), cx, cy, x, y, exponents);
+                        break;
+                    case gradient_size::FarthestCorner:
+                        r = ellipse_radius(std::abs(corners[farthest][0] - cx), std::abs(corners[farthest][1] - cy), cx, cy, x, y, exponents);
+                        break;
+                    }
+                }
+                else
+                {
+                    switch (size)
+                    {
+                    default:
+                    case gradient_size::ClosestSide:
+                        r = std::min(csx, csy);
+                        break;
+                    case gradient_size::FarthestSide:
+                        r = std::max(fsx, fsy);
+                        break;
+                    case gradient_size::ClosestCorner:
+                        r = distance(corners[closest][0], corners[closest][1], cx, cy);
+                        break;
+                    case gradient_size::FarthestCorner:
+                        r = distance(corners[farthest][0], corners[farthest][1], cx, cy);
+                        break;
+                    }
+                }
+                return d < r ? d / r : 1.0f;
+            }
+        }
+    }
+
+    software_rasterizer::software_rasterizer(i_image& aTarget) :
+        iTarget{ aTarget },
+        iBlendingMode{ neogfx::blending_mode::Default },
+        iMaxThreads{ std::max(1u, std::thread::hardware_concurrency()) }
+    {
+        if (iTarget.color_format() != neogfx::color_format::RGBA8)
+            throw unsupported_color_format();
+    }
+
+    i_image& software_rasterizer::target() const
+    {
+        return iTarget;
+    }
+
+    size_u32 software_rasterizer::extents() const
+    {
+        return iTarget.extents().as<uint32_t>();
+    }
+
+    std::optional<rect_i32> const& software_rasterizer::clip() const
+    {
+        return iClip;
+    }
+
+    void software_rasterizer::set_clip(std::optional<rect_i32> const& aClip)
+    {
+        iClip = aClip;
+    }
+
+    neogfx::blending_mode software_rasterizer::blending_mode() const
+    {
+        return iBlendingMode;
+    }
+
+    void software_rasterizer::set_blending_mode(neogfx::blending_mode aBlendingMode)
+    {
+        iBlendingMode = aBlendingMode;
+    }
+
+    uint32_t software_rasterizer::max_threads() const
+    {
+        return iMaxThreads;
+    }
+
+    void software_rasterizer::set_max_threads(uint32_t aMaxThreads)
+    {
+        iMaxThreads = std::max(1u, aMaxThreads);
+    }
+
+    software_rasterizer::statistics const& software_rasterizer::stats() const
+    {
+        return iStats;
+    }
+
+    software_rasterizer::statistics& software_rasterizer::stats()
+    {
+        return iStats;
+    }
+
+    void software_rasterizer::reset_stats()
+    {
+        iStats = {};
+    }
+
+    void software_rasterizer::clear(const color& aColor)
+    {
+        auto const area = bounds();
+        if (area.cx <= 0 || area.cy <= 0)
+            return;
+        texel const value = { aColor.red(), aColor.green(), aColor.blue(), aColor.alpha() };
+        auto const stride = static_cast<std::size_t>(extents().cx);
+        auto pixels = static_cast<texel*>(iTarget.pixels());
+        for (int32_t y = area.y; y < area.y + area.cy; ++y)
+            std::fill(pixels + y * stride + area.x, pixels + y * stride + area.x + area.cx, value);
+    }
+
+    void software_rasterizer::set_pixel(const point_i32& aPoint, const color& aColor)
+    {
+        if (!bounds().contains(aPoint))
+            return;
+        auto pixels = static_cast<texel*>(iTarget.pixels());
+        pixels[static_cast<std::size_t>(aPoint.y) * extents().cx + aPoint.x] = texel{ aColor.red(), aColor.green(), aColor.blue(), aColor.alpha() };
+    }
+
+    void software_rasterizer::fill(triangle const* aFirst, triangle const* aLast, paint const* aPaints)
+    {
+        if (aFirst == aLast)
+            return;
+        auto const area = bounds();
+        if (area.cx <= 0 || area.cy <= 0)
+            return;
+
+        iStats.triangles += (aLast - aFirst);
+        ++iStats.batches;
+
+        float top = std::numeric_limits<float>::max();
+        float bottom = std::numeric_limits<float>::lowest();
+        uint64_t coverage = 0;
+        for (auto t = aFirst; t != aLast; ++t)
+        {
+            auto const& v = t->vertices;
+            auto const minX = std::min({ v[0].xy.x, v[1].xy.x, v[2].xy.x });
+            auto const maxX = std::max({ v[0].xy.x, v[1].xy.x, v[2].xy.x });
+            auto const minY = std::min({ v[0].xy.y, v[1].xy.y, v[2].xy.y });
+            auto const maxY = std::max({ v[0].xy.y, v[1].xy.y, v[2].xy.y });
+            top = std::min(top, minY);
+            bottom = std::max(bottom, maxY);
+            coverage += static_cast<uint64_t>(std::max(0.0f, std::min<float>(maxX, area.x + area.cx) - std::max<float>(minX, area.x))) *
+                static_cast<uint64_t>(std::max(0.0f, std::min<float>(maxY, area.y + area.cy) - std::max<float>(minY, area.y)));
+        }
+
+        int32_t const bandTop = std::max(area.y, static_cast<int32_t>(std::ceil(top - 0.5f)));
+        int32_t const bandBottom = std::min(area.y + area.cy, static_cast<int32_t>(std::ceil(bottom - 0.5f)));
+        if (bandTop >= bandBottom)
+            return;
+
+        auto const rows = static_cast<uint32_t>(bandBottom - bandTop);
+        auto const bandCount = coverage >= ParallelThreshold ? std::min(iMaxThreads, rows) : 1u;
+        if (bandCount <= 1u)
+        {
+            fill_band(aFirst, aLast, aPaints, bandTop, bandBottom, iStats);
+            return;
+        }
+
+        ++iStats.parallelBatches;
+        std::vector<statistics> bandStats(bandCount);
+        std::vector<std::future<void>> bands;
+        bands.reserve(bandCount - 1u);
+        auto band_top = [&](uint32_t aBand) { return bandTop + static_cast<int32_t>(static_cast<uint64_t>(rows) * aBand / bandCount); };
+        for (uint32_t band = 1u; band < bandCount; ++band)
+            bands.push_back(std::async(std::launch::async, [&, band]()
+            {
+                fill_band(aFirst, aLast, aPaints, band_top(band), band_top(band + 1u), bandStats[band]);
+            }));
+        fill_band(aFirst, aLast, aPaints, band_top(0u), band_top(1u), bandStats[0u]);
+        for (auto& band : bands)
+            band.get();
+        for (auto const& s : bandStats)
+        {
+            iStats.spans += s.spans;
+            iStats.pixels += s.pixels;
+        }
+    }
+
+    std::shared_ptr<const software_rasterizer::gradient_ramp> software_rasterizer::to_ramp(const gradient& aGradient, bool aGuiCoordinates, double aOpacity, const rect& aDeviceBoundingBox)
+    {
+        auto result = std::make_shared<gradient_ramp>();
+        result->direction = aGradient.direction();
+        result->startFrom = std::holds_alternative<corner>(aGradient.orientation()) ? static_cast<int32_t>(static_variant_cast<corner>(aGradient.orientation())) : -1;
+        result->angle = std::holds_alternative<double>(aGradient.orientation()) ? static_cast<float>(static_variant_cast<double>(aGradient.orientation())) : 0.0f;
+        result->flipY = aGuiCoordinates;
+        result->shape = aGradient.shape();
+        result->size = aGradient.size();
+        result->exponents = (aGradient.exponents() != std::nullopt ? *aGradient.exponents() : vec2{ 2.0, 2.0 }).as<float>();
+        result->center = aGradient.center() != std::nullopt ?
+            vec2f{ static_cast<float>(aGradient.center()->x), static_cast<float>(aGuiCoordinates ? aGradient.center()->y : -aGradient.center()->y) } : vec2f{};
+        result->boundingBox = vec4f{
+            static_cast<float>(aDeviceBoundingBox.left()), static_cast<float>(aDeviceBoundingBox.top()),
+            static_cast<float>(aDeviceBoundingBox.right()), static_cast<float>(aDeviceBoundingBox.bottom()) };
+        for (std::size_t i = 0; i < gradient_ramp::Resolution; ++i)
+        {
+            auto const c = aGradient.at(static_cast<scalar>(i) / (gradient_ramp::Resolution - 1u));
+            result->colors[i] = vec4f{ c.red<float>(), c.green<float>(), c.blue<float>(), c.alpha<float>() * static_cast<float>(aOpacity) };
+        }
+        return result;
+    }
+
+    rect_i32 software_rasterizer::bounds() const
+    {
+        rect_i32 const area{ point_i32{}, extents().as<int32_t>() };
+        if (iClip)
+            return area.intersection(*iClip);
+        return area;
+    }
+
+    void software_rasterizer::fill_band(triangle const* aFirst, triangle const* aLast, paint const* aPaints, int32_t aTop, int32_t aBottom, statistics& aStats) const
+    {
+        auto const area = bounds();
+        int32_t const left = area.x;
+        int32_t const right = area.x + area.cx;
+        for (auto t = aFirst; t != aLast; ++t)
+        {
+            auto const& v = t->vertices;
+            auto const& p = aPaints[t->paint];
+
+            float const x0 = v[0].xy.x, y0 = v[0].xy.y;
+            float const dx1 = v[1].xy.x - x0, dy1 = v[1].xy.y - y0;
+            float const dx2 = v[2].xy.x - x0, dy2 = v[2].xy.y - y0;
+            float const det = dx1 * dy2 - dx2 * dy1;
+            if (std::abs(det) < 1e-6f)
+                continue;
+
+            std::array<float, 6> texelMap = {};
+            if (p.type == paint_type::Texture)
+            {
+                for (std::size_t c = 0; c < 2; ++c)
+                {
+                    float const u0 = v[0].uv[c];
+                    float const du1 = v[1].uv[c] - u0;
+                    float const du2 = v[2].uv[c] - u0;
+                    float const a = (du1 * dy2 - du2 * dy1) / det;
+                    float const b = (dx1 * du2 - dx2 * du1) / det;
+                    texelMap[c * 3 + 0] = a;
+                    texelMap[c * 3 + 1] = b;
+                    texelMap[c * 3 + 2] = u0 - a * x0 - b * y0;
+                }
+            }
+
+            auto const minY = std::min({ v[0].xy.y, v[1].xy.y, v[2].xy.y });
+            auto const maxY = std::max({ v[0].xy.y, v[1].xy.y, v[2].xy.y });
+            int32_t const rowBegin = std::max(aTop, static_cast<int32_t>(std::ceil(minY - 0.5f)));
+            int32_t const rowEnd = std::min(aBottom, static_cast<int32_t>(std::ceil(maxY - 0.5f)));
+
+            // edges are always evaluated from their upper vertex so that triangles sharing an edge agree exactly on span ends
+            std::array<std::pair<vec2f, vec2f>, 3> edges;
+            for (std::size_t e = 0; e < 3; ++e)
+            {
+                auto const& a = v[e].xy;
+                auto const& b = v[(e + 1) % 3].xy;
+                edges[e] = (a.y < b.y || (a.y == b.y && a.x < b.x)) ? std::make_pair(a, b) : std::make_pair(b, a);
+            }
+
+            for (int32_t y = rowBegin; y < rowEnd; ++y)
+            {
+                float const yc = y + 0.5f;
+                float xl = std::numeric_limits<float>::max();
+                float xr = std::numeric_limits<float>::lowest();
+                uint32_t crossings = 0;
+                for (auto const& edge : edges)
+                {
+                    if (edge.first.y <= yc && yc < edge.second.y)
+                    {
+                        float const x = edge.first.x + (yc - edge.first.y) * (edge.second.x - edge.first.x) / (edge.second.y - edge.first.y);
+                        xl = std::min(xl, x);
+                        xr = std::max(xr, x);
+                        ++crossings;
+                    }
+                }
+                if (crossings < 2)
+                    continue;
+                int32_t const spanBegin = std::max(left, static_cast<int32_t>(std::ceil(xl - 0.5f)));
+                int32_t const spanEnd = std::min(right, static_cast<int32_t>(std::ceil(xr - 0.5f)));
+                if (spanBegin >= spanEnd)
+                    continue;
+                fill_span(p, texelMap, y, spanBegin, spanEnd);
+                ++aStats.spans;
+                aStats.pixels += (spanEnd - spanBegin);
+            }
+        }
+    }
+
+    void software_rasterizer::fill_span(paint const& aPaint, std::array<float, 6> const& aTexelMap, int32_t aY, int32_t aX0, int32_t aX1) const
+    {
+        auto const count = static_cast<std::size_t>(aX1 - aX0);
+        auto& span = tSpan;
+        span.resize(count);
+        float* const r = span.r.data();
+        float* const g = span.g.data();
+        float* const b = span.b.data();
+        float* const a = span.a.data();
+        float* const cr = span.cr.data();
+        float* const cg = span.cg.data();
+        float* const cb = span.cb.data();
+        auto const& pc = aPaint.color;
+
+        std::fill(cr, cr + count, 1.0f);
+        std::fill(cg, cg + count, 1.0f);
+        std::fill(cb, cb + count, 1.0f);
+
+        switch (aPaint.type)
+        {
+        case paint_type::Solid:
+            std::fill(r, r + count, pc[0]);
+            std::fill(g, g + count, pc[1]);
+            std::fill(b, b + count, pc[2]);
+            std::fill(a, a + count, pc[3]);
+            break;
+        case paint_type::Gradient:
+            {
+                float const yc = aY + 0.5f;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    auto const& c = aPaint.gradient->color_at(static_cast<float>(aX0 + static_cast<int32_t>(i)) + 0.5f, yc);
+                    r[i] = c[0] * pc[0];
+                    g[i] = c[1] * pc[1];
+                    b[i] = c[2] * pc[2];
+                    a[i] = c[3] * pc[3];
+                }
+            }
+            break;
+        case paint_type::Texture:
+            {
+                auto const& texels = *aPaint.texels;
+                float const yc = aY + 0.5f;
+                float u = aTexelMap[0] * (aX0 + 0.5f) + aTexelMap[1] * yc + aTexelMap[2];
+                float v = aTexelMap[3] * (aX0 + 0.5f) + aTexelMap[4] * yc + aTexelMap[5];
+                for (std::size_t i = 0; i < count; ++i, u += aTexelMap[0], v += aTexelMap[3])
+                {
+                    auto const& t = texels.at(static_cast<int32_t>(std::floor(u)), static_cast<int32_t>(std::floor(v)));
+                    if (texels.coverage)
+                    {
+                        r[i] = pc[0];
+                        g[i] = pc[1];
+                        b[i] = pc[2];
+                        a[i] = pc[3];
+                        if (texels.subpixel)
+                        {
+                            cr[i] = unorm(t[0]);
+                            cg[i] = unorm(t[1]);
+                            cb[i] = unorm(t[2]);
+                        }
+                        else
+                            cr[i] = cg[i] = cb[i] = unorm(t[0]);
+                        continue;
+                    }
+                    float tr = unorm(t[0]);
+                    float tg = unorm(t[1]);
+                    float tb = unorm(t[2]);
+                    float ta = unorm(t[3]);
+                    switch (aPaint.effect)
+                    {
+                    case shader_effect::None:
+                    default:
+                        break;
+                    case shader_effect::ColorizeAverage:
+                        tr = tg = tb = (tr + tg + tb) / 3.0f;
+                        break;
+                    case shader_effect::ColorizeMaximum:
+                        tr = tg = tb = std::max(tr, std::max(tg, tb));
+                        break;
+                    case shader_effect::ColorizeSpot:
+                        tr = tg = tb = 1.0f;
+                        break;
+                    case shader_effect::ColorizeAlpha:
+                        ta *= (tr + tg + tb) / 3.0f;
+                        tr = tg = tb = 1.0f;
+                        break;
+                    case shader_effect::Monochrome:
+                        tr = tg = tb = (pc[0] * tr * 0.299f + pc[1] * tg * 0.587f + pc[2] * tb * 0.114f);
+                        break;
+                    }
+                    r[i] = tr * pc[0];
+                    g[i] = tg * pc[1];
+                    b[i] = tb * pc[2];
+                    a[i] = ta * pc[3];
+                }
+                if (aPaint.gradient)
+                {
+                    // gradient ink (glyphs, colorized textures)
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        auto const& c = aPaint.gradient->color_at(static_cast<float>(aX0 + static_cast<int32_t>(i)) + 0.5f, yc);
+                        r[i] *= c[0];
+                        g[i] *= c[1];
+                        b[i] *= c[2];
+                        a[i] *= c[3];
+                    }
+                }
+            }
+            break;
+        }
+
+        uint8_t* const dst = static_cast<uint8_t*>(iTarget.pixels()) + (static_cast<std::size_t>(aY) * extents().cx + aX0) * 4u;
+        switch (iBlendingMode)
+        {
+        case neogfx::blending_mode::None:
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                dst[i * 4 + 0] = to_unorm8(r[i]);
+                dst[i * 4 + 1] = to_unorm8(g[i]);
+                dst[i * 4 + 2] = to_unorm8(b[i]);
+                dst[i * 4 + 3] = to_unorm8(a[i]);
+            }
+            break;
+        case neogfx::blending_mode::Blit:
+            // GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                float const ca = a[i] * (cr[i] + cg[i] + cb[i]) * (1.0f / 3.0f);
+                dst[i * 4 + 0] = to_unorm8(r[i] * cr[i] + unorm(dst[i * 4 + 0]) * (1.0f - a[i] * cr[i]));
+                dst[i * 4 + 1] = to_unorm8(g[i] * cg[i] + unorm(dst[i * 4 + 1]) * (1.0f - a[i] * cg[i]));
+                dst[i * 4 + 2] = to_unorm8(b[i] * cb[i] + unorm(dst[i * 4 + 2]) * (1.0f - a[i] * cb[i]));
+                dst[i * 4 + 3] = to_unorm8(ca + unorm(dst[i * 4 + 3]) * (1.0f - ca));
+            }
+            break;
+        case neogfx::blending_mode::Default:
+            // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                float const fr = a[i] * cr[i];
+                float const fg = a[i] * cg[i];
+                float const fb = a[i] * cb[i];
+                float const fa = (fr + fg + fb) * (1.0f / 3.0f);
+                dst[i * 4 + 0] = to_unorm8(r[i] * fr + unorm(dst[i * 4 + 0]) * (1.0f - fr));
+                dst[i * 4 + 1] = to_unorm8(g[i] * fg + unorm(dst[i * 4 + 1]) * (1.0f - fg));
+                dst[i * 4 + 2] = to_unorm8(b[i] * fb + unorm(dst[i * 4 + 2]) * (1.0f - fb));
+                dst[i * 4 + 3] = to_unorm8(a[i] * fa + unorm(dst[i * 4 + 3]) * (1.0f - fa));
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,136 @@
+// software_rasterizer.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <array>
+#include <vector>
+#include <memory>
+#include <neogfx/core/geometrical.hpp>
+#include <neogfx/gfx/primitives.hpp>
+#include <neogfx/gfx/gradient.hpp>
+#include <neogfx/gfx/i_image.hpp>
+#include <neogfx/gfx/software_render_target.hpp>
+
+namespace neogfx
+{
+    // Scanline rasterizer that renders triangles into an RGBA8 image on the CPU. Spans are shaded into
+    // per-channel float rows and then blended; large batches are split into horizontal bands which are
+    // rasterized concurrently.
+    class software_rasterizer
+    {
+    public:
+        struct unsupported_color_format : std::runtime_error { unsupported_color_format() : std::runtime_error("neogfx::software_rasterizer::unsupported_color_format") {} };
+    public:
+        typedef std::array<uint8_t, 4> texel;
+        // Texels captured (on the calling thread) from a texture so that worker threads never touch the texture itself.
+        struct texel_block
+        {
+            rect_i32 region;
+            std::vector<texel> data;
+            bool coverage = false;  // Red/SubPixel texture data: texel RGB is per channel coverage (glyphs)
+            bool subpixel = false;
+            texel const& at(int32_t aX, int32_t aY) const
+            {
+                aX = std::max(region.x, std::min(aX, region.x + region.cx - 1)) - region.x;
+                aY = std::max(region.y, std::min(aY, region.y + region.cy - 1)) - region.y;
+                return data[static_cast<std::size_t>(aY) * region.cx + aX];
+            }
+        };
+        // CPU port of the standard gradient shader's color_at (tiling and gradient filters are not supported).
+        struct gradient_ramp
+        {
+            static constexpr std::size_t Resolution = 256u;
+            gradient_direction direction;
+            int32_t startFrom;
+            float angle;
+            bool flipY;
+            gradient_shape shape;
+            gradient_size size;
+            vec2f exponents;
+            vec2f center;
+            vec4f boundingBox; // device coordinates
+            std::array<vec4f, Resolution> colors;
+            float position(float aX, float aY) const;
+            vec4f const& color_at(float aX, float aY) const
+            {
+                auto const n = std::max(0.0f, std::min(position(aX, aY), 1.0f)) * (Resolution - 1);
+                return colors[static_cast<std::size_t>(n + 0.5f)];
+            }
+        };
+        enum class paint_type : uint32_t
+        {
+            Solid,
+            Gradient,
+            Texture
+        };
+        struct paint
+        {
+            paint_type type = paint_type::Solid;
+            vec4f color = vec4f{ 1.0f, 1.0f, 1.0f, 1.0f };
+            std::shared_ptr<const gradient_ramp> gradient;
+            std::shared_ptr<const texel_block> texels;
+            shader_effect effect = shader_effect::None;
+        };
+        struct vertex
+        {
+            vec2f xy;   // device coordinates
+            vec2f uv;   // texel coordinates (texture paints only)
+        };
+        struct triangle
+        {
+            std::array<vertex, 3> vertices;
+            uint32_t paint;
+        };
+        typedef software_render_statistics statistics;
+    public:
+        static constexpr uint64_t ParallelThreshold = 128u * 128u;
+    public:
+        software_rasterizer(i_image& aTarget);
+    public:
+        i_image& target() const;
+        size_u32 extents() const;
+        std::optional<rect_i32> const& clip() const;
+        void set_clip(std::optional<rect_i32> const& aClip);
+        neogfx::blending_mode blending_mode() const;
+        void set_blending_mode(neogfx::blending_mode aBlendingMode);
+        uint32_t max_threads() const;
+        void set_max_threads(uint32_t aMaxThreads);
+        statistics const& stats() const;
+        statistics& stats();
+        void reset_stats();
+    public:
+        void clear(const color& aColor);
+        void set_pixel(const point_i32& aPoint, const color& aColor);
+        void fill(triangle const* aFirst, triangle const* aLast, paint const* aPaints);
+    public:
+        static std::shared_ptr<const gradient_ramp> to_ramp(const gradient& aGradient, bool aGuiCoordinates, double aOpacity, const rect& aDeviceBoundingBox);
+    private:
+        rect_i32 bounds() const;
+        void fill_band(triangle const* aFirst, triangle const* aLast, paint const* aPaints, int32_t aTop, int32_t aBottom, statistics& aStats) const;
+        void fill_span(paint const& aPaint, std::array<float, 6> const& aTexelMap, int32_t aY, int32_t aX0, int32_t aX1) const;
+    private:
+        i_image& iTarget;
+        std::optional<rect_i32> iClip;
+        neogfx::blending_mode iBlendingMode;
+        uint32_t iMaxThreads;
+        statistics iStats;
+    };
+}
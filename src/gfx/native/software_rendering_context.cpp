@@ -0,0 +1,1184 @@
+// software_rendering_context.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <chrono>
+#include <neolib/core/scoped.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/i_texture_manager.hpp>
+#include <neogfx/gfx/i_gradient_manager.hpp>
+#include <neogfx/gfx/i_fragment_shader.hpp>
+#include <neogfx/gfx/shapes.hpp>
+#include <neogfx/gfx/stroke.hpp>
+#include <neogfx/gfx/tessellator.hpp>
+#include <neogfx/gfx/text/glyph.hpp>
+#include <neogfx/gfx/text/i_glyph_texture.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/text/i_emoji_atlas.hpp>
+#include "software_rendering_context.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        inline quad line_to_quad(const vec3& aStart, const vec3& aEnd, double aLineWidth)
+        {
+            auto const vecLine = aEnd - aStart;
+            auto const length = vecLine.magnitude();
+            auto const halfWidth = aLineWidth / 2.0;
+            // the line's direction and left normal span the quad; no rotation matrix is needed in the plane
+            auto const along = (length != 0.0 ? vecLine / length : vec3{ 1.0, 0.0, 0.0 }) * halfWidth;
+            auto const across = vec3{ -along.y, along.x, 0.0 };
+            return quad{ aStart - along - across, aStart - along + across, aEnd + along + across, aEnd + along - across };
+        }
+
+        template <typename VerticesIn, typename VerticesOut>
+        inline void lines_to_quads(const VerticesIn& aLines, double aLineWidth, VerticesOut& aQuads)
+        {
+            for (auto v = aLines.begin(); v != aLines.end(); v += 2)
+            {
+                quad const q = line_to_quad(v[0], v[1], aLineWidth);
+                aQuads.insert(aQuads.end(), q.begin(), q.end());
+            }
+        }
+
+        template <typename VerticesIn, typename VerticesOut>
+        inline void quads_to_triangles(const VerticesIn& aQuads, VerticesOut& aTriangles)
+        {
+            for (auto v = aQuads.begin(); v != aQuads.end(); v += 4)
+            {
+                aTriangles.push_back(v[0]);
+                aTriangles.push_back(v[1]);
+                aTriangles.push_back(v[2]);
+                aTriangles.push_back(v[0]);
+                aTriangles.push_back(v[3]);
+                aTriangles.push_back(v[2]);
+            }
+        }
+
+        inline bool readable(const i_texture& aTexture)
+        {
+            switch (aTexture.sampling())
+            {
+            case texture_sampling::Normal:
+            case texture_sampling::Nearest:
+            case texture_sampling::Data:
+                return true;
+            default:
+                return false;
+            }
+        }
+    }
+
+    software_rendering_context::software_rendering_context(const software_render_target& aTarget, neogfx::blending_mode aBlendingMode) :
+        iTarget{ aTarget },
+        iInFlush{ false },
+        iSnapToPixel{ false },
+        iOpacity{ 1.0 },
+        iBlendingMode{ aBlendingMode },
+        iSubpixelRendering{ service<i_rendering_engine>().is_subpixel_rendering_on() }
+    {
+    }
+
+    software_rendering_context::software_rendering_context(const software_rendering_context& aOther) :
+        iTarget{ aOther.iTarget },
+        iInFlush{ false },
+        iLogicalCoordinateSystem{ aOther.iLogicalCoordinateSystem },
+        iLogicalCoordinates{ aOther.iLogicalCoordinates },
+        iOrigin{ aOther.iOrigin },
+        iOffset{ aOther.iOffset },
+        iSnapToPixel{ false },
+        iOpacity{ 1.0 },
+        iBlendingMode{ aOther.iBlendingMode },
+        iSubpixelRendering{ aOther.iSubpixelRendering }
+    {
+    }
+
+    software_rendering_context::~software_rendering_context()
+    {
+    }
+
+    std::unique_ptr<i_rendering_context> software_rendering_context::clone() const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context(*this));
+    }
+
+    i_rendering_engine& software_rendering_context::rendering_engine() const
+    {
+        return service<i_rendering_engine>();
+    }
+
+    const i_render_target& software_rendering_context::render_target() const
+    {
+        return iTarget;
+    }
+
+    rect software_rendering_context::rendering_area(bool aConsiderScissor) const
+    {
+        if (scissor_rect() == std::nullopt || !aConsiderScissor)
+            return rect{ render_target().target_origin(), render_target().target_extents() };
+        else
+            return *scissor_rect();
+    }
+
+    const graphics_operation::queue& software_rendering_context::queue() const
+    {
+        return iQueue;
+    }
+
+    graphics_operation::queue& software_rendering_context::queue()
+    {
+        return const_cast<graphics_operation::queue&>(to_const(*this).queue());
+    }
+
+    void software_rendering_context::enqueue(const graphics_operation::operation& aOperation)
+    {
+        queue().push_back(aOperation);
+    }
+
+    void software_rendering_context::flush()
+    {
+        if (iInFlush)
+            return;
+
+        neolib::scoped_flag sf{ iInFlush };
+
+        if (queue().empty())
+            return;
+
+        auto const start = std::chrono::high_resolution_clock::now();
+        auto& stats = rasterizer().stats();
+        ++stats.flushes;
+        stats.operations += queue().size();
+
+        // activate the target directly: scoped_render_target would deactivate whichever GPU target is current
+        bool const activated = !render_target().target_active();
+        if (activated)
+            render_target().activate_target();
+        rasterizer().set_blending_mode(blending_mode());
+        scissor_on(rendering_area(false));
+        scissor_off();
+
+        for (auto batchStart = queue().begin(); batchStart != queue().end();)
+        {
+            auto batchEnd = std::next(batchStart);
+            while (batchEnd != queue().end() && graphics_operation::batchable(*batchStart, *batchEnd))
+                ++batchEnd;
+            graphics_operation::batch const opBatch{ &*batchStart, &*batchStart + (batchEnd - batchStart) };
+            batchStart = batchEnd;
+            switch (opBatch.first->index())
+            {
+            case graphics_operation::operation_type::SetLogicalCoordinateSystem:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_logical_coordinate_system(static_variant_cast<const graphics_operation::set_logical_coordinate_system&>(*op).system);
+                break;
+            case graphics_operation::operation_type::SetLogicalCoordinates:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_logical_coordinates(static_variant_cast<const graphics_operation::set_logical_coordinates&>(*op).coordinates);
+                break;
+            case graphics_operation::operation_type::SetOrigin:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_origin(static_variant_cast<const graphics_operation::set_origin&>(*op).origin);
+                break;
+            case graphics_operation::operation_type::SetViewport:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& setViewport = static_variant_cast<const graphics_operation::set_viewport&>(*op);
+                    if (setViewport.rect)
+                        render_target().set_viewport(setViewport.rect->as<int32_t>());
+                    else
+                        render_target().set_viewport(rect{ render_target().target_origin(), render_target().extents() }.as<int32_t>());
+                }
+                break;
+            case graphics_operation::operation_type::ScissorOn:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    scissor_on(static_variant_cast<const graphics_operation::scissor_on&>(*op).rect);
+                break;
+            case graphics_operation::operation_type::ScissorOff:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    (void)op;
+                    scissor_off();
+                }
+                break;
+            case graphics_operation::operation_type::SnapToPixelOn:
+                set_snap_to_pixel(true);
+                break;
+            case graphics_operation::operation_type::SnapToPixelOff:
+                set_snap_to_pixel(false);
+                break;
+            case graphics_operation::operation_type::SetOpacity:
+                set_opacity(static_variant_cast<const graphics_operation::set_opacity&>(*(std::prev(opBatch.second))).opacity);
+                break;
+            case graphics_operation::operation_type::SetBlendingMode:
+                set_blending_mode(static_variant_cast<const graphics_operation::set_blending_mode&>(*(std::prev(opBatch.second))).blendingMode);
+                break;
+            case graphics_operation::operation_type::SetSmoothingMode:
+            case graphics_operation::operation_type::PushLogicalOperation:
+            case graphics_operation::operation_type::PopLogicalOperation:
+            case graphics_operation::operation_type::LineStippleOn:
+            case graphics_operation::operation_type::LineStippleOff:
+            case graphics_operation::operation_type::ClearDepthBuffer:
+            case graphics_operation::operation_type::ClearStencilBuffer:
+            case graphics_operation::operation_type::DrawEntities:
+                // not supported by the software rasterizer (output is aliased and has no depth/stencil buffers)
+                break;
+            case graphics_operation::operation_type::SubpixelRenderingOn:
+                subpixel_rendering_on();
+                break;
+            case graphics_operation::operation_type::SubpixelRenderingOff:
+                subpixel_rendering_off();
+                break;
+            case graphics_operation::operation_type::Clear:
+                clear(static_variant_cast<const graphics_operation::clear&>(*(std::prev(opBatch.second))).color);
+                break;
+            case graphics_operation::operation_type::SetGradient:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_gradient(static_variant_cast<const graphics_operation::set_gradient&>(*op).gradient);
+                break;
+            case graphics_operation::operation_type::ClearGradient:
+                clear_gradient();
+                break;
+            case graphics_operation::operation_type::SetPixel:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_pixel(static_variant_cast<const graphics_operation::set_pixel&>(*op).point, static_variant_cast<const graphics_operation::set_pixel&>(*op).color);
+                break;
+            case graphics_operation::operation_type::DrawPixel:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    draw_pixel(static_variant_cast<const graphics_operation::draw_pixel&>(*op).point, static_variant_cast<const graphics_operation::draw_pixel&>(*op).color);
+                break;
+            case graphics_operation::operation_type::DrawLine:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_line&>(*op);
+                    draw_line(args.from, args.to, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_rect&>(*op);
+                    draw_rect(args.rect, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawRoundedRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_rounded_rect&>(*op);
+                    draw_rounded_rect(args.rect, args.radius, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawCircle:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_circle&>(*op);
+                    draw_circle(args.center, args.radius, args.pen, args.startAngle);
+                }
+                break;
+            case graphics_operation::operation_type::DrawArc:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_arc&>(*op);
+                    draw_arc(args.center, args.radius, args.startAngle, args.endAngle, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawCubicBezier:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_cubic_bezier&>(*op);
+                    draw_cubic_bezier(args.p0, args.p1, args.p2, args.p3, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawPath:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_path&>(*op);
+                    draw_path(args.path, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawShape:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_shape&>(*op);
+                    draw_shape(args.mesh, args.position, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::FillRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_rect&>(*op);
+                    fill_rect(args.rect, args.fill, args.zpos);
+                }
+                break;
+            case graphics_operation::operation_type::FillRoundedRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_rounded_rect&>(*op);
+                    fill_rounded_rect(args.rect, args.radius, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillCheckerRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_checker_rect&>(*op);
+                    fill_checker_rect(args.rect, args.squareSize, args.fill1, args.fill2, args.zpos);
+                }
+                break;
+            case graphics_operation::operation_type::FillCircle:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_circle&>(*op);
+                    fill_circle(args.center, args.radius, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillArc:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_arc&>(*op);
+                    fill_arc(args.center, args.radius, args.startAngle, args.endAngle, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillPath:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    fill_path(static_variant_cast<const graphics_operation::fill_path&>(*op).path, static_variant_cast<const graphics_operation::fill_path&>(*op).fill);
+                break;
+            case graphics_operation::operation_type::FillShape:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_shape&>(*op);
+                    fill_shape(args.mesh, args.position, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::DrawGlyph:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    draw_glyphs(static_variant_cast<const graphics_operation::draw_glyphs&>(*op));
+                break;
+            case graphics_operation::operation_type::DrawMesh:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_mesh&>(*op);
+                    draw_mesh(args.mesh, args.material, args.transformation);
+                }
+                break;
+            }
+        }
+        submit();
+        iTexels.clear();
+        queue().clear();
+        if (activated)
+            render_target().deactivate_target();
+
+        stats.flushTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    neogfx::logical_coordinate_system software_rendering_context::logical_coordinate_system() const
+    {
+        if (iLogicalCoordinateSystem != std::nullopt)
+            return *iLogicalCoordinateSystem;
+        return render_target().logical_coordinate_system();
+    }
+
+    void software_rendering_context::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem)
+    {
+        iLogicalCoordinateSystem = aSystem;
+        iDeviceTransform = std::nullopt;
+    }
+
+    logical_coordinates software_rendering_context::logical_coordinates() const
+    {
+        if (iLogicalCoordinates != std::nullopt)
+            return *iLogicalCoordinates;
+        auto result = render_target().logical_coordinates();
+        if (logical_coordinate_system() != render_target().logical_coordinate_system())
+        {
+            switch (logical_coordinate_system())
+            {
+            case neogfx::logical_coordinate_system::Specified:
+                break;
+            case neogfx::logical_coordinate_system::AutomaticGame:
+                if (render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui)
+                    std::swap(result.bottomLeft.y, result.topRight.y);
+                break;
+            case neogfx::logical_coordinate_system::AutomaticGui:
+                std::swap(result.bottomLeft.y, result.topRight.y);
+                break;
+            }
+        }
+        return result;
+    }
+
+    void software_rendering_context::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates)
+    {
+        iLogicalCoordinates = aCoordinates;
+        iDeviceTransform = std::nullopt;
+    }
+
+    point software_rendering_context::origin() const
+    {
+        return iOrigin;
+    }
+
+    void software_rendering_context::set_origin(const point& aOrigin)
+    {
+        iOrigin = aOrigin;
+    }
+
+    vec2 software_rendering_context::offset() const
+    {
+        return (iOffset != std::nullopt ? *iOffset : vec2{}) + (snap_to_pixel() ? 0.5 : 0.0);
+    }
+
+    void software_rendering_context::set_offset(const optional_vec2& aOffset)
+    {
+        iOffset = aOffset;
+        iDeviceTransform = std::nullopt;
+    }
+
+    bool software_rendering_context::gradient_set() const
+    {
+        return !!iGradient;
+    }
+
+    void software_rendering_context::apply_gradient(i_gradient_shader& aShader)
+    {
+        aShader.set_gradient(*this, *iGradient, iOpacity);
+    }
+
+    bool software_rendering_context::snap_to_pixel() const
+    {
+        return iSnapToPixel;
+    }
+
+    void software_rendering_context::set_snap_to_pixel(bool aSnapToPixel)
+    {
+        iSnapToPixel = aSnapToPixel;
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::scissor_on(const rect& aRect)
+    {
+        submit();
+        iScissorRects.push_back(aRect);
+        iScissorRect = std::nullopt;
+        apply_scissor();
+    }
+
+    void software_rendering_context::scissor_off()
+    {
+        submit();
+        if (!iScissorRects.empty())
+            iScissorRects.pop_back();
+        iScissorRect = std::nullopt;
+        apply_scissor();
+    }
+
+    const optional_rect& software_rendering_context::scissor_rect() const
+    {
+        if (iScissorRect == std::nullopt && !iScissorRects.empty())
+        {
+            for (auto const& rect : iScissorRects)
+                if (iScissorRect != std::nullopt)
+                    iScissorRect = iScissorRect->intersection(rect);
+                else
+                    iScissorRect = rect;
+        }
+        return iScissorRect;
+    }
+
+    void software_rendering_context::set_opacity(double aOpacity)
+    {
+        iOpacity = aOpacity;
+    }
+
+    neogfx::blending_mode software_rendering_context::blending_mode() const
+    {
+        return iBlendingMode;
+    }
+
+    void software_rendering_context::set_blending_mode(neogfx::blending_mode aBlendingMode)
+    {
+        if (iBlendingMode != aBlendingMode)
+        {
+            submit();
+            iBlendingMode = aBlendingMode;
+        }
+        rasterizer().set_blending_mode(iBlendingMode);
+    }
+
+    void software_rendering_context::set_gradient(const gradient& aGradient)
+    {
+        iGradient = aGradient;
+    }
+
+    void software_rendering_context::clear_gradient()
+    {
+        iGradient = std::nullopt;
+    }
+
+    bool software_rendering_context::is_subpixel_rendering_on() const
+    {
+        return iSubpixelRendering;
+    }
+
+    void software_rendering_context::subpixel_rendering_on()
+    {
+        iSubpixelRendering = true;
+    }
+
+    void software_rendering_context::subpixel_rendering_off()
+    {
+        iSubpixelRendering = false;
+    }
+
+    void software_rendering_context::clear(const color& aColor)
+    {
+        submit();
+        rasterizer().clear(aColor);
+    }
+
+    void software_rendering_context::set_pixel(const point& aPoint, const color& aColor)
+    {
+        submit();
+        auto const devicePoint = to_device(aPoint.to_vec3());
+        rasterizer().set_pixel(point_i32{ static_cast<int32_t>(std::floor(devicePoint.x)), static_cast<int32_t>(std::floor(devicePoint.y)) }, aColor);
+    }
+
+    void software_rendering_context::draw_pixel(const point& aPoint, const color& aColor)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        rect const pixel{ aPoint, size{ 1.0, 1.0 } };
+        auto const rectVertices = rect_vertices(pixel, mesh_type::Triangles, 0.0);
+        add_triangles(&*rectVertices.begin(), &*rectVertices.begin() + rectVertices.size(), add_paint(color_or_gradient{ aColor }, pixel));
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::draw_line(const point& aFrom, const point& aTo, const pen& aPen)
+    {
+        auto v1 = aFrom.to_vec3();
+        auto v2 = aTo.to_vec3();
+        if (snap_to_pixel() && static_cast<int32_t>(aPen.width()) % 2 == 0)
+        {
+            v1 -= vec3{ 0.5, 0.5, 0.0 };
+            v2 -= vec3{ 0.5, 0.5, 0.0 };
+        }
+        add_stroke(vertices{ v1, v2 }, false, aPen, rect{ aFrom, aTo });
+    }
+
+    void software_rendering_context::draw_rect(const rect& aRect, const pen& aPen)
+    {
+        auto adjustedRect = aRect;
+        if (snap_to_pixel())
+        {
+            bool const oddWidth = static_cast<int32_t>(aPen.width()) % 2 == 1;
+            adjustedRect.position() -= size{ oddWidth ? 0.0 : 0.5 };
+            if (oddWidth)
+                adjustedRect = adjustedRect.with_epsilon(size{ 1.0 });
+        }
+        else
+            adjustedRect.inflate(size{ aPen.width() / 2.0 }.floor());
+
+        vec3_array<8> lines = rect_vertices(adjustedRect, mesh_type::Outline, 0.0);
+        lines[1].x -= (aPen.width() + rect::default_epsilon);
+        lines[3].y -= (aPen.width() + rect::default_epsilon);
+        lines[5].x += (aPen.width() + rect::default_epsilon);
+        lines[7].y += (aPen.width() + rect::default_epsilon);
+        vec3_array<4 * 4> quads;
+        lines_to_quads(lines, aPen.width(), quads);
+        vec3_array<4 * 6> triangles;
+        quads_to_triangles(quads, triangles);
+        add_triangles(&*triangles.begin(), &*triangles.begin() + triangles.size(), add_paint(aPen.color(), aRect));
+    }
+
+    void software_rendering_context::draw_rounded_rect(const rect& aRect, dimension aRadius, const pen& aPen)
+    {
+        auto adjustedRect = aRect;
+        if (snap_to_pixel())
+        {
+            bool const oddWidth = static_cast<int32_t>(aPen.width()) % 2 == 1;
+            adjustedRect.position() -= size{ oddWidth ? 0.0 : 0.5 };
+            if (oddWidth)
+                adjustedRect = adjustedRect.with_epsilon(size{ 1.0 });
+        }
+        else
+            adjustedRect.inflate(size{ aPen.width() / 2.0 }.floor());
+
+        add_stroke(rounded_rect_vertices(adjustedRect, aRadius, mesh_type::Outline), true, aPen, aRect);
+    }
+
+    void software_rendering_context::draw_circle(const point& aCenter, dimension aRadius, const pen& aPen, angle aStartAngle)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        add_stroke(circle_vertices(aCenter, aRadius, aStartAngle, mesh_type::Outline), true, aPen,
+            rect{ aCenter - size{ aRadius, aRadius }, size{ aRadius * 2.0, aRadius * 2.0 } });
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::draw_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const pen& aPen)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        add_stroke(arc_vertices(aCenter, aRadius, aStartAngle, aEndAngle, aCenter, mesh_type::Outline), false, aPen,
+            rect{ aCenter - size{ aRadius, aRadius }, size{ aRadius * 2.0, aRadius * 2.0 } });
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::draw_cubic_bezier(const point& aP0, const point& aP1, const point& aP2, const point& aP3, const pen& aPen)
+    {
+        // the GL backend evaluates the curve in a shader; here it is flattened into line segments of about two pixels
+        auto const hull = aP0.to_vec3().distance(aP1.to_vec3()) + aP1.to_vec3().distance(aP2.to_vec3()) + aP2.to_vec3().distance(aP3.to_vec3());
+        auto const segments = std::max<uint32_t>(8u, static_cast<uint32_t>(std::ceil(hull / 2.0)));
+        vertices curve;
+        curve.reserve(segments + 1u);
+        for (uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            auto const t = static_cast<scalar>(segment) / segments;
+            auto const mt = 1.0 - t;
+            curve.push_back(
+                aP0.to_vec3() * (mt * mt * mt) +
+                aP1.to_vec3() * (3.0 * mt * mt * t) +
+                aP2.to_vec3() * (3.0 * mt * t * t) +
+                aP3.to_vec3() * (t * t * t));
+        }
+        add_stroke(curve, false, aPen, rect{ aP0.min(aP1.min(aP2.min(aP3))), aP0.max(aP1.max(aP2.max(aP3))) });
+    }
+
+    void software_rendering_context::draw_path(const path& aPath, const pen& aPen)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() < 2)
+                continue;
+            auto pathVertices = aPath.to_vertices(subPath);
+            switch (aPath.shape())
+            {
+            case path_shape::ConvexPolygon:
+                {
+                    auto const paint = add_paint(aPen.color(), aPath.bounding_rect());
+                    add_fan(&*pathVertices.begin(), &*pathVertices.begin() + pathVertices.size(), paint);
+                }
+                break;
+            case path_shape::LineLoop:
+            case path_shape::Polygon:
+                add_stroke(pathVertices, true, aPen, aPath.bounding_rect());
+                break;
+            case path_shape::LineStrip:
+                add_stroke(pathVertices, false, aPen, aPath.bounding_rect());
+                break;
+            case path_shape::Lines:
+                for (std::size_t line = 0; line + 1 < pathVertices.size(); line += 2)
+                    add_stroke(vertices{ pathVertices[line], pathVertices[line + 1] }, false, aPen, aPath.bounding_rect());
+                break;
+            case path_shape::Quads:
+                {
+                    vertices triangles;
+                    quads_to_triangles(pathVertices, triangles);
+                    auto const paint = add_paint(aPen.color(), aPath.bounding_rect());
+                    add_triangles(&*triangles.begin(), &*triangles.begin() + triangles.size(), paint);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen)
+    {
+        auto outline = aMesh.vertices;
+        for (auto& v : outline)
+            v += aPosition;
+        add_stroke(outline, true, aPen, bounding_rect(aMesh.vertices) + point{ aPosition.x, aPosition.y });
+    }
+
+    void software_rendering_context::fill_rect(const rect& aRect, const brush& aFill, scalar aZpos)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        auto const rectVertices = rect_vertices(aRect, mesh_type::Triangles, aZpos);
+        add_triangles(&*rectVertices.begin(), &*rectVertices.begin() + rectVertices.size(), add_paint(aFill, aRect));
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::fill_rounded_rect(const rect& aRect, dimension aRadius, const brush& aFill)
+    {
+        if (aRect.empty())
+            return;
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        auto const fan = rounded_rect_vertices(aRect, aRadius, mesh_type::TriangleFan);
+        add_fan(&*fan.begin(), &*fan.begin() + fan.size(), add_paint(aFill, aRect));
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::fill_checker_rect(const rect& aRect, const size& aSquareSize, const brush& aFill1, const brush& aFill2, scalar aZpos)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        for (int32_t step = 0; step <= 1; ++step)
+        {
+            auto const& fill = (step == 0 ? aFill1 : aFill2);
+            for (coordinate x = 0; x < aRect.cx; x += aSquareSize.cx)
+            {
+                bool alt = ((static_cast<int32_t>(x / aSquareSize.cx) % 2) == step);
+                for (coordinate y = 0; y < aRect.cy; y += aSquareSize.cy)
+                {
+                    if (alt)
+                    {
+                        auto const square = rect{ aRect.top_left() + point{ x, y }, aSquareSize };
+                        auto const rectVertices = rect_vertices(square, mesh_type::Triangles, aZpos);
+                        add_triangles(&*rectVertices.begin(), &*rectVertices.begin() + rectVertices.size(), add_paint(fill, square));
+                    }
+                    alt = !alt;
+                }
+            }
+        }
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::fill_circle(const point& aCenter, dimension aRadius, const brush& aFill)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        auto const fan = circle_vertices(aCenter, aRadius, 0.0, mesh_type::TriangleFan);
+        add_fan(&*fan.begin(), &*fan.begin() + fan.size(), add_paint(aFill, rect{ aCenter - point{ aRadius, aRadius }, size{ aRadius * 2.0 } }));
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::fill_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const brush& aFill)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        auto const fan = arc_vertices(aCenter, aRadius, aStartAngle, aEndAngle, aCenter, mesh_type::TriangleFan);
+        add_fan(&*fan.begin(), &*fan.begin() + fan.size(), add_paint(aFill, rect{ aCenter - point{ aRadius, aRadius }, size{ aRadius * 2.0 } }));
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::fill_path(const path& aPath, const brush& aFill)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        if (aPath.shape() == path_shape::Polygon)
+        {
+            auto const mesh = tessellated(aPath);
+            if (!mesh->empty())
+            {
+                thread_local vertices triangles;
+                triangles.clear();
+                auto const offset = xyz{ aPath.position().x, aPath.position().y };
+                for (auto const& v : *mesh)
+                    triangles.push_back(v + offset);
+                add_triangles(&*triangles.begin(), &*triangles.begin() + triangles.size(), add_paint(aFill, aPath.bounding_rect()));
+            }
+            iDeviceTransform = std::nullopt;
+            return;
+        }
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() <= 2)
+                continue;
+            auto const pathVertices = aPath.to_vertices(subPath);
+            auto const paint = add_paint(aFill, aPath.bounding_rect());
+            if (aPath.shape() == path_shape::Quads)
+            {
+                vertices triangles;
+                quads_to_triangles(pathVertices, triangles);
+                add_triangles(&*triangles.begin(), &*triangles.begin() + triangles.size(), paint);
+            }
+            else
+                add_fan(&*pathVertices.begin(), &*pathVertices.begin() + pathVertices.size(), paint);
+        }
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::fill_shape(const game::mesh& aMesh, const vec3& aPosition, const brush& aFill)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+        auto const paint = add_paint(aFill, bounding_rect(aMesh.vertices) + point{ aPosition.x, aPosition.y });
+        thread_local vertices triangles;
+        triangles.clear();
+        for (auto const& f : aMesh.faces)
+            for (auto vi : f)
+                triangles.push_back(aMesh.vertices[vi] + aPosition);
+        if (!triangles.empty())
+            add_triangles(&*triangles.begin(), &*triangles.begin() + triangles.size(), paint);
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::draw_glyphs(const graphics_operation::draw_glyphs& aDrawGlyphs)
+    {
+        // text effects (outline, glow, shadow) and emulated italics are not rendered by the software rasterizer
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+
+        auto const& glyphText = aDrawGlyphs.glyphText.content();
+        auto const& appearance = aDrawGlyphs.appearance;
+        bool const gameCoordinates = (logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame);
+
+        // paper
+        if (appearance.paper() != std::nullopt)
+        {
+            vec3 pos = aDrawGlyphs.point;
+            for (auto g = aDrawGlyphs.begin; g != aDrawGlyphs.end; ++g)
+            {
+                auto const& glyph = *g;
+                rect const glyphRect{ point{ pos } + glyph.offset.as<scalar>(), size{ advance(glyph).cx, glyphText.glyph_font(glyph).height() } };
+                auto const rectVertices = rect_vertices(glyphRect, mesh_type::Triangles, pos.z);
+                add_triangles(&*rectVertices.begin(), &*rectVertices.begin() + rectVertices.size(), add_paint(*appearance.paper(), glyphRect));
+                pos.x += advance(glyph).cx;
+            }
+        }
+
+        // emoji and glyphs
+        vec3 pos = aDrawGlyphs.point;
+        for (auto g = aDrawGlyphs.begin; g != aDrawGlyphs.end; ++g)
+        {
+            auto const& glyph = *g;
+            auto const& glyphFont = glyphText.glyph_font(glyph);
+            if (is_emoji(glyph))
+            {
+                rect const outputRect{ point{ pos } + glyph.offset.as<scalar>(), size{ advance(glyph).cx, glyphFont.height() } };
+                auto const& emojiTexture = rendering_engine().font_manager().emoji_atlas().emoji_texture(glyph.value).as_sub_texture();
+                auto const texels = capture(emojiTexture, rect_i32{ point_i32{}, emojiTexture.extents().as<int32_t>() }, false, false);
+                if (texels)
+                {
+                    paint emojiPaint;
+                    if (!appearance.ignore_emoji())
+                    {
+                        emojiPaint = iPaints[add_paint(appearance.ink(), outputRect)];
+                        emojiPaint.effect = shader_effect::Colorize;
+                    }
+                    else
+                        emojiPaint.color = vec4f{ 1.0f, 1.0f, 1.0f, static_cast<float>(iOpacity) };
+                    emojiPaint.type = software_rasterizer::paint_type::Texture;
+                    emojiPaint.texels = texels;
+                    add_textured_rect(outputRect, rect{ point{}, emojiTexture.extents() }, add_paint(emojiPaint));
+                }
+            }
+            else if (!is_whitespace(glyph))
+            {
+                auto const& glyphTexture = glyphText.glyph_texture(glyph);
+                glyphFont.glyph_texture_drawn(glyph);
+                auto const& texture = glyphTexture.texture();
+                auto const glyphOrigin = point{
+                    pos.x + glyphTexture.placement().x,
+                    gameCoordinates ?
+                        pos.y + (glyphTexture.placement().y + -glyphFont.descender()) :
+                        pos.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.extents().cy
+                } + glyph.offset.as<scalar>();
+                rect const outputRect{ glyphOrigin, glyphTexture.extents() };
+                bool const subpixelRender = iSubpixelRendering && subpixel(glyph) && glyphTexture.subpixel();
+                auto const texels = capture(texture, rect_i32{ point_i32{}, texture.extents().as<int32_t>() }, true, subpixelRender);
+                if (texels)
+                {
+                    paint glyphPaint = iPaints[add_paint(appearance.ink(), outputRect)];
+                    glyphPaint.type = software_rasterizer::paint_type::Texture;
+                    glyphPaint.texels = texels;
+                    add_textured_rect(outputRect, rect{ point{}, texture.extents() }, add_paint(glyphPaint));
+                }
+            }
+            pos.x += advance(glyph).cx;
+        }
+
+        // adornments
+        pos = aDrawGlyphs.point;
+        for (auto g = aDrawGlyphs.begin; g != aDrawGlyphs.end; ++g)
+        {
+            auto const& glyph = *g;
+            if (underline(glyph) || (aDrawGlyphs.showMnemonics && neogfx::mnemonic(glyph)))
+            {
+                auto const& glyphFont = glyphText.glyph_font(glyph);
+                auto const descender = glyphFont.descender();
+                auto const underlinePosition = glyphFont.native_font_face().underline_position();
+                auto const dy = descender - underlinePosition;
+                auto const yLine = pos.y + (logical_coordinates().is_gui_orientation() ? glyphFont.height() - 1 + dy : -dy) + glyph.offset.as<scalar>().y;
+                auto const cx = (aDrawGlyphs.showMnemonics && neogfx::mnemonic(glyph) ? glyphText.extents(glyph).cx : advance(glyph).cx);
+                draw_line(point{ pos.x, yLine }, point{ pos.x + cx, yLine }, pen{ appearance.ink(), glyphFont.native_font_face().underline_thickness() });
+            }
+            pos.x += advance(glyph).cx;
+        }
+
+        iDeviceTransform = std::nullopt;
+    }
+
+    void software_rendering_context::draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation)
+    {
+        if (aMesh.faces.empty())
+            return;
+
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+        iDeviceTransform = std::nullopt;
+
+        paint meshPaint;
+        if (aMaterial.color != std::nullopt)
+        {
+            auto const rgba = aMaterial.color->rgba.as<float>();
+            meshPaint.color = vec4f{ rgba[0], rgba[1], rgba[2], rgba[3] * static_cast<float>(iOpacity) };
+        }
+        else
+            meshPaint.color = vec4f{ 1.0f, 1.0f, 1.0f, static_cast<float>(iOpacity) };
+        if (aMaterial.gradient != std::nullopt)
+        {
+            gradient const g = service<i_gradient_manager>().find_gradient(aMaterial.gradient->id.cookie());
+            rect const boundingBox = aMaterial.gradient->boundingBox ?
+                rect{ point{ aMaterial.gradient->boundingBox->min }, point{ aMaterial.gradient->boundingBox->max } } :
+                bounding_rect(aMesh.vertices, aTransformation);
+            meshPaint.type = software_rasterizer::paint_type::Gradient;
+            meshPaint.gradient = software_rasterizer::to_ramp(g, logical_coordinates().is_gui_orientation(), 1.0, to_device(boundingBox));
+        }
+
+        std::optional<game::texture> materialTexture;
+        if (aMaterial.texture != std::nullopt)
+            materialTexture = *aMaterial.texture;
+        else if (aMaterial.sharedTexture != std::nullopt)
+            materialTexture = *aMaterial.sharedTexture->ptr;
+
+        vec2 uvScale{ 1.0, 1.0 };
+        vec2 uvOffset;
+        std::optional<scalar> uvFlip;
+        if (materialTexture != std::nullopt && !aMesh.uv.empty())
+        {
+            auto const& texture = *service<i_texture_manager>().find_texture(materialTexture->id.cookie());
+            rect_i32 region{ point_i32{}, texture.extents().as<int32_t>() };
+            if (materialTexture->type != texture_type::Texture && materialTexture->subTexture != std::nullopt)
+                region = rect_i32{ point{ materialTexture->subTexture->min }.as<int32_t>(), point{ materialTexture->subTexture->max }.as<int32_t>() };
+            else if (materialTexture->type != texture_type::Texture)
+                region = texture.as_sub_texture().atlas_location().as<int32_t>();
+            auto const texels = capture(texture, region, false, false);
+            if (texels)
+            {
+                meshPaint.type = software_rasterizer::paint_type::Texture;
+                meshPaint.texels = texels;
+                meshPaint.effect = aMaterial.shaderEffect != std::nullopt ? *aMaterial.shaderEffect : shader_effect::None;
+                uvScale = materialTexture->extents;
+                uvOffset = vec2{ static_cast<scalar>(region.x), static_cast<scalar>(region.y) };
+                if (texture.is_render_target() && texture.as_render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui)
+                    uvFlip = texture.extents().cy;
+            }
+        }
+
+        auto const paintIndex = add_paint(meshPaint);
+        for (auto const& face : aMesh.faces)
+        {
+            triangle t;
+            t.paint = paintIndex;
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                auto const vi = face[i];
+                t.vertices[i].xy = to_device(aTransformation * aMesh.vertices[vi]);
+                if (meshPaint.type == software_rasterizer::paint_type::Texture)
+                {
+                    auto uv = aMesh.uv[vi].scale(uvScale) + uvOffset;
+                    if (uvFlip)
+                        uv.y = *uvFlip - uv.y;
+                    t.vertices[i].uv = uv.as<float>();
+                }
+            }
+            iTriangles.push_back(t);
+        }
+
+        iDeviceTransform = std::nullopt;
+    }
+
+    subpixel_format software_rendering_context::subpixel_format() const
+    {
+        return neogfx::subpixel_format::None;
+    }
+
+    software_rasterizer& software_rendering_context::rasterizer() const
+    {
+        return iTarget.rasterizer();
+    }
+
+    void software_rendering_context::apply_scissor()
+    {
+        auto const& sr = scissor_rect();
+        if (sr != std::nullopt)
+        {
+            auto const cy = render_target().target_extents().cy;
+            int32_t const x = static_cast<int32_t>(std::ceil(sr->x));
+            int32_t const y = static_cast<int32_t>(logical_coordinates().is_gui_orientation() ? std::ceil(sr->y) : std::ceil(cy - sr->cy - sr->y));
+            rasterizer().set_clip(rect_i32{ point_i32{ x, y }, size_i32{ static_cast<int32_t>(std::ceil(sr->cx)), static_cast<int32_t>(std::ceil(sr->cy)) } });
+        }
+        else
+            rasterizer().set_clip({});
+    }
+
+    vec2f software_rendering_context::to_device(const vec3& aPoint) const
+    {
+        if (iDeviceTransform == std::nullopt)
+        {
+            auto const lc = logical_coordinates();
+            auto const extents = render_target().target_extents();
+            auto const sx = extents.cx / (lc.topRight.x - lc.bottomLeft.x);
+            auto const sy = extents.cy / (lc.bottomLeft.y - lc.topRight.y);
+            auto const off = offset();
+            iDeviceTransform = vec4{ sx, (off.x - lc.bottomLeft.x) * sx, sy, (off.y - lc.topRight.y) * sy };
+        }
+        auto const& dt = *iDeviceTransform;
+        return vec2f{ static_cast<float>(aPoint.x * dt[0] + dt[1]), static_cast<float>(aPoint.y * dt[2] + dt[3]) };
+    }
+
+    rect software_rendering_context::to_device(const rect& aRect) const
+    {
+        auto const p1 = to_device(aRect.top_left().to_vec3());
+        auto const p2 = to_device(aRect.bottom_right().to_vec3());
+        return rect{ point{ std::min(p1.x, p2.x), std::min(p1.y, p2.y) }, point{ std::max(p1.x, p2.x), std::max(p1.y, p2.y) } };
+    }
+
+    template <typename ColorContainer>
+    uint32_t software_rendering_context::add_paint(const ColorContainer& aColor, const rect& aBoundingBox)
+    {
+        paint result;
+        std::optional<gradient> paintGradient;
+        if (std::holds_alternative<gradient>(aColor))
+            paintGradient = static_variant_cast<const gradient&>(aColor);
+        else if (iGradient)
+            paintGradient = *iGradient;
+        if (paintGradient)
+        {
+            result.type = software_rasterizer::paint_type::Gradient;
+            auto const& boundingBox = std::holds_alternative<gradient>(aColor) && paintGradient->bounding_box() ?
+                *paintGradient->bounding_box() : aBoundingBox;
+            result.gradient = software_rasterizer::to_ramp(*paintGradient, logical_coordinates().is_gui_orientation(), iOpacity, to_device(boundingBox));
+        }
+        else if (std::holds_alternative<color>(aColor))
+        {
+            auto const& c = static_variant_cast<const color&>(aColor);
+            result.color = vec4f{ c.red<float>(), c.green<float>(), c.blue<float>(), c.alpha<float>() * static_cast<float>(iOpacity) };
+        }
+        else
+            result.color = vec4f{};
+        return add_paint(result);
+    }
+
+    uint32_t software_rendering_context::add_paint(const paint& aPaint)
+    {
+        iPaints.push_back(aPaint);
+        return static_cast<uint32_t>(iPaints.size() - 1u);
+    }
+
+    void software_rendering_context::add_triangles(const vec3* aFirst, const vec3* aLast, uint32_t aPaint)
+    {
+        for (auto v = aFirst; v + 2 < aLast; v += 3)
+        {
+            triangle t;
+            t.paint = aPaint;
+            t.vertices[0].xy = to_device(v[0]);
+            t.vertices[1].xy = to_device(v[1]);
+            t.vertices[2].xy = to_device(v[2]);
+            iTriangles.push_back(t);
+        }
+    }
+
+    void software_rendering_context::add_fan(const vec3* aFirst, const vec3* aLast, uint32_t aPaint)
+    {
+        if (aLast - aFirst < 3)
+            return;
+        auto const center = to_device(*aFirst);
+        auto previous = to_device(aFirst[1]);
+        for (auto v = aFirst + 2; v != aLast; ++v)
+        {
+            auto const next = to_device(*v);
+            triangle t;
+            t.paint = aPaint;
+            t.vertices[0].xy = center;
+            t.vertices[1].xy = previous;
+            t.vertices[2].xy = next;
+            iTriangles.push_back(t);
+            previous = next;
+        }
+    }
+
+    void software_rendering_context::add_stroke(const vertices& aPolyline, bool aClosed, const pen& aPen, const rect& aBoundingBox)
+    {
+        // the same expansion as the GL backend so that joins, caps and miter limits match
+        thread_local std::vector<vec3f> tStrokeTriangles;
+        tStrokeTriangles.clear();
+        stroke_polyline(aPolyline, aClosed, aPen, tStrokeTriangles);
+        thread_local vertices tTriangles;
+        tTriangles.clear();
+        for (auto const& v : tStrokeTriangles)
+            tTriangles.push_back(v.as<scalar>());
+        if (!tTriangles.empty())
+            add_triangles(&*tTriangles.begin(), &*tTriangles.begin() + tTriangles.size(), add_paint(aPen.color(), aBoundingBox));
+    }
+
+    void software_rendering_context::add_textured_rect(const rect& aRect, const rect& aTexelRect, uint32_t aPaint)
+    {
+        // texture storage is bottom-up so the top of the output rectangle samples the last texel row
+        auto const deviceRect = to_device(aRect);
+        vec2f const tl{ static_cast<float>(deviceRect.left()), static_cast<float>(deviceRect.top()) };
+        vec2f const tr{ static_cast<float>(deviceRect.right()), static_cast<float>(deviceRect.top()) };
+        vec2f const bl{ static_cast<float>(deviceRect.left()), static_cast<float>(deviceRect.bottom()) };
+        vec2f const br{ static_cast<float>(deviceRect.right()), static_cast<float>(deviceRect.bottom()) };
+        vec2f const uvTl{ static_cast<float>(aTexelRect.left()), static_cast<float>(aTexelRect.bottom()) };
+        vec2f const uvTr{ static_cast<float>(aTexelRect.right()), static_cast<float>(aTexelRect.bottom()) };
+        vec2f const uvBl{ static_cast<float>(aTexelRect.left()), static_cast<float>(aTexelRect.top()) };
+        vec2f const uvBr{ static_cast<float>(aTexelRect.right()), static_cast<float>(aTexelRect.top()) };
+        iTriangles.push_back(triangle{ { software_rasterizer::vertex{ tl, uvTl }, software_rasterizer::vertex{ tr, uvTr }, software_rasterizer::vertex{ bl, uvBl } }, aPaint });
+        iTriangles.push_back(triangle{ { software_rasterizer::vertex{ tr, uvTr }, software_rasterizer::vertex{ br, uvBr }, software_rasterizer::vertex{ bl, uvBl } }, aPaint });
+    }
+
+    std::shared_ptr<const software_rasterizer::texel_block> software_rendering_context::capture(const i_texture& aTexture, const rect_i32& aRegion, bool aCoverage, bool aSubpixel)
+    {
+        texel_key const key{ &aTexture, aRegion.x, aRegion.y, aRegion.cx, aRegion.cy, aSubpixel };
+        auto existing = iTexels.find(key);
+        if (existing != iTexels.end())
+            return existing->second;
+        std::shared_ptr<software_rasterizer::texel_block> result;
+        if (readable(aTexture) && aRegion.cx > 0 && aRegion.cy > 0)
+        {
+            // texels are read here, on the rendering thread, so rasterizer worker threads never touch the texture
+            result = std::make_shared<software_rasterizer::texel_block>();
+            result->region = aRegion;
+            result->coverage = aCoverage;
+            result->subpixel = aSubpixel;
+            result->data.resize(static_cast<std::size_t>(aRegion.cx) * aRegion.cy);
+            bool const subpixelData = (aTexture.data_format() == texture_data_format::SubPixel);
+            bool const distanceFieldData = (aTexture.data_format() == texture_data_format::DistanceField);
+            auto texel = result->data.begin();
+            for (int32_t y = aRegion.y; y < aRegion.y + aRegion.cy; ++y)
+                for (int32_t x = aRegion.x; x < aRegion.x + aRegion.cx; ++x, ++texel)
+                {
+                    auto const c = aTexture.get_pixel(point{ static_cast<coordinate>(x), static_cast<coordinate>(y) });
+                    *texel = software_rasterizer::texel{ c.red(), c.green(), c.blue(), c.alpha() };
+                    if (aCoverage && subpixelData && !aSubpixel)
+                        (*texel)[0] = static_cast<uint8_t>((c.red() + c.green() + c.blue()) / 3);
+                    else if (aCoverage && distanceFieldData) // a fixed ramp either side of the edge
+                        (*texel)[0] = static_cast<uint8_t>(std::clamp((static_cast<int32_t>(c.red()) - 128) * 8 + 128, 0, 255));
+                }
+        }
+        iTexels.emplace(key, result);
+        return result;
+    }
+
+    void software_rendering_context::submit()
+    {
+        if (!iTriangles.empty())
+            rasterizer().fill(&*iTriangles.begin(), &*iTriangles.begin() + iTriangles.size(), &*iPaints.begin());
+        iTriangles.clear();
+        iPaints.clear();
+    }
+}
@@ -0,0 +1,146 @@
+// software_rendering_context.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <map>
+#include <neogfx/gfx/i_rendering_context.hpp>
+#include <neogfx/gfx/i_texture.hpp>
+#include <neogfx/gfx/software_render_target.hpp>
+#include <neogfx/game/mesh.hpp>
+#include <neogfx/game/material.hpp>
+#include "software_rasterizer.hpp"
+
+namespace neogfx
+{
+    class software_rendering_context : public i_rendering_context
+    {
+    private:
+        typedef software_rasterizer::paint paint;
+        typedef software_rasterizer::triangle triangle;
+        struct texel_key
+        {
+            const i_texture* texture;
+            int32_t x;
+            int32_t y;
+            int32_t cx;
+            int32_t cy;
+            bool subpixel;
+            bool operator<(texel_key const& aOther) const
+            {
+                return std::tie(texture, x, y, cx, cy, subpixel) < std::tie(aOther.texture, aOther.x, aOther.y, aOther.cx, aOther.cy, aOther.subpixel);
+            }
+        };
+    public:
+        software_rendering_context(const software_render_target& aTarget, blending_mode aBlendingMode = blending_mode::Default);
+        software_rendering_context(const software_rendering_context& aOther);
+        ~software_rendering_context();
+    public:
+        std::unique_ptr<i_rendering_context> clone() const override;
+    public:
+        i_rendering_engine& rendering_engine() const override;
+        const i_render_target& render_target() const override;
+        rect rendering_area(bool aConsiderScissor = true) const override;
+    public:
+        const graphics_operation::queue& queue() const override;
+        graphics_operation::queue& queue() override;
+        void enqueue(const graphics_operation::operation& aOperation) override;
+        void flush() override;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const override;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem);
+        neogfx::logical_coordinates logical_coordinates() const override;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates);
+        point origin() const;
+        void set_origin(const point& aOrigin);
+        vec2 offset() const override;
+        void set_offset(const optional_vec2& aOffset) override;
+        bool gradient_set() const override;
+        void apply_gradient(i_gradient_shader& aShader) override;
+        bool snap_to_pixel() const;
+        void set_snap_to_pixel(bool aSnapToPixel);
+        void scissor_on(const rect& aRect);
+        void scissor_off();
+        const optional_rect& scissor_rect() const;
+        void set_opacity(double aOpacity);
+        neogfx::blending_mode blending_mode() const;
+        void set_blending_mode(neogfx::blending_mode aBlendingMode);
+        void set_gradient(const gradient& aGradient);
+        void clear_gradient();
+        bool is_subpixel_rendering_on() const;
+        void subpixel_rendering_on();
+        void subpixel_rendering_off();
+        void clear(const color& aColor);
+        void set_pixel(const point& aPoint, const color& aColor);
+        void draw_pixel(const point& aPoint, const color& aColor);
+        void draw_line(const point& aFrom, const point& aTo, const pen& aPen);
+        void draw_rect(const rect& aRect, const pen& aPen);
+        void draw_rounded_rect(const rect& aRect, dimension aRadius, const pen& aPen);
+        void draw_circle(const point& aCenter, dimension aRadius, const pen& aPen, angle aStartAngle);
+        void draw_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const pen& aPen);
+        void draw_cubic_bezier(const point& aP0, const point& aP1, const point& aP2, const point& aP3, const pen& aPen);
+        void draw_path(const path& aPath, const pen& aPen);
+        void draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen);
+        void fill_rect(const rect& aRect, const brush& aFill, scalar aZpos = 0.0);
+        void fill_rounded_rect(const rect& aRect, dimension aRadius, const brush& aFill);
+        void fill_checker_rect(const rect& aRect, const size& aSquareSize, const brush& aFill1, const brush& aFill2, scalar aZpos = 0.0);
+        void fill_circle(const point& aCenter, dimension aRadius, const brush& aFill);
+        void fill_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const brush& aFill);
+        void fill_path(const path& aPath, const brush& aFill);
+        void fill_shape(const game::mesh& aMesh, const vec3& aPosition, const brush& aFill);
+        void draw_glyphs(const graphics_operation::draw_glyphs& aDrawGlyphs);
+        void draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation);
+    public:
+        neogfx::subpixel_format subpixel_format() const override;
+    private:
+        software_rasterizer& rasterizer() const;
+        void apply_scissor();
+        vec2f to_device(const vec3& aPoint) const;
+        rect to_device(const rect& aRect) const;
+        template <typename ColorContainer>
+        uint32_t add_paint(const ColorContainer& aColor, const rect& aBoundingBox);
+        uint32_t add_paint(const paint& aPaint);
+        void add_triangles(const vec3* aFirst, const vec3* aLast, uint32_t aPaint);
+        void add_fan(const vec3* aFirst, const vec3* aLast, uint32_t aPaint);
+        void add_stroke(const vertices& aPolyline, bool aClosed, const pen& aPen, const rect& aBoundingBox);
+        void add_textured_rect(const rect& aRect, const rect& aTexelRect, uint32_t aPaint);
+        std::shared_ptr<const software_rasterizer::texel_block> capture(const i_texture& aTexture, const rect_i32& aRegion, bool aCoverage, bool aSubpixel);
+        void submit();
+    private:
+        const software_render_target& iTarget;
+        graphics_operation::queue iQueue;
+        bool iInFlush;
+        mutable std::optional<neogfx::logical_coordinate_system> iLogicalCoordinateSystem;
+        mutable std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
+        point iOrigin;
+        optional_vec2 iOffset;
+        mutable std::optional<vec4> iDeviceTransform; // x scale, x translation, y scale, y translation
+        bool iSnapToPixel;
+        double iOpacity;
+        neogfx::blending_mode iBlendingMode;
+        bool iSubpixelRendering;
+        std::vector<rect> iScissorRects;
+        mutable optional_rect iScissorRect;
+        std::optional<gradient> iGradient;
+        std::vector<triangle> iTriangles;
+        std::vector<paint> iPaints;
+        std::map<texel_key, std::shared_ptr<const software_rasterizer::texel_block>> iTexels;
+    };
+}
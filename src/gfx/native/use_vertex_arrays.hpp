@@ -28,21 +28,22 @@ namespace neogfx
     {
         struct with_textures_t {} with_textures;
 
-        class use_vertex_arrays
+        template <typename V = standard_vertex>
+        class basic_use_vertex_arrays
         {
         public:
             struct not_enough_room : std::invalid_argument { not_enough_room() : std::invalid_argument("neogfx::use_vertex_arrays::not_enough_room") {} };
             struct invalid_draw_count : std::invalid_argument { invalid_draw_count() : std::invalid_argument("neogfx::use_vertex_arrays::invalid_draw_count") {} };
             struct cannot_use_barrier : std::invalid_argument { cannot_use_barrier() : std::invalid_argument("neogfx::use_vertex_arrays::cannot_use_barrier") {} };
         public:
-            typedef opengl_vertex_buffer<>::vertex_array::value_type value_type;
-            typedef opengl_vertex_buffer<>::vertex_array::const_iterator const_iterator;
-            typedef opengl_vertex_buffer<>::vertex_array::iterator iterator;
+            typedef typename opengl_vertex_buffer<V>::vertex_array::value_type value_type;
+            typedef typename opengl_vertex_buffer<V>::vertex_array::const_iterator const_iterator;
+            typedef typename opengl_vertex_buffer<V>::vertex_array::iterator iterator;
         public:
-            use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, std::size_t aNeed = 0u, bool aUseBarrier = false) :
+            basic_use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, std::size_t aNeed = 0u, bool aUseBarrier = false) :
                 iProvider{ aProvider },
                 iParent{ aParent }, 
-                iUse{ static_cast<opengl_vertex_buffer<>&>(aParent.rendering_engine().vertex_buffer(aProvider)) },
+                iUse{ vertex_buffer_cast<V>(aParent.rendering_engine().vertex_buffer(aProvider)) },
                 iMode{ aMode }, 
                 iWithTextures{ false }, 
                 iStart{ static_cast<GLint>(vertices().size()) }, 
@@ -57,10 +58,10 @@ namespace neogfx
                 if (!room_for(aNeed) && !need(aNeed))
                     throw not_enough_room();
             }
-            use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, const optional_mat44& aTransformation, std::size_t aNeed = 0u, bool aUseBarrier = false) :
+            basic_use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, const optional_mat44& aTransformation, std::size_t aNeed = 0u, bool aUseBarrier = false) :
                 iProvider{ aProvider },
                 iParent{ aParent },
-                iUse{ static_cast<opengl_vertex_buffer<>&>(aParent.rendering_engine().vertex_buffer(aProvider)) },
+                iUse{ vertex_buffer_cast<V>(aParent.rendering_engine().vertex_buffer(aProvider)) },
                 iMode{ aMode },
                 iWithTextures{ false }, 
                 iStart{ static_cast<GLint>(vertices().size()) },
@@ -75,10 +76,10 @@ namespace neogfx
                 if (!room_for(aNeed) && !need(aNeed))
                     throw not_enough_room();
             }
-            use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, with_textures_t, std::size_t aNeed = 0u, bool aUseBarrier = false) :
+            basic_use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, with_textures_t, std::size_t aNeed = 0u, bool aUseBarrier = false) :
                 iProvider{ aProvider },
                 iParent{ aParent },
-                iUse{ static_cast<opengl_vertex_buffer<>&>(aParent.rendering_engine().vertex_buffer(aProvider)) },
+                iUse{ vertex_buffer_cast<V>(aParent.rendering_engine().vertex_buffer(aProvider)) },
                 iMode{ aMode },
                 iWithTextures{ true }, 
                 iStart{ static_cast<GLint>(vertices().size()) },
@@ -93,10 +94,10 @@ namespace neogfx
                 if (!room_for(aNeed) && !need(aNeed))
                     throw not_enough_room();
             }
-            use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, const optional_mat44& aTransformation, with_textures_t, std::size_t aNeed = 0u, bool aUseBarrier = false) :
+            basic_use_vertex_arrays(i_vertex_provider& aProvider, i_rendering_context& aParent, GLenum aMode, const optional_mat44& aTransformation, with_textures_t, std::size_t aNeed = 0u, bool aUseBarrier = false) :
                 iProvider{ aProvider },
                 iParent{ aParent },
-                iUse{ static_cast<opengl_vertex_buffer<>&>(aParent.rendering_engine().vertex_buffer(aProvider)) },
+                iUse{ vertex_buffer_cast<V>(aParent.rendering_engine().vertex_buffer(aProvider)) },
                 iMode{ aMode },
                 iWithTextures{ true }, 
                 iStart{ static_cast<GLint>(vertices().size()) },
@@ -111,7 +112,7 @@ namespace neogfx
                 if (!room_for(aNeed) && !need(aNeed))
                     throw not_enough_room();
             }
-            ~use_vertex_arrays()
+            ~basic_use_vertex_arrays()
             {
                 if (iDrawOnExit)
                     draw();
@@ -229,9 +230,8 @@ namespace neogfx
             void draw_and_execute()
             {
                 draw();
-                execute();
-                vertices().clear();
-				iStart = 0;
+                iUse.next_region();
+                iStart = static_cast<GLint>(vertices().size());
             }
             void execute()
             {
@@ -261,8 +261,11 @@ namespace neogfx
                 if (static_cast<std::size_t>(iStart) == vertices().size())
                     return;
                 iParent.rendering_engine().vertex_buffer(iProvider).attach_shader(iParent, iParent.rendering_engine().active_shader_program());
+                auto& statistics = iParent.rendering_engine().statistics();
+                statistics.vertices += aCount;
                 if (!iUseBarrier && mode() == translated_mode())
                 {
+                    ++statistics.drawCalls;
                     glCheck(glDrawArrays(translated_mode(), iStart, static_cast<GLsizei>(aCount)));
                     iStart += static_cast<GLint>(aCount);
                 }
@@ -277,6 +280,7 @@ namespace neogfx
                     while (aCount > 0)
                     {
                         auto amount = std::min(chunk, aCount);
+                        ++statistics.drawCalls;
                         glCheck(glDrawArrays(translated_mode(), iStart, static_cast<GLsizei>(amount)));
                         iStart += static_cast<GLint>(amount);
                         aCount -= amount;
@@ -287,6 +291,52 @@ namespace neogfx
                     } 
                 }
             }
+            void draw_elements(std::size_t aIndexStart, std::size_t aCount)
+            {
+                if (aCount == 0u)
+                    return;
+                iDrawOnExit = false;
+                if (aIndexStart + aCount > indices().size())
+                    throw invalid_draw_count();
+                iParent.rendering_engine().vertex_buffer(iProvider).attach_shader(iParent, iParent.rendering_engine().active_shader_program());
+                auto& statistics = iParent.rendering_engine().statistics();
+                statistics.vertices += aCount;
+                if (!iUseBarrier)
+                {
+                    ++statistics.drawCalls;
+                    glCheck(glDrawElements(translated_mode(), static_cast<GLsizei>(aCount), GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(aIndexStart * sizeof(uint32_t))));
+                }
+                else
+                {
+                    glCheck(glTextureBarrier());
+                    auto const pvc = primitive_vertex_count();
+                    while (aCount > 0)
+                    {
+                        auto amount = std::min(pvc, aCount);
+                        ++statistics.drawCalls;
+                        glCheck(glDrawElements(translated_mode(), static_cast<GLsizei>(amount), GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(aIndexStart * sizeof(uint32_t))));
+                        aIndexStart += amount;
+                        aCount -= amount;
+                        glCheck(glTextureBarrier());
+                    }
+                }
+            }
+            void draw_elements_instanced(std::size_t aIndexStart, std::size_t aCount, std::size_t aInstanceStart, std::size_t aInstanceCount)
+            {
+                if (aCount == 0u || aInstanceCount == 0u)
+                    return;
+                iDrawOnExit = false;
+                if (aIndexStart + aCount > indices().size())
+                    throw invalid_draw_count();
+                iParent.rendering_engine().vertex_buffer(iProvider).attach_shader(iParent, iParent.rendering_engine().active_shader_program());
+                auto& statistics = iParent.rendering_engine().statistics();
+                statistics.vertices += aCount * aInstanceCount;
+                ++statistics.drawCalls;
+                iUse.enable_instance_attributes(true);
+                glCheck(glDrawElementsInstancedBaseInstance(translated_mode(), static_cast<GLsizei>(aCount), GL_UNSIGNED_INT, 
+                    reinterpret_cast<const GLvoid*>(aIndexStart * sizeof(uint32_t)), static_cast<GLsizei>(aInstanceCount), static_cast<GLuint>(aInstanceStart)));
+                iUse.enable_instance_attributes(false);
+            }
         private:
             bool is_new_transformation(const optional_mat44& aTransformation) const
             {
@@ -300,14 +350,22 @@ namespace neogfx
             {
                 iUse.set_transformation(aTransformation);
             }
-            const opengl_vertex_buffer<>::vertex_array& vertices() const
+            const typename opengl_vertex_buffer<V>::vertex_array& vertices() const
             {
                 return iUse.vertices();
             }
-            opengl_vertex_buffer<>::vertex_array& vertices()
+            typename opengl_vertex_buffer<V>::vertex_array& vertices()
             {
                 return iUse.vertices();
             }
+            const typename opengl_vertex_buffer<V>::index_array& indices() const
+            {
+                return iUse.indices();
+            }
+            typename opengl_vertex_buffer<V>::index_array& indices()
+            {
+                return iUse.indices();
+            }
             GLenum translated_mode() const
             {
                 switch (iMode)
@@ -325,12 +383,14 @@ namespace neogfx
         private:
             i_vertex_provider& iProvider;
             i_rendering_context& iParent;
-            opengl_vertex_buffer<>::use iUse;
+            typename opengl_vertex_buffer<V>::use iUse;
             GLenum iMode;
             bool iWithTextures;
             GLint iStart;
             bool iUseBarrier;
             bool iDrawOnExit;
         };
+
+        typedef basic_use_vertex_arrays<> use_vertex_arrays;
     }
 }
\ No newline at end of file
@@ -435,6 +435,8 @@ namespace neogfx
 
         void renderer::render_now()
         {
+            // one glyph cache frame for all the surfaces this engine renders
+            font_manager().next_glyph_cache_frame();
             service<i_surface_manager>().render_surfaces();
         }
 
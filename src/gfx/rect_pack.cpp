@@ -1,6 +1,7 @@
 // rect_pack.cpp
 /*
- *  Based on public domain code @ http://blackpawn.com/texts/lightmaps/default.html.
+ *  Maximal rectangles (MaxRects) bin packing as described by Jukka Jylanki in
+ *  "A Thousand Ways to Pack the Bin".
  *
  *  This implementation written by Leigh Johnston.
  *
@@ -34,56 +35,190 @@
 */
 
 #include <neogfx/neogfx.hpp>
+#include <algorithm>
+#include <numeric>
+#include <tuple>
 #include <neogfx/gfx/rect_pack.hpp>
 
 namespace neogfx
 {
-    rect_pack::node* rect_pack::node::insert(const size& aElementSize)
+    namespace
     {
-        if (!is_leaf())
+        inline bool contains(const rect& aOuter, const rect& aInner)
         {
-            auto result = iChildren[0]->insert(aElementSize);
-            if (result != nullptr)
-                return result;
-            return iChildren[1]->insert(aElementSize);
+            return aInner.x >= aOuter.x && aInner.y >= aOuter.y &&
+                aInner.x + aInner.cx <= aOuter.x + aOuter.cx && aInner.y + aInner.cy <= aOuter.y + aOuter.cy;
         }
-        if (iInUse)
-            return nullptr;
-        if (iRect.extents().cx < aElementSize.cx || iRect.extents().cy < aElementSize.cy)
-            return nullptr;
-        else if (iRect.extents() == aElementSize)
+
+        inline bool overlaps(const rect& aLhs, const rect& aRhs)
         {
-            iInUse = true;
-            return this;
+            return aLhs.x < aRhs.x + aRhs.cx && aRhs.x < aLhs.x + aLhs.cx &&
+                aLhs.y < aRhs.y + aRhs.cy && aRhs.y < aLhs.y + aLhs.cy;
         }
-        auto dw = iRect.width() - aElementSize.cx;
-        auto dh = iRect.height() - aElementSize.cy;
-        neogfx::rect rcChild0 = dw > dh ?
-            neogfx::rect{ iRect.left(), iRect.top(), iRect.left() + aElementSize.cx, iRect.bottom() } :
-            neogfx::rect{ iRect.left(), iRect.top(), iRect.right(), iRect.top() + aElementSize.cy };
-        neogfx::rect rcChild1 = dw > dh ?
-            neogfx::rect{ iRect.left() + aElementSize.cx, iRect.top(), iRect.right(), iRect.bottom() } :
-            neogfx::rect{ iRect.left(), iRect.top() + aElementSize.cy, iRect.right(), iRect.bottom() };
-        iChildren[0] = iAllocator.allocate(1);
-        iChildren[1] = iAllocator.allocate(1);
-        iAllocator.construct(iChildren[0], rcChild0, iAllocator);
-        iAllocator.construct(iChildren[1], rcChild1, iAllocator);
-        return iChildren[0]->insert(aElementSize);
     }
 
     rect_pack::rect_pack(const size& aDimensions) :
-        iRoot{ rect{ point{}, aDimensions }, iAllocator }
+        iDimensions{ aDimensions }, iUsedArea{ 0.0 }
     {
+        clear();
+    }
+
+    const size& rect_pack::dimensions() const
+    {
+        return iDimensions;
     }
 
     bool rect_pack::insert(const size& aElementSize, rect& aResult)
     {
-        auto result = iRoot.insert(aElementSize);
-        if (result != nullptr)
+        // best short side fit: the free rectangle leaving the smallest leftover along its shorter side wins
+        auto best = iFreeRects.end();
+        dimension bestShortSide = 0.0;
+        dimension bestLongSide = 0.0;
+        for (auto freeRect = iFreeRects.begin(); freeRect != iFreeRects.end(); ++freeRect)
+        {
+            if (freeRect->cx < aElementSize.cx || freeRect->cy < aElementSize.cy)
+                continue;
+            auto const dw = freeRect->cx - aElementSize.cx;
+            auto const dh = freeRect->cy - aElementSize.cy;
+            auto const shortSide = std::min(dw, dh);
+            auto const longSide = std::max(dw, dh);
+            if (best == iFreeRects.end() || shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+            {
+                best = freeRect;
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+            }
+        }
+        if (best == iFreeRects.end())
+            return false;
+        aResult = rect{ best->position(), aElementSize };
+        split_free_rects(aResult);
+        iUsedArea += aElementSize.cx * aElementSize.cy;
+        return true;
+    }
+
+    bool rect_pack::insert(const std::vector<size>& aElementSizes, std::vector<rect>& aResults)
+    {
+        // tallest first, which suits the glyph and icon sized elements atlases mostly hold; results are in element order
+        std::vector<std::size_t> order(aElementSizes.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](std::size_t aLhs, std::size_t aRhs)
+        {
+            return std::forward_as_tuple(aElementSizes[aLhs].cy, aElementSizes[aLhs].cx) > std::forward_as_tuple(aElementSizes[aRhs].cy, aElementSizes[aRhs].cx);
+        });
+        aResults.resize(aElementSizes.size());
+        for (auto element : order)
+            if (!insert(aElementSizes[element], aResults[element]))
+                return false;
+        return true;
+    }
+
+    void rect_pack::remove(const rect& aElement)
+    {
+        iUsedArea = std::max(0.0, iUsedArea - aElement.cx * aElement.cy);
+        if (iUsedArea == 0.0)
+        {
+            clear();
+            return;
+        }
+        iFreeRects.push_back(merge_free_rects(aElement));
+        prune_free_rects(iFreeRects.size() - 1u);
+    }
+
+    void rect_pack::clear()
+    {
+        iFreeRects.assign(1u, rect{ point{}, iDimensions });
+        iUsedArea = 0.0;
+    }
+
+    dimension rect_pack::used_area() const
+    {
+        return iUsedArea;
+    }
+
+    double rect_pack::occupancy() const
+    {
+        auto const area = iDimensions.cx * iDimensions.cy;
+        return area != 0.0 ? iUsedArea / area : 0.0;
+    }
+
+    std::size_t rect_pack::free_rect_count() const
+    {
+        return iFreeRects.size();
+    }
+
+    void rect_pack::split_free_rects(const rect& aUsed)
+    {
+        iSplitRects.clear();
+        auto survivor = iFreeRects.begin();
+        for (auto const& freeRect : iFreeRects)
+        {
+            if (!overlaps(freeRect, aUsed))
+            {
+                *survivor++ = freeRect;
+                continue;
+            }
+            // keep the maximal free rectangles either side of the used rectangle; they are allowed to overlap
+            if (aUsed.x > freeRect.x)
+                iSplitRects.push_back(rect{ point{ freeRect.x, freeRect.y }, size{ aUsed.x - freeRect.x, freeRect.cy } });
+            if (aUsed.x + aUsed.cx < freeRect.x + freeRect.cx)
+                iSplitRects.push_back(rect{ point{ aUsed.x + aUsed.cx, freeRect.y }, size{ freeRect.x + freeRect.cx - (aUsed.x + aUsed.cx), freeRect.cy } });
+            if (aUsed.y > freeRect.y)
+                iSplitRects.push_back(rect{ point{ freeRect.x, freeRect.y }, size{ freeRect.cx, aUsed.y - freeRect.y } });
+            if (aUsed.y + aUsed.cy < freeRect.y + freeRect.cy)
+                iSplitRects.push_back(rect{ point{ freeRect.x, aUsed.y + aUsed.cy }, size{ freeRect.cx, freeRect.y + freeRect.cy - (aUsed.y + aUsed.cy) } });
+        }
+        iFreeRects.erase(survivor, iFreeRects.end());
+        auto const firstNew = iFreeRects.size();
+        iFreeRects.insert(iFreeRects.end(), iSplitRects.begin(), iSplitRects.end());
+        prune_free_rects(firstNew);
+    }
+
+    rect rect_pack::merge_free_rects(const rect& aFreed)
+    {
+        // grow the freed rectangle by absorbing free neighbours that share a whole edge with it
+        rect merged = aFreed;
+        for (bool absorbed = true; absorbed;)
+        {
+            absorbed = false;
+            for (auto freeRect = iFreeRects.begin(); freeRect != iFreeRects.end(); ++freeRect)
+            {
+                if (freeRect->x == merged.x && freeRect->cx == merged.cx && (freeRect->y + freeRect->cy == merged.y || merged.y + merged.cy == freeRect->y))
+                    merged = rect{ point{ merged.x, std::min(merged.y, freeRect->y) }, size{ merged.cx, merged.cy + freeRect->cy } };
+                else if (freeRect->y == merged.y && freeRect->cy == merged.cy && (freeRect->x + freeRect->cx == merged.x || merged.x + merged.cx == freeRect->x))
+                    merged = rect{ point{ std::min(merged.x, freeRect->x), merged.y }, size{ merged.cx + freeRect->cx, merged.cy } };
+                else
+                    continue;
+                iFreeRects.erase(freeRect);
+                absorbed = true;
+                break;
+            }
+        }
+        return merged;
+    }
+
+    void rect_pack::prune_free_rects(std::size_t aFirstNew)
+    {
+        // rectangles before aFirstNew already contain none of each other so only the new ones need testing;
+        // pruned rectangles are given zero width and swept at the end
+        auto const pruned = [](const rect& aRect) { return aRect.cx == 0.0; };
+        for (std::size_t n = aFirstNew; n < iFreeRects.size(); ++n)
         {
-            aResult = result->rect();
-            return true;
+            if (pruned(iFreeRects[n]))
+                continue;
+            for (std::size_t other = 0u; other < iFreeRects.size(); ++other)
+            {
+                if (other == n || pruned(iFreeRects[other]))
+                    continue;
+                if (contains(iFreeRects[other], iFreeRects[n]))
+                {
+                    iFreeRects[n].cx = 0.0;
+                    break;
+                }
+                if (contains(iFreeRects[n], iFreeRects[other]))
+                    iFreeRects[other].cx = 0.0;
+            }
         }
-        return false;
+        iFreeRects.erase(std::remove_if(iFreeRects.begin(), iFreeRects.end(), pruned), iFreeRects.end());
     }
 }
\ No newline at end of file
@@ -2,68 +2,146 @@
 /*
   neogfx C++ App/Game Engine
   Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
-  
+
   This program is free software: you can redistribute it and / or modify
   it under the terms of the GNU General Public License as published by
   the Free Software Foundation, either version 3 of the License, or
   (at your option) any later version.
-  
+
   This program is distributed in the hope that it will be useful,
   but WITHOUT ANY WARRANTY; without even the implied warranty of
   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
   GNU General Public License for more details.
-  
+
   You should have received a copy of the GNU General Public License
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <neogfx/neogfx.hpp>
+#include <unordered_map>
 #include <neolib/core/vecarray.hpp>
 #include <neogfx/gfx/shapes.hpp>
 
 namespace neogfx
 {
-    vertices arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, uint32_t aArcSegments)
+    namespace
     {
-        vertices result;
-        angle arc = (aEndAngle != aStartAngle ? aEndAngle - aStartAngle : boost::math::constants::two_pi<angle>());
-        uint32_t arcSegments = aArcSegments;
-        if (arcSegments == 0)
-            arcSegments = static_cast<uint32_t>(std::ceil(std::sqrt(aRadius) * 10.0) * arc / boost::math::constants::two_pi<angle>());
-        angle theta = arc / static_cast<angle>(arcSegments);
-        if (aType == mesh_type::TriangleFan)
+        uint32_t constexpr MinimumArcSegments = 8u;
+        uint32_t constexpr MaximumArcSegments = 4096u;
+        // explicit segment counts can ask for any table size so the per-thread set is bounded
+        std::size_t constexpr MaximumUnitCircleTables = 64u;
+
+        // cos and sin of 2*pi*i/N for i = 0..N; arcs with the same number of segments per circle share one table
+        struct unit_circle
         {
-            result.reserve(arcSegments + 2);
-            result.push_back(xyz{ aOrigin.x, aOrigin.y });
-        }
-        else if (aType == mesh_type::Triangles)
-            result.reserve(arcSegments * 3);
-        else if (aType == mesh_type::Outline)
-            result.reserve(arcSegments + 1);
-        auto c = std::cos(theta);
-        auto s = std::sin(theta);
-        auto startCoordinate = mat22{ { std::cos(aStartAngle), std::sin(aStartAngle) },{ -std::sin(aStartAngle), std::cos(aStartAngle) } } *
-            vec2{ aRadius, 0.0 };
-        coordinate x = startCoordinate.x;
-        coordinate y = startCoordinate.y;
-        for (uint32_t i = 0; i < arcSegments; ++i)
+            std::vector<coordinate> cos;
+            std::vector<coordinate> sin;
+        };
+
+        unit_circle const& unit_circle_table(uint32_t aSegmentsPerCircle)
         {
-            if (aType == mesh_type::Triangles)
-                result.push_back(xyz{ aOrigin.x, aOrigin.y });
-            result.push_back(xyz{ x + aCenter.x, y + aCenter.y });
-            coordinate t = x;
-            x = c * x - s * y;
-            y = s * t + c * y;
-            if (aType == mesh_type::Triangles)
-                result.push_back(xyz{ x + aCenter.x, y + aCenter.y });
+            thread_local std::unordered_map<uint32_t, unit_circle> tTables;
+            auto existing = tTables.find(aSegmentsPerCircle);
+            if (existing != tTables.end())
+                return existing->second;
+            // a handful of counts are in use at any one time so starting afresh is cheaper than tracking recency;
+            // callers only hold the returned table until they request another one
+            if (tTables.size() >= MaximumUnitCircleTables)
+                tTables.clear();
+            auto& table = tTables[aSegmentsPerCircle];
+            table.cos.resize(aSegmentsPerCircle + 1u);
+            table.sin.resize(aSegmentsPerCircle + 1u);
+            for (uint32_t i = 0u; i < aSegmentsPerCircle; ++i)
+            {
+                auto const theta = boost::math::constants::two_pi<angle>() * i / aSegmentsPerCircle;
+                table.cos[i] = std::cos(theta);
+                table.sin[i] = std::sin(theta);
+            }
+            table.cos[aSegmentsPerCircle] = table.cos[0u];
+            table.sin[aSegmentsPerCircle] = table.sin[0u];
+            return table;
         }
-        if (aStartAngle == aEndAngle)
+
+        // Appends an arc's vertices to aResult in the layout arc_vertices() produces for aType.
+        void append_arc(vertices& aResult, const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, uint32_t aArcSegments)
         {
-            if (aType == mesh_type::TriangleFan)
-                result.push_back(result[1]);
-            else if (aType == mesh_type::Outline)
-                result.push_back(result[0]);
+            bool const fullCircle = (aStartAngle == aEndAngle);
+            angle arc = (!fullCircle ? aEndAngle - aStartAngle : boost::math::constants::two_pi<angle>());
+            if (arc < 0.0)
+                arc += boost::math::constants::two_pi<angle>();
+            arc = std::min(arc, boost::math::constants::two_pi<angle>());
+            // clamped in floating point so that a tiny arc cannot overflow the count or build an unbounded table
+            uint32_t const segmentsPerCircle = aArcSegments == 0 ?
+                arc_segments_per_circle(aRadius) :
+                static_cast<uint32_t>(std::clamp<scalar>(std::ceil(aArcSegments * boost::math::constants::two_pi<angle>() / arc - 1.0e-6), 3.0, MaximumArcSegments));
+            auto const theta = boost::math::constants::two_pi<angle>() / segmentsPerCircle;
+            uint32_t const arcSegments = fullCircle ? segmentsPerCircle :
+                std::min(segmentsPerCircle, std::max(1u, static_cast<uint32_t>(std::ceil(arc / theta - 1.0e-6))));
+            auto const& table = unit_circle_table(segmentsPerCircle);
+            // rotate the table to the start angle, scale and translate; no trigonometry is evaluated per vertex
+            thread_local std::vector<coordinate> tX;
+            thread_local std::vector<coordinate> tY;
+            tX.resize(arcSegments + 1u);
+            tY.resize(arcSegments + 1u);
+            auto const rc = aRadius * std::cos(aStartAngle);
+            auto const rs = aRadius * std::sin(aStartAngle);
+            coordinate const* const tableCos = table.cos.data();
+            coordinate const* const tableSin = table.sin.data();
+            coordinate* const x = tX.data();
+            coordinate* const y = tY.data();
+            for (uint32_t i = 0u; i <= arcSegments; ++i)
+            {
+                x[i] = aCenter.x + rc * tableCos[i] - rs * tableSin[i];
+                y[i] = aCenter.y + rs * tableCos[i] + rc * tableSin[i];
+            }
+            if (!fullCircle)
+            {
+                // the last segment may be shorter than the others so that the arc ends exactly where requested
+                x[arcSegments] = aCenter.x + aRadius * std::cos(aStartAngle + arc);
+                y[arcSegments] = aCenter.y + aRadius * std::sin(aStartAngle + arc);
+            }
+            auto const first = aResult.size();
+            switch (aType)
+            {
+            case mesh_type::TriangleFan:
+                aResult.reserve(first + arcSegments + 2u);
+                aResult.push_back(xyz{ aOrigin.x, aOrigin.y });
+                for (uint32_t i = 0u; i <= arcSegments; ++i)
+                    aResult.push_back(xyz{ x[i], y[i] });
+                break;
+            case mesh_type::Triangles:
+                aResult.reserve(first + arcSegments * 3u);
+                for (uint32_t i = 0u; i < arcSegments; ++i)
+                {
+                    aResult.push_back(xyz{ aOrigin.x, aOrigin.y });
+                    aResult.push_back(xyz{ x[i], y[i] });
+                    aResult.push_back(xyz{ x[i + 1u], y[i + 1u] });
+                }
+                break;
+            case mesh_type::Outline:
+                aResult.reserve(first + arcSegments + 1u);
+                for (uint32_t i = 0u; i <= arcSegments; ++i)
+                    aResult.push_back(xyz{ x[i], y[i] });
+                break;
+            }
         }
+    }
+
+    uint32_t arc_segments_per_circle(dimension aRadius, scalar aTolerance)
+    {
+        // the largest step whose chord strays from the circle by no more than the tolerance, r(1 - cos(theta/2)),
+        // rounded up to a multiple of four so that quarter arcs (rounded rect corners) start on a table entry
+        if (aRadius <= aTolerance || aTolerance <= 0.0)
+            return MinimumArcSegments;
+        auto const theta = 2.0 * std::acos(1.0 - aTolerance / aRadius);
+        auto const segments = static_cast<uint32_t>(std::min<scalar>(std::ceil(boost::math::constants::two_pi<scalar>() / theta), MaximumArcSegments));
+        return std::clamp((segments + 3u) & ~3u, MinimumArcSegments, MaximumArcSegments);
+    }
+
+    vertices arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, uint32_t aArcSegments)
+    {
+        vertices result;
+        append_arc(result, aCenter, aRadius, aStartAngle, aEndAngle, aOrigin, aType, aArcSegments);
         return result;
     }
 
@@ -75,34 +153,29 @@ namespace neogfx
     vertices rounded_rect_vertices(const rect& aRect, dimension aRadius, mesh_type aType, uint32_t aArcSegments)
     {
         vertices result;
-        auto const topLeft = arc_vertices(
-            aRect.top_left() + point{ aRadius, aRadius },
-            aRadius,
-            boost::math::constants::pi<coordinate>(),
-            boost::math::constants::pi<coordinate>() * 1.5,
-            aRect.center(),
-            aType, aArcSegments);
-        auto const topRight = arc_vertices(
-            aRect.top_right() + point{ -aRadius, aRadius },
-            aRadius,
-            boost::math::constants::pi<coordinate>() * 1.5,
-            boost::math::constants::pi<coordinate>() * 2.0,
-            aRect.center(),
-            aType, aArcSegments);
-        auto const bottomRight = arc_vertices(
-            aRect.bottom_right() + point{ -aRadius, -aRadius },
-            aRadius,
-            0.0,
-            boost::math::constants::pi<coordinate>() * 0.5,
-            aRect.center(),
-            aType, aArcSegments);
-        auto const bottomLeft = arc_vertices(
-            aRect.bottom_left() + point{ aRadius, -aRadius },
-            aRadius,
-            boost::math::constants::pi<coordinate>() * 0.5,
-            boost::math::constants::pi<coordinate>(),
-            aRect.center(),
-            aType, aArcSegments);
+        // corners are appended in place; fan and outline corners contribute perimeter points only, their first and
+        // last points being the ends of the straight edges
+        auto const cornerType = (aType == mesh_type::Triangles ? mesh_type::Triangles : mesh_type::Outline);
+        auto const appendCorner = [&](const point& aCornerCenter, angle aStartAngle, angle aEndAngle)
+        {
+            append_arc(result, aCornerCenter, aRadius, aStartAngle, aEndAngle, aRect.center(), cornerType, aArcSegments);
+        };
+        auto const topLeft = [&]()
+        {
+            appendCorner(aRect.top_left() + point{ aRadius, aRadius }, boost::math::constants::pi<coordinate>(), boost::math::constants::pi<coordinate>() * 1.5);
+        };
+        auto const topRight = [&]()
+        {
+            appendCorner(aRect.top_right() + point{ -aRadius, aRadius }, boost::math::constants::pi<coordinate>() * 1.5, boost::math::constants::pi<coordinate>() * 2.0);
+        };
+        auto const bottomRight = [&]()
+        {
+            appendCorner(aRect.bottom_right() + point{ -aRadius, -aRadius }, 0.0, boost::math::constants::pi<coordinate>() * 0.5);
+        };
+        auto const bottomLeft = [&]()
+        {
+            appendCorner(aRect.bottom_left() + point{ aRadius, -aRadius }, boost::math::constants::pi<coordinate>() * 0.5, boost::math::constants::pi<coordinate>());
+        };
         std::array<xyz, 8> const remainingCoordinates =
         {
             xyz{ (aRect.top_left() + point{ 0.0, aRadius }).x, (aRect.top_left() + point{ 0.0, aRadius }).y },
@@ -114,42 +187,35 @@ namespace neogfx
             xyz{ (aRect.bottom_left() + point{ aRadius, 0.0 }).x, (aRect.bottom_left() + point{ aRadius, 0.0 }).y },
             xyz{ (aRect.bottom_left() + point{ 0.0, -aRadius }).x, (aRect.bottom_left() + point{ 0.0, -aRadius }).y }
         };
+        std::size_t const cornerSegments = aArcSegments != 0 ? aArcSegments : arc_segments_per_circle(aRadius) / 4u;
         if (aType == mesh_type::TriangleFan || aType == mesh_type::Outline)
         {
-            result.reserve(topLeft.size() + topRight.size() + bottomRight.size() + bottomLeft.size() + (aType == mesh_type::TriangleFan ? 10 : 9));
+            result.reserve((cornerSegments + 1u) * 4u + 2u);
             if (aType == mesh_type::TriangleFan)
                 result.push_back(xyz{ aRect.center().x, aRect.center().y });
-            result.insert(result.end(), remainingCoordinates[0]);
-            result.insert(result.end(), topLeft.begin(), topLeft.end());
-            result.insert(result.end(), remainingCoordinates[1]);
-            result.insert(result.end(), remainingCoordinates[2]);
-            result.insert(result.end(), topRight.begin(), topRight.end());
-            result.insert(result.end(), remainingCoordinates[3]);
-            result.insert(result.end(), remainingCoordinates[4]);
-            result.insert(result.end(), bottomRight.begin(), bottomRight.end());
-            result.insert(result.end(), remainingCoordinates[5]);
-            result.insert(result.end(), remainingCoordinates[6]);
-            result.insert(result.end(), bottomLeft.begin(), bottomLeft.end());
-            result.insert(result.end(), remainingCoordinates[7]);
+            topLeft();
+            topRight();
+            bottomRight();
+            bottomLeft();
             result.push_back(result[aType == mesh_type::TriangleFan ? 1 : 0]);
         }
         else if (aType == mesh_type::Triangles)
         {
-            result.reserve(topLeft.size() + topRight.size() + bottomRight.size() + bottomLeft.size() + (remainingCoordinates.size() - 1) * 3 + 3);
-            result.insert(result.end(), topLeft.begin(), topLeft.end());
-            result.insert(result.end(), topRight.begin(), topRight.end());
-            result.insert(result.end(), bottomRight.begin(), bottomRight.end());
-            result.insert(result.end(), bottomLeft.begin(), bottomLeft.end());
+            result.reserve(cornerSegments * 3u * 4u + (remainingCoordinates.size() - 1) * 3 + 3);
+            topLeft();
+            topRight();
+            bottomRight();
+            bottomLeft();
             for (std::size_t i = 0u; i < remainingCoordinates.size() - 1; ++i)
             {
-                result.insert(result.end(), xyz{ aRect.center().x, aRect.center().y });
-                result.insert(result.end(), remainingCoordinates[i]);
-                result.insert(result.end(), remainingCoordinates[i + 1u]);
+                result.push_back(xyz{ aRect.center().x, aRect.center().y });
+                result.push_back(remainingCoordinates[i]);
+                result.push_back(remainingCoordinates[i + 1u]);
             }
-            result.insert(result.end(), xyz{ aRect.center().x, aRect.center().y });
-            result.insert(result.end(), remainingCoordinates[7]);
-            result.insert(result.end(), remainingCoordinates[0]);
+            result.push_back(xyz{ aRect.center().x, aRect.center().y });
+            result.push_back(remainingCoordinates[7]);
+            result.push_back(remainingCoordinates[0]);
         }
         return result;
     }
-}
\ No newline at end of file
+}
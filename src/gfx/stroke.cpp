@@ -0,0 +1,244 @@
+// stroke.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <neogfx/gfx/shapes.hpp>
+#include <neogfx/gfx/stroke.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        class stroker
+        {
+        public:
+            stroker(std::vector<vec3f>& aTriangles, float aHalfWidth, float aZ) :
+                iTriangles{ aTriangles },
+                iHalfWidth{ aHalfWidth },
+                iZ{ aZ },
+                iRoundStep{ boost::math::constants::two_pi<float>() / static_cast<float>(arc_segments_per_circle(aHalfWidth)) }
+            {
+            }
+        public:
+            void triangle(float aX0, float aY0, float aX1, float aY1, float aX2, float aY2)
+            {
+                iTriangles.push_back(vec3f{ aX0, aY0, iZ });
+                iTriangles.push_back(vec3f{ aX1, aY1, iZ });
+                iTriangles.push_back(vec3f{ aX2, aY2, iZ });
+            }
+            // A fan about (aX, aY) sweeping the offset (aFromX, aFromY) through aAngle radians (anticlockwise if aSign
+            // is positive) and finishing exactly on (aToX, aToY).
+            void fan(float aX, float aY, float aFromX, float aFromY, float aToX, float aToY, float aAngle, float aSign)
+            {
+                auto const steps = std::max(1u, static_cast<uint32_t>(std::ceil(aAngle / iRoundStep)));
+                auto const theta = aSign * aAngle / static_cast<float>(steps);
+                auto const c = std::cos(theta);
+                auto const s = std::sin(theta);
+                float ox = aFromX;
+                float oy = aFromY;
+                for (uint32_t step = 1u; step <= steps; ++step)
+                {
+                    float nx = c * ox - s * oy;
+                    float ny = s * ox + c * oy;
+                    if (step == steps)
+                    {
+                        nx = aToX;
+                        ny = aToY;
+                    }
+                    triangle(aX, aY, aX + ox, aY + oy, aX + nx, aY + ny);
+                    ox = nx;
+                    oy = ny;
+                }
+            }
+            // Fills the gap on the outside of the turn between two segments whose unit left normals are given.
+            void join(line_join aJoin, float aMiterLimit, float aX, float aY, float aN0x, float aN0y, float aN1x, float aN1y)
+            {
+                auto const cross = aN0x * aN1y - aN0y * aN1x;
+                auto const dot = aN0x * aN1x + aN0y * aN1y;
+                if (std::abs(cross) < 1.0e-6f)
+                {
+                    if (dot > 0.0f)
+                        return; // straight on; the segment quads already meet
+                    // doubling back; only a round join has anything to add
+                    if (aJoin == line_join::Round)
+                        fan(aX, aY, aN0x * iHalfWidth, aN0y * iHalfWidth, aN1x * iHalfWidth, aN1y * iHalfWidth, boost::math::constants::pi<float>(), -1.0f);
+                    return;
+                }
+                // the outer side of a left turn is on the right of travel and vice versa
+                auto const side = cross > 0.0f ? -1.0f : 1.0f;
+                auto const o0x = aN0x * iHalfWidth * side;
+                auto const o0y = aN0y * iHalfWidth * side;
+                auto const o1x = aN1x * iHalfWidth * side;
+                auto const o1y = aN1y * iHalfWidth * side;
+                switch (aJoin)
+                {
+                case line_join::Round:
+                    fan(aX, aY, o0x, o0y, o1x, o1y, std::acos(std::clamp(dot, -1.0f, 1.0f)), cross > 0.0f ? 1.0f : -1.0f);
+                    break;
+                case line_join::Miter:
+                    {
+                        // the miter tip lies on the bisector at half width / cos(half the turn)
+                        auto const bx = aN0x + aN1x;
+                        auto const by = aN0y + aN1y;
+                        auto const bisectorLength = std::sqrt(bx * bx + by * by);
+                        auto const cosHalfTurn = bisectorLength / 2.0f;
+                        if (cosHalfTurn * aMiterLimit >= 1.0f)
+                        {
+                            auto const scale = iHalfWidth * side / (bisectorLength * cosHalfTurn);
+                            auto const mx = bx * scale;
+                            auto const my = by * scale;
+                            triangle(aX, aY, aX + o0x, aY + o0y, aX + mx, aY + my);
+                            triangle(aX, aY, aX + mx, aY + my, aX + o1x, aY + o1y);
+                            break;
+                        }
+                    }
+                    [[fallthrough]];
+                case line_join::Bevel:
+                default:
+                    triangle(aX, aY, aX + o0x, aY + o0y, aX + o1x, aY + o1y);
+                    break;
+                }
+            }
+        private:
+            std::vector<vec3f>& iTriangles;
+            float iHalfWidth;
+            float iZ;
+            float iRoundStep;
+        };
+    }
+
+    void stroke_polyline(const vertices& aPolyline, bool aClosed, const pen& aPen, std::vector<vec3f>& aTriangles)
+    {
+        thread_local std::vector<float> tX;
+        thread_local std::vector<float> tY;
+        thread_local std::vector<float> tNormalX;
+        thread_local std::vector<float> tNormalY;
+        tX.clear();
+        tY.clear();
+        for (auto const& v : aPolyline)
+        {
+            auto const x = static_cast<float>(v.x);
+            auto const y = static_cast<float>(v.y);
+            if (tX.empty() || x != tX.back() || y != tY.back())
+            {
+                tX.push_back(x);
+                tY.push_back(y);
+            }
+        }
+        if (aClosed && tX.size() > 2 && tX.front() == tX.back() && tY.front() == tY.back())
+        {
+            tX.pop_back();
+            tY.pop_back();
+        }
+        std::size_t const points = tX.size();
+        if (points == 0 || aPen.width() <= 0.0)
+            return;
+        float const halfWidth = static_cast<float>(aPen.width() / 2.0);
+        float const z = static_cast<float>(aPolyline.begin()->z);
+        if (points == 1)
+        {
+            // a zero-length stroke is a dot shaped by the cap; a butt cap has no extent so draws nothing
+            stroker s{ aTriangles, halfWidth, z };
+            float const x = tX[0];
+            float const y = tY[0];
+            if (aPen.line_cap() == line_cap::Round)
+                s.fan(x, y, halfWidth, 0.0f, halfWidth, 0.0f, boost::math::constants::two_pi<float>(), 1.0f);
+            else if (aPen.line_cap() == line_cap::Square)
+            {
+                s.triangle(x - halfWidth, y - halfWidth, x + halfWidth, y - halfWidth, x + halfWidth, y + halfWidth);
+                s.triangle(x - halfWidth, y - halfWidth, x + halfWidth, y + halfWidth, x - halfWidth, y + halfWidth);
+            }
+            return;
+        }
+        bool const closed = aClosed && points > 2;
+        std::size_t const segments = closed ? points : points - 1;
+        float* const x = tX.data();
+        float* const y = tY.data();
+        tNormalX.resize(segments);
+        tNormalY.resize(segments);
+        float* const nx = tNormalX.data();
+        float* const ny = tNormalY.data();
+        // unit left normal of every segment
+        for (std::size_t i = 0; i < points - 1; ++i)
+        {
+            float const dx = x[i + 1] - x[i];
+            float const dy = y[i + 1] - y[i];
+            float const inverseLength = 1.0f / std::sqrt(dx * dx + dy * dy);
+            nx[i] = -dy * inverseLength;
+            ny[i] = dx * inverseLength;
+        }
+        if (closed)
+        {
+            float const dx = x[0] - x[points - 1];
+            float const dy = y[0] - y[points - 1];
+            float const inverseLength = 1.0f / std::sqrt(dx * dx + dy * dy);
+            nx[points - 1] = -dy * inverseLength;
+            ny[points - 1] = dx * inverseLength;
+        }
+        // square caps lengthen the end segments by half the width (the direction of travel is (ny, -nx))
+        float startX = x[0];
+        float startY = y[0];
+        float endX = x[points - 1];
+        float endY = y[points - 1];
+        if (!closed && aPen.line_cap() == line_cap::Square)
+        {
+            startX -= ny[0] * halfWidth;
+            startY += nx[0] * halfWidth;
+            endX += ny[segments - 1] * halfWidth;
+            endY -= nx[segments - 1] * halfWidth;
+        }
+        // segment bodies: two triangles per segment written straight into the output
+        std::size_t const first = aTriangles.size();
+        aTriangles.resize(first + segments * 6u);
+        vec3f* out = aTriangles.data() + first;
+        for (std::size_t i = 0; i < segments; ++i)
+        {
+            std::size_t const next = (i + 1 == points ? 0 : i + 1);
+            float const x0 = (i == 0 ? startX : x[i]);
+            float const y0 = (i == 0 ? startY : y[i]);
+            float const x1 = (i == points - 2 && !closed ? endX : x[next]);
+            float const y1 = (i == points - 2 && !closed ? endY : y[next]);
+            float const ox = nx[i] * halfWidth;
+            float const oy = ny[i] * halfWidth;
+            out[0] = vec3f{ x0 + ox, y0 + oy, z };
+            out[1] = vec3f{ x0 - ox, y0 - oy, z };
+            out[2] = vec3f{ x1 - ox, y1 - oy, z };
+            out[3] = out[0];
+            out[4] = out[2];
+            out[5] = vec3f{ x1 + ox, y1 + oy, z };
+            out += 6;
+        }
+        stroker s{ aTriangles, halfWidth, z };
+        float const miterLimit = static_cast<float>(aPen.miter_limit());
+        for (std::size_t k = (closed ? 0 : 1); k < (closed ? points : points - 1); ++k)
+        {
+            std::size_t const incoming = (k == 0 ? points - 1 : k - 1);
+            s.join(aPen.line_join(), miterLimit, x[k], y[k], nx[incoming], ny[incoming], nx[k], ny[k]);
+        }
+        if (!closed && aPen.line_cap() == line_cap::Round)
+        {
+            // half turns from the left edge round the start and from the right edge round the end
+            float const pi = boost::math::constants::pi<float>();
+            s.fan(x[0], y[0], nx[0] * halfWidth, ny[0] * halfWidth, -nx[0] * halfWidth, -ny[0] * halfWidth, pi, 1.0f);
+            auto const last = segments - 1;
+            s.fan(x[points - 1], y[points - 1], -nx[last] * halfWidth, -ny[last] * halfWidth, nx[last] * halfWidth, ny[last] * halfWidth, pi, 1.0f);
+        }
+    }
+}
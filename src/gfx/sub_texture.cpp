@@ -24,17 +24,17 @@
 namespace neogfx
 {
     sub_texture::sub_texture(texture_id aAtlasId, i_texture& aAtlasTexture, const rect& aAtlasLocation, const size& aExtents) :
-        iAtlasId{ aAtlasId }, iAtlasTexture{ &aAtlasTexture }, iAtlasLocation{ aAtlasLocation }, iStorageExtents{ aAtlasTexture.storage_extents() }, iExtents{ aExtents }
+        iAtlasId{ aAtlasId }, iAtlasTexture{ &aAtlasTexture }, iAtlasLocation{ std::make_shared<rect>(aAtlasLocation) }, iStorageExtents{ aAtlasTexture.storage_extents() }, iExtents{ aExtents }
     {
     }
 
     sub_texture::sub_texture(const i_sub_texture& aSubTexture) :
-        iAtlasId{ aSubTexture.atlas_id() }, iAtlasTexture{ &aSubTexture.atlas_texture() }, iAtlasLocation{ aSubTexture.atlas_location() }, iStorageExtents{ aSubTexture.storage_extents() }, iExtents{ aSubTexture.extents() }
+        iAtlasId{ aSubTexture.atlas_id() }, iAtlasTexture{ &aSubTexture.atlas_texture() }, iAtlasLocation{ dynamic_cast<const sub_texture*>(&aSubTexture) != nullptr ? static_cast<const sub_texture&>(aSubTexture).iAtlasLocation : std::make_shared<rect>(aSubTexture.atlas_location()) }, iStorageExtents{ aSubTexture.storage_extents() }, iExtents{ aSubTexture.extents() }
     {
     }
 
     sub_texture::sub_texture(const i_sub_texture& aSubTexture, const rect& aAtlasLocation) :
-        iAtlasId{ aSubTexture.atlas_id() }, iAtlasTexture{ &aSubTexture.atlas_texture() }, iAtlasLocation{ aAtlasLocation }, iStorageExtents{ aSubTexture.storage_extents() }, iExtents{ aAtlasLocation.extents() }
+        iAtlasId{ aSubTexture.atlas_id() }, iAtlasTexture{ &aSubTexture.atlas_texture() }, iAtlasLocation{ std::make_shared<rect>(aAtlasLocation) }, iStorageExtents{ aSubTexture.storage_extents() }, iExtents{ aAtlasLocation.extents() }
     {
     }
 
@@ -204,6 +204,11 @@ namespace neogfx
 
     const rect& sub_texture::atlas_location() const
     {
-        return iAtlasLocation;
+        return *iAtlasLocation;
+    }
+
+    void sub_texture::set_atlas_location(const rect& aAtlasLocation)
+    {
+        *iAtlasLocation = aAtlasLocation;
     }
 }
\ No newline at end of file
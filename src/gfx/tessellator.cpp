@@ -0,0 +1,249 @@
+// tessellator.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <algorithm>
+#include <cstring>
+#include <neogfx/gfx/tessellator.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        struct edge
+        {
+            point top;
+            point bottom;
+            int32_t winding; // +1 if the contour runs down the edge, -1 if up
+
+            coordinate x_at(coordinate aY) const
+            {
+                return top.x + (bottom.x - top.x) * (aY - top.y) / (bottom.y - top.y);
+            }
+        };
+
+        struct crossing
+        {
+            coordinate x0;
+            coordinate x1;
+            coordinate middle;
+            int32_t winding;
+        };
+
+        inline bool inside(fill_rule aFillRule, int32_t aWinding)
+        {
+            return aFillRule == fill_rule::NonZero ? aWinding != 0 : (aWinding & 1) != 0;
+        }
+    }
+
+    vertices tessellate(const path& aPath)
+    {
+        // The region is cut into horizontal slabs at every vertex and every edge crossing. No two edges cross inside
+        // a slab, so ordering the edges spanning it by x and walking their windings yields the filled spans as
+        // trapezoids; this copes with any contour arrangement and either fill rule.
+        std::vector<edge> edges;
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() < 3)
+                continue;
+            for (std::size_t i = 0; i < subPath.size(); ++i)
+            {
+                auto const& from = subPath[i];
+                auto const& to = subPath[(i + 1) % subPath.size()];
+                if (from.y < to.y)
+                    edges.push_back(edge{ from, to, 1 });
+                else if (from.y > to.y)
+                    edges.push_back(edge{ to, from, -1 });
+            }
+        }
+        vertices result;
+        if (edges.empty())
+            return result;
+        std::sort(edges.begin(), edges.end(), [](edge const& lhs, edge const& rhs) { return lhs.top.y < rhs.top.y; });
+        std::vector<coordinate> slabs;
+        slabs.reserve(edges.size() * 2);
+        for (auto const& e : edges)
+        {
+            slabs.push_back(e.top.y);
+            slabs.push_back(e.bottom.y);
+        }
+        // sweep down the edges keeping only those still spanning the sweep line, so each edge is only tested
+        // against edges whose y-ranges overlap its own rather than against every later edge
+        std::vector<std::size_t> active;
+        for (std::size_t i = 0; i < edges.size(); ++i)
+        {
+            auto const& ei = edges[i];
+            active.erase(std::remove_if(active.begin(), active.end(), [&](std::size_t e) { return edges[e].bottom.y <= ei.top.y; }), active.end());
+            auto const iLeft = std::min(ei.top.x, ei.bottom.x);
+            auto const iRight = std::max(ei.top.x, ei.bottom.x);
+            for (auto j : active)
+            {
+                auto const& ej = edges[j];
+                if (std::max(ej.top.x, ej.bottom.x) < iLeft || std::min(ej.top.x, ej.bottom.x) > iRight)
+                    continue;
+                auto const low = ei.top.y;
+                auto const high = std::min(ei.bottom.y, ej.bottom.y);
+                if (low >= high)
+                    continue;
+                auto const dLow = ei.x_at(low) - ej.x_at(low);
+                auto const dHigh = ei.x_at(high) - ej.x_at(high);
+                if ((dLow < 0.0 && dHigh > 0.0) || (dLow > 0.0 && dHigh < 0.0))
+                    slabs.push_back(low + (high - low) * dLow / (dLow - dHigh));
+            }
+            active.push_back(i);
+        }
+        std::sort(slabs.begin(), slabs.end());
+        slabs.erase(std::unique(slabs.begin(), slabs.end()), slabs.end());
+        active.clear();
+        std::vector<crossing> crossings;
+        std::size_t nextEdge = 0;
+        for (std::size_t slab = 0; slab + 1 < slabs.size(); ++slab)
+        {
+            auto const y0 = slabs[slab];
+            auto const y1 = slabs[slab + 1];
+            while (nextEdge < edges.size() && edges[nextEdge].top.y <= y0)
+                active.push_back(nextEdge++);
+            active.erase(std::remove_if(active.begin(), active.end(), [&](std::size_t e) { return edges[e].bottom.y <= y0; }), active.end());
+            crossings.clear();
+            auto const middle = (y0 + y1) / 2.0;
+            for (auto e : active)
+                crossings.push_back(crossing{ edges[e].x_at(y0), edges[e].x_at(y1), edges[e].x_at(middle), edges[e].winding });
+            std::sort(crossings.begin(), crossings.end(), [](crossing const& lhs, crossing const& rhs) { return lhs.middle < rhs.middle; });
+            int32_t winding = 0;
+            std::size_t left = 0;
+            for (std::size_t c = 0; c < crossings.size(); ++c)
+            {
+                bool const wasInside = inside(aPath.fill_rule(), winding);
+                winding += crossings[c].winding;
+                bool const isInside = inside(aPath.fill_rule(), winding);
+                if (!wasInside && isInside)
+                    left = c;
+                else if (wasInside && !isInside)
+                {
+                    auto const& l = crossings[left];
+                    auto const& r = crossings[c];
+                    if (r.x0 != l.x0)
+                    {
+                        result.push_back(xyz{ l.x0, y0 });
+                        result.push_back(xyz{ r.x0, y0 });
+                        result.push_back(xyz{ r.x1, y1 });
+                    }
+                    if (r.x1 != l.x1)
+                    {
+                        result.push_back(xyz{ l.x0, y0 });
+                        result.push_back(xyz{ r.x1, y1 });
+                        result.push_back(xyz{ l.x1, y1 });
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    path_mesh_cache::path_mesh_cache(std::size_t aCapacity, hash_function aHash) :
+        iCapacity{ aCapacity }, iHash{ aHash }
+    {
+    }
+
+    std::shared_ptr<const vertices> path_mesh_cache::find(const path& aPath)
+    {
+        auto const key = iHash(aPath);
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            auto existing = iEntries.find(key);
+            if (existing != iEntries.end() && same_content(existing->second, aPath))
+            {
+                iQueue.splice(iQueue.end(), iQueue, existing->second.queuePosition);
+                return existing->second.mesh;
+            }
+        }
+        // tessellated without the lock held so that other threads are not held up by a large path
+        auto mesh = std::make_shared<const vertices>(tessellate(aPath));
+        std::unique_lock<std::mutex> lock{ iMutex };
+        auto existing = iEntries.find(key);
+        if (existing != iEntries.end())
+        {
+            // replaces a hash collision or an entry another thread has just added
+            existing->second.fillRule = aPath.fill_rule();
+            existing->second.subPaths = aPath.sub_paths();
+            existing->second.mesh = mesh;
+            iQueue.splice(iQueue.end(), iQueue, existing->second.queuePosition);
+            return mesh;
+        }
+        if (iEntries.size() >= iCapacity && !iQueue.empty())
+        {
+            iEntries.erase(iQueue.front());
+            iQueue.pop_front();
+        }
+        iQueue.push_back(key);
+        iEntries.emplace(key, entry{ aPath.fill_rule(), aPath.sub_paths(), mesh, std::prev(iQueue.end()) });
+        return mesh;
+    }
+
+    std::size_t path_mesh_cache::size() const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        return iEntries.size();
+    }
+
+    uint64_t path_mesh_cache::content_hash(const path& aPath)
+    {
+        // 64-bit FNV-1a over the fill rule and contour points
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint64_t aValue)
+        {
+            for (uint32_t byte = 0u; byte < 8u; ++byte, aValue >>= 8u)
+                hash = (hash ^ (aValue & 0xFFu)) * 1099511628211ull;
+        };
+        auto coordinate_bits = [](coordinate aCoordinate)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &aCoordinate, sizeof(bits));
+            return bits;
+        };
+        mix(static_cast<uint64_t>(aPath.fill_rule()));
+        mix(aPath.sub_paths().size());
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            mix(subPath.size());
+            for (auto const& point : subPath)
+            {
+                mix(coordinate_bits(point.x));
+                mix(coordinate_bits(point.y));
+            }
+        }
+        return hash;
+    }
+
+    bool path_mesh_cache::same_content(entry const& aEntry, const path& aPath)
+    {
+        if (aEntry.fillRule != aPath.fill_rule() || aEntry.subPaths.size() != aPath.sub_paths().size())
+            return false;
+        for (std::size_t i = 0; i < aEntry.subPaths.size(); ++i)
+            if (!std::equal(aEntry.subPaths[i].begin(), aEntry.subPaths[i].end(), aPath.sub_paths()[i].begin(), aPath.sub_paths()[i].end()))
+                return false;
+        return true;
+    }
+
+    std::shared_ptr<const vertices> tessellated(const path& aPath)
+    {
+        static path_mesh_cache sCache;
+        return sCache.find(aPath);
+    }
+}
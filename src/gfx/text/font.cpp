@@ -613,6 +613,11 @@ namespace neogfx
         return native_font_face().glyph_texture(aGlyph);
     }
 
+    void font::glyph_texture_drawn(const glyph& aGlyph) const
+    {
+        native_font_face().glyph_texture_drawn(aGlyph);
+    }
+
     bool font::operator==(const font& aRhs) const
     {
         return iInstance->native_font_face().handle() == aRhs.iInstance->native_font_face().handle() &&
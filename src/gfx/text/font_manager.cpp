@@ -19,6 +19,8 @@
 
 #include <neogfx/neogfx.hpp>
 #include <filesystem>
+#include <list>
+#include <boost/functional/hash.hpp>
 #include <neolib/core/string_utils.hpp>
 #include <neolib/core/string_utf.hpp>
 #include <ft2build.h>
@@ -27,6 +29,7 @@
 #include FT_GLYPH_H
 #include FT_OUTLINE_H
 #include FT_BITMAP_H
+#include FT_MODULE_H
 #ifdef u8
 #undef u8
 #include <harfbuzz\hb.h>
@@ -41,6 +44,7 @@
 #include <Shlobj.h>
 #endif
 #include <neolib/file/file.hpp>
+#include <neogfx/core/worker_pool.hpp>
 #include <neogfx/app/i_app.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/i_graphics_context.hpp>
@@ -48,6 +52,8 @@
 #include <neogfx/gfx/text/text_category_map.hpp>
 #include "../../gfx/text/native/native_font_face.hpp"
 #include "../../gfx/text/native/native_font.hpp"
+#include "../../gfx/text/native/font_index.hpp"
+#include "../../gfx/text/native/glyph_rasterizer.hpp"
 
 template <>
 neogfx::i_font_manager& services::start_service<neogfx::i_font_manager>()
@@ -130,6 +136,19 @@ namespace neogfx
 #endif
             }
 
+            std::string get_font_index_path()
+            {
+#ifdef WIN32
+                char szPath[MAX_PATH];
+                if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, szPath)))
+                    return neolib::tidy_path(szPath) + "/neogfx/font_index.txt";
+                else
+                    throw std::logic_error("neogfx::detail::platform_specific::get_font_index_path: Error");
+#else
+                throw std::logic_error("neogfx::detail::platform_specific::get_font_index_path: Unknown system");
+#endif
+            }
+
             fallback_font_info default_fallback_font_info()
             {
 #ifdef WIN32
@@ -174,17 +193,70 @@ namespace neogfx
             glyph::flags_e flags;
         };
         typedef std::vector<cluster> cluster_map_t;
-        typedef std::tuple<const char32_t*, const char32_t*, text_direction, bool, hb_script_t> glyph_run;
+        typedef std::tuple<const char32_t*, const char32_t*, text_direction, bool, hb_script_t, uint32_t> glyph_run; // last is the fallback font index
         typedef std::vector<glyph_run> run_list;
+    private:
+        // everything shaping depends on besides the font selector; direction and script runs follow from the text
+        struct cache_key
+        {
+            std::u32string text;
+            font_id font;
+            bool subpixel;
+            char32_t mnemonic; // zero if none
+            std::u32string passwordMask; // empty if not a password
+            bool operator==(cache_key const&) const = default;
+        };
+        struct cache_key_hash
+        {
+            std::size_t operator()(cache_key const& aKey) const
+            {
+                std::size_t seed = std::hash<std::u32string>{}(aKey.text);
+                boost::hash_combine(seed, aKey.font);
+                boost::hash_combine(seed, aKey.subpixel);
+                boost::hash_combine(seed, aKey.mnemonic);
+                boost::hash_combine(seed, std::hash<std::u32string>{}(aKey.passwordMask));
+                return seed;
+            }
+        };
+        struct cache_entry
+        {
+            ref_ptr<glyph_text_content> content;
+            std::size_t bytes;
+            std::list<cache_key const*>::iterator lruPosition;
+        };
+        typedef std::unordered_map<cache_key, cache_entry, cache_key_hash> cache;
+        struct paragraph;
+    public:
+        static constexpr std::size_t MinimumConcurrentParagraphs = 16u;
+    public:
+        glyph_text_factory(std::size_t aCacheBudget);
+        ~glyph_text_factory();
     public:
         glyph_text create_glyph_text(font const& aFont) override;
         glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, i_font_selector const& aFontSelector) override;
         glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector) override;
+        glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, font const& aFont) override;
+        glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, font const& aFont) override;
+        std::vector<glyph_text> to_glyph_text(i_graphics_context const& aContext, std::vector<std::u32string_view> const& aParagraphs, std::function<font(std::size_t, std::size_t)> const& aFontSelector) override;
+    public:
+        std::size_t cache_budget() const override;
+        void set_cache_budget(std::size_t aBudget) override;
+        glyph_text_cache_statistics const& cache_statistics() const override;
+        void clear_cache() override;
+    private:
+        void itemize(i_graphics_context const& aContext, paragraph& aParagraph, i_font_selector const& aFontSelector);
+        static void shape(i_graphics_context const& aContext, paragraph& aParagraph);
+        glyph_text assemble(i_graphics_context const& aContext, paragraph& aParagraph, i_font_selector const& aFontSelector);
+        void evict();
     private:
         cluster_map_t iClusterMap;
-        std::vector<character_type> iTextDirections;
         std::u32string iCodePointsBuffer;
-        run_list iRuns;
+        std::unique_ptr<paragraph> iParagraph;
+        worker_pool iShapingPool; // one thread fewer than the hardware supports as the calling thread shapes too
+        cache iCache;
+        std::list<cache_key const*> iLru; // most recently used first
+        cache_key iLookupKey;
+        glyph_text_cache_statistics iCacheStatistics;
     };
 
     class glyph_shapes
@@ -198,17 +270,21 @@ namespace neogfx
             glyphs(const i_graphics_context& aParent, const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun) :
                 iParent{ aParent },
                 iFont{ static_cast<font_face_handle*>(aFont.native_font_face().handle())->harfbuzzFont },
-                iGlyphRun{ aGlyphRun },
-                iBuf{ static_cast<font_face_handle*>(aFont.native_font_face().handle())->harfbuzzBuf },
-                iGlyphCount{ 0u },
-                iGlyphInfo{ nullptr },
-                iGlyphPos{ nullptr }
+                iGlyphRun{ aGlyphRun }
             {
-                hb_buffer_set_direction(iBuf, std::get<2>(aGlyphRun) == text_direction::RTL ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
-                hb_buffer_set_script(iBuf, std::get<4>(aGlyphRun));
+                // HarfBuzz buffers are not thread safe so each shaping thread has its own; the results are copied out so it can be reused straight away
+                struct thread_buffer
+                {
+                    hb_buffer_t* buffer = hb_buffer_create();
+                    ~thread_buffer() { hb_buffer_destroy(buffer); }
+                };
+                thread_local thread_buffer tBuffer;
+                hb_buffer_t* const buffer = tBuffer.buffer;
+                hb_buffer_set_direction(buffer, std::get<2>(aGlyphRun) == text_direction::RTL ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
+                hb_buffer_set_script(buffer, std::get<4>(aGlyphRun));
                 std::vector<uint32_t> reversed;
                 if (std::get<2>(aGlyphRun) != text_direction::None_RTL)
-                    hb_buffer_add_utf32(iBuf, reinterpret_cast<const uint32_t*>(std::get<0>(aGlyphRun)), static_cast<int>(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun)), 0, static_cast<int>(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun)));
+                    hb_buffer_add_utf32(buffer, reinterpret_cast<const uint32_t*>(std::get<0>(aGlyphRun)), static_cast<int>(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun)), 0, static_cast<int>(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun)));
                 else
                 {
                     reversed.reserve(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun));
@@ -238,26 +314,24 @@ namespace neogfx
                             reversed.push_back(*(ch - 1));
                         }
                     }
-                    hb_buffer_add_utf32(iBuf, &*reversed.begin(), static_cast<int>(reversed.size()), 0u, static_cast<int>(reversed.size()));
+                    hb_buffer_add_utf32(buffer, &*reversed.begin(), static_cast<int>(reversed.size()), 0u, static_cast<int>(reversed.size()));
                 }
                 scoped_kerning sk{ aFont.kerning() };
-                hb_shape(iFont, iBuf, NULL, 0);
+                hb_shape(iFont, buffer, NULL, 0);
                 unsigned int glyphCount = 0;
-                iGlyphInfo = hb_buffer_get_glyph_infos(iBuf, &glyphCount);
-                iGlyphPos = hb_buffer_get_glyph_positions(iBuf, &glyphCount);
-                iGlyphCount = glyphCount;
+                auto const glyphInfo = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+                auto const glyphPos = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+                iGlyphInfo.assign(glyphInfo, glyphInfo + glyphCount);
+                iGlyphPos.assign(glyphPos, glyphPos + glyphCount);
+                hb_buffer_clear_contents(buffer);
                 if (std::get<2>(aGlyphRun) == text_direction::None_RTL)
-                    for (uint32_t i = 0; i < iGlyphCount; ++i)
-                        iGlyphInfo[i].cluster = static_cast<uint32_t>(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun) - 1 - iGlyphInfo[i].cluster);
-            }
-            ~glyphs()
-            {
-                hb_buffer_clear_contents(iBuf);
+                    for (auto& info : iGlyphInfo)
+                        info.cluster = static_cast<uint32_t>(std::get<1>(aGlyphRun) - std::get<0>(aGlyphRun) - 1 - info.cluster);
             }
         public:
             uint32_t glyph_count() const
             {
-                return iGlyphCount;
+                return static_cast<uint32_t>(iGlyphInfo.size());
             }
             const hb_glyph_info_t& glyph_info(uint32_t aIndex) const
             {
@@ -281,27 +355,23 @@ namespace neogfx
             const i_graphics_context& iParent;
             hb_font_t* iFont;
             const glyph_text_factory::glyph_run& iGlyphRun;
-            hb_buffer_t* iBuf;
-            uint32_t iGlyphCount;
-            hb_glyph_info_t* iGlyphInfo;
-            hb_glyph_position_t* iGlyphPos;
+            std::vector<hb_glyph_info_t> iGlyphInfo;
+            std::vector<hb_glyph_position_t> iGlyphPos;
         };
         typedef std::list<glyphs> glyphs_list;
         typedef std::vector<std::pair<glyphs_list::const_iterator, uint32_t>> result_type;
     public:
-        glyph_shapes(const i_graphics_context& aParent, const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun)
+        // aFonts is the run's font followed by its distinct fallbacks; they are resolved up front as fonts cannot be created off the main thread
+        glyph_shapes(const i_graphics_context& aParent, std::vector<font> const& aFonts, const glyph_text_factory::glyph_run& aGlyphRun)
         {
-            thread_local std::vector<font> fontsTried;
-            auto tryFont = aFont;
-            fontsTried.push_back(aFont);
-            iGlyphsList.emplace_back(glyphs{ aParent, tryFont, aGlyphRun });
+            auto tryFont = aFonts.begin();
+            iGlyphsList.emplace_back(aParent, *tryFont, aGlyphRun);
             while (iGlyphsList.back().needs_fallback_font())
             {
-                if (tryFont.has_fallback() && std::find(fontsTried.begin(), fontsTried.end(), tryFont.fallback()) == fontsTried.end())
+                if (std::next(tryFont) != aFonts.end())
                 {
-                    tryFont = tryFont.fallback();
-                    fontsTried.push_back(tryFont);
-                    iGlyphsList.emplace_back(glyphs{ aParent, tryFont, aGlyphRun });
+                    ++tryFont;
+                    iGlyphsList.emplace_back(aParent, *tryFont, aGlyphRun);
                 }
                 else
                 {
@@ -309,11 +379,10 @@ namespace neogfx
                     for (uint32_t i = 0; i < iGlyphsList.back().glyph_count(); ++i)
                         if (iGlyphsList.back().glyph_info(i).codepoint == 0)
                             lastResort[iGlyphsList.back().glyph_info(i).cluster] = neolib::INVALID_CHAR32; // replacement character
-                    iGlyphsList.emplace_back(glyphs{ aParent, aFont, glyph_text_factory::glyph_run{&lastResort[0], &lastResort[0] + lastResort.size(), std::get<2>(aGlyphRun), std::get<3>(aGlyphRun), std::get<4>(aGlyphRun) } });
+                    iGlyphsList.emplace_back(aParent, aFonts.front(), glyph_text_factory::glyph_run{&lastResort[0], &lastResort[0] + lastResort.size(), std::get<2>(aGlyphRun), std::get<3>(aGlyphRun), std::get<4>(aGlyphRun), std::get<5>(aGlyphRun) });
                     break;
                 }
             }
-            fontsTried.clear();
             auto const g = iGlyphsList.begin();
             iResults.reserve(g->glyph_count());
             for (uint32_t i = 0; i < g->glyph_count();)
@@ -390,6 +459,39 @@ namespace neogfx
         result_type iResults;
     };
 
+    // a paragraph's progress through itemization, shaping and assembly; only shaping is done off the calling thread
+    struct glyph_text_factory::paragraph
+    {
+        char32_t const* begin = nullptr;
+        char32_t const* end = nullptr;
+        std::u32string adjustedCodePoints;
+        std::vector<character_type> textDirections;
+        run_list runs;
+        std::vector<std::vector<font>> runFonts;
+        std::vector<std::optional<glyph_shapes>> shapes;
+        bool hasEmojis = false;
+    };
+
+    namespace
+    {
+        font fallback_font(font aFont, uint32_t aFallbackIndex)
+        {
+            while (aFallbackIndex-- > 0u && aFont.has_fallback())
+                aFont = aFont.fallback();
+            return aFont;
+        }
+    }
+
+    glyph_text_factory::glyph_text_factory(std::size_t aCacheBudget) :
+        iParagraph{ std::make_unique<paragraph>() },
+        iCacheStatistics{ aCacheBudget }
+    {
+    }
+
+    glyph_text_factory::~glyph_text_factory()
+    {
+    }
+
     glyph_text glyph_text_factory::create_glyph_text(font const& aFont)
     {
         return *make_ref<glyph_text_content>(aFont);
@@ -418,25 +520,74 @@ namespace neogfx
 
     glyph_text glyph_text_factory::to_glyph_text(i_graphics_context const& aContext, char32_t const*  aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector)
     {
-        auto refResult = make_ref<glyph_text_content>(aFontSelector.select_font(0));
-        auto& result = *refResult;
-
         if (aUtf32End == aUtf32Begin)
-            return result;
+            return create_glyph_text(aFontSelector.select_font(0));
+
+        auto& paragraph = *iParagraph;
+        paragraph.begin = aUtf32Begin;
+        paragraph.end = aUtf32End;
+        itemize(aContext, paragraph, aFontSelector);
+        shape(aContext, paragraph);
+        return assemble(aContext, paragraph, aFontSelector);
+    }
 
-        bool hasEmojis = false;
+    std::vector<glyph_text> glyph_text_factory::to_glyph_text(i_graphics_context const& aContext, std::vector<std::u32string_view> const& aParagraphs, std::function<font(std::size_t, std::size_t)> const& aFontSelector)
+    {
+        auto paragraph_font_selector = [&aFontSelector](std::size_t aParagraph)
+        {
+            return font_selector{ [&aFontSelector, aParagraph](std::size_t aCharacterPos) { return aFontSelector(aParagraph, aCharacterPos); } };
+        };
+
+        // itemization and assembly create fonts and request glyph textures so stay on this thread
+        std::vector<paragraph> paragraphs(aParagraphs.size());
+        for (std::size_t p = 0; p < aParagraphs.size(); ++p)
+        {
+            paragraphs[p].begin = aParagraphs[p].data();
+            paragraphs[p].end = aParagraphs[p].data() + aParagraphs[p].size();
+            if (!aParagraphs[p].empty())
+                itemize(aContext, paragraphs[p], paragraph_font_selector(p));
+        }
+
+        // shaping is split into contiguous chunks of at least MinimumConcurrentParagraphs paragraphs, one per thread
+        auto const chunkCount = std::max<std::size_t>(1u, 
+            std::min<std::size_t>(iShapingPool.thread_count() + 1u, paragraphs.size() / MinimumConcurrentParagraphs));
+        iShapingPool.run(chunkCount, [&](std::size_t aChunk)
+        {
+            auto const chunkEnd = paragraphs.size() * (aChunk + 1u) / chunkCount;
+            for (auto p = paragraphs.size() * aChunk / chunkCount; p < chunkEnd; ++p)
+                if (paragraphs[p].begin != paragraphs[p].end)
+                    shape(aContext, paragraphs[p]);
+        });
+
+        std::vector<glyph_text> results;
+        results.reserve(paragraphs.size());
+        for (std::size_t p = 0; p < paragraphs.size(); ++p)
+        {
+            if (paragraphs[p].begin != paragraphs[p].end)
+                results.push_back(assemble(aContext, paragraphs[p], paragraph_font_selector(p)));
+            else
+                results.push_back(create_glyph_text(aFontSelector(p, 0)));
+        }
+        return results;
+    }
+
+    void glyph_text_factory::itemize(i_graphics_context const& aContext, paragraph& aParagraph, i_font_selector const& aFontSelector)
+    {
+        auto& hasEmojis = aParagraph.hasEmojis;
+        hasEmojis = false;
 
-        auto& textDirections = iTextDirections;
+        auto& textDirections = aParagraph.textDirections;
         textDirections.clear();
 
-        std::u32string::size_type codePointCount = aUtf32End - aUtf32Begin;
+        std::u32string::size_type codePointCount = aParagraph.end - aParagraph.begin;
 
-        std::u32string adjustedCodepoints;
+        auto& adjustedCodepoints = aParagraph.adjustedCodePoints;
+        adjustedCodepoints.clear();
         if (aContext.password())
             adjustedCodepoints.assign(codePointCount, neolib::utf8_to_utf32(aContext.password_mask())[0]);
-        auto codePoints = adjustedCodepoints.empty() ? &*aUtf32Begin : &adjustedCodepoints[0];
+        auto codePoints = adjustedCodepoints.empty() ? aParagraph.begin : &adjustedCodepoints[0];
 
-        auto& runs = iRuns;
+        auto& runs = aParagraph.runs;
         runs.clear();
         auto const& emojiAtlas = service<i_font_manager>().emoji_atlas();
         text_category previousCategory = get_text_category(emojiAtlas, codePoints, codePoints + codePointCount);
@@ -448,6 +599,8 @@ namespace neogfx
         std::u32string::size_type lastCodePointIndex = codePointCount - 1;
         font previousFont = aFontSelector.select_font(0);
         hb_script_t previousScript = hb_unicode_script(static_cast<font_face_handle*>(previousFont.native_font_face().handle())->harfbuzzUnicodeFuncs, codePoints[0]);
+        auto& fontManager = service<i_font_manager>();
+        uint32_t previousFallback = 0u;
 
         std::deque<std::pair<text_direction, bool>> directionStack;
         const char32_t LRE = U'\u202A';
@@ -565,8 +718,14 @@ namespace neogfx
             hb_script_t currentScript = hb_unicode_script(unicodeFuncs, codePoints[codePointIndex]);
             if (currentScript == HB_SCRIPT_COMMON || currentScript == HB_SCRIPT_INHERITED)
                 currentScript = previousScript;
+            // runs are split by the fallback font covering each letter so that fallback text is shaped once with the right font;
+            // anything else stays with the current run's font if it can
+            uint32_t currentFallback = previousFallback;
+            if (codePointIndex == 0 || previousFont != currentFont || currentCategory == text_category::LTR || currentCategory == text_category::RTL)
+                currentFallback = fontManager.fallback_coverage(currentFont.native_font_face(), codePoints[codePointIndex]).value_or(0u);
             bool newRun =
                 previousFont != currentFont ||
+                previousFallback != currentFallback ||
                 (newLine && (previousDirection == text_direction::RTL || previousDirection == text_direction::None_RTL || previousDirection == text_direction::Digit_RTL || previousDirection == text_direction::Emoji_RTL)) ||
                 currentCategory == text_category::Mnemonic ||
                 previousCategory == text_category::Mnemonic ||
@@ -596,14 +755,15 @@ namespace neogfx
                 hasEmojis = true;
             if (newRun && codePointIndex > 0)
             {
-                runs.push_back(std::make_tuple(runStart, &codePoints[codePointIndex], previousDirection, previousCategory == text_category::Mnemonic, previousScript));
+                runs.push_back(std::make_tuple(runStart, &codePoints[codePointIndex], previousDirection, previousCategory == text_category::Mnemonic, previousScript, previousFallback));
                 runStart = &codePoints[codePointIndex];
             }
             previousDirection = currentDirection;
             previousCategory = currentCategory;
             previousScript = currentScript;
+            previousFallback = currentFallback;
             if (codePointIndex == lastCodePointIndex)
-                runs.push_back(std::make_tuple(runStart, &codePoints[codePointIndex + 1], previousDirection, previousCategory == text_category::Mnemonic, previousScript));
+                runs.push_back(std::make_tuple(runStart, &codePoints[codePointIndex + 1], previousDirection, previousCategory == text_category::Mnemonic, previousScript, previousFallback));
             if (newLine && (newRun || codePointIndex == lastCodePointIndex))
             {
                 for (auto i = runs.rbegin(); i != runs.rend(); ++i)
@@ -652,14 +812,47 @@ namespace neogfx
             } while (i < runs.size());
         }
 
+        auto& runFonts = aParagraph.runFonts;
+        runFonts.clear();
+        for (auto const& run : runs)
+        {
+            auto& fonts = runFonts.emplace_back();
+            if (std::get<3>(run))
+                continue;
+            fonts.push_back(fallback_font(aFontSelector.select_font(std::get<0>(run) - &codePoints[0]), std::get<5>(run)));
+            while (fonts.back().has_fallback() && std::find(fonts.begin(), fonts.end(), fonts.back().fallback()) == fonts.end())
+                fonts.push_back(fonts.back().fallback());
+        }
+    }
+
+    void glyph_text_factory::shape(i_graphics_context const& aContext, paragraph& aParagraph)
+    {
+        aParagraph.shapes.clear();
+        aParagraph.shapes.resize(aParagraph.runs.size());
+        for (std::size_t i = 0; i < aParagraph.runs.size(); ++i)
+            if (!std::get<3>(aParagraph.runs[i]))
+                aParagraph.shapes[i].emplace(aContext, aParagraph.runFonts[i], aParagraph.runs[i]);
+    }
+
+    glyph_text glyph_text_factory::assemble(i_graphics_context const& aContext, paragraph& aParagraph, i_font_selector const& aFontSelector)
+    {
+        auto refResult = make_ref<glyph_text_content>(aFontSelector.select_font(0));
+        auto& result = *refResult;
+
+        auto const text = aParagraph.begin;
+        std::u32string::size_type codePointCount = aParagraph.end - aParagraph.begin;
+        auto codePoints = aParagraph.adjustedCodePoints.empty() ? aParagraph.begin : &aParagraph.adjustedCodePoints[0];
+        auto const& textDirections = aParagraph.textDirections;
+        auto const& runs = aParagraph.runs;
+        auto const& emojiAtlas = service<i_font_manager>().emoji_atlas();
+
         for (std::size_t i = 0; i < runs.size(); ++i)
         {
             if (std::get<3>(runs[i]))
                 continue;
             
             bool drawMnemonic = (i > 0 && std::get<3>(runs[i - 1]));
-            std::string::size_type sourceClusterRunStart = std::get<0>(runs[i]) - &codePoints[0];
-            glyph_shapes shapes{ aContext, aFontSelector.select_font(sourceClusterRunStart), runs[i] };
+            auto const& shapes = *aParagraph.shapes[i];
             
             for (uint32_t j = 0; j < shapes.glyph_count(); ++j)
             {
@@ -682,10 +875,10 @@ namespace neogfx
                 startCluster += (std::get<0>(runs[i]) - &codePoints[0]);
                 endCluster += (std::get<0>(runs[i]) - &codePoints[0]);
 
-                if (textDirections[startCluster].category == text_category::Whitespace && aUtf32Begin[startCluster] == U'\r')
+                if (textDirections[startCluster].category == text_category::Whitespace && text[startCluster] == U'\r')
                     result.line_breaks().push_back(result.size());
 
-                neogfx::font selectedFont = aFontSelector.select_font(startCluster);
+                neogfx::font selectedFont = fallback_font(aFontSelector.select_font(startCluster), std::get<5>(runs[i]));
                 neogfx::font font = selectedFont;
                 if (shapes.using_fallback(j))
                 {
@@ -705,9 +898,9 @@ namespace neogfx
                     advance, point(shapes.glyph_position(j).x_offset / 64.0, shapes.glyph_position(j).y_offset / 64.0),
                     size{advance.cx, font.height()});
                 if (category(newGlyph) == text_category::Whitespace)
-                    newGlyph.value = aUtf32Begin[startCluster];
+                    newGlyph.value = text[startCluster];
                 else if (category(newGlyph) == text_category::Emoji)
-                    newGlyph.value = emojiAtlas.emoji(aUtf32Begin[startCluster], font.height());
+                    newGlyph.value = emojiAtlas.emoji(text[startCluster], font.height());
                 if ((selectedFont.style() & font_style::Underline) == font_style::Underline)
                     set_underline(newGlyph, true);
                 if ((selectedFont.style() & font_style::Superscript) == font_style::Superscript)
@@ -718,9 +911,12 @@ namespace neogfx
                     set_subpixel(newGlyph, true);
                 if (drawMnemonic && ((j == 0 && std::get<2>(runs[i]) == text_direction::LTR) || (j == shapes.glyph_count() - 1 && std::get<2>(runs[i]) == text_direction::RTL)))
                     set_mnemonic(newGlyph, true);
+                if (!is_whitespace(newGlyph) && !is_emoji(newGlyph))
+                    font.native_font_face().request_glyph_texture(newGlyph);
             }
         }
-        if (hasEmojis)
+        aParagraph.shapes.clear();
+        if (aParagraph.hasEmojis)
         {
             auto refEmojiResult = make_ref<glyph_text_content>(aFontSelector.select_font(0));
             auto& emojiResult = *refEmojiResult;
@@ -728,14 +924,14 @@ namespace neogfx
             for (auto i = result.begin(); i != result.end(); ++i)
             {
                 auto cluster = i->source.first;
-                auto chStart = aUtf32Begin[cluster];
+                auto chStart = text[cluster];
                 if (category(*i) == text_category::Emoji)
                 {
                     if (!emojiResult.empty() && is_emoji(emojiResult.back()) && emojiResult.back().source == i->source)
                     {
                         // probable variant selector fubar'd by harfbuzz
                         auto s = emojiResult.back().source;
-                        if (s.second < codePointCount && get_text_category(service<i_font_manager>().emoji_atlas(), aUtf32Begin[s.second]) == text_category::Control)
+                        if (s.second < codePointCount && get_text_category(service<i_font_manager>().emoji_atlas(), text[s.second]) == text_category::Control)
                         {
                             ++s.first;
                             ++s.second;
@@ -750,7 +946,7 @@ namespace neogfx
                     bool absorbNext = false;
                     for (; j != result.end(); ++j)
                     {
-                        auto ch = aUtf32Begin[cluster + (j - i)];
+                        auto ch = text[cluster + (j - i)];
                         if (ch == 0x200D)
                             continue;
                         else if (ch == 0xFE0F)
@@ -787,9 +983,93 @@ namespace neogfx
         return result.bottom_justify();
     }
 
+    glyph_text glyph_text_factory::to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, font const& aFont)
+    {
+        auto& key = iLookupKey;
+        key.text.assign(aUtf32Begin, aUtf32End);
+        key.font = aFont.id();
+        key.subpixel = aContext.is_subpixel_rendering_on();
+        key.mnemonic = aContext.mnemonic_set() ? static_cast<char32_t>(aContext.mnemonic()) : U'\0';
+        key.passwordMask.clear();
+        if (aContext.password())
+            key.passwordMask = neolib::utf8_to_utf32(aContext.password_mask());
+        auto existing = iCache.find(key);
+        if (existing != iCache.end())
+        {
+            ++iCacheStatistics.hits;
+            if (existing->second.lruPosition != iLru.begin())
+                iLru.splice(iLru.begin(), iLru, existing->second.lruPosition);
+            // callers are free to modify what they are given so hand out a copy
+            return *make_ref<glyph_text_content>(*existing->second.content);
+        }
+        ++iCacheStatistics.misses;
+        auto result = to_glyph_text(aContext, aUtf32Begin, aUtf32End, font_selector{ [&aFont](std::size_t) { return aFont; } });
+        auto const& content = static_cast<glyph_text_content const&>(result.content());
+        std::size_t const bytes = sizeof(cache_entry) + sizeof(cache_key) +
+            (key.text.size() + key.passwordMask.size()) * sizeof(char32_t) + content.size() * sizeof(glyph);
+        if (bytes > iCacheStatistics.budget / 16u)
+            return result; // would only push out many smaller entries
+        auto newEntry = iCache.emplace(key, cache_entry{ make_ref<glyph_text_content>(content), bytes }).first;
+        iLru.push_front(&newEntry->first);
+        newEntry->second.lruPosition = iLru.begin();
+        iCacheStatistics.bytes += bytes;
+        ++iCacheStatistics.entries;
+        evict();
+        return result;
+    }
+
+    glyph_text glyph_text_factory::to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, font const& aFont)
+    {
+        std::u32string& codePoints = iCodePointsBuffer;
+        codePoints = neolib::utf8_to_utf32(std::string_view{ aUtf8Begin, aUtf8End });
+        if (codePoints.empty())
+            return aFont;
+        // with a single font the cluster map is only needed for font selection so it is not built
+        return to_glyph_text(aContext, codePoints.data(), codePoints.data() + codePoints.size(), aFont);
+    }
+
+    std::size_t glyph_text_factory::cache_budget() const
+    {
+        return iCacheStatistics.budget;
+    }
+
+    void glyph_text_factory::set_cache_budget(std::size_t aBudget)
+    {
+        iCacheStatistics.budget = aBudget;
+        evict();
+    }
+
+    glyph_text_cache_statistics const& glyph_text_factory::cache_statistics() const
+    {
+        return iCacheStatistics;
+    }
+
+    void glyph_text_factory::clear_cache()
+    {
+        iLru.clear();
+        iCache.clear();
+        iCacheStatistics.bytes = 0u;
+        iCacheStatistics.entries = 0u;
+    }
+
+    void glyph_text_factory::evict()
+    {
+        while (iCacheStatistics.bytes > iCacheStatistics.budget && !iLru.empty())
+        {
+            auto victim = iCache.find(*iLru.back());
+            iLru.pop_back();
+            iCacheStatistics.bytes -= victim->second.bytes;
+            --iCacheStatistics.entries;
+            ++iCacheStatistics.evictions;
+            iCache.erase(victim);
+        }
+    }
+
     font_manager::font_manager() :
-        iGlyphTextFactory{ std::make_unique<neogfx::glyph_text_factory>() },
+        iGlyphTextFactory{ std::make_unique<neogfx::glyph_text_factory>(4u * 1024u * 1024u) },
         iGlyphAtlas{ size{1024.0, 1024.0} },
+        iGlyphCache{ 32u * 1024u * 1024u },
+        iGlyphRasterizer{ std::make_unique<neogfx::glyph_rasterizer>() },
         iEmojiAtlas{}
     {
         FT_Error error = FT_Init_FreeType(&iFontLib);
@@ -798,32 +1078,31 @@ namespace neogfx
         error = FT_Library_SetLcdFilter(iFontLib, FT_LCD_FILTER_NONE);
         if (error)
             throw error_initializing_font_library();
-        auto enumerate = [this](const std::string fontsDirectory)
+        // the spread is a property of the library's SDF renderers, not of a face, so it is set once for every font; a 
+        // FreeType built without them fails to render distance field glyphs and faces fall back to bitmap glyphs
+        FT_Int distanceFieldSpread = static_cast<FT_Int>(native_font::DistanceFieldSpread);
+        FT_Property_Set(iFontLib, "sdf", "spread", &distanceFieldSpread);
+        FT_Property_Set(iFontLib, "bsdf", "spread", &distanceFieldSpread);
+        std::vector<std::string> fontFiles;
+        auto enumerate = [&fontFiles](const std::string fontsDirectory)
         {
             if (std::filesystem::exists(fontsDirectory))
                 for (std::filesystem::directory_iterator file(fontsDirectory); file != std::filesystem::directory_iterator(); ++file)
-                {
-                    if (!std::filesystem::is_regular_file(file->status()))
-                        continue;
-                    try
-                    {
-                        if (is_font_file(string{ file->path().string() }))
-                        {
-                            auto font = iNativeFonts.emplace(iNativeFonts.end(), iFontLib, file->path().string());
-                            iFontFamilies[font->family_name()].push_back(font);
-                        }
-                    }
-                    catch (native_font::failed_to_load_font&)
-                    {
-                    }
-                    catch (...)
-                    {
-                        throw;
-                    }
-                }
+                    if (std::filesystem::is_regular_file(file->status()))
+                        fontFiles.push_back(file->path().string());
         };
         enumerate(detail::platform_specific::get_system_font_directory());
         enumerate(detail::platform_specific::get_local_font_directory());
+        // faces of unchanged files come from the index; nothing is opened until a face is first created
+        font_index fontIndex{ detail::platform_specific::get_font_index_path() };
+        for (auto const& indexedFile : fontIndex.update(fontFiles))
+        {
+            if (indexedFile->faces.empty())
+                continue;
+            auto font = iNativeFonts.emplace(iNativeFonts.end(), iFontLib, *indexedFile);
+            iFontFamilies[font->family_name()].push_back(font);
+        }
+        fontIndex.save();
         for (auto& family : iFontFamilies)
         {
             std::optional<native_font_list::iterator> bold;
@@ -863,7 +1142,9 @@ namespace neogfx
 
     font_manager::~font_manager()
     {
+        iGlyphTextFactory->clear_cache(); // cached text holds references to its fonts
         iIdCache.clear();
+        iGlyphRasterizer.reset(); // worker faces share the native fonts' data
         iFontFamilies.clear();
         iNativeFonts.clear();
         FT_Done_FreeType(iFontLib);
@@ -916,6 +1197,31 @@ namespace neogfx
         return fallbackFont;
     }
 
+    std::optional<uint32_t> font_manager::fallback_coverage(i_native_font_face& aFace, char32_t aCodePoint)
+    {
+        // fallback chains follow family and style name so coverage is shared by every size of a face
+        auto& coverage = iFallbackCoverage[std::make_pair(&aFace.native_font(), aFace.style_name().to_std_string())];
+        auto existing = coverage.find(aCodePoint);
+        if (existing != coverage.end())
+            return existing->second;
+        std::optional<uint32_t> result;
+        thread_local std::vector<i_native_font_face const*> facesTried;
+        facesTried.clear();
+        for (i_native_font_face* face = &aFace; std::find(facesTried.begin(), facesTried.end(), face) == facesTried.end(); face = &face->fallback())
+        {
+            if (face->glyph_index(aCodePoint) != 0u)
+            {
+                result = static_cast<uint32_t>(facesTried.size());
+                break;
+            }
+            facesTried.push_back(face);
+            if (!face->has_fallback())
+                break;
+        }
+        coverage.emplace(aCodePoint, result);
+        return result;
+    }
+
     i_native_font_face& font_manager::create_font(i_string const& aFamilyName, neogfx::font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice)
     {
         if (aStyle == neogfx::font_style::Emulated)
@@ -1098,6 +1404,68 @@ namespace neogfx
         return iEmojiAtlas;
     }
 
+    std::size_t font_manager::glyph_cache_budget() const
+    {
+        return iGlyphCache.budget();
+    }
+
+    void font_manager::set_glyph_cache_budget(std::size_t aBudget)
+    {
+        iGlyphCache.set_budget(aBudget);
+    }
+
+    neogfx::glyph_cache_statistics font_manager::glyph_cache_statistics() const
+    {
+        return iGlyphCache.statistics();
+    }
+
+    void font_manager::next_glyph_cache_frame()
+    {
+        iGlyphCache.next_frame();
+    }
+
+    glyph_rasterization_policy font_manager::glyph_rasterization_policy() const
+    {
+        return iGlyphRasterizer->policy();
+    }
+
+    void font_manager::set_glyph_rasterization_policy(neogfx::glyph_rasterization_policy aPolicy)
+    {
+        iGlyphRasterizer->set_policy(aPolicy);
+    }
+
+    void font_manager::upload_rasterized_glyphs()
+    {
+        for (auto& completed : iGlyphRasterizer->take_completed())
+            if (completed.result)
+                completed.owner->upload_glyph(completed.glyph, completed.subpixel, *completed.result);
+    }
+
+    uint64_t font_manager::placeholder_glyphs_issued() const
+    {
+        return iGlyphRasterizer->placeholders_issued();
+    }
+
+    optional_dimension const& font_manager::distance_field_glyph_threshold() const
+    {
+        return iDistanceFieldGlyphThreshold;
+    }
+
+    void font_manager::set_distance_field_glyph_threshold(optional_dimension const& aPixelSize)
+    {
+        iDistanceFieldGlyphThreshold = aPixelSize;
+    }
+
+    neogfx::glyph_cache& font_manager::glyph_cache()
+    {
+        return iGlyphCache;
+    }
+
+    neogfx::glyph_rasterizer& font_manager::glyph_rasterizer()
+    {
+        return *iGlyphRasterizer;
+    }
+
     void font_manager::add_ref(font_id aId)
     {
         font_from_id(aId).native_font_face().add_ref();
@@ -0,0 +1,94 @@
+// glyph_cache.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/text/glyph_cache.hpp>
+
+namespace neogfx
+{
+    glyph_cache::glyph_cache(std::size_t aBudget) :
+        iFrame{ 1u }, iBudget{ aBudget }, iBytes{ 0u }, iHits{ 0u }, iMisses{ 0u }, iEvictions{ 0u }
+    {
+    }
+
+    std::size_t glyph_cache::budget() const
+    {
+        return iBudget;
+    }
+
+    void glyph_cache::set_budget(std::size_t aBudget)
+    {
+        iBudget = aBudget;
+        evict();
+    }
+
+    neogfx::glyph_cache_statistics glyph_cache::statistics() const
+    {
+        return neogfx::glyph_cache_statistics{ iBudget, iBytes, iEntries.size(), iHits.load(), iMisses.load(), iEvictions.load() };
+    }
+
+    void glyph_cache::next_frame()
+    {
+        ++iFrame;
+        evict();
+    }
+
+    glyph_cache::handle glyph_cache::add(i_glyph_cache_owner const& aOwner, uint32_t aGlyph, std::size_t aBytes)
+    {
+        // a glyph is added because it is about to be drawn so it starts out protected for the current frame
+        iEntries.push_front(entry{ &aOwner, aGlyph, aBytes, iFrame });
+        iBytes += aBytes;
+        evict();
+        return iEntries.begin();
+    }
+
+    void glyph_cache::use(handle aEntry)
+    {
+        aEntry->frame = iFrame;
+        if (aEntry != iEntries.begin())
+            iEntries.splice(iEntries.begin(), iEntries, aEntry);
+    }
+
+    void glyph_cache::remove(handle aEntry)
+    {
+        iBytes -= aEntry->bytes;
+        iEntries.erase(aEntry);
+    }
+
+    void glyph_cache::hit()
+    {
+        ++iHits;
+    }
+
+    void glyph_cache::miss()
+    {
+        ++iMisses;
+    }
+
+    void glyph_cache::evict()
+    {
+        while (iBytes > iBudget && !iEntries.empty() && iEntries.back().frame < iFrame)
+        {
+            ++iEvictions;
+            // the owner releases the glyph's atlas space and calls remove()
+            auto const& victim = iEntries.back();
+            victim.owner->evict_glyph(victim.glyph);
+        }
+    }
+}
@@ -0,0 +1,184 @@
+// font_index.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include "native_font.hpp"
+#include "font_index.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        char const* const sIndexHeader = "neogfx font index 1";
+
+        std::vector<std::string> split_fields(std::string const& aLine)
+        {
+            std::vector<std::string> fields;
+            std::string::size_type start = 0;
+            for (auto tab = aLine.find('\t'); tab != std::string::npos; tab = aLine.find('\t', start))
+            {
+                fields.push_back(aLine.substr(start, tab - start));
+                start = tab + 1;
+            }
+            fields.push_back(aLine.substr(start));
+            return fields;
+        }
+    }
+
+    font_index::font_index(std::string const& aIndexPath) :
+        iIndexPath{ aIndexPath }, iDirty{ false }
+    {
+        load();
+    }
+
+    std::vector<font_index::file const*> font_index::update(std::vector<std::string> const& aPaths)
+    {
+        file_map current;
+        std::vector<file const*> result;
+        std::vector<file*> changed;
+        result.reserve(aPaths.size());
+        for (auto const& path : aPaths)
+        {
+            if (current.find(path) != current.end())
+                continue;
+            std::error_code ec;
+            auto const modified = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+            if (ec)
+                continue;
+            auto const size = std::filesystem::file_size(path, ec);
+            if (ec)
+                continue;
+            auto existing = iFiles.find(path);
+            if (existing != iFiles.end() && existing->second.modified == modified && existing->second.size == size)
+                result.push_back(&current.insert(iFiles.extract(existing)).position->second);
+            else
+            {
+                auto& newFile = current.emplace(path, file{ path, modified, size }).first->second;
+                result.push_back(&newFile);
+                changed.push_back(&newFile);
+            }
+        }
+        // anything left over has been removed since the index was written
+        if (!changed.empty() || !iFiles.empty())
+            iDirty = true;
+        iFiles.swap(current);
+        if (!changed.empty())
+        {
+            // FreeType libraries are not thread safe so each worker has its own
+            std::atomic<std::size_t> next = 0u;
+            auto worker = [&]()
+            {
+                FT_Library fontLib;
+                if (FT_Init_FreeType(&fontLib) != 0)
+                    return;
+                for (auto i = next++; i < changed.size(); i = next++)
+                    scan(fontLib, *changed[i]);
+                FT_Done_FreeType(fontLib);
+            };
+            auto const threadCount = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), changed.size());
+            std::vector<std::thread> threads;
+            for (std::size_t t = 1u; t < threadCount; ++t)
+                threads.emplace_back(worker);
+            worker();
+            for (auto& thread : threads)
+                thread.join();
+        }
+        return result;
+    }
+
+    void font_index::save()
+    {
+        if (!iDirty)
+            return;
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path{ iIndexPath }.parent_path(), ec);
+        auto const temporaryPath = iIndexPath + ".tmp";
+        {
+            std::ofstream output{ temporaryPath, std::ios::out | std::ios::trunc };
+            if (!output)
+                return;
+            output << sIndexHeader << '\n';
+            for (auto const& f : iFiles)
+            {
+                output << "F\t" << f.second.path << '\t' << f.second.modified << '\t' << f.second.size << '\t' << f.second.familyName << '\n';
+                for (auto const& s : f.second.faces)
+                    output << "S\t" << s.index << '\t' << static_cast<uint32_t>(s.style) << '\t' << s.styleName << '\n';
+            }
+            if (!output)
+                return;
+        }
+        std::filesystem::rename(temporaryPath, iIndexPath, ec);
+        if (!ec)
+            iDirty = false;
+    }
+
+    void font_index::load()
+    {
+        std::ifstream input{ iIndexPath };
+        std::string line;
+        if (!std::getline(input, line) || line != sIndexHeader)
+            return;
+        file* current = nullptr;
+        try
+        {
+            while (std::getline(input, line))
+            {
+                auto const fields = split_fields(line);
+                if (fields[0] == "F" && fields.size() == 5u)
+                    current = &iFiles.emplace(fields[1], file{ fields[1], std::stoll(fields[2]), std::stoull(fields[3]), fields[4] }).first->second;
+                else if (fields[0] == "S" && fields.size() == 4u && current != nullptr)
+                    current->faces.push_back(face{ static_cast<FT_Long>(std::stol(fields[1])), static_cast<font_style>(std::stoul(fields[2])), fields[3] });
+                else
+                    throw std::invalid_argument("neogfx::font_index::load");
+            }
+        }
+        catch (std::logic_error const&)
+        {
+            // a damaged index is rebuilt from scratch
+            iFiles.clear();
+            iDirty = true;
+        }
+    }
+
+    void font_index::scan(FT_Library aFontLib, file& aFile)
+    {
+        FT_Long faceCount = 1;
+        for (FT_Long faceIndex = 0; faceIndex < faceCount; ++faceIndex)
+        {
+            FT_Face ftFace;
+            if (FT_New_Face(aFontLib, aFile.path.c_str(), faceIndex, &ftFace) != 0)
+            {
+                // as with native_font a file with a face that fails to load is not used at all
+                aFile.faces.clear();
+                return;
+            }
+            if (faceIndex == 0)
+            {
+                faceCount = ftFace->num_faces;
+                aFile.familyName = ftFace->family_name != nullptr ? ftFace->family_name : "";
+            }
+            aFile.faces.push_back(face{ faceIndex, native_font::face_style(ftFace), ftFace->style_name != nullptr ? ftFace->style_name : "" });
+            FT_Done_Face(ftFace);
+        }
+    }
+}
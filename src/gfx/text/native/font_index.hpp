@@ -0,0 +1,66 @@
+// font_index.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <map>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <neogfx/gfx/text/font.hpp>
+
+namespace neogfx
+{
+    // On-disk record of the family and styles of every font file found by a previous enumeration so that startup
+    // only has to open the files that are new or have changed since.
+    class font_index
+    {
+    public:
+        struct face
+        {
+            FT_Long index;
+            font_style style;
+            std::string styleName;
+        };
+        struct file
+        {
+            std::string path;
+            int64_t modified;
+            uintmax_t size;
+            std::string familyName;
+            std::vector<face> faces; // empty if FreeType cannot load the file
+        };
+    private:
+        typedef std::map<std::string, file> file_map;
+    public:
+        font_index(std::string const& aIndexPath);
+    public:
+        // returns the index records for aPaths, scanning new and changed files in parallel
+        std::vector<file const*> update(std::vector<std::string> const& aPaths);
+        void save();
+    private:
+        void load();
+        static void scan(FT_Library aFontLib, file& aFile);
+    private:
+        std::string iIndexPath;
+        file_map iFiles;
+        bool iDirty;
+    };
+}
@@ -0,0 +1,460 @@
+// glyph_rasterizer.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <tuple>
+#include <algorithm>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_BITMAP_H
+#include FT_LCD_FILTER_H
+#include "native_font_face.hpp"
+#include "glyph_rasterizer.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        glyph_pixel_mode to_glyph_pixel_mode(unsigned char aFreeTypePixelMode)
+        {
+            switch (aFreeTypePixelMode)
+            {
+            default:
+            case FT_PIXEL_MODE_NONE:
+                return glyph_pixel_mode::None;
+            case FT_PIXEL_MODE_MONO:
+                return glyph_pixel_mode::Mono;
+            case FT_PIXEL_MODE_GRAY:
+                return glyph_pixel_mode::Gray;
+            case FT_PIXEL_MODE_GRAY2:
+                return glyph_pixel_mode::Gray2Bit;
+            case FT_PIXEL_MODE_GRAY4:
+                return glyph_pixel_mode::Gray4Bit;
+            case FT_PIXEL_MODE_LCD:
+                return glyph_pixel_mode::LCD;
+            case FT_PIXEL_MODE_LCD_V:
+                return glyph_pixel_mode::LCD_V;
+            case FT_PIXEL_MODE_BGRA:
+                return glyph_pixel_mode::BGRA;
+            }
+        }
+
+        // worker faces are shared by every owner using the same font data at the same size; the key holds the data
+        // open and compares it by owner so data freed and reallocated at the same address is never mistaken for it
+        struct worker_face_key
+        {
+            std::shared_ptr<void const> data;
+            std::tuple<FT_Long, FT_F26Dot6, FT_UInt, FT_UInt, FT_Int> size;
+
+            bool operator<(worker_face_key const& aRhs) const
+            {
+                if (data.owner_before(aRhs.data))
+                    return true;
+                if (aRhs.data.owner_before(data))
+                    return false;
+                return size < aRhs.size;
+            }
+        };
+        std::size_t const kMaxWorkerFaces = 64u;
+
+        worker_face_key to_worker_face_key(rasterizer_face const& aFace)
+        {
+            return worker_face_key{ aFace.dataOwner, { aFace.faceIndex, aFace.charSize, aFace.horizontalDpi, aFace.verticalDpi, aFace.strikeIndex.value_or(-1) } };
+        }
+    }
+
+    rasterized_glyph rasterize_glyph(FT_Library aLibrary, FT_Face aFace, uint32_t aGlyph, bool aSubpixel, FT_Pos aEmbolden)
+    {
+        // todo: investigate why turning off sub-pixel doesn't produce same grayscale bitmap as Windows with ClearType disabled
+        try
+        {
+            // todo: remove FT_LOAD_NO_AUTOHINT when cause of crash in freetype 2.11 with certain fonts is resolved
+            if (aSubpixel)
+            {
+                freetypeCheck(FT_Load_Glyph(aFace, aGlyph, FT_LOAD_NO_AUTOHINT | FT_LOAD_TARGET_LCD | FT_LOAD_NO_BITMAP));
+            }
+            else
+            {
+                freetypeCheck(FT_Load_Glyph(aFace, aGlyph, FT_LOAD_NO_AUTOHINT | FT_LOAD_TARGET_NORMAL | FT_LOAD_NO_BITMAP));
+            }
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_load_glyph_error(fe.what());
+        }
+        try
+        {
+            if (aSubpixel)
+            {
+                freetypeCheck(FT_Render_Glyph(aFace->glyph, FT_RENDER_MODE_LCD));
+            }
+            else
+            {
+                freetypeCheck(FT_Render_Glyph(aFace->glyph, FT_RENDER_MODE_NORMAL));
+            }
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_render_glyph_error(fe.what());
+        }
+
+        FT_Bitmap& bitmap = aFace->glyph->bitmap;
+
+        if (aEmbolden != 0)
+            FT_Bitmap_Embolden(aLibrary, &bitmap, aEmbolden, 0);
+
+        rasterized_glyph result;
+        result.pixelMode = to_glyph_pixel_mode(bitmap.pixel_mode);
+        result.subpixel = aSubpixel && result.pixelMode == glyph_pixel_mode::LCD;
+        result.extents = size_u32{ bitmap.width / (result.subpixel ? 3u : 1u), bitmap.rows };
+        result.placement = point{
+            aFace->glyph->metrics.horiBearingX / 64.0,
+            (aFace->glyph->metrics.horiBearingY - aFace->glyph->metrics.height) / 64.0 };
+        if (result.extents.cx == 0)
+            return result;
+
+        auto const stride = static_cast<std::size_t>(result.extents.cx);
+        if (result.subpixel)
+        {
+            result.pixels.resize(stride * result.extents.cy * 4u);
+            // sub-pixel FIR filter.
+            static double coefficients[] = { 1.5 / 16.0, 3.5 / 16.0, 6.0 / 16.0, 3.5 / 16.0, 1.5 / 16.0 };
+            for (uint32_t y = 0; y < bitmap.rows; y++)
+            {
+                for (uint32_t x = 0; x < bitmap.width; x++)
+                {
+                    uint8_t alpha = 0;
+                    for (int32_t z = -2; z <= 2; ++z)
+                    {
+                        int32_t const s = x + z;
+                        if (s >= 0 && s <= static_cast<int32_t>(bitmap.width) - 1)
+                            alpha += static_cast<uint8_t>(bitmap.buffer[s + bitmap.pitch * y] * coefficients[z + 2]);
+                    }
+                    result.pixels[((x / 3) + (bitmap.rows - 1 - y) * stride) * 4u + x % 3] = alpha;
+                }
+            }
+        }
+        else
+        {
+            result.pixels.resize(stride * result.extents.cy);
+            for (uint32_t y = 0; y < bitmap.rows; y++)
+                switch (bitmap.pixel_mode)
+                {
+                case FT_PIXEL_MODE_MONO: // 1 bit per pixel monochrome
+                    for (uint32_t x = 0; x < bitmap.width; x += 8)
+                        for (uint32_t b = 0; b < std::min(bitmap.width - x, 8u); ++b)
+                            result.pixels[(x + b) + (bitmap.rows - 1 - y) * stride] =
+                                (bitmap.buffer[x / 8 + bitmap.pitch * y] & (1 << (7 - b))) != 0 ? 0xFF : 0x00;
+                    break;
+                case FT_PIXEL_MODE_GRAY:
+                default:
+                    for (uint32_t x = 0; x < bitmap.width; x++)
+                        result.pixels[x + (bitmap.rows - 1 - y) * stride] = bitmap.buffer[x + bitmap.pitch * y];
+                    break;
+                }
+        }
+        return result;
+    }
+
+    rasterized_glyph rasterize_distance_field_glyph(FT_Face aFace, uint32_t aGlyph)
+    {
+        try
+        {
+            freetypeCheck(FT_Load_Glyph(aFace, aGlyph, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP));
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_load_glyph_error(fe.what());
+        }
+        try
+        {
+            freetypeCheck(FT_Render_Glyph(aFace->glyph, FT_RENDER_MODE_SDF));
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_render_glyph_error(fe.what());
+        }
+
+        FT_Bitmap const& bitmap = aFace->glyph->bitmap;
+
+        rasterized_glyph result;
+        result.pixelMode = glyph_pixel_mode::Gray;
+        result.subpixel = false;
+        result.extents = size_u32{ bitmap.width, bitmap.rows };
+        // the bitmap extends past the outline by the spread so is placed by its own origin rather than the glyph metrics
+        result.placement = point{
+            static_cast<coordinate>(aFace->glyph->bitmap_left),
+            static_cast<coordinate>(aFace->glyph->bitmap_top) - static_cast<coordinate>(bitmap.rows) };
+        if (result.extents.cx == 0 || bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+            return rasterized_glyph{};
+
+        auto const stride = static_cast<std::size_t>(result.extents.cx);
+        result.pixels.resize(stride * result.extents.cy);
+        for (uint32_t y = 0; y < bitmap.rows; y++)
+            std::copy(bitmap.buffer + bitmap.pitch * y, bitmap.buffer + bitmap.pitch * y + bitmap.width, &result.pixels[(bitmap.rows - 1 - y) * stride]);
+        return result;
+    }
+
+    glyph_rasterizer::glyph_rasterizer(uint32_t aThreads) :
+        iPolicy{ neogfx::glyph_rasterization_policy::WaitForFrame },
+        iPlaceholdersIssued{ 0u },
+        iRetiredData{ std::max(1u, aThreads) },
+        iStopping{ false }
+    {
+        for (std::size_t t = 0u; t < iRetiredData.size(); ++t)
+            iThreads.emplace_back([this, t]() { worker(t); });
+    }
+
+    glyph_rasterizer::~glyph_rasterizer()
+    {
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            iStopping = true;
+        }
+        iWorkAvailable.notify_all();
+        for (auto& thread : iThreads)
+            thread.join();
+    }
+
+    glyph_rasterization_policy glyph_rasterizer::policy() const
+    {
+        return iPolicy;
+    }
+
+    void glyph_rasterizer::set_policy(neogfx::glyph_rasterization_policy aPolicy)
+    {
+        iPolicy = aPolicy;
+    }
+
+    uint64_t glyph_rasterizer::placeholders_issued() const
+    {
+        return iPlaceholdersIssued;
+    }
+
+    void glyph_rasterizer::placeholder_issued()
+    {
+        ++iPlaceholdersIssued;
+    }
+
+    void glyph_rasterizer::request(native_font_face const& aOwner, rasterizer_face const& aFace, uint32_t aGlyph, bool aSubpixel)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            job_key const key{ &aOwner, aGlyph, aSubpixel };
+            if (!iJobs.try_emplace(key, job{ aFace, false, false }).second)
+                return;
+            iQueue.push_back(key);
+        }
+        iWorkAvailable.notify_one();
+    }
+
+    bool glyph_rasterizer::requested(native_font_face const& aOwner, uint32_t aGlyph, bool aSubpixel) const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        return iJobs.find(job_key{ &aOwner, aGlyph, aSubpixel }) != iJobs.end();
+    }
+
+    bool glyph_rasterizer::finished(native_font_face const& aOwner, uint32_t aGlyph, bool aSubpixel) const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        auto existing = iJobs.find(job_key{ &aOwner, aGlyph, aSubpixel });
+        return existing != iJobs.end() && existing->second.finished;
+    }
+
+    std::optional<rasterized_glyph> glyph_rasterizer::wait(native_font_face const& aOwner, uint32_t aGlyph, bool aSubpixel)
+    {
+        job_key const key{ &aOwner, aGlyph, aSubpixel };
+        std::unique_lock<std::mutex> lock{ iMutex };
+        auto existing = iJobs.find(key);
+        if (existing == iJobs.end())
+            return {};
+        if (!existing->second.running && !existing->second.finished)
+        {
+            // jump the queue; the stale queue entry is skipped when a worker reaches it
+            iQueue.push_front(key);
+            iWorkAvailable.notify_one();
+        }
+        iWorkFinished.wait(lock, [&]() 
+        { 
+            auto const waitedFor = iJobs.find(key);
+            return waitedFor == iJobs.end() || waitedFor->second.finished; 
+        });
+        existing = iJobs.find(key);
+        if (existing == iJobs.end())
+            return {}; // cancelled
+        auto result = std::move(existing->second.result);
+        iJobs.erase(existing);
+        return result;
+    }
+
+    std::vector<glyph_rasterizer::completed_glyph> glyph_rasterizer::take_completed()
+    {
+        std::vector<completed_glyph> result;
+        std::unique_lock<std::mutex> lock{ iMutex };
+        for (auto j = iJobs.begin(); j != iJobs.end();)
+        {
+            if (j->second.finished)
+            {
+                result.push_back(completed_glyph{ std::get<0>(j->first), std::get<1>(j->first), std::get<2>(j->first), std::move(j->second.result) });
+                j = iJobs.erase(j);
+            }
+            else
+                ++j;
+        }
+        return result;
+    }
+
+    void glyph_rasterizer::cancel(native_font_face const& aOwner, rasterizer_face const& aFace)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        auto const first = job_key{ &aOwner, 0u, false };
+        auto const last = job_key{ &aOwner, std::numeric_limits<uint32_t>::max(), true };
+        for (auto j = iJobs.lower_bound(first); j != iJobs.end() && j->first <= last;)
+        {
+            if (!j->second.running)
+                j = iJobs.erase(j);
+            else
+                ++j;
+        }
+        iWorkFinished.wait(lock, [&]()
+        {
+            for (auto j = iJobs.lower_bound(first); j != iJobs.end() && j->first <= last; ++j)
+                if (j->second.running)
+                    return false;
+            return true;
+        });
+        iJobs.erase(iJobs.lower_bound(first), iJobs.upper_bound(last));
+        if (aFace.dataOwner != nullptr)
+        {
+            for (auto& retired : iRetiredData)
+                retired.push_back(aFace.dataOwner);
+            iWorkAvailable.notify_all();
+        }
+    }
+
+    void glyph_rasterizer::worker(std::size_t aWorker)
+    {
+        FT_Library library = nullptr;
+        if (FT_Init_FreeType(&library) == FT_Err_Ok)
+            FT_Library_SetLcdFilter(library, FT_LCD_FILTER_NONE);
+        else
+            library = nullptr;
+        std::map<worker_face_key, FT_Face> faces;
+        auto close_faces = [&]()
+        {
+            for (auto& face : faces)
+                FT_Done_Face(face.second);
+            faces.clear();
+        };
+        auto close_retired_faces = [&](std::vector<std::shared_ptr<void const>> const& aRetired)
+        {
+            for (auto face = faces.begin(); face != faces.end();)
+            {
+                bool const retired = std::any_of(aRetired.begin(), aRetired.end(), [&](std::shared_ptr<void const> const& aData)
+                {
+                    return !aData.owner_before(face->first.data) && !face->first.data.owner_before(aData);
+                });
+                if (retired)
+                {
+                    FT_Done_Face(face->second);
+                    face = faces.erase(face);
+                }
+                else
+                    ++face;
+            }
+        };
+        auto open_face = [&](rasterizer_face const& aFace) -> FT_Face
+        {
+            auto const key = to_worker_face_key(aFace);
+            auto existing = faces.find(key);
+            if (existing != faces.end())
+                return existing->second;
+            if (faces.size() >= kMaxWorkerFaces)
+                close_faces();
+            FT_Face face = nullptr;
+            freetypeCheck(FT_New_Memory_Face(library, aFace.data, aFace.dataSize, aFace.faceIndex, &face));
+            try
+            {
+                if (aFace.strikeIndex)
+                {
+                    freetypeCheck(FT_Select_Size(face, *aFace.strikeIndex));
+                }
+                else
+                {
+                    freetypeCheck(FT_Set_Char_Size(face, 0, aFace.charSize, aFace.horizontalDpi, aFace.verticalDpi));
+                }
+            }
+            catch (...)
+            {
+                FT_Done_Face(face);
+                throw;
+            }
+            return faces.emplace(key, face).first->second;
+        };
+
+        std::unique_lock<std::mutex> lock{ iMutex };
+        for (;;)
+        {
+            iWorkAvailable.wait(lock, [&]() { return iStopping || !iQueue.empty() || !iRetiredData[aWorker].empty(); });
+            if (iStopping)
+                break;
+            if (!iRetiredData[aWorker].empty())
+            {
+                close_retired_faces(iRetiredData[aWorker]);
+                iRetiredData[aWorker].clear();
+            }
+            if (iQueue.empty())
+                continue;
+            auto const key = iQueue.front();
+            iQueue.pop_front();
+            auto existing = iJobs.find(key);
+            if (existing == iJobs.end() || existing->second.running || existing->second.finished)
+                continue; // cancelled or already promoted by wait()
+            existing->second.running = true;
+            auto const face = existing->second.face;
+            lock.unlock();
+            std::optional<rasterized_glyph> result;
+            if (library != nullptr)
+            {
+                try
+                {
+                    result = rasterize_glyph(library, open_face(face), std::get<1>(key), std::get<2>(key), face.embolden);
+                }
+                catch (...)
+                {
+                    // the render thread retries failed glyphs synchronously and substitutes a replacement
+                }
+            }
+            lock.lock();
+            // cancel() waits for running jobs so the job should still be here
+            auto finishedJob = iJobs.find(key);
+            if (finishedJob != iJobs.end())
+            {
+                finishedJob->second.running = false;
+                finishedJob->second.finished = true;
+                finishedJob->second.result = std::move(result);
+            }
+            iWorkFinished.notify_all();
+        }
+        lock.unlock();
+        close_faces();
+        if (library != nullptr)
+            FT_Done_FreeType(library);
+    }
+}
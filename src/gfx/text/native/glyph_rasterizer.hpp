@@ -0,0 +1,122 @@
+// glyph_rasterizer.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <optional>
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <neogfx/core/geometrical.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/text/i_glyph_texture.hpp>
+
+namespace neogfx
+{
+    class native_font_face;
+
+    // Everything a worker thread needs to open and size its own FreeType instance of a face.
+    struct rasterizer_face
+    {
+        std::shared_ptr<void const> dataOwner; // keeps data alive and identifies it for as long as a worker face reads it
+        FT_Byte const* data;
+        FT_Long dataSize;
+        FT_Long faceIndex;
+        FT_F26Dot6 charSize;
+        FT_UInt horizontalDpi;
+        FT_UInt verticalDpi;
+        std::optional<FT_Int> strikeIndex;
+        FT_Pos embolden;
+    };
+
+    struct rasterized_glyph
+    {
+        size_u32 extents;
+        bool subpixel;
+        point placement;
+        glyph_pixel_mode pixelMode;
+        std::vector<uint8_t> pixels; // bottom-up rows; four bytes per pixel if subpixel, one otherwise
+    };
+
+    // Loads, renders and repacks a glyph into texture data; throws freetype_error on failure.
+    rasterized_glyph rasterize_glyph(FT_Library aLibrary, FT_Face aFace, uint32_t aGlyph, bool aSubpixel, FT_Pos aEmbolden);
+    // Renders an unhinted signed distance field of the glyph at the face's current size; throws freetype_error on failure.
+    rasterized_glyph rasterize_distance_field_glyph(FT_Face aFace, uint32_t aGlyph);
+
+    // Rasterizes requested glyphs on a pool of worker threads, each with its own FreeType library and face instances;
+    // the render thread collects the finished bitmaps and uploads them to the glyph atlas in one batch.
+    class glyph_rasterizer
+    {
+    public:
+        struct completed_glyph
+        {
+            native_font_face const* owner;
+            uint32_t glyph;
+            bool subpixel;
+            std::optional<rasterized_glyph> result;
+        };
+    private:
+        typedef std::tuple<native_font_face const*, uint32_t, bool> job_key;
+        struct job
+        {
+            rasterizer_face face;
+            bool running;
+            bool finished;
+            std::optional<rasterized_glyph> result;
+        };
+        typedef std::map<job_key, job> job_map;
+    public:
+        glyph_rasterizer(uint32_t aThreads = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2u)));
+        ~glyph_rasterizer();
+    public:
+        neogfx::glyph_rasterization_policy policy() const;
+        void set_policy(neogfx::glyph_rasterization_policy aPolicy);
+        uint64_t placeholders_issued() const;
+        void placeholder_issued();
+    public:
+        void request(native_font_face const& aOwner, rasterizer_face const& aFace, uint32_t aGlyph, bool aSubpixel);
+        bool requested(native_font_face const& aOwner, uint32_t aGlyph, bool aSubpixel) const;
+        bool finished(native_font_face const& aOwner, uint32_t aGlyph, bool aSubpixel) const;
+        std::optional<rasterized_glyph> wait(native_font_face const& aOwner, uint32_t aGlyph, bool aSubpixel);
+        std::vector<completed_glyph> take_completed();
+        // drops the owner's pending jobs, waits for its running ones and has every worker close the faces it opened from aFace's data
+        void cancel(native_font_face const& aOwner, rasterizer_face const& aFace);
+    private:
+        void worker(std::size_t aWorker);
+    private:
+        neogfx::glyph_rasterization_policy iPolicy;
+        uint64_t iPlaceholdersIssued;
+        mutable std::mutex iMutex;
+        std::condition_variable iWorkAvailable;
+        std::condition_variable iWorkFinished;
+        std::deque<job_key> iQueue;
+        job_map iJobs;
+        std::vector<std::vector<std::shared_ptr<void const>>> iRetiredData; // per worker
+        bool iStopping;
+        std::vector<std::thread> iThreads;
+    };
+}
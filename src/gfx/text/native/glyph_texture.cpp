@@ -23,7 +23,12 @@
 namespace neogfx
 {
     glyph_texture::glyph_texture(const i_sub_texture& aTexture, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode) :
-        iTexture(aTexture), iSubpixel{ aSubpixel }, iPlacement{ aPlacement }, iPixelMode{ aPixelMode }
+        iTexture(aTexture), iExtents{ aTexture.extents() }, iSubpixel{ aSubpixel }, iPlacement{ aPlacement }, iPixelMode{ aPixelMode }
+    {
+    }
+
+    glyph_texture::glyph_texture(const i_sub_texture& aTexture, const size& aExtents, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode) :
+        iTexture(aTexture), iExtents{ aExtents }, iSubpixel{ aSubpixel }, iPlacement{ aPlacement }, iPixelMode{ aPixelMode }
     {
     }
 
@@ -36,6 +41,11 @@ namespace neogfx
         return iTexture;
     }
 
+    const size& glyph_texture::extents() const
+    {
+        return iExtents;
+    }
+
     bool glyph_texture::subpixel() const
     {
         return iSubpixel && iPixelMode == glyph_pixel_mode::LCD;
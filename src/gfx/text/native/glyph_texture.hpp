@@ -28,14 +28,17 @@ namespace neogfx
     {
     public:
         glyph_texture(const i_sub_texture& aTexture, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode);
+        glyph_texture(const i_sub_texture& aTexture, const size& aExtents, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode);
         ~glyph_texture();
     public:
         const i_sub_texture& texture() const override;
+        const size& extents() const override;
         bool subpixel() const override;
         const point& placement() const override;
         glyph_pixel_mode pixel_mode() const override;
     private:
         const i_sub_texture& iTexture;
+        const size iExtents;
         bool iSubpixel;
         const point iPlacement;
         glyph_pixel_mode iPixelMode;
@@ -0,0 +1,134 @@
+// mapped_font_file.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "mapped_font_file.hpp"
+
+namespace neogfx
+{
+    mapped_font_file::mapped_font_file(std::string const& aPath) :
+        iPath{ aPath }, iData{ nullptr }, iSize{ 0u }
+#ifdef _WIN32
+        , iFile{ INVALID_HANDLE_VALUE }, iMapping{ nullptr }
+#endif
+    {
+#ifdef _WIN32
+        iFile = ::CreateFileW(std::filesystem::path{ aPath }.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (iFile != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER fileSize;
+            if (::GetFileSizeEx(iFile, &fileSize) && fileSize.QuadPart > 0)
+            {
+                iMapping = ::CreateFileMappingW(iFile, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (iMapping != nullptr)
+                {
+                    iData = ::MapViewOfFile(iMapping, FILE_MAP_READ, 0, 0, 0);
+                    if (iData != nullptr)
+                        iSize = static_cast<std::size_t>(fileSize.QuadPart);
+                }
+            }
+        }
+#else
+        int const fd = ::open(aPath.c_str(), O_RDONLY);
+        if (fd != -1)
+        {
+            struct stat fileStatus;
+            if (::fstat(fd, &fileStatus) == 0 && fileStatus.st_size > 0)
+            {
+                void* const mapping = ::mmap(nullptr, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_SHARED, fd, 0);
+                if (mapping != MAP_FAILED)
+                {
+                    iData = mapping;
+                    iSize = static_cast<std::size_t>(fileStatus.st_size);
+                }
+            }
+            ::close(fd);
+        }
+#endif
+        if (iData == nullptr)
+        {
+            std::error_code ec;
+            auto const fileSize = static_cast<std::size_t>(std::filesystem::file_size(aPath, ec));
+            std::ifstream file{ aPath, std::ios::in | std::ios::binary };
+            if (ec || fileSize == 0u || !file)
+                throw failed_to_map_font_file();
+            iFallback.resize(fileSize);
+            if (!file.read(reinterpret_cast<char*>(&iFallback[0]), fileSize))
+                throw failed_to_map_font_file();
+            iData = &iFallback[0];
+            iSize = iFallback.size();
+        }
+    }
+
+    mapped_font_file::~mapped_font_file()
+    {
+        bool const mapped = iFallback.empty() && iData != nullptr;
+#ifdef _WIN32
+        if (mapped)
+            ::UnmapViewOfFile(iData);
+        if (iMapping != nullptr)
+            ::CloseHandle(iMapping);
+        if (iFile != INVALID_HANDLE_VALUE)
+            ::CloseHandle(iFile);
+#else
+        if (mapped)
+            ::munmap(const_cast<void*>(iData), iSize);
+#endif
+    }
+
+    std::shared_ptr<mapped_font_file> mapped_font_file::open(std::string const& aPath)
+    {
+        static std::mutex sMutex;
+        static std::map<std::string, std::weak_ptr<mapped_font_file>> sMappings;
+        std::scoped_lock lock{ sMutex };
+        auto& existing = sMappings[aPath];
+        if (auto mapping = existing.lock())
+            return mapping;
+        auto mapping = std::make_shared<mapped_font_file>(aPath);
+        existing = mapping;
+        return mapping;
+    }
+
+    std::string const& mapped_font_file::path() const
+    {
+        return iPath;
+    }
+
+    void const* mapped_font_file::data() const
+    {
+        return iData;
+    }
+
+    std::size_t mapped_font_file::size() const
+    {
+        return iSize;
+    }
+}
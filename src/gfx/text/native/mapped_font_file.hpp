@@ -0,0 +1,54 @@
+// mapped_font_file.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace neogfx
+{
+    // A font file mapped read-only into memory; every face opened from the same path shares one mapping
+    // (and the operating system shares its pages between processes).
+    class mapped_font_file
+    {
+    public:
+        struct failed_to_map_font_file : std::runtime_error { failed_to_map_font_file() : std::runtime_error("neogfx::mapped_font_file::failed_to_map_font_file") {} };
+    public:
+        explicit mapped_font_file(std::string const& aPath);
+        ~mapped_font_file();
+    public:
+        static std::shared_ptr<mapped_font_file> open(std::string const& aPath);
+    public:
+        std::string const& path() const;
+        void const* data() const;
+        std::size_t size() const;
+    private:
+        std::string iPath;
+        void const* iData;
+        std::size_t iSize;
+        std::vector<unsigned char> iFallback; // used if the file cannot be mapped
+#ifdef _WIN32
+        void* iFile;
+        void* iMapping;
+#endif
+    };
+}
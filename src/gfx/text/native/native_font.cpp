@@ -18,28 +18,50 @@
 */
 
 #include <neogfx/neogfx.hpp>
-#include <boost/filesystem.hpp>
 #include <neolib/core/string_ci.hpp>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <neogfx/gfx/i_texture_atlas.hpp>
 #include <neogfx/gfx/text/i_font_manager.hpp>
+#include "../../native/i_native_texture.hpp"
 #include "native_font.hpp"
 #include "native_font_face.hpp"
+#include "glyph_rasterizer.hpp"
 
 namespace neogfx
 {
     native_font::native_font(FT_Library aFontLib, const std::string aFileName) :
-        iFontLib(aFontLib), iSource(filename_type(aFileName)), iCache{}, iFaceCount(0)
+        iFontLib(aFontLib), iSource(filename_type(aFileName)), iFaceCount(0)
     {
         register_faces();
     }
 
     native_font::native_font(FT_Library aFontLib, const void* aData, std::size_t aSizeInBytes) :
-        iFontLib(aFontLib), iSource(memory_block_type(aData, aSizeInBytes)), iCache{}, iFaceCount(0)
+        iFontLib(aFontLib), iSource(memory_block_type(aData, aSizeInBytes)), iMemoryOwner{ aData, [](void const*) {} }, iFaceCount(0)
     {
         register_faces();
     }
 
+    native_font::native_font(FT_Library aFontLib, const font_index::file& aIndexedFile) :
+        iFontLib(aFontLib), iSource(filename_type(aIndexedFile.path)), iFamilyName{ aIndexedFile.familyName }, iFaceCount(static_cast<FT_Long>(aIndexedFile.faces.size()))
+    {
+        // the file itself is not opened until a face is created
+        for (auto const& face : aIndexedFile.faces)
+            iStyleMap.emplace(std::make_pair(face.style, string{ face.styleName }), face.index);
+        add_emulated_styles();
+    }
+
     native_font::~native_font()
     {
+        for (auto const& glyph : iDistanceFieldGlyphs)
+            if (glyph.second.texture != nullptr)
+            {
+                auto& glyphAtlas = service<i_font_manager>().glyph_atlas();
+                glyphAtlas.destroy_sub_texture(glyphAtlas.sub_texture(glyph.second.texture->atlas_id()));
+            }
+        for (auto const& face : iDistanceFieldFaces)
+            close_face(face.second);
+        // the mapping itself is released after iFaces, whose FreeType faces still reference it
         if (iHarfbuzzBlob != nullptr)
             hb_blob_destroy(iHarfbuzzBlob);
     }
@@ -137,6 +159,32 @@ namespace neogfx
         aResult = create_face(faceIndex, faceStyle, aSize, aDevice);
     }
 
+    native_font::distance_field_glyph const& native_font::shared_distance_field_glyph(FT_Long aFaceIndex, uint32_t aGlyph)
+    {
+        auto existing = iDistanceFieldGlyphs.find(std::make_pair(aFaceIndex, aGlyph));
+        if (existing != iDistanceFieldGlyphs.end())
+            return existing->second;
+        auto& newGlyph = iDistanceFieldGlyphs.emplace(std::make_pair(aFaceIndex, aGlyph), distance_field_glyph{}).first->second;
+        try
+        {
+            auto const rasterizedGlyph = rasterize_distance_field_glyph(distance_field_face(aFaceIndex), aGlyph);
+            if (rasterizedGlyph.extents.cx != 0 && rasterizedGlyph.extents.cy != 0)
+            {
+                auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
+                    size{ static_cast<dimension>(rasterizedGlyph.extents.cx), static_cast<dimension>(rasterizedGlyph.extents.cy) },
+                    1.0, texture_sampling::Normal, texture_data_format::DistanceField);
+                static_cast<i_native_texture&>(subTexture.native_texture()).queue_pixels(rect{ subTexture.atlas_location() }, &rasterizedGlyph.pixels[0], 1u);
+                newGlyph.texture = &subTexture;
+                newGlyph.placement = rasterizedGlyph.placement;
+            }
+        }
+        catch (freetype_error const&)
+        {
+            // faces fall back to bitmap glyphs
+        }
+        return newGlyph;
+    }
+
     native_font::style_map::const_iterator native_font::find_style(font_style aStyle) const
     {
         return std::find_if(iStyleMap.begin(), iStyleMap.end(), [aStyle](auto const& s) { return s.first.first == aStyle; });
@@ -147,6 +195,13 @@ namespace neogfx
         register_face(0);
         for (FT_Long f = 1; f < iFaceCount; ++f)
             register_face(f);
+        add_emulated_styles();
+        // nothing has been created from the file yet so it need not stay mapped until a face is
+        release_data();
+    }
+
+    void native_font::add_emulated_styles()
+    {
         if (!has_style(font_style::Bold) && has_style(font_style::Normal))
         {
             auto existingNormal = find_style(font_style::Normal);
@@ -163,8 +218,23 @@ namespace neogfx
             auto existingNormal = find_style(font_style::Normal);
             iStyleMap.emplace(std::make_pair(font_style::EmulatedBoldItalic, "Bold Italic (Emulated)"), existingNormal->second);
         }
-        iCache.clear();
-        iCache.shrink_to_fit();
+    }
+
+    font_style native_font::face_style(FT_Face aFace)
+    {
+        font_style style = font_style::Invalid;
+        if (aFace->style_flags & FT_STYLE_FLAG_ITALIC)
+            style |= static_cast<font_style>(style | font_style::Italic);
+        if (aFace->style_flags & FT_STYLE_FLAG_BOLD)
+            style |= static_cast<font_style>(style | font_style::Bold);
+        auto const searchKey = neolib::ci_string{ aFace->style_name };
+        if (searchKey.find("italic") != neolib::ci_string::npos)
+            style |= font_style::Italic;
+        if (searchKey.find("bold") != neolib::ci_string::npos || searchKey.find("heavy") != neolib::ci_string::npos || searchKey.find("black") != neolib::ci_string::npos)
+            style |= font_style::Bold;
+        if (style == font_style::Invalid)
+            style = font_style::Normal;
+        return style;
     }
 
     void native_font::register_face(FT_Long aFaceIndex)
@@ -177,70 +247,114 @@ namespace neogfx
                 iFaceCount = face.first->num_faces;
                 iFamilyName = face.first->family_name;
             }
-            font_style style = font_style::Invalid;
-            if (face.first->style_flags & FT_STYLE_FLAG_ITALIC)
-                style |= static_cast<font_style>(style | font_style::Italic);
-            if (face.first->style_flags & FT_STYLE_FLAG_BOLD)
-                style |= static_cast<font_style>(style | font_style::Bold);
-            auto const searchKey = neolib::ci_string{ face.first->style_name };
-            if (searchKey.find("italic") != neolib::ci_string::npos)
-                style |= font_style::Italic;
-            if (searchKey.find("bold") != neolib::ci_string::npos || searchKey.find("heavy") != neolib::ci_string::npos || searchKey.find("black") != neolib::ci_string::npos)
-                style |= font_style::Bold;
-            if (style == font_style::Invalid)
-                style = font_style::Normal;
-            iStyleMap.emplace(std::make_pair(style, face.first->style_name), aFaceIndex);
+            iStyleMap.emplace(std::make_pair(face_style(face.first), face.first->style_name), aFaceIndex);
         }
         catch (...)
         {
+            hb_face_destroy(face.second);
             close_face(face.first);
             throw;
         }
+        hb_face_destroy(face.second);
         close_face(face.first);
     }
 
     std::pair<FT_Face, hb_face_t*> native_font::open_face(FT_Long aFaceIndex)
     {
         std::pair<FT_Face, hb_face_t*> face;
+        auto const fontData = data();
+        FT_Error error = FT_New_Memory_Face(
+            iFontLib,
+            static_cast<const FT_Byte*>(fontData.first),
+            static_cast<FT_Long>(fontData.second),
+            aFaceIndex,
+            &face.first);
+        if (error)
+            throw failed_to_load_font();
+        face.second = hb_face_create(harfbuzz_blob(), aFaceIndex);
+        return face;
+    }
+
+    native_font::memory_block_type native_font::data()
+    {
         if (std::holds_alternative<filename_type>(iSource))
         {
-            if (iCache.empty())
+            if (iMapping == nullptr)
             {
-                std::size_t fileSize = static_cast<std::size_t>(boost::filesystem::file_size(static_variant_cast<const filename_type&>(iSource)));
-                iCache.resize(fileSize);
-                std::ifstream file{ std::get<filename_type>(iSource).c_str(), std::ios::in | std::ios::binary };
-                file.read(reinterpret_cast<char*>(&iCache[0]), fileSize);
+                try
+                {
+                    iMapping = mapped_font_file::open(std::get<filename_type>(iSource));
+                }
+                catch (mapped_font_file::failed_to_map_font_file&)
+                {
+                    throw failed_to_load_font();
+                }
             }
-            FT_Error error = FT_New_Memory_Face(
-                iFontLib,
-                static_cast<const FT_Byte*>(&iCache[0]),
-                static_cast<FT_Long>(iCache.size()),
-                aFaceIndex,
-                &face.first);
-            if (error)
-                throw failed_to_load_font();
-            iHarfbuzzBlob = hb_blob_create_from_file_or_fail(std::get<filename_type>(iSource).c_str());
-            if (iHarfbuzzBlob == nullptr)
-                throw failed_to_load_font();
-            face.second = hb_face_create(iHarfbuzzBlob, aFaceIndex);
+            return memory_block_type{ iMapping->data(), iMapping->size() };
         }
-        else
+        return std::get<memory_block_type>(iSource);
+    }
+
+    std::shared_ptr<void const> native_font::data_owner()
+    {
+        data();
+        if (iMapping != nullptr)
+            return iMapping;
+        // memory passed in by the caller outlives the font; this only gives it an identity of its own
+        return iMemoryOwner;
+    }
+
+    hb_blob_t* native_font::harfbuzz_blob()
+    {
+        if (iHarfbuzzBlob == nullptr)
         {
-            auto const& memBlk = std::get<memory_block_type>(iSource);
-            FT_Error error = FT_New_Memory_Face(
-                iFontLib,
-                static_cast<const FT_Byte*>(memBlk.first),
-                static_cast<FT_Long>(memBlk.second),
-                aFaceIndex,
-                &face.first);
-            if (error)
-                throw failed_to_load_font();
-            iHarfbuzzBlob = hb_blob_create_or_fail(static_cast<const char*>(memBlk.first), static_cast<unsigned int>(memBlk.second), hb_memory_mode_t::HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+            auto const fontData = data();
+            if (iMapping != nullptr)
+            {
+                // the blob keeps the mapping alive for as long as HarfBuzz holds a reference to it
+                auto mappingRef = new std::shared_ptr<mapped_font_file>{ iMapping };
+                iHarfbuzzBlob = hb_blob_create_or_fail(static_cast<const char*>(fontData.first), static_cast<unsigned int>(fontData.second), HB_MEMORY_MODE_READONLY,
+                    mappingRef, [](void* aUserData) { delete static_cast<std::shared_ptr<mapped_font_file>*>(aUserData); });
+            }
+            else
+                iHarfbuzzBlob = hb_blob_create_or_fail(static_cast<const char*>(fontData.first), static_cast<unsigned int>(fontData.second), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
             if (iHarfbuzzBlob == nullptr)
                 throw failed_to_load_font();
-            face.second = hb_face_create(iHarfbuzzBlob, aFaceIndex);
         }
-        return face;
+        return iHarfbuzzBlob;
+    }
+
+    void native_font::release_data()
+    {
+        // FreeType faces read the font data in place so it is never released from under them
+        if (!iFaces.empty() || !iDistanceFieldFaces.empty())
+            return;
+        if (iHarfbuzzBlob != nullptr)
+        {
+            hb_blob_destroy(iHarfbuzzBlob);
+            iHarfbuzzBlob = nullptr;
+        }
+        iMapping = nullptr;
+    }
+
+    FT_Face native_font::distance_field_face(FT_Long aFaceIndex)
+    {
+        auto existing = iDistanceFieldFaces.find(aFaceIndex);
+        if (existing != iDistanceFieldFaces.end())
+            return existing->second;
+        auto const fontData = data();
+        FT_Face face = nullptr;
+        freetypeCheck(FT_New_Memory_Face(iFontLib, static_cast<const FT_Byte*>(fontData.first), static_cast<FT_Long>(fontData.second), aFaceIndex, &face));
+        try
+        {
+            freetypeCheck(FT_Set_Pixel_Sizes(face, 0, DistanceFieldEmSize));
+        }
+        catch (...)
+        {
+            close_face(face);
+            throw;
+        }
+        return iDistanceFieldFaces[aFaceIndex] = face;
     }
 
     void native_font::close_face(FT_Face aFace)
@@ -257,7 +371,7 @@ namespace neogfx
         try
         {
             auto newFontId = service<i_font_manager>().allocate_font_id();
-            auto newFace = make_ref<native_font_face>(iFontLib, newFontId, *this, aStyle, aSize, size(aDevice.horizontal_dpi(), aDevice.vertical_dpi()), newFaceHandles.first, newFaceHandles.second);
+            auto newFace = make_ref<native_font_face>(iFontLib, newFontId, *this, aStyle, aSize, size(aDevice.horizontal_dpi(), aDevice.vertical_dpi()), newFaceHandles.first, newFaceHandles.second, data_owner());
             iFaces.insert(std::make_pair(std::make_tuple(aFaceIndex, aStyle, aSize, size(aDevice.horizontal_dpi(), aDevice.vertical_dpi())), newFace)).first;
             return newFace;
         }
@@ -28,9 +28,13 @@
 #include <harfbuzz/hb.h>
 #include "i_native_font.hpp"
 #include "i_native_font_face.hpp"
+#include "font_index.hpp"
+#include "mapped_font_file.hpp"
 
 namespace neogfx
 {
+    class i_sub_texture;
+
     class native_font : public reference_counted<i_native_font>
     {
     public:
@@ -40,12 +44,25 @@ namespace neogfx
         typedef std::variant<std::monostate, filename_type, memory_block_type> source_type;
         typedef std::map<std::pair<font_style, string>, FT_Long> style_map;
         typedef std::map<std::tuple<FT_Long, font_style, font::point_size, size>, ref_ptr<i_native_font_face>> face_map;
+    public:
+        // glyphs rasterized once as distance fields at this many pixels per em are shared by every face size
+        static constexpr uint32_t DistanceFieldEmSize = 64u;
+        static constexpr uint32_t DistanceFieldSpread = 8u;
+        struct distance_field_glyph
+        {
+            i_sub_texture const* texture; // null if the glyph has no outline
+            point placement;
+        };
+    private:
+        typedef std::map<FT_Long, FT_Face> distance_field_face_map;
+        typedef std::map<std::pair<FT_Long, uint32_t>, distance_field_glyph> distance_field_glyph_map;
     public:
         struct failed_to_load_font : std::runtime_error { failed_to_load_font() : std::runtime_error("neogfx::native_font::failed_to_load_font") {} };
         struct no_matching_style_found : std::runtime_error { no_matching_style_found() : std::runtime_error("neogfx::native_font::no_matching_style_found") {} };
     public:
         native_font(FT_Library aFontLib, const std::string aFileName);
         native_font(FT_Library aFontLib, const void* aData, std::size_t aSizeInBytes);
+        native_font(FT_Library aFontLib, const font_index::file& aIndexedFile);
         ~native_font();
     public:
         i_string const& family_name() const override;
@@ -57,21 +74,33 @@ namespace neogfx
         void remove_style(uint32_t aStyleIndex) override;
         void create_face(font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice, i_ref_ptr<i_native_font_face>& aResult) override;
         void create_face(i_string const& aStyleName, font::point_size aSize, const i_device_resolution& aDevice, i_ref_ptr<i_native_font_face>& aResult) override;
+    public:
+        static font_style face_style(FT_Face aFace);
+        distance_field_glyph const& shared_distance_field_glyph(FT_Long aFaceIndex, uint32_t aGlyph);
     private:
+        memory_block_type data();
+        std::shared_ptr<void const> data_owner();
+        hb_blob_t* harfbuzz_blob();
+        void release_data();
+        FT_Face distance_field_face(FT_Long aFaceIndex);
         style_map::const_iterator find_style(font_style aStyle) const;
         void register_faces();
         void register_face(FT_Long aFaceIndex);
+        void add_emulated_styles();
         std::pair<FT_Face, hb_face_t*> open_face(FT_Long aFaceIndex);
         void close_face(FT_Face aFace);
         ref_ptr<i_native_font_face> create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice);
     private:
         FT_Library iFontLib;
         source_type iSource;
-        std::vector<unsigned char> iCache;
+        std::shared_ptr<mapped_font_file> iMapping;
+        std::shared_ptr<void const> iMemoryOwner;
         hb_blob_t* iHarfbuzzBlob = nullptr;
         string iFamilyName;
         FT_Long iFaceCount;
         style_map iStyleMap;
         face_map iFaces;
+        distance_field_face_map iDistanceFieldFaces;
+        distance_field_glyph_map iDistanceFieldGlyphs;
     };
 }
\ No newline at end of file
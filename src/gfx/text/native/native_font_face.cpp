@@ -29,7 +29,9 @@
 #include FT_ADVANCES_H
 #include "../../native/opengl.hpp"
 #include "../../native/i_native_texture.hpp"
+#include "native_font.hpp"
 #include "native_font_face.hpp"
+#include "glyph_rasterizer.hpp"
 #include <neogfx/gfx/text/glyph.hpp>
 #include <neogfx/gfx/text/i_font_manager.hpp>
 #include <neogfx/gfx/i_texture_atlas.hpp>
@@ -65,8 +67,8 @@ namespace neogfx
         return static_cast<hb_position_t>(static_cast<font_face_handle*>(user_data)->owner.kerning(first_glyph, second_glyph));
     }
 
-    native_font_face::native_font_face(FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace) :
-        iFontLib{ aFontLib }, iId { aId }, iFont{ aFont }, iStyle{ aStyle }, iStyleName{ aFreetypeFace->style_name }, iSize{ aSize }, iPixelDensityDpi{ aDpiResolution }, iHandle{ *this, aFreetypeFace, aHarfbuzzFace }, iHasKerning{ !!FT_HAS_KERNING(iHandle.freetypeFace) }
+    native_font_face::native_font_face(FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace, std::shared_ptr<void const> aData) :
+        iFontLib{ aFontLib }, iId { aId }, iFont{ aFont }, iStyle{ aStyle }, iStyleName{ aFreetypeFace->style_name }, iSize{ aSize }, iPixelDensityDpi{ aDpiResolution }, iData{ std::move(aData) }, iHandle{ *this, aFreetypeFace, aHarfbuzzFace }, iHasKerning{ !!FT_HAS_KERNING(iHandle.freetypeFace) }
     {
         switch (aStyle)
         {
@@ -86,6 +88,14 @@ namespace neogfx
 
     native_font_face::~native_font_face()
     {
+        if (iGlyphRasterizer != nullptr)
+            iGlyphRasterizer->cancel(*this, iRasterizerFace);
+        for (auto const& cachedGlyph : iGlyphs)
+        {
+            auto& glyphAtlas = service<i_font_manager>().glyph_atlas();
+            glyphAtlas.destroy_sub_texture(glyphAtlas.sub_texture(cachedGlyph.second.first.texture().atlas_id()));
+            iGlyphCache->remove(cachedGlyph.second.second);
+        }
         if (iHandle.freetypeFace != nullptr)
             sGetAdvanceCache.erase(sGetAdvanceCache.find(iHandle.freetypeFace));
         FT_Done_Face(iHandle.freetypeFace);
@@ -193,6 +203,7 @@ namespace neogfx
     {
         if (!iHasKerning)
             return 0.0;
+        std::unique_lock<std::mutex> lock{ iKerningMutex };
         auto existing = iKerningTable.find(std::make_pair(aLeftGlyphIndex, aRightGlyphIndex));
         if (existing != iKerningTable.end())
             return existing->second;
@@ -259,174 +270,148 @@ namespace neogfx
         return FT_Get_Char_Index(iHandle.freetypeFace, aCodePoint);
     }
 
-    inline glyph_pixel_mode to_glyph_pixel_mode(unsigned char aFreeTypePixelMode)
+    void native_font_face::request_glyph_texture(const glyph& aGlyph) const
     {
-        switch (aFreeTypePixelMode)
-        {
-        default:
-        case FT_PIXEL_MODE_NONE:
-            return glyph_pixel_mode::None;
-        case FT_PIXEL_MODE_MONO:
-            return glyph_pixel_mode::Mono;
-        case FT_PIXEL_MODE_GRAY:
-            return glyph_pixel_mode::Gray;
-        case FT_PIXEL_MODE_GRAY2:
-            return glyph_pixel_mode::Gray2Bit;
-        case FT_PIXEL_MODE_GRAY4:
-            return glyph_pixel_mode::Gray4Bit;
-        case FT_PIXEL_MODE_LCD:
-            return glyph_pixel_mode::LCD;
-        case FT_PIXEL_MODE_LCD_V:
-            return glyph_pixel_mode::LCD_V;
-        case FT_PIXEL_MODE_BGRA:
-            return glyph_pixel_mode::BGRA;
-        }
+        if (glyph_rasterizer().policy() == glyph_rasterization_policy::Synchronous || iRasterizerFace.data == nullptr || distance_field())
+            return;
+        auto const subpixelTexture = subpixel(aGlyph);
+        if (iGlyphs.find(texture_key(aGlyph.value, subpixelTexture)) != iGlyphs.end() || glyph_rasterizer().requested(*this, aGlyph.value, subpixelTexture))
+            return;
+        glyph_cache().miss();
+        glyph_rasterizer().request(*this, iRasterizerFace, aGlyph.value, subpixelTexture);
     }
-         
+
     i_glyph_texture& native_font_face::glyph_texture(const glyph& aGlyph) const
     {
-        // todo: investigate why turning off sub-pixel doesn't produce same grayscale bitmap as Windows with ClearType disabled
-        bool useSubpixelFiltering = true;
-
-        auto existingGlyph = iGlyphs.find(aGlyph.value);
+        if (distance_field())
+        {
+            auto distanceFieldGlyph = distance_field_glyph_texture(aGlyph.value);
+            if (distanceFieldGlyph != nullptr)
+                return *distanceFieldGlyph;
+        }
+        // the glyph's sub-pixel flag reflects both the render target's setting and whether the face is a bitmap font
+        auto const subpixelTexture = subpixel(aGlyph);
+        auto existingGlyph = iGlyphs.find(texture_key(aGlyph.value, subpixelTexture));
         if (existingGlyph != iGlyphs.end())
-            return existingGlyph->second;
-        try
         {
-            try
-            {
-                // todo: remove FT_LOAD_NO_AUTOHINT when cause of crash in freetype 2.11 with certain fonts is resolved
-                if (useSubpixelFiltering)
-                {
-                    freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyph.value, FT_LOAD_NO_AUTOHINT | FT_LOAD_TARGET_LCD | FT_LOAD_NO_BITMAP));
-                }
-                else
-                {
-                    freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyph.value, FT_LOAD_NO_AUTOHINT | FT_LOAD_TARGET_NORMAL | FT_LOAD_NO_BITMAP));
-                }
-            }
-            catch (freetype_error fe)
-            {
-                service<debug::logger>() << "neogfx: warning: Cannot load font glyph" << endl;
-                throw freetype_load_glyph_error(fe.what());
-            }
-            try
-            {
-                if (useSubpixelFiltering)
-                {
-                    freetypeCheck(FT_Render_Glyph(iHandle.freetypeFace->glyph, FT_RENDER_MODE_LCD));
-                }
-                else
-                {
-                    freetypeCheck(FT_Render_Glyph(iHandle.freetypeFace->glyph, FT_RENDER_MODE_NORMAL));
-                }
-            }
-            catch (freetype_error fe)
+            glyph_cache().hit();
+            return existingGlyph->second.first;
+        }
+        if (glyph_rasterizer().requested(*this, aGlyph.value, subpixelTexture))
+        {
+            // counted as a miss when requested
+            if (glyph_rasterizer().policy() == glyph_rasterization_policy::Placeholder && !glyph_rasterizer().finished(*this, aGlyph.value, subpixelTexture))
             {
-                service<debug::logger>() << "neogfx: warning: Cannot render font glyph" << endl;
-                throw freetype_render_glyph_error(fe.what());
+                glyph_rasterizer().placeholder_issued();
+                return placeholder_glyph();
             }
+            auto const rasterizedGlyph = glyph_rasterizer().wait(*this, aGlyph.value, subpixelTexture);
+            if (rasterizedGlyph)
+                return upload_glyph(aGlyph.value, subpixelTexture, *rasterizedGlyph);
+        }
+        else
+            glyph_cache().miss();
+
+        std::optional<rasterized_glyph> rasterizedGlyph;
+        try
+        {
+            rasterizedGlyph = rasterize_glyph(iFontLib, iHandle.freetypeFace, aGlyph.value, subpixelTexture, iRasterizerFace.embolden);
+        }
+        catch (freetype_load_glyph_error)
+        {
+            service<debug::logger>() << "neogfx: warning: Cannot load font glyph" << endl;
         }
-        catch (...)
+        catch (freetype_render_glyph_error)
+        {
+            service<debug::logger>() << "neogfx: warning: Cannot render font glyph" << endl;
+        }
+        if (rasterizedGlyph == std::nullopt)
         {
             thread_local bool inHere = false;
             if (!inHere)
             {
                 neolib::scoped_flag sf{ inHere };
-                glyph invalid = aGlyph;
+                glyph replacement = aGlyph;
                 auto const replacementGlyph = FT_Get_Char_Index(iHandle.freetypeFace, 0xFFFD);
-                if (replacementGlyph != 0)
+                if (replacementGlyph != 0 && replacementGlyph != aGlyph.value)
                 {
-                    invalid.value = replacementGlyph;
-                    return glyph_texture(aGlyph);
+                    replacement.value = replacementGlyph;
+                    return glyph_texture(replacement);
                 }
             }
             return invalid_glyph();
         }
+        return upload_glyph(aGlyph.value, subpixelTexture, *rasterizedGlyph);
+    }
 
-        FT_Bitmap& bitmap = iHandle.freetypeFace->glyph->bitmap;
-
-        if ((style() & (font_style::EmulatedBold)) == font_style::EmulatedBold)
-            FT_Bitmap_Embolden(iFontLib, &bitmap, static_cast<FT_F26Dot6>(default_dpi_scale_factor(iPixelDensityDpi.cx) * 64), 0);
-
-        auto pixelMode = to_glyph_pixel_mode(bitmap.pixel_mode);
+    void native_font_face::glyph_texture_drawn(const glyph& aGlyph) const
+    {
+        auto existingGlyph = iGlyphs.find(texture_key(aGlyph.value, subpixel(aGlyph)));
+        if (existingGlyph != iGlyphs.end())
+            glyph_cache().use(existingGlyph->second.second);
+    }
 
-        if (pixelMode != glyph_pixel_mode::LCD)
-            useSubpixelFiltering = false;
+    i_glyph_texture& native_font_face::upload_glyph(glyph_index_t aGlyph, bool aSubpixel, rasterized_glyph const& aRasterizedGlyph) const
+    {
+        auto const textureKey = texture_key(aGlyph, aSubpixel);
+        auto existingGlyph = iGlyphs.find(textureKey);
+        if (existingGlyph != iGlyphs.end())
+            return existingGlyph->second.first;
 
-        auto subTextureWidth = bitmap.width / (useSubpixelFiltering ? 3 : 1);
-        if (subTextureWidth == 0)
+        if (aRasterizedGlyph.extents.cx == 0)
             return invalid_glyph();
 
         auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
-            neogfx::size{ static_cast<dimension>(subTextureWidth), static_cast<dimension>(bitmap.rows) }.ceil(),
-            1.0, texture_sampling::Normal, pixelMode == glyph_pixel_mode::LCD ? texture_data_format::SubPixel : texture_data_format::Red);
+            neogfx::size{ static_cast<dimension>(aRasterizedGlyph.extents.cx), static_cast<dimension>(aRasterizedGlyph.extents.cy) }.ceil(),
+            1.0, texture_sampling::Normal, aRasterizedGlyph.pixelMode == glyph_pixel_mode::LCD ? texture_data_format::SubPixel : texture_data_format::Red);
 
         rect glyphRect{ subTexture.atlas_location() };
-        i_glyph_texture& glyphTexture = iGlyphs.insert(std::make_pair(aGlyph.value,
-            neogfx::glyph_texture{
-                subTexture,
-                useSubpixelFiltering,
-                point{
-                    iHandle.freetypeFace->glyph->metrics.horiBearingX / 64.0,
-                    (iHandle.freetypeFace->glyph->metrics.horiBearingY - iHandle.freetypeFace->glyph->metrics.height) / 64.0 },
-                pixelMode })).first->second;
-
-        thread_local std::vector<GLubyte> glyphTextureData;
-        thread_local std::vector<std::array<GLubyte, 4>> subpixelGlyphTextureData;
-        glyphTextureData.clear();
-        subpixelGlyphTextureData.clear();
-
-        const GLubyte* textureData = 0;
-        
-        if (useSubpixelFiltering)
-        {
-            subpixelGlyphTextureData.resize(static_cast<std::size_t>(glyphRect.cx * glyphRect.cy));
-            // sub-pixel FIR filter.
-            static double coefficients[] = { 1.5 / 16.0, 3.5 / 16.0, 6.0 / 16.0, 3.5 / 16.0, 1.5 / 16.0 };
-            for (uint32_t y = 0; y < bitmap.rows; y++)
-            {
-                for (uint32_t x = 0; x < bitmap.width; x++)
-                {
-                    uint8_t alpha = 0;
-                    for (int32_t z = -2; z <= 2; ++z)
-                    {
-                        int32_t const s = x + z;
-                        if (s >= 0 && s <= static_cast<int32_t>(bitmap.width) - 1)
-                            alpha += static_cast<uint8_t>(bitmap.buffer[s + bitmap.pitch * y] * coefficients[z + 2]);
-                    }
-                    subpixelGlyphTextureData[(x / 3) + (bitmap.rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)][x % 3] = alpha;
-                }
-            }
-            textureData = &subpixelGlyphTextureData[0][0];
-        }
-        else
-        {
-            glyphTextureData.resize(static_cast<std::size_t>(glyphRect.cx * glyphRect.cy));
-            for (uint32_t y = 0; y < bitmap.rows; y++)
-                switch (bitmap.pixel_mode)
-                {
-                case FT_PIXEL_MODE_MONO: // 1 bit per pixel monochrome
-                    for (uint32_t x = 0; x < bitmap.width; x += 8)
-                        for (uint32_t b = 0; b < std::min(bitmap.width - x, 8u); ++b)
-                            glyphTextureData[(x + b) + (bitmap.rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)] =
-                                (x >= bitmap.width || y >= bitmap.rows) ? 0x00 : ((bitmap.buffer[x / 8 + bitmap.pitch * y] & (1 << (7 - b))) != 0 ? 0xFF : 0x00);
-                    break;
-                case FT_PIXEL_MODE_GRAY:
-                default:
-                    for (uint32_t x = 0; x < bitmap.width; x++)
-                        glyphTextureData[x + (bitmap.rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)] =
-                            (x >= bitmap.width || y >= bitmap.rows) ? 0x00 : bitmap.buffer[x + bitmap.pitch * y];
-                    break;
-                }
-            textureData = &glyphTextureData[0];
-        }
-        
-        static_cast<i_native_texture&>(glyphTexture.texture().native_texture()).set_pixels(glyphRect, &textureData[0], 1u);
+        auto& cachedGlyph = iGlyphs.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(textureKey),
+            std::forward_as_tuple(
+                neogfx::glyph_texture{ subTexture, aRasterizedGlyph.subpixel, aRasterizedGlyph.placement, aRasterizedGlyph.pixelMode },
+                neogfx::glyph_cache::handle{})).first->second;
+        i_glyph_texture& glyphTexture = cachedGlyph.first;
+
+        static_cast<i_native_texture&>(glyphTexture.texture().native_texture()).queue_pixels(glyphRect, &aRasterizedGlyph.pixels[0], 1u);
+
+        cachedGlyph.second = glyph_cache().add(*this, textureKey, 
+            static_cast<std::size_t>(glyphRect.cx * glyphRect.cy) * (aRasterizedGlyph.pixelMode == glyph_pixel_mode::LCD ? 4u : 1u));
 
         return glyphTexture;
     }
 
+    void native_font_face::evict_glyph(uint32_t aTextureKey) const
+    {
+        auto existingGlyph = iGlyphs.find(aTextureKey);
+        if (existingGlyph == iGlyphs.end())
+            return;
+        auto& glyphAtlas = service<i_font_manager>().glyph_atlas();
+        glyphAtlas.destroy_sub_texture(glyphAtlas.sub_texture(existingGlyph->second.first.texture().atlas_id()));
+        iGlyphCache->remove(existingGlyph->second.second);
+        iGlyphs.erase(existingGlyph);
+    }
+
+    native_font_face::glyph_index_t native_font_face::texture_key(glyph_index_t aGlyph, bool aSubpixel)
+    {
+        return aSubpixel ? aGlyph | SubpixelTextureKey : aGlyph;
+    }
+
+    neogfx::glyph_cache& native_font_face::glyph_cache() const
+    {
+        if (iGlyphCache == nullptr)
+            iGlyphCache = &service<i_font_manager>().glyph_cache();
+        return *iGlyphCache;
+    }
+
+    neogfx::glyph_rasterizer& native_font_face::glyph_rasterizer() const
+    {
+        if (iGlyphRasterizer == nullptr)
+            iGlyphRasterizer = &service<i_font_manager>().glyph_rasterizer();
+        return *iGlyphRasterizer;
+    }
+
     i_glyph_texture& native_font_face::invalid_glyph() const
     {
         if (iInvalidGlyph == std::nullopt)
@@ -444,6 +429,54 @@ namespace neogfx
         return *iInvalidGlyph;
     }
 
+    i_glyph_texture& native_font_face::placeholder_glyph() const
+    {
+        if (iPlaceholderGlyph == std::nullopt)
+        {
+            auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
+                neogfx::size{ 1.0, 1.0 }, 1.0, texture_sampling::Normal, texture_data_format::Red);
+            GLubyte const blank = 0x00;
+            static_cast<i_native_texture&>(subTexture.native_texture()).set_pixels(rect{ subTexture.atlas_location() }, &blank, 1u);
+            iPlaceholderGlyph.emplace(
+                subTexture,
+                false,
+                point{},
+                glyph_pixel_mode::Gray);
+        }
+        return *iPlaceholderGlyph;
+    }
+
+    bool native_font_face::distance_field() const
+    {
+        auto const& threshold = service<i_font_manager>().distance_field_glyph_threshold();
+        if (threshold == std::nullopt || is_bitmap_font() || (style() & font_style::EmulatedBold) == font_style::EmulatedBold)
+            return false;
+        return pixel_size() >= *threshold;
+    }
+
+    dimension native_font_face::pixel_size() const
+    {
+        return iRasterizerFace.charSize / 64.0 * iPixelDensityDpi.cy / 72.0;
+    }
+
+    i_glyph_texture* native_font_face::distance_field_glyph_texture(glyph_index_t aGlyph) const
+    {
+        auto existingGlyph = iDistanceFieldGlyphs.find(aGlyph);
+        if (existingGlyph != iDistanceFieldGlyphs.end())
+            return &existingGlyph->second;
+        // one distance field rendered at the reference size is shared by every size of this face; scale it to ours
+        auto const& sharedGlyph = static_cast<neogfx::native_font&>(iFont).shared_distance_field_glyph(iHandle.freetypeFace->face_index, aGlyph);
+        if (sharedGlyph.texture == nullptr)
+            return nullptr;
+        auto const scale = pixel_size() / neogfx::native_font::DistanceFieldEmSize;
+        return &iDistanceFieldGlyphs.try_emplace(aGlyph, 
+            *sharedGlyph.texture, 
+            sharedGlyph.texture->extents() * scale, 
+            false, 
+            sharedGlyph.placement * scale, 
+            glyph_pixel_mode::Gray).first->second;
+    }
+
     void native_font_face::set_metrics()
     {
         auto const size = ((style() & (font_style::Superscript | font_style::Subscript)) == font_style::Invalid) ? iSize : iSize * 0.58;
@@ -466,7 +499,17 @@ namespace neogfx
                 }
             }
             freetypeCheck(FT_Select_Size(iHandle.freetypeFace, strikeIndex));
+            iRasterizerFace.strikeIndex = strikeIndex;
         }
+        iRasterizerFace.dataOwner = iData;
+        iRasterizerFace.data = iHandle.freetypeFace->stream->base; // null unless the face was opened from memory
+        iRasterizerFace.dataSize = static_cast<FT_Long>(iHandle.freetypeFace->stream->size);
+        iRasterizerFace.faceIndex = iHandle.freetypeFace->face_index;
+        iRasterizerFace.charSize = static_cast<FT_F26Dot6>(size * 64);
+        iRasterizerFace.horizontalDpi = static_cast<FT_UInt>(iPixelDensityDpi.cx);
+        iRasterizerFace.verticalDpi = static_cast<FT_UInt>(iPixelDensityDpi.cy);
+        iRasterizerFace.embolden = (style() & (font_style::EmulatedBold)) == font_style::EmulatedBold ?
+            static_cast<FT_F26Dot6>(default_dpi_scale_factor(iPixelDensityDpi.cx) * 64) : 0;
         if (iMetrics == std::nullopt)
             iMetrics.emplace(iHandle.freetypeFace->size->metrics);
         for (const FT_CharMap* cm = iHandle.freetypeFace->charmaps; cm != iHandle.freetypeFace->charmaps + iHandle.freetypeFace->num_charmaps; ++cm)
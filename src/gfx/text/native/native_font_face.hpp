@@ -21,6 +21,8 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
+#include <mutex>
+#include <memory>
 #include <boost/functional/hash.hpp>
 #include <boost/pool/pool_alloc.hpp>
 #include <ft2build.h>
@@ -40,7 +42,9 @@
 #include <neogfx/core/geometrical.hpp>
 #include <neogfx/hid/i_surface.hpp>
 #include <neogfx/gfx/text/font.hpp>
+#include <neogfx/gfx/text/glyph_cache.hpp>
 #include "glyph_texture.hpp"
+#include "glyph_rasterizer.hpp"
 #include "i_native_font.hpp"
 #include "i_native_font_face.hpp"
 
@@ -80,7 +84,6 @@ namespace neogfx
         hb_face_t* harfbuzzFace;
         hb_font_t* harfbuzzFont;
         hb_font_funcs_t* harfbuzzFontFuncs;
-        hb_buffer_t* harfbuzzBuf;
         hb_unicode_funcs_t* harfbuzzUnicodeFuncs;
         font_face_handle(native_font_face& aOwner,  FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace) :
             owner{ aOwner },
@@ -88,24 +91,23 @@ namespace neogfx
             harfbuzzFace{ aHarfbuzzFace },
             harfbuzzFont{ hb_font_create_sub_font(hb_font_create(aHarfbuzzFace)) },
             harfbuzzFontFuncs{ hb_font_funcs_create() },
-            harfbuzzBuf{ hb_buffer_create() },
-            harfbuzzUnicodeFuncs{ hb_buffer_get_unicode_funcs(harfbuzzBuf) }
+            harfbuzzUnicodeFuncs{ hb_unicode_funcs_get_default() }
         {
             hb_font_funcs_set_glyph_h_kerning_func(harfbuzzFontFuncs, hb_kerning_func, this, nullptr);
             hb_font_set_funcs(harfbuzzFont, harfbuzzFontFuncs, nullptr, nullptr);
         }
         ~font_face_handle()
         {
-            hb_buffer_destroy(harfbuzzBuf);
             hb_font_funcs_destroy(harfbuzzFontFuncs);
             hb_font_destroy(harfbuzzFont);
         }
     };
 
-    class native_font_face : public neolib::reference_counted<i_native_font_face>
+    class native_font_face : public neolib::reference_counted<i_native_font_face>, public i_glyph_cache_owner
     {
     private:
-        typedef std::unordered_map<glyph_index_t, neogfx::glyph_texture> glyph_map;
+        // keyed by texture_key() as sub-pixel and grayscale textures of a glyph are cached separately
+        typedef std::unordered_map<glyph_index_t, std::pair<neogfx::glyph_texture, neogfx::glyph_cache::handle>> glyph_map;
         typedef std::pair<glyph_index_t, glyph_index_t> kerning_pair;
         typedef std::unordered_map<kerning_pair, dimension, boost::hash<kerning_pair>, std::equal_to<kerning_pair>,
             boost::fast_pool_allocator<std::pair<const kerning_pair, dimension>>> kerning_table;
@@ -113,7 +115,7 @@ namespace neogfx
         struct freetype_load_glyph_error : freetype_error { freetype_load_glyph_error(std::string const& aError) : freetype_error(aError) {} };
         struct freetype_render_glyph_error : freetype_error { freetype_render_glyph_error(std::string const& aError) : freetype_error(aError) {} };
     public:
-        native_font_face(FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace);
+        native_font_face(FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace, std::shared_ptr<void const> aData);
         ~native_font_face();
     public:
         font_id id() const final;
@@ -141,9 +143,22 @@ namespace neogfx
         i_native_font_face& fallback() const final;
         void* handle() const final;
         glyph_index_t glyph_index(char32_t aCodePoint) const final;
+        void request_glyph_texture(const glyph& aGlyph) const final;
         i_glyph_texture& glyph_texture(const glyph& aGlyph) const final;
+        void glyph_texture_drawn(const glyph& aGlyph) const final;
+    public:
+        i_glyph_texture& upload_glyph(glyph_index_t aGlyph, bool aSubpixel, rasterized_glyph const& aRasterizedGlyph) const;
+        void evict_glyph(uint32_t aTextureKey) const final;
     private:
+        static constexpr glyph_index_t SubpixelTextureKey = 0x80000000u; // FreeType glyph indices never reach the top bit
+        static glyph_index_t texture_key(glyph_index_t aGlyph, bool aSubpixel);
+        neogfx::glyph_cache& glyph_cache() const;
+        neogfx::glyph_rasterizer& glyph_rasterizer() const;
         i_glyph_texture& invalid_glyph() const;
+        i_glyph_texture& placeholder_glyph() const;
+        bool distance_field() const;
+        dimension pixel_size() const;
+        i_glyph_texture* distance_field_glyph_texture(glyph_index_t aGlyph) const;
         void set_metrics();
     private:
         FT_Library iFontLib;
@@ -153,15 +168,22 @@ namespace neogfx
         string iStyleName;
         font::point_size iSize;
         neogfx::size iPixelDensityDpi;
+        std::shared_ptr<void const> iData; // the font data iHandle's FreeType face reads from
         mutable font_face_handle iHandle;
         std::optional<FT_Size_Metrics> iMetrics;
         mutable ref_ptr<i_native_font_face> iFallbackFont;
         mutable glyph_map iGlyphs;
+        mutable neogfx::glyph_cache* iGlyphCache = nullptr;
+        mutable neogfx::glyph_rasterizer* iGlyphRasterizer = nullptr;
+        rasterizer_face iRasterizerFace = {};
         bool iHasKerning = false;
         neogfx::kerning_method iKerningMethod = neogfx::kerning_method::Harfbuzz;
         mutable kerning_table iKerningTable;
+        mutable std::mutex iKerningMutex; // HarfBuzz may ask for kerning from several shaping threads at once
         mutable std::optional<bool> iHasFallback;
         mutable std::optional<neogfx::glyph_texture> iInvalidGlyph;
+        mutable std::optional<neogfx::glyph_texture> iPlaceholderGlyph;
+        mutable std::unordered_map<glyph_index_t, neogfx::glyph_texture> iDistanceFieldGlyphs;
     };
 
     bool kerning_enabled();
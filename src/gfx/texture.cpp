@@ -222,6 +222,9 @@ namespace neogfx
     {
         if (is_empty())
             throw texture_empty();
+        // follow the atlas page rather than the cached one as a repack replaces the page's native texture
+        if (iSubTexture != std::nullopt)
+            return iSubTexture->native_texture();
         return *iNativeTexture;
     }
 }
\ No newline at end of file
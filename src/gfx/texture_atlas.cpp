@@ -20,8 +20,10 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <thread>
 #include <neogfx/gfx/texture_atlas.hpp>
 #include <neogfx/gfx/image.hpp>
+#include <neogfx/gfx/graphics_context.hpp>
 
 namespace neogfx
 {
@@ -77,16 +79,66 @@ namespace neogfx
 
     void texture_atlas::destroy_sub_texture(i_sub_texture& aSubTexture)
     {
+        complete_repacks();
         auto iterEntry = iEntries.find(aSubTexture.atlas_id());
         if (iterEntry == iEntries.end() || &aSubTexture != &iterEntry->second.second)
             throw sub_texture_not_found();
-        auto rectEntry = iterEntry->second.second.atlas_location();
-        auto space = iterEntry->second.first->second.used.find(rectEntry);
-        if (space != iterEntry->second.first->second.used.end())
-            iterEntry->second.first->second.used.erase(space);
-        iterEntry->second.first->second.freed.insert(rectEntry);
+        auto const iterPage = iterEntry->second.first;
+        auto const& location = iterEntry->second.second.atlas_location();
+        iterPage->second.remove(rect{ location.position() - point{ 1.0, 1.0 }, location.extents() + size{ 2.0, 2.0 } });
         iTextureManager.remove_sub_texture(aSubTexture);
         iEntries.erase(iterEntry);
+        if (iterPage->second.subTextures == 0u && iPages.size() > 1u)
+            destroy_page(iterPage);
+    }
+
+    std::size_t texture_atlas::page_count() const
+    {
+        return iPages.size();
+    }
+
+    atlas_page_statistics texture_atlas::page_statistics(std::size_t aPageIndex) const
+    {
+        auto const& fragments = page(aPageIndex)->second;
+        return atlas_page_statistics{ page_size(), fragments.pack.used_area(), fragments.subTextures, fragments.pack.free_rect_count() };
+    }
+
+    void texture_atlas::repack_page(std::size_t aPageIndex)
+    {
+        complete_repacks();
+        auto const iterPage = page(aPageIndex);
+        for (auto const& pending : iPendingRepacks)
+            if (pending.page == iterPage)
+                return;
+        std::vector<texture_id> ids;
+        std::vector<size> elements;
+        ids.reserve(iterPage->second.subTextures);
+        elements.reserve(iterPage->second.subTextures);
+        for (auto const& e : iEntries)
+            if (e.second.first == iterPage)
+            {
+                ids.push_back(e.first);
+                elements.push_back(e.second.second.atlas_location().extents() + size{ 2.0, 2.0 });
+            }
+        // run on a detached thread rather than std::async so that dropping the future (when the page is destroyed)
+        // never waits for the layout to finish
+        auto cancelled = std::make_shared<std::atomic<bool>>(false);
+        std::packaged_task<std::optional<repack_layout>()> task{ 
+            [pageSize = page_size(), ids = std::move(ids), elements = std::move(elements), cancelled]() -> std::optional<repack_layout>
+            {
+                if (*cancelled)
+                    return {};
+                repack_layout result{ rect_pack{ pageSize } };
+                std::vector<rect> spaces;
+                if (!result.pack.insert(elements, spaces))
+                    return {};
+                result.spaces.reserve(spaces.size());
+                for (std::size_t element = 0u; element < spaces.size(); ++element)
+                    result.spaces.emplace_back(ids[element], spaces[element]);
+                return result;
+            } };
+        iPendingRepacks.push_back(pending_repack{ iterPage, iterPage->second.generation, cancelled, task.get_future() });
+        std::thread{ std::move(task) }.detach();
     }
 
     const size& texture_atlas::page_size() const
@@ -94,13 +146,38 @@ namespace neogfx
         return iPageSize;
     }
 
+    texture_atlas::pages::const_iterator texture_atlas::page(std::size_t aPageIndex) const
+    {
+        if (aPageIndex >= iPages.size())
+            throw page_not_found();
+        return std::next(iPages.begin(), aPageIndex);
+    }
+
+    texture_atlas::pages::iterator texture_atlas::page(std::size_t aPageIndex)
+    {
+        if (aPageIndex >= iPages.size())
+            throw page_not_found();
+        return std::next(iPages.begin(), aPageIndex);
+    }
+
     texture_atlas::pages::iterator texture_atlas::create_page(dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat)
     {
         return iPages.insert(iPages.end(), page{ texture{ page_size(), aDpiScaleFactor, aSampling, aDataFormat }, fragments{ page_size() } });
     }
 
+    void texture_atlas::destroy_page(pages::iterator aPage)
+    {
+        for (auto& pending : iPendingRepacks)
+            if (pending.page == aPage)
+                *pending.cancelled = true;
+        iPendingRepacks.erase(std::remove_if(iPendingRepacks.begin(), iPendingRepacks.end(), 
+            [aPage](pending_repack const& aPending) { return aPending.page == aPage; }), iPendingRepacks.end());
+        iPages.erase(aPage);
+    }
+
     std::pair<texture_atlas::pages::iterator, rect> texture_atlas::allocate_space(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat)
     {
+        complete_repacks();
         if (iPages.empty())
             create_page(aDpiScaleFactor, aSampling, aDataFormat);
         rect result;
@@ -113,4 +190,45 @@ namespace neogfx
         iPages.erase(iterPage);
         throw texture_too_big_for_atlas();
     }
+
+    void texture_atlas::complete_repacks()
+    {
+        for (auto pending = iPendingRepacks.begin(); pending != iPendingRepacks.end();)
+        {
+            if (pending->layout.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+            {
+                ++pending;
+                continue;
+            }
+            auto layout = pending->layout.get();
+            // a layout computed for a set of sub-textures that has since changed is stale
+            if (layout != std::nullopt && pending->generation == pending->page->second.generation)
+                apply_repack(pending->page, *layout);
+            pending = iPendingRepacks.erase(pending);
+        }
+    }
+
+    void texture_atlas::apply_repack(pages::iterator aPage, repack_layout& aLayout)
+    {
+        auto& pageTexture = aPage->first;
+        texture repacked{ page_size(), pageTexture.dpi_scale_factor(), pageTexture.sampling(), pageTexture.data_format(), pageTexture.data_type(), pageTexture.color_space(), color{} };
+        {
+            graphics_context gc{ repacked, graphics_context::type::Unattached };
+            // atlas locations are in texture space so copy in the orientation set_pixels uses
+            gc.set_logical_coordinate_system(logical_coordinate_system::AutomaticGame);
+            scoped_blending_mode sbm{ gc, neogfx::blending_mode::None };
+            for (auto const& space : aLayout.spaces)
+                gc.draw_texture(
+                    rect{ space.second.position() + point{ 1.0, 1.0 }, space.second.extents() + size{ -2.0, -2.0 } },
+                    pageTexture,
+                    iEntries.find(space.first)->second.second.atlas_location());
+            gc.flush();
+        }
+        // sub-textures hold a pointer to the page's texture object so assigning it moves them all across
+        pageTexture = repacked;
+        aPage->second.pack = std::move(aLayout.pack);
+        for (auto const& space : aLayout.spaces)
+            iEntries.find(space.first)->second.second.set_atlas_location(
+                rect{ space.second.position() + point{ 1.0, 1.0 }, space.second.extents() + size{ -2.0, -2.0 } });
+    }
 }
\ No newline at end of file
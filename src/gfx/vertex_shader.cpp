@@ -31,6 +31,10 @@ namespace neogfx
         add_out_variable<vec3f>("Coord"_s, 0u).link(coord);
         add_out_variable<vec4f>("Color"_s, 1u).link(color);
         add_out_variable<vec4f>("Function"_s, 3u).link(function);
+        add_attribute("InstanceTransformation"_s, 4u, shader_data_type::Mat4); // locations 4 to 7
+        add_attribute("InstanceColor"_s, 8u, shader_data_type::Vec4);
+        add_attribute("InstanceTextureRect"_s, 9u, shader_data_type::Vec4);
+        uInstanced = false;
     }
 
     bool standard_vertex_shader::has_standard_vertex_matrices() const
@@ -66,6 +70,11 @@ namespace neogfx
         }
     }
 
+    void standard_vertex_shader::set_instanced(bool aInstanced)
+    {
+        uInstanced = aInstanced;
+    }
+
     void standard_vertex_shader::prepare_uniforms(const i_rendering_context& aContext, i_shader_program&)
     {
         if (iProjectionMatrix == std::nullopt)
@@ -114,6 +123,11 @@ namespace neogfx
             {
                 "void standard_vertex_shader(inout vec3 coord, inout vec4 color)\n"
                 "{\n"
+                "    if (uInstanced)\n"
+                "    {\n"
+                "        coord = (InstanceTransformation * vec4(coord, 1.0)).xyz;\n"
+                "        color = color * InstanceColor;\n"
+                "    }\n"
                 "    gl_Position = vec4((uProjectionMatrix * (uTransformationMatrix * vec4(coord, 1.0))).xyz, 1.0);\n"
                 "}\n"_s
             };
@@ -140,6 +154,8 @@ namespace neogfx
                 "void standard_texture_vertex_shader(inout vec3 coord, inout vec4 color, inout vec2 texCoord, inout vec4 function)\n"
                 "{\n"
                 "    standard_vertex_shader(coord, color);\n"
+                "    if (uInstanced)\n"
+                "        texCoord = texCoord * InstanceTextureRect.xy + InstanceTextureRect.zw;\n"
                 "}\n"_s
             };
             aOutput += code;
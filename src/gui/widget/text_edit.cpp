@@ -2018,22 +2018,14 @@ namespace neogfx
         iCharacterToParagraphCacheLastAccess.reset();
         iGlyphToParagraphCache.clear();
         iGlyphToParagraphCacheLastAccess.reset();
-        std::u32string paragraphBuffer;
+        // paragraphs are independent so are shaped together, which lets the glyph text factory spread them over several threads
+        std::u32string const documentBuffer{ iText.begin(), iText.end() };
+        std::vector<std::u32string_view> paragraphs;
+        std::vector<std::size_t> paragraphStarts;
+        std::vector<neolib::vecarray<std::u32string::size_type, 16, -1>> paragraphColumnDelimiters;
         auto nextParagraph = iText.begin();
         auto iterColumn = iGlyphColumns.begin();
         neolib::vecarray<std::u32string::size_type, 16, -1> columnDelimiters;
-        auto fs = [this, &nextParagraph, &columnDelimiters](std::u32string::size_type aSourceIndex)
-        {
-            auto const& tagStyle = iText.tag(nextParagraph + aSourceIndex).style();
-            std::size_t indexColumn = std::lower_bound(columnDelimiters.begin(), columnDelimiters.end(), aSourceIndex) - columnDelimiters.begin();
-            if (indexColumn > columns() - 1)
-                indexColumn = columns() - 1;
-            auto const& columnStyle = column_style(indexColumn);
-            auto const& style =
-                std::holds_alternative<style_list::const_iterator>(tagStyle) ? *static_variant_cast<style_list::const_iterator>(tagStyle) :
-                columnStyle.character().font() != std::nullopt ? columnStyle : iDefaultStyle;
-            return style.character().font() != std::nullopt ? *style.character().font() : font();
-        };
         for (auto iterChar = iText.begin(); iterChar != iText.end(); ++iterChar)
         {
             auto& column = *(iterColumn);
@@ -2047,27 +2039,47 @@ namespace neogfx
             bool newParagraph = (ch == U'\n');
             if (newParagraph || iterChar == iText.end() - 1)
             {
-                paragraphBuffer.assign(nextParagraph, iterChar + 1);
-                auto gt = gc.to_glyph_text(paragraphBuffer.begin(), paragraphBuffer.end(), fs);
-                if (gt.cbegin() != gt.cend())
-                {
-                    auto paragraphGlyphs = glyphs().container().insert(glyphs().container().end(), gt.cbegin(), gt.cend());
-                    for (auto& newGlyph : gt)
-                        glyphs().cache_glyph_font(newGlyph.font);
-                    auto paragraph = iGlyphParagraphs.insert(iGlyphParagraphs.end(),
-                        std::make_pair(
-                            glyph_paragraph{ *this },
-                            glyph_paragraph_index{
-                                static_cast<std::size_t>((iterChar + 1) - iText.begin()) - static_cast<std::size_t>(nextParagraph - iText.begin()),
-                                glyphs().size() - static_cast<std::size_t>(paragraphGlyphs - glyphs().container().begin()) }),
-                                glyph_paragraphs::skip_type{ glyph_paragraph_index{}, glyph_paragraph_index{} });
-                    paragraph->first.set_self(paragraph);
-                    paragraph->first.set_line_breaks(gt.content().line_breaks());
-                }
+                auto const paragraphStart = static_cast<std::size_t>(nextParagraph - iText.begin());
+                paragraphs.emplace_back(documentBuffer.data() + paragraphStart, static_cast<std::size_t>((iterChar + 1) - nextParagraph));
+                paragraphStarts.push_back(paragraphStart);
+                paragraphColumnDelimiters.push_back(columnDelimiters);
                 nextParagraph = iterChar + 1;
                 columnDelimiters.clear();
             }
         }
+        auto fs = [this, &paragraphStarts, &paragraphColumnDelimiters](std::size_t aParagraph, std::u32string::size_type aSourceIndex)
+        {
+            auto const& tagStyle = iText.tag(iText.begin() + paragraphStarts[aParagraph] + aSourceIndex).style();
+            auto const& delimiters = paragraphColumnDelimiters[aParagraph];
+            std::size_t indexColumn = std::lower_bound(delimiters.begin(), delimiters.end(), aSourceIndex) - delimiters.begin();
+            if (indexColumn > columns() - 1)
+                indexColumn = columns() - 1;
+            auto const& columnStyle = column_style(indexColumn);
+            auto const& style =
+                std::holds_alternative<style_list::const_iterator>(tagStyle) ? *static_variant_cast<style_list::const_iterator>(tagStyle) :
+                columnStyle.character().font() != std::nullopt ? columnStyle : iDefaultStyle;
+            return style.character().font() != std::nullopt ? *style.character().font() : font();
+        };
+        auto paragraphGlyphTexts = service<i_font_manager>().glyph_text_factory().to_glyph_text(gc, paragraphs, fs);
+        for (std::size_t p = 0; p < paragraphs.size(); ++p)
+        {
+            auto& gt = paragraphGlyphTexts[p];
+            if (gt.cbegin() != gt.cend())
+            {
+                auto paragraphGlyphs = glyphs().container().insert(glyphs().container().end(), gt.cbegin(), gt.cend());
+                for (auto& newGlyph : gt)
+                    glyphs().cache_glyph_font(newGlyph.font);
+                auto paragraph = iGlyphParagraphs.insert(iGlyphParagraphs.end(),
+                    std::make_pair(
+                        glyph_paragraph{ *this },
+                        glyph_paragraph_index{
+                            paragraphs[p].size(),
+                            glyphs().size() - static_cast<std::size_t>(paragraphGlyphs - glyphs().container().begin()) }),
+                            glyph_paragraphs::skip_type{ glyph_paragraph_index{}, glyph_paragraph_index{} });
+                paragraph->first.set_self(paragraph);
+                paragraph->first.set_line_breaks(gt.content().line_breaks());
+            }
+        }
         for (auto p = iGlyphParagraphs.begin(); p != iGlyphParagraphs.end(); ++p)
         {
             auto& paragraph = *p;
@@ -28,6 +28,7 @@
 #include <neogfx/hid/i_surface_manager.hpp>
 #include <neogfx/hid/i_surface_window.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
 #include "opengl_window.hpp"
 #include "../../../gfx/native/opengl_helpers.hpp"
 #include "../../../gfx/native/opengl_texture.hpp"
@@ -317,6 +318,10 @@ namespace neogfx
 
         scoped_render_target srt{ *this };
 
+        service<i_font_manager>().upload_rasterized_glyphs();
+        service<i_rendering_engine>().texture_manager().flush_uploads();
+        auto const placeholderGlyphs = service<i_font_manager>().placeholder_glyphs_issued();
+
         if (iFrameBufferExtents.cx < static_cast<double>(extents().cx) || iFrameBufferExtents.cy < static_cast<double>(extents().cy))
         {
             if (iFrameBufferExtents != size{})
@@ -365,6 +370,10 @@ namespace neogfx
         iRendering = false;
         validate();
 
+        // glyphs drawn as placeholders will be ready for a later frame
+        if (service<i_font_manager>().placeholder_glyphs_issued() != placeholderGlyphs)
+            invalidate(rect{ point{}, extents() });
+
         surface_window().rendering_finished().trigger();
 
         iFpsData.push_back(frame_times{ *iLastFrameTime, std::chrono::high_resolution_clock::now() });
@@ -0,0 +1,84 @@
+// entity_draw_lists.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <neolib/ecs/ecs.hpp>
+#include <neogfx/game/entity_draw_lists.hpp>
+#include <neogfx/game/renderable_entity_archetype.hpp>
+#include <neogfx/game/mesh_renderer.hpp>
+#include <neogfx/game/mesh_filter.hpp>
+#include <neogfx/game/rigid_body.hpp>
+#include <neogfx/game/mesh_render_cache.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    ng::game::renderable_entity_archetype const drawListEntity{ "DrawListEntity", { ng::game::mesh_renderer::meta::id() } };
+
+    // a plain ECS is used as the draw lists do not need a rendering engine
+    struct draw_list_fixture
+    {
+        neolib::ecs::ecs ecs{ ng::game::ecs_flags::Default };
+        ng::game::entity_draw_lists drawLists{ ecs };
+
+        ng::game::entity_draw_lists::entry const& entry(ng::game::entity_id aEntity)
+        {
+            for (auto const& e : drawLists.layer(0))
+                if (e.entity == aEntity)
+                    return e;
+            throw std::logic_error("entity not in draw list");
+        }
+    };
+}
+
+NEOGFX_TEST(entity_draw_lists_pick_up_components_attached_after_add)
+{
+    draw_list_fixture fixture;
+    auto const entity = fixture.ecs.create_entity(drawListEntity, ng::game::mesh_renderer{});
+    ng::game::scoped_component_lock<ng::game::mesh_render_cache> lock{ fixture.ecs };
+    fixture.drawLists.update();
+    NEOGFX_CHECK(!fixture.entry(entity).hasMeshFilter);
+    NEOGFX_CHECK(!fixture.entry(entity).hasRigidBody);
+    // mirrors game::shape::text which fills in its mesh and is then given a rigid body by its owner
+    fixture.ecs.populate(entity, ng::game::mesh_filter{});
+    fixture.ecs.populate(entity, ng::game::rigid_body{});
+    fixture.drawLists.update();
+    NEOGFX_CHECK(fixture.entry(entity).hasMeshFilter);
+    NEOGFX_CHECK(fixture.entry(entity).hasRigidBody);
+    NEOGFX_CHECK(!fixture.entry(entity).hasAnimationFilter);
+    NEOGFX_CHECK(fixture.drawLists.layer(0).size() == 1u);
+}
+
+NEOGFX_TEST(entity_draw_lists_drop_stale_bounds_when_components_change)
+{
+    draw_list_fixture fixture;
+    auto const entity = fixture.ecs.create_entity(drawListEntity, ng::game::mesh_renderer{}, ng::game::mesh_filter{});
+    ng::game::scoped_component_lock<ng::game::mesh_render_cache> lock{ fixture.ecs };
+    fixture.drawLists.update();
+    fixture.drawLists.layer(0)[0].bounds = ng::aabb_2d{ ng::vec2{ 0.0, 0.0 }, ng::vec2{ 1.0, 1.0 } };
+    fixture.drawLists.update();
+    NEOGFX_CHECK(fixture.entry(entity).bounds != std::nullopt);
+    // a rigid body moves the entity so bounds computed without it can no longer be used for culling
+    fixture.ecs.populate(entity, ng::game::rigid_body{});
+    fixture.drawLists.update();
+    NEOGFX_CHECK(fixture.entry(entity).hasRigidBody);
+    NEOGFX_CHECK(fixture.entry(entity).bounds == std::nullopt);
+}
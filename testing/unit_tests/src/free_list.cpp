@@ -0,0 +1,86 @@
+// free_list.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <neogfx/gfx/free_list.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+NEOGFX_TEST(free_list_coalesces_adjacent_blocks)
+{
+    ng::free_list freeList;
+    std::size_t const top = 100u;
+    NEOGFX_CHECK(freeList.release(10u, 20u, top) == top);
+    NEOGFX_CHECK(freeList.release(30u, 40u, top) == top);
+    NEOGFX_CHECK(freeList.free_blocks() == 2u);
+    NEOGFX_CHECK(freeList.coalesces() == 0u);
+    // fills the gap so merges with both neighbours
+    NEOGFX_CHECK(freeList.release(20u, 30u, top) == top);
+    NEOGFX_CHECK(freeList.free_blocks() == 1u);
+    NEOGFX_CHECK(freeList.free_elements() == 30u);
+    NEOGFX_CHECK(freeList.largest_block() == 30u);
+    NEOGFX_CHECK(freeList.coalesces() == 2u);
+    NEOGFX_CHECK(freeList.allocate(30u) == std::optional<std::size_t>{ 10u });
+    NEOGFX_CHECK(freeList.free_blocks() == 0u && freeList.free_elements() == 0u);
+}
+
+NEOGFX_TEST(free_list_returns_trailing_space_to_top)
+{
+    ng::free_list freeList;
+    NEOGFX_CHECK(freeList.release(40u, 50u, 100u) == 100u);
+    // ends at the top so is given back rather than kept, taking the adjacent free block with it
+    NEOGFX_CHECK(freeList.release(50u, 100u, 100u) == 40u);
+    NEOGFX_CHECK(freeList.free_blocks() == 0u && freeList.free_elements() == 0u);
+    NEOGFX_CHECK(freeList.release(0u, 0u, 40u) == 40u);
+}
+
+NEOGFX_TEST(free_list_allocates_best_fit_and_splits)
+{
+    ng::free_list freeList;
+    std::size_t const top = 1000u;
+    freeList.release(0u, 100u, top);     // 100
+    freeList.release(200u, 212u, top);   // 12
+    freeList.release(300u, 310u, top);   // 10
+    // the smallest block that fits, not the first
+    NEOGFX_CHECK(freeList.allocate(10u) == std::optional<std::size_t>{ 300u });
+    NEOGFX_CHECK(freeList.allocate(11u) == std::optional<std::size_t>{ 200u });
+    NEOGFX_CHECK(freeList.free_blocks() == 2u);
+    NEOGFX_CHECK(freeList.free_elements() == 101u);
+    NEOGFX_CHECK(freeList.allocate(60u) == std::optional<std::size_t>{ 0u });
+    NEOGFX_CHECK(freeList.allocate(50u) == std::nullopt);
+    NEOGFX_CHECK(freeList.allocate(40u) == std::optional<std::size_t>{ 60u });
+    NEOGFX_CHECK(freeList.allocate(0u) == std::nullopt);
+    NEOGFX_CHECK(freeList.free_blocks() == 1u && freeList.largest_block() == 1u);
+}
+
+NEOGFX_TEST(free_list_churn_keeps_totals_consistent)
+{
+    ng::free_list freeList;
+    std::size_t top = 64u * 16u;
+    // free every other 16-element block then the rest; everything coalesces back into the top
+    for (std::size_t block = 0u; block < 64u; block += 2u)
+        top = freeList.release(block * 16u, block * 16u + 16u, top);
+    NEOGFX_CHECK(freeList.free_blocks() == 32u && freeList.free_elements() == 512u);
+    NEOGFX_CHECK(freeList.largest_block() == 16u);
+    for (std::size_t block = 1u; block < 64u; block += 2u)
+        top = freeList.release(block * 16u, block * 16u + 16u, top);
+    NEOGFX_CHECK(top == 0u);
+    NEOGFX_CHECK(freeList.free_blocks() == 0u && freeList.free_elements() == 0u);
+}
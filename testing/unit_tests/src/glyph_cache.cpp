@@ -0,0 +1,134 @@
+// glyph_cache.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <map>
+#include <vector>
+#include <neogfx/gfx/text/glyph_cache.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    // stands in for a font face: holds a handle per glyph and gives the glyph up when asked
+    class glyph_owner : public ng::i_glyph_cache_owner
+    {
+    public:
+        glyph_owner(ng::glyph_cache& aCache) :
+            iCache{ aCache }
+        {
+        }
+    public:
+        void add(uint32_t aGlyph, std::size_t aBytes)
+        {
+            iGlyphs[aGlyph] = iCache.add(*this, aGlyph, aBytes);
+        }
+        void draw(uint32_t aGlyph)
+        {
+            iCache.use(iGlyphs.at(aGlyph));
+        }
+        bool has(uint32_t aGlyph) const
+        {
+            return iGlyphs.find(aGlyph) != iGlyphs.end();
+        }
+        std::vector<uint32_t> const& evicted() const
+        {
+            return iEvicted;
+        }
+    public:
+        void evict_glyph(uint32_t aGlyph) const override
+        {
+            auto existing = iGlyphs.find(aGlyph);
+            iCache.remove(existing->second);
+            iGlyphs.erase(existing);
+            iEvicted.push_back(aGlyph);
+        }
+    private:
+        ng::glyph_cache& iCache;
+        mutable std::map<uint32_t, ng::glyph_cache::handle> iGlyphs;
+        mutable std::vector<uint32_t> iEvicted;
+    };
+}
+
+NEOGFX_TEST(glyph_cache_evicts_least_recently_drawn_first)
+{
+    ng::glyph_cache cache{ 300u };
+    glyph_owner owner{ cache };
+    owner.add(1u, 100u);
+    owner.add(2u, 100u);
+    owner.add(3u, 100u);
+    cache.next_frame();
+    owner.draw(1u);
+    cache.next_frame();
+    owner.add(4u, 100u);
+    NEOGFX_CHECK(owner.evicted() == std::vector<uint32_t>{ 2u });
+    owner.add(5u, 100u);
+    NEOGFX_CHECK((owner.evicted() == std::vector<uint32_t>{ 2u, 3u }));
+    NEOGFX_CHECK(owner.has(1u) && owner.has(4u) && owner.has(5u));
+    auto const statistics = cache.statistics();
+    NEOGFX_CHECK(statistics.bytes == 300u);
+    NEOGFX_CHECK(statistics.glyphs == 3u);
+    NEOGFX_CHECK(statistics.evictions == 2u);
+}
+
+NEOGFX_TEST(glyph_cache_protects_glyphs_drawn_this_frame)
+{
+    ng::glyph_cache cache{ 200u };
+    glyph_owner owner{ cache };
+    owner.add(1u, 100u);
+    owner.add(2u, 100u);
+    owner.add(3u, 100u);
+    // everything was added this frame so the cache may run over budget
+    NEOGFX_CHECK(owner.evicted().empty());
+    NEOGFX_CHECK(cache.statistics().bytes == 300u);
+    cache.next_frame();
+    NEOGFX_CHECK(owner.evicted() == std::vector<uint32_t>{ 1u });
+    NEOGFX_CHECK(cache.statistics().bytes == 200u);
+}
+
+NEOGFX_TEST(glyph_cache_lookups_do_not_stamp)
+{
+    ng::glyph_cache cache{ 200u };
+    glyph_owner owner{ cache };
+    owner.add(1u, 100u);
+    owner.add(2u, 100u);
+    cache.next_frame();
+    // a lookup that is not followed by a draw leaves the entry where it is
+    cache.hit();
+    owner.draw(2u);
+    owner.add(3u, 100u);
+    NEOGFX_CHECK(owner.evicted() == std::vector<uint32_t>{ 1u });
+    NEOGFX_CHECK(cache.statistics().hits == 1u);
+}
+
+NEOGFX_TEST(glyph_cache_shrinking_budget_evicts)
+{
+    ng::glyph_cache cache{ 1000u };
+    glyph_owner owner{ cache };
+    for (uint32_t glyph = 1u; glyph <= 5u; ++glyph)
+        owner.add(glyph, 100u);
+    cache.next_frame();
+    cache.set_budget(250u);
+    NEOGFX_CHECK((owner.evicted() == std::vector<uint32_t>{ 1u, 2u, 3u }));
+    NEOGFX_CHECK(cache.budget() == 250u);
+    cache.miss();
+    cache.miss();
+    NEOGFX_CHECK(cache.statistics().misses == 2u);
+}
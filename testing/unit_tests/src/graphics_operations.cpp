@@ -0,0 +1,107 @@
+// graphics_operations.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <vector>
+#include <neogfx/gfx/graphics_operations.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+namespace gop = neogfx::graphics_operation;
+
+namespace
+{
+    // operations are told apart by their x coordinate
+    gop::operation fill(ng::scalar aX, ng::scalar aY = 0.0)
+    {
+        return gop::fill_rect{ ng::rect{ ng::point{ aX, aY }, ng::size{ 10.0, 10.0 } }, ng::color::Red, 0.0 };
+    }
+
+    gop::operation line(ng::scalar aX, ng::scalar aY = 100.0)
+    {
+        return gop::draw_line{ ng::point{ aX, aY }, ng::point{ aX + 10.0, aY }, ng::pen{ ng::color::Blue, 1.0 } };
+    }
+
+    ng::scalar id(gop::operation const& aOperation)
+    {
+        if (std::holds_alternative<gop::fill_rect>(aOperation))
+            return std::get<gop::fill_rect>(aOperation).rect.x;
+        if (std::holds_alternative<gop::draw_line>(aOperation))
+            return std::get<gop::draw_line>(aOperation).from.x;
+        return -1.0;
+    }
+
+    std::vector<ng::scalar> ids(gop::queue const& aQueue)
+    {
+        std::vector<ng::scalar> result;
+        for (auto const& op : aQueue)
+            result.push_back(id(op));
+        return result;
+    }
+}
+
+NEOGFX_TEST(reorder_keeps_overlapping_operations_in_order)
+{
+    // the second fill overlaps the line so cannot be moved before it to join the first fill
+    gop::queue queue{ fill(0.0), line(20.0, 5.0), fill(25.0) };
+    NEOGFX_CHECK(gop::reorder_for_batching(queue) == 0u);
+    NEOGFX_CHECK((ids(queue) == std::vector<ng::scalar>{ 0.0, 20.0, 25.0 }));
+}
+
+NEOGFX_TEST(reorder_batches_non_overlapping_operations)
+{
+    gop::queue queue{ fill(0.0), line(0.0), fill(20.0), line(20.0), fill(40.0) };
+    NEOGFX_CHECK(gop::reorder_for_batching(queue) == 2u);
+    NEOGFX_CHECK((ids(queue) == std::vector<ng::scalar>{ 0.0, 20.0, 40.0, 0.0, 20.0 }));
+    for (std::size_t i = 0u; i < 3u; ++i)
+        NEOGFX_CHECK(std::holds_alternative<gop::fill_rect>(queue[i]));
+    for (std::size_t i = 3u; i < 5u; ++i)
+        NEOGFX_CHECK(std::holds_alternative<gop::draw_line>(queue[i]));
+}
+
+NEOGFX_TEST(reorder_is_stable_within_batches)
+{
+    gop::queue queue;
+    for (int i = 0; i < 8; ++i)
+    {
+        queue.push_back(fill(i * 20.0));
+        queue.push_back(line(i * 20.0));
+    }
+    gop::reorder_for_batching(queue);
+    std::vector<ng::scalar> fills;
+    std::vector<ng::scalar> lines;
+    for (auto const& op : queue)
+        (std::holds_alternative<gop::fill_rect>(op) ? fills : lines).push_back(id(op));
+    NEOGFX_CHECK(fills.size() == 8u && lines.size() == 8u);
+    NEOGFX_CHECK(std::is_sorted(fills.begin(), fills.end()));
+    NEOGFX_CHECK(std::is_sorted(lines.begin(), lines.end()));
+    // everything ends up in one batch of each kind
+    for (std::size_t i = 0u; i < 8u; ++i)
+        NEOGFX_CHECK(std::holds_alternative<gop::fill_rect>(queue[i]));
+}
+
+NEOGFX_TEST(reorder_does_not_cross_operations_without_bounds)
+{
+    NEOGFX_CHECK(gop::bounding_rect(gop::set_opacity{ 0.5 }) == std::nullopt);
+    gop::queue queue{ fill(0.0), line(0.0), gop::set_opacity{ 0.5 }, fill(20.0), line(20.0) };
+    NEOGFX_CHECK(gop::reorder_for_batching(queue) == 0u);
+    NEOGFX_CHECK((ids(queue) == std::vector<ng::scalar>{ 0.0, 0.0, -1.0, 20.0, 20.0 }));
+    NEOGFX_CHECK(std::holds_alternative<gop::set_opacity>(queue[2]));
+}
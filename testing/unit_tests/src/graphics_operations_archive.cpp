@@ -0,0 +1,306 @@
+// graphics_operations_archive.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <neogfx/gfx/graphics_operations_archive.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+namespace gop = neogfx::graphics_operation;
+
+namespace
+{
+    // Writes values in the archive's encoding so that archives of earlier versions can be built by hand.
+    class archive_builder
+    {
+    public:
+        template <typename T>
+        archive_builder& put(T const& aValue) requires(std::is_arithmetic_v<T>)
+        {
+            iData.append(reinterpret_cast<char const*>(&aValue), sizeof(T));
+            return *this;
+        }
+        template <typename T>
+        archive_builder& put(T const& aValue) requires(std::is_enum_v<T>)
+        {
+            return put(static_cast<std::underlying_type_t<T>>(aValue));
+        }
+        archive_builder& put(ng::point const& aValue)
+        {
+            return put(aValue.x).put(aValue.y);
+        }
+        archive_builder& put(ng::color const& aValue)
+        {
+            return put(aValue.red()).put(aValue.green()).put(aValue.blue()).put(aValue.alpha());
+        }
+        std::string const& data() const
+        {
+            return iData;
+        }
+    private:
+        std::string iData;
+    };
+
+    // A frame record holding one operation whose encoding is aOperation.
+    std::string frame_record(archive_builder const& aOperation)
+    {
+        archive_builder frame;
+        frame.put(ng::dimension{ 64.0 }).put(ng::dimension{ 32.0 });
+        frame.put(ng::logical_coordinate_system::AutomaticGui);
+        frame.put(uint32_t{ 1u });
+        archive_builder record;
+        record.put(uint8_t{ 0x04u }); // frame
+        record.put(static_cast<uint64_t>(frame.data().size() + aOperation.data().size()));
+        return record.data() + frame.data() + aOperation.data();
+    }
+
+    std::string header(uint32_t aVersion, uint32_t aMagic = gop::ArchiveMagic)
+    {
+        return archive_builder{}.put(aMagic).put(aVersion).data();
+    }
+
+    // A version 1 pen: colour, width and anti-aliasing only.
+    archive_builder& put_legacy_pen(archive_builder& aBuilder, ng::color const& aColor, ng::dimension aWidth)
+    {
+        return aBuilder.put(uint8_t{ 1u }).put(aColor).put(aWidth).put(true);
+    }
+
+    std::vector<gop::frame> read_archive(std::string const& aArchive, uint32_t& aVersion)
+    {
+        std::istringstream input{ aArchive };
+        gop::queue_reader reader{ input };
+        aVersion = reader.version();
+        return reader.read_all();
+    }
+
+    bool rejected(std::string const& aArchive)
+    {
+        uint32_t version = 0u;
+        try
+        {
+            read_archive(aArchive, version);
+        }
+        catch (gop::queue_reader::bad_archive const&)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+NEOGFX_TEST(archive_round_trips_current_version)
+{
+    ng::path triangle{ ng::path_shape::LineLoop };
+    triangle.move_to(0.0, 0.0);
+    triangle.line_to(10.0, 0.0);
+    triangle.line_to(5.0, 8.0);
+    gop::frame written;
+    written.extents = ng::size{ 640.0, 480.0 };
+    written.operations.push_back(gop::draw_line{ ng::point{ 1.0, 2.0 }, ng::point{ 3.0, 4.0 }, ng::pen{ ng::color{ 10, 20, 30, 40 }, 2.5 } });
+    written.operations.push_back(gop::draw_path{ triangle, ng::pen{ ng::color{ 50, 60, 70 }, 1.0 } });
+
+    std::stringstream archive;
+    {
+        gop::queue_writer writer{ archive };
+        writer.write(written);
+        writer.write(written);
+        NEOGFX_CHECK(writer.frames_written() == 2u);
+        NEOGFX_CHECK(writer.operations_skipped() == 0u);
+    }
+    uint32_t version = 0u;
+    auto const frames = read_archive(archive.str(), version);
+    NEOGFX_CHECK(version == gop::ArchiveVersion);
+    NEOGFX_CHECK(frames.size() == 2u);
+    for (auto const& frame : frames)
+    {
+        NEOGFX_CHECK(frame.extents == written.extents);
+        NEOGFX_CHECK(frame.logicalCoordinateSystem == written.logicalCoordinateSystem);
+        NEOGFX_CHECK(frame.operations.size() == 2u);
+        auto const& line = std::get<gop::draw_line>(frame.operations[0]);
+        NEOGFX_CHECK(line.from == (ng::point{ 1.0, 2.0 }) && line.to == (ng::point{ 3.0, 4.0 }));
+        NEOGFX_CHECK(std::get<ng::color>(line.pen.color()) == (ng::color{ 10, 20, 30, 40 }));
+        NEOGFX_CHECK(line.pen.width() == 2.5);
+        auto const& path = std::get<gop::draw_path>(frame.operations[1]).path;
+        NEOGFX_CHECK(path.shape() == ng::path_shape::LineLoop);
+        NEOGFX_CHECK(path.sub_paths().size() == 1u && path.sub_paths()[0].size() == 3u);
+        NEOGFX_CHECK(path.sub_paths()[0][2] == (ng::point{ 5.0, 8.0 }));
+    }
+}
+
+NEOGFX_TEST(archive_rejects_bad_header)
+{
+    uint32_t version = 0u;
+    bool rejected = false;
+    try
+    {
+        read_archive(header(gop::ArchiveVersion, 0x12345678u), version);
+    }
+    catch (gop::queue_reader::bad_archive const&)
+    {
+        rejected = true;
+    }
+    NEOGFX_CHECK(rejected);
+    rejected = false;
+    try
+    {
+        read_archive(header(gop::ArchiveVersion + 1u), version);
+    }
+    catch (gop::queue_reader::unsupported_version const&)
+    {
+        rejected = true;
+    }
+    NEOGFX_CHECK(rejected);
+    NEOGFX_CHECK(read_archive(header(gop::ArchiveVersion), version).empty());
+}
+
+NEOGFX_TEST(archive_reads_version_1)
+{
+    archive_builder operation;
+    operation.put(static_cast<uint8_t>(gop::operation_type::DrawLine));
+    operation.put(ng::point{ 1.0, 2.0 }).put(ng::point{ 3.0, 4.0 });
+    put_legacy_pen(operation, ng::color{ 1, 2, 3, 4 }, 3.0);
+    uint32_t version = 0u;
+    auto const frames = read_archive(header(1u) + frame_record(operation), version);
+    NEOGFX_CHECK(version == 1u);
+    NEOGFX_CHECK(frames.size() == 1u && frames[0].operations.size() == 1u);
+    NEOGFX_CHECK(frames[0].extents == (ng::size{ 64.0, 32.0 }));
+    auto const& line = std::get<gop::draw_line>(frames[0].operations[0]);
+    NEOGFX_CHECK(line.from == (ng::point{ 1.0, 2.0 }) && line.to == (ng::point{ 3.0, 4.0 }));
+    NEOGFX_CHECK(std::get<ng::color>(line.pen.color()) == (ng::color{ 1, 2, 3, 4 }));
+    NEOGFX_CHECK(line.pen.width() == 3.0 && line.pen.anti_aliased());
+}
+
+NEOGFX_TEST(archive_paths_record_fill_rule_from_version_2)
+{
+    auto const drawPath = [](bool aFillRule)
+    {
+        archive_builder operation;
+        operation.put(static_cast<uint8_t>(gop::operation_type::DrawPath));
+        operation.put(ng::path_shape::Polygon);
+        if (aFillRule)
+            operation.put(ng::fill_rule::EvenOdd);
+        operation.put(ng::point{ 5.0, 6.0 });
+        operation.put(uint32_t{ 1u }).put(uint32_t{ 3u });
+        operation.put(ng::point{ 0.0, 0.0 }).put(ng::point{ 4.0, 0.0 }).put(ng::point{ 0.0, 4.0 });
+        put_legacy_pen(operation, ng::color{ 9, 9, 9 }, 1.0);
+        return operation;
+    };
+    uint32_t version = 0u;
+    // version 1 paths have no fill rule so read as NonZero
+    auto const version1 = read_archive(header(1u) + frame_record(drawPath(false)), version);
+    NEOGFX_CHECK(version1.size() == 1u);
+    auto const& path1 = std::get<gop::draw_path>(version1[0].operations[0]).path;
+    NEOGFX_CHECK(path1.shape() == ng::path_shape::Polygon && path1.fill_rule() == ng::fill_rule::NonZero);
+    NEOGFX_CHECK(path1.position() == (ng::point{ 5.0, 6.0 }));
+    NEOGFX_CHECK(path1.sub_paths().size() == 1u && path1.sub_paths()[0].size() == 3u);
+    auto const version2 = read_archive(header(2u) + frame_record(drawPath(true)), version);
+    NEOGFX_CHECK(version == 2u && version2.size() == 1u);
+    auto const& path2 = std::get<gop::draw_path>(version2[0].operations[0]).path;
+    NEOGFX_CHECK(path2.fill_rule() == ng::fill_rule::EvenOdd);
+    NEOGFX_CHECK(path2.sub_paths()[0][1] == (ng::point{ 4.0, 0.0 }));
+
+    ng::path written{ ng::path_shape::Polygon };
+    written.set_fill_rule(ng::fill_rule::EvenOdd);
+    written.move_to(0.0, 0.0);
+    written.line_to(4.0, 0.0);
+    written.line_to(0.0, 4.0);
+    gop::frame frame;
+    frame.operations.push_back(gop::fill_path{ written, ng::color{ 1, 2, 3 } });
+    std::stringstream archive;
+    gop::queue_writer{ archive }.write(frame);
+    auto const current = read_archive(archive.str(), version);
+    NEOGFX_CHECK(current.size() == 1u);
+    NEOGFX_CHECK(std::get<gop::fill_path>(current[0].operations[0]).path.fill_rule() == ng::fill_rule::EvenOdd);
+}
+
+NEOGFX_TEST(archive_pens_record_join_and_cap_from_version_3)
+{
+    // a version 2 pen has no join, cap or miter limit so reads back with the pen defaults
+    archive_builder operation;
+    operation.put(static_cast<uint8_t>(gop::operation_type::DrawLine));
+    operation.put(ng::point{ 0.0, 0.0 }).put(ng::point{ 8.0, 0.0 });
+    put_legacy_pen(operation, ng::color{ 7, 7, 7 }, 2.0);
+    uint32_t version = 0u;
+    auto const version2 = read_archive(header(2u) + frame_record(operation), version);
+    NEOGFX_CHECK(version2.size() == 1u);
+    auto const& legacyPen = std::get<gop::draw_line>(version2[0].operations[0]).pen;
+    ng::pen const defaults;
+    NEOGFX_CHECK(legacyPen.line_join() == defaults.line_join());
+    NEOGFX_CHECK(legacyPen.line_cap() == defaults.line_cap());
+    NEOGFX_CHECK(legacyPen.miter_limit() == defaults.miter_limit());
+
+    ng::pen styled{ ng::color{ 7, 7, 7 }, 3.0 };
+    styled.set_line_join(ng::line_join::Round).set_line_cap(ng::line_cap::Butt).set_miter_limit(7.5);
+    gop::frame frame;
+    frame.operations.push_back(gop::draw_line{ ng::point{ 0.0, 0.0 }, ng::point{ 8.0, 0.0 }, styled });
+    std::stringstream archive;
+    gop::queue_writer{ archive }.write(frame);
+    auto const current = read_archive(archive.str(), version);
+    NEOGFX_CHECK(version >= 3u && current.size() == 1u);
+    auto const& pen = std::get<gop::draw_line>(current[0].operations[0]).pen;
+    NEOGFX_CHECK(pen.width() == 3.0);
+    NEOGFX_CHECK(pen.line_join() == ng::line_join::Round);
+    NEOGFX_CHECK(pen.line_cap() == ng::line_cap::Butt);
+    NEOGFX_CHECK(pen.miter_limit() == 7.5);
+}
+
+NEOGFX_TEST(archive_rejects_out_of_range_enumerators)
+{
+    // the same draw line is accepted with valid enumerators and rejected when exactly one of them is corrupt
+    auto const drawLine = [](uint8_t aOperation, ng::line_join aJoin, ng::line_cap aCap)
+    {
+        archive_builder operation;
+        operation.put(aOperation);
+        operation.put(ng::point{ 0.0, 0.0 }).put(ng::point{ 8.0, 0.0 });
+        put_legacy_pen(operation, ng::color{ 7, 7, 7 }, 2.0);
+        operation.put(aJoin).put(aCap).put(ng::scalar{ 4.0 });
+        return operation;
+    };
+    auto const drawLineType = static_cast<uint8_t>(gop::operation_type::DrawLine);
+    NEOGFX_CHECK(!rejected(header(3u) + frame_record(drawLine(drawLineType, ng::line_join::Bevel, ng::line_cap::Round))));
+    NEOGFX_CHECK(rejected(header(3u) + frame_record(drawLine(0xFFu, ng::line_join::Bevel, ng::line_cap::Round))));
+    NEOGFX_CHECK(rejected(header(3u) + frame_record(drawLine(drawLineType, static_cast<ng::line_join>(3u), ng::line_cap::Round))));
+    NEOGFX_CHECK(rejected(header(3u) + frame_record(drawLine(drawLineType, ng::line_join::Bevel, static_cast<ng::line_cap>(3u)))));
+
+    auto const drawPath = [](ng::path_shape aShape, ng::fill_rule aFillRule)
+    {
+        archive_builder operation;
+        operation.put(static_cast<uint8_t>(gop::operation_type::DrawPath));
+        operation.put(aShape).put(aFillRule);
+        operation.put(ng::point{ 0.0, 0.0 });
+        operation.put(uint32_t{ 0u });
+        put_legacy_pen(operation, ng::color{ 9, 9, 9 }, 1.0);
+        return operation;
+    };
+    NEOGFX_CHECK(!rejected(header(2u) + frame_record(drawPath(ng::path_shape::Polygon, ng::fill_rule::EvenOdd))));
+    NEOGFX_CHECK(rejected(header(2u) + frame_record(drawPath(static_cast<ng::path_shape>(7u), ng::fill_rule::EvenOdd))));
+    NEOGFX_CHECK(rejected(header(2u) + frame_record(drawPath(ng::path_shape::Polygon, static_cast<ng::fill_rule>(2u)))));
+
+    archive_builder setSystem;
+    setSystem.put(static_cast<uint8_t>(gop::operation_type::SetLogicalCoordinateSystem));
+    setSystem.put(ng::logical_coordinate_system::AutomaticGame);
+    NEOGFX_CHECK(!rejected(header(gop::ArchiveVersion) + frame_record(setSystem)));
+    archive_builder badSystem;
+    badSystem.put(static_cast<uint8_t>(gop::operation_type::SetLogicalCoordinateSystem));
+    badSystem.put(static_cast<ng::logical_coordinate_system>(-1));
+    NEOGFX_CHECK(rejected(header(gop::ArchiveVersion) + frame_record(badSystem)));
+}
@@ -0,0 +1,141 @@
+// image_blur.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <neogfx/gfx/image.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    // square images only: the sizing constructor fills rows by width
+    ng::image transparent_image(int32_t aExtent)
+    {
+        return ng::image{ ng::size{ static_cast<ng::dimension>(aExtent), static_cast<ng::dimension>(aExtent) }, ng::color{ 0, 0, 0, 0 } };
+    }
+
+    uint8_t const* pixel(ng::image const& aImage, int32_t aX, int32_t aY)
+    {
+        return static_cast<uint8_t const*>(aImage.cpixels()) + (static_cast<std::size_t>(aY) * static_cast<std::size_t>(aImage.extents().cx) + aX) * 4u;
+    }
+
+    uint8_t alpha(ng::image const& aImage, int32_t aX, int32_t aY)
+    {
+        return pixel(aImage, aX, aY)[3];
+    }
+
+    uint64_t total_alpha(ng::image const& aImage)
+    {
+        uint64_t result = 0u;
+        auto const extent = static_cast<int32_t>(aImage.extents().cx);
+        for (int32_t y = 0; y < extent; ++y)
+            for (int32_t x = 0; x < extent; ++x)
+                result += alpha(aImage, x, y);
+        return result;
+    }
+
+    bool within(int32_t aLhs, int32_t aRhs, int32_t aTolerance = 1)
+    {
+        return std::abs(aLhs - aRhs) <= aTolerance;
+    }
+}
+
+NEOGFX_TEST(blur_preserves_total_alpha)
+{
+    auto image = transparent_image(16);
+    for (int32_t y = 6; y < 10; ++y)
+        for (int32_t x = 6; x < 10; ++x)
+            image.set_pixel(ng::point{ static_cast<ng::coordinate>(x), static_cast<ng::coordinate>(y) }, ng::color::White);
+    auto const before = total_alpha(image);
+    image.blur(2.0);
+    auto const after = total_alpha(image);
+    // the block stays clear of the edges so only per-pixel rounding is lost
+    NEOGFX_CHECK(within(static_cast<int32_t>(after), static_cast<int32_t>(before), static_cast<int32_t>(before / 100u)));
+    NEOGFX_CHECK(alpha(image, 7, 7) < 255u);
+    NEOGFX_CHECK(alpha(image, 4, 7) > 0u);
+    NEOGFX_CHECK(alpha(image, 3, 7) == 0u);
+}
+
+NEOGFX_TEST(blur_impulse_is_symmetric)
+{
+    int32_t const centre = 7;
+    int32_t const radius = 3;
+    auto image = transparent_image(centre * 2 + 1);
+    image.set_pixel(ng::point{ static_cast<ng::coordinate>(centre), static_cast<ng::coordinate>(centre) }, ng::color{ 255, 0, 0, 255 });
+    image.blur(static_cast<ng::dimension>(radius));
+    NEOGFX_CHECK(alpha(image, centre, centre) < 255u);
+    for (int32_t dy = -radius; dy <= radius; ++dy)
+        for (int32_t dx = -radius; dx <= radius; ++dx)
+        {
+            auto const a = alpha(image, centre + dx, centre + dy);
+            NEOGFX_CHECK(within(a, alpha(image, centre - dx, centre + dy)));
+            NEOGFX_CHECK(within(a, alpha(image, centre + dx, centre - dy)));
+            NEOGFX_CHECK(within(a, alpha(image, centre + dy, centre + dx)));
+            // falls off with distance from the impulse
+            if (dx > 0)
+                NEOGFX_CHECK(a <= alpha(image, centre + dx - 1, centre + dy) + 1);
+            // colour is unpremultiplied back to the impulse's colour wherever there is coverage
+            if (a > 0u)
+                NEOGFX_CHECK(within(pixel(image, centre + dx, centre + dy)[0], 255) && pixel(image, centre + dx, centre + dy)[1] == 0u);
+        }
+    NEOGFX_CHECK(alpha(image, centre + radius + 1, centre) == 0u);
+}
+
+NEOGFX_TEST(blur_radius_zero_is_identity)
+{
+    auto image = transparent_image(8);
+    for (int32_t y = 0; y < 8; ++y)
+        for (int32_t x = 0; x < 8; ++x)
+            image.set_pixel(ng::point{ static_cast<ng::coordinate>(x), static_cast<ng::coordinate>(y) }, 
+                ng::color{ x * 32, y * 32, (x + y) * 16, 255 - (x ^ y) * 16 });
+    ng::image const original{ image };
+    image.blur(0.0);
+    bool same = true;
+    for (int32_t y = 0; y < 8; ++y)
+        for (int32_t x = 0; x < 8; ++x)
+            for (std::size_t channel = 0u; channel < 4u; ++channel)
+                same = same && pixel(image, x, y)[channel] == pixel(original, x, y)[channel];
+    NEOGFX_CHECK(same);
+}
+
+NEOGFX_TEST(blur_edges_fade_to_transparent)
+{
+    int32_t const extent = 12;
+    auto image = transparent_image(extent);
+    for (int32_t y = 0; y < extent; ++y)
+        for (int32_t x = 0; x < extent; ++x)
+            image.set_pixel(ng::point{ static_cast<ng::coordinate>(x), static_cast<ng::coordinate>(y) }, ng::color::White);
+    image.blur(3.0);
+    // the kernel only reaches past the edge for pixels within the radius of it
+    NEOGFX_CHECK(alpha(image, 6, 6) == 255u);
+    NEOGFX_CHECK(alpha(image, 3, 6) == 255u);
+    // outside the image is transparent, so edges lose coverage and corners lose it on both axes
+    auto const edge = alpha(image, 0, 6);
+    auto const corner = alpha(image, 0, 0);
+    NEOGFX_CHECK(edge < 255u && edge > 0u);
+    NEOGFX_CHECK(corner < edge && corner > 0u);
+    NEOGFX_CHECK(within(alpha(image, extent - 1, 6), edge));
+    NEOGFX_CHECK(within(alpha(image, 6, extent - 1), edge));
+    NEOGFX_CHECK(within(alpha(image, extent - 1, extent - 1), corner));
+    // premultiplied filtering keeps faded edge pixels white rather than darkening them
+    NEOGFX_CHECK(pixel(image, 0, 0)[0] == 255u && pixel(image, 0, 0)[1] == 255u && pixel(image, 0, 0)[2] == 255u);
+}
@@ -0,0 +1,49 @@
+// main.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <iostream>
+#include "unit_test.hpp"
+
+// Runs every registered test case, or those whose names contain the first argument, and reports the failures.
+// Usage: unit_tests [filter]
+
+int main(int argc, char* argv[])
+{
+    std::string const filter = argc > 1 ? argv[1] : "";
+    std::size_t run = 0u;
+    std::size_t failed = 0u;
+    for (auto const& testCase : neogfx::unit_tests::test_cases())
+    {
+        if (!filter.empty() && std::string{ testCase.name }.find(filter) == std::string::npos)
+            continue;
+        ++run;
+        try
+        {
+            testCase.function();
+        }
+        catch (std::exception& e)
+        {
+            ++failed;
+            std::cerr << testCase.name << ": " << e.what() << std::endl;
+        }
+    }
+    std::cout << run << " test(s) run, " << failed << " failed" << std::endl;
+    return failed == 0u ? EXIT_SUCCESS : EXIT_FAILURE;
+}
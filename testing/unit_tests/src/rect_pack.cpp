@@ -0,0 +1,174 @@
+// rect_pack.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <random>
+#include <algorithm>
+#include <neogfx/gfx/rect_pack.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    bool overlaps(ng::rect const& aLhs, ng::rect const& aRhs)
+    {
+        return aLhs.x < aRhs.x + aRhs.cx && aRhs.x < aLhs.x + aLhs.cx &&
+            aLhs.y < aRhs.y + aRhs.cy && aRhs.y < aLhs.y + aLhs.cy;
+    }
+
+    bool disjoint_and_inside(std::vector<ng::rect> const& aElements, ng::size const& aDimensions)
+    {
+        for (std::size_t i = 0u; i < aElements.size(); ++i)
+        {
+            auto const& e = aElements[i];
+            if (e.x < 0.0 || e.y < 0.0 || e.x + e.cx > aDimensions.cx || e.y + e.cy > aDimensions.cy)
+                return false;
+            for (std::size_t j = i + 1u; j < aElements.size(); ++j)
+                if (overlaps(e, aElements[j]))
+                    return false;
+        }
+        return true;
+    }
+
+    ng::size random_glyph(std::mt19937& aPrng)
+    {
+        return ng::size{ static_cast<double>(std::uniform_int_distribution<int>{ 3, 24 }(aPrng)), static_cast<double>(std::uniform_int_distribution<int>{ 6, 40 }(aPrng)) };
+    }
+}
+
+NEOGFX_TEST(rect_pack_inserts_disjoint_elements)
+{
+    std::mt19937 prng{ 42u };
+    ng::rect_pack pack{ ng::size{ 256.0, 256.0 } };
+    std::vector<ng::rect> elements;
+    double area = 0.0;
+    ng::rect space;
+    while (pack.insert(random_glyph(prng), space))
+    {
+        elements.push_back(space);
+        area += space.cx * space.cy;
+    }
+    NEOGFX_CHECK(!elements.empty());
+    NEOGFX_CHECK(disjoint_and_inside(elements, pack.dimensions()));
+    NEOGFX_CHECK(pack.used_area() == area);
+    NEOGFX_CHECK(pack.occupancy() > 0.5);
+}
+
+NEOGFX_TEST(rect_pack_rejects_oversized_element)
+{
+    ng::rect_pack pack{ ng::size{ 64.0, 64.0 } };
+    ng::rect space;
+    NEOGFX_CHECK(!pack.insert(ng::size{ 65.0, 1.0 }, space));
+    NEOGFX_CHECK(pack.insert(ng::size{ 64.0, 64.0 }, space));
+    NEOGFX_CHECK(!pack.insert(ng::size{ 1.0, 1.0 }, space));
+}
+
+NEOGFX_TEST(rect_pack_remove_coalesces_free_space)
+{
+    ng::rect_pack pack{ ng::size{ 64.0, 64.0 } };
+    std::vector<ng::rect> quarters(4u);
+    for (auto& quarter : quarters)
+        NEOGFX_CHECK(pack.insert(ng::size{ 32.0, 32.0 }, quarter));
+    NEOGFX_CHECK(pack.occupancy() == 1.0);
+    // freeing two quarters sharing an edge must leave room for an element spanning both
+    for (std::size_t i = 0u; i < quarters.size(); ++i)
+        for (std::size_t j = i + 1u; j < quarters.size(); ++j)
+            if (quarters[i].x == quarters[j].x && quarters[i].y != quarters[j].y)
+            {
+                pack.remove(quarters[i]);
+                pack.remove(quarters[j]);
+                ng::rect column;
+                NEOGFX_CHECK(pack.insert(ng::size{ 32.0, 64.0 }, column));
+                NEOGFX_CHECK(column.x == quarters[i].x && column.y == 0.0);
+                return;
+            }
+    NEOGFX_CHECK(false);
+}
+
+NEOGFX_TEST(rect_pack_emptied_pack_is_whole_again)
+{
+    std::mt19937 prng{ 7u };
+    ng::rect_pack pack{ ng::size{ 128.0, 128.0 } };
+    std::vector<ng::rect> elements;
+    ng::rect space;
+    while (pack.insert(random_glyph(prng), space))
+        elements.push_back(space);
+    std::shuffle(elements.begin(), elements.end(), prng);
+    for (auto const& element : elements)
+        pack.remove(element);
+    NEOGFX_CHECK(pack.used_area() == 0.0);
+    NEOGFX_CHECK(pack.free_rect_count() == 1u);
+    NEOGFX_CHECK(pack.insert(ng::size{ 128.0, 128.0 }, space));
+}
+
+NEOGFX_TEST(rect_pack_churn_keeps_elements_disjoint)
+{
+    std::mt19937 prng{ 3u };
+    ng::rect_pack pack{ ng::size{ 256.0, 256.0 } };
+    std::vector<ng::rect> elements;
+    ng::rect space;
+    for (int round = 0; round < 20; ++round)
+    {
+        while (pack.insert(random_glyph(prng), space))
+            elements.push_back(space);
+        std::shuffle(elements.begin(), elements.end(), prng);
+        for (std::size_t i = 0u; i < elements.size() / 2u; ++i)
+        {
+            pack.remove(elements.back());
+            elements.pop_back();
+        }
+        NEOGFX_CHECK(disjoint_and_inside(elements, pack.dimensions()));
+    }
+}
+
+NEOGFX_TEST(rect_pack_repack_recovers_fragmented_page)
+{
+    // the atlas repacks a page by inserting its surviving elements into a fresh pack
+    std::mt19937 prng{ 11u };
+    ng::rect_pack fragmented{ ng::size{ 256.0, 256.0 } };
+    std::vector<ng::rect> elements;
+    ng::rect space;
+    while (fragmented.insert(random_glyph(prng), space))
+        elements.push_back(space);
+    std::shuffle(elements.begin(), elements.end(), prng);
+    for (std::size_t i = 0u; i < elements.size() / 2u; ++i)
+    {
+        fragmented.remove(elements.back());
+        elements.pop_back();
+    }
+    std::vector<ng::size> sizes;
+    for (auto const& element : elements)
+        sizes.push_back(element.extents());
+    ng::rect_pack repacked{ fragmented.dimensions() };
+    std::vector<ng::rect> spaces;
+    NEOGFX_CHECK(repacked.insert(sizes, spaces));
+    NEOGFX_CHECK(spaces.size() == sizes.size());
+    for (std::size_t i = 0u; i < sizes.size(); ++i)
+        NEOGFX_CHECK(spaces[i].extents() == sizes[i]);
+    NEOGFX_CHECK(disjoint_and_inside(spaces, repacked.dimensions()));
+    NEOGFX_CHECK(repacked.used_area() == fragmented.used_area());
+}
+
+NEOGFX_TEST(rect_pack_repack_fails_when_elements_do_not_fit)
+{
+    ng::rect_pack pack{ ng::size{ 64.0, 64.0 } };
+    std::vector<ng::rect> spaces;
+    NEOGFX_CHECK(!pack.insert(std::vector<ng::size>{ ng::size{ 64.0, 40.0 }, ng::size{ 64.0, 40.0 } }, spaces));
+}
@@ -0,0 +1,119 @@
+// shapes.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <cmath>
+#include <algorithm>
+#include <initializer_list>
+#include <boost/math/constants/constants.hpp>
+#include <neogfx/gfx/shapes.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    bool near(ng::scalar aLhs, ng::scalar aRhs, ng::scalar aTolerance = 1.0e-9)
+    {
+        return std::abs(aLhs - aRhs) <= aTolerance;
+    }
+
+    bool on_circle(const ng::xyz& aVertex, const ng::point& aCenter, ng::dimension aRadius)
+    {
+        return near(std::hypot(aVertex.x - aCenter.x, aVertex.y - aCenter.y), aRadius, 1.0e-9 * std::max(1.0, aRadius));
+    }
+}
+
+NEOGFX_TEST(arc_segments_per_circle_keeps_within_tolerance)
+{
+    auto const twoPi = boost::math::constants::two_pi<ng::scalar>();
+    for (ng::dimension radius : { 0.1, 1.0, 4.0, 16.0, 100.0, 1000.0 })
+    {
+        auto const segments = ng::arc_segments_per_circle(radius);
+        NEOGFX_CHECK(segments % 4u == 0u);
+        NEOGFX_CHECK(segments >= 8u && segments <= 4096u);
+        if (radius > ng::DefaultArcTolerance)
+            NEOGFX_CHECK(radius * (1.0 - std::cos(twoPi / segments / 2.0)) <= ng::DefaultArcTolerance + 1.0e-12);
+    }
+    NEOGFX_CHECK(ng::arc_segments_per_circle(1.0e12) == 4096u);
+    NEOGFX_CHECK(ng::arc_segments_per_circle(10.0, 0.0) == 8u);
+}
+
+NEOGFX_TEST(arc_segment_count_is_bounded_for_tiny_arcs)
+{
+    // a large explicit segment count over a tiny arc would otherwise ask for an enormous circle table
+    auto const outline = ng::arc_vertices(ng::point{}, 10.0, 0.0, 1.0e-9, ng::point{}, ng::mesh_type::Outline, 1000u);
+    NEOGFX_CHECK(outline.size() >= 2u && outline.size() <= 4097u);
+    auto const triangles = ng::arc_vertices(ng::point{}, 10.0, 0.0, 1.0e-12, ng::point{}, ng::mesh_type::Triangles, 0xFFFFFFFFu);
+    NEOGFX_CHECK(triangles.size() % 3u == 0u && triangles.size() <= 4096u * 3u);
+}
+
+NEOGFX_TEST(arc_outline_and_fan_include_both_end_points)
+{
+    auto const pi = boost::math::constants::pi<ng::scalar>();
+    ng::point const center{ 5.0, -3.0 };
+    ng::dimension const radius = 20.0;
+    ng::angle const start = 0.3;
+    ng::angle const end = 0.3 + pi * 0.7;
+    auto const outline = ng::arc_vertices(center, radius, start, end, center, ng::mesh_type::Outline);
+    NEOGFX_CHECK(outline.size() >= 2u);
+    NEOGFX_CHECK(near(outline.front().x, center.x + radius * std::cos(start)) && near(outline.front().y, center.y + radius * std::sin(start)));
+    NEOGFX_CHECK(near(outline.back().x, center.x + radius * std::cos(end)) && near(outline.back().y, center.y + radius * std::sin(end)));
+    for (auto const& v : outline)
+        NEOGFX_CHECK(on_circle(v, center, radius));
+
+    ng::point const origin{ 1.0, 2.0 };
+    auto const fan = ng::arc_vertices(center, radius, start, end, origin, ng::mesh_type::TriangleFan);
+    NEOGFX_CHECK(fan.size() == outline.size() + 1u);
+    NEOGFX_CHECK(fan.front().x == origin.x && fan.front().y == origin.y);
+    NEOGFX_CHECK(near(fan.back().x, center.x + radius * std::cos(end)) && near(fan.back().y, center.y + radius * std::sin(end)));
+
+    auto const triangles = ng::arc_vertices(center, radius, start, end, origin, ng::mesh_type::Triangles);
+    NEOGFX_CHECK(triangles.size() == (outline.size() - 1u) * 3u);
+    NEOGFX_CHECK(near(triangles.back().x, outline.back().x) && near(triangles.back().y, outline.back().y));
+}
+
+NEOGFX_TEST(circle_outline_is_closed)
+{
+    ng::point const center{ 0.0, 0.0 };
+    auto const outline = ng::circle_vertices(center, 50.0, 0.0, ng::mesh_type::Outline);
+    NEOGFX_CHECK(outline.size() == ng::arc_segments_per_circle(50.0) + 1u);
+    NEOGFX_CHECK(outline.front() == outline.back());
+    auto const fan = ng::circle_vertices(center, 50.0, 0.0, ng::mesh_type::TriangleFan);
+    NEOGFX_CHECK(fan.size() == outline.size() + 1u);
+    NEOGFX_CHECK(fan[1] == fan.back());
+}
+
+NEOGFX_TEST(rounded_rect_outline_is_closed_and_inside)
+{
+    ng::rect const r{ ng::point{ 10.0, 20.0 }, ng::size{ 100.0, 60.0 } };
+    for (auto type : { ng::mesh_type::Outline, ng::mesh_type::TriangleFan, ng::mesh_type::Triangles })
+    {
+        auto const vertices = ng::rounded_rect_vertices(r, 8.0, type);
+        NEOGFX_CHECK(!vertices.empty());
+        for (auto const& v : vertices)
+            NEOGFX_CHECK(v.x >= r.left() - 1.0e-9 && v.x <= r.right() + 1.0e-9 && v.y >= r.top() - 1.0e-9 && v.y <= r.bottom() + 1.0e-9);
+        if (type == ng::mesh_type::Outline)
+            NEOGFX_CHECK(vertices.front() == vertices.back());
+        else if (type == ng::mesh_type::TriangleFan)
+            NEOGFX_CHECK(vertices[1] == vertices.back());
+        else
+            NEOGFX_CHECK(vertices.size() % 3u == 0u);
+    }
+}
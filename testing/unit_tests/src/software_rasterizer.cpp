@@ -0,0 +1,208 @@
+// software_rasterizer.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <neogfx/gfx/image.hpp>
+#include "../../../src/gfx/native/software_rasterizer.hpp"
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+// Rasterizes small fixed scenes and compares the result with reference buffers; geometry references are drawn as
+// text, one character per pixel, with '#' for the ink colour and '.' for the background.
+
+namespace
+{
+    typedef ng::software_rasterizer rasterizer;
+
+    constexpr int32_t SceneSize = 8;
+
+    rasterizer::triangle triangle(ng::vec2f const& aV0, ng::vec2f const& aV1, ng::vec2f const& aV2, ng::vec2f const& aUv0 = {}, ng::vec2f const& aUv1 = {}, ng::vec2f const& aUv2 = {})
+    {
+        rasterizer::triangle result;
+        result.vertices[0] = rasterizer::vertex{ aV0, aUv0 };
+        result.vertices[1] = rasterizer::vertex{ aV1, aUv1 };
+        result.vertices[2] = rasterizer::vertex{ aV2, aUv2 };
+        result.paint = 0u;
+        return result;
+    }
+
+    std::vector<rasterizer::triangle> quad(float aLeft, float aTop, float aRight, float aBottom, bool aMapTexels = false)
+    {
+        auto uv = [&](float aX, float aY) { return aMapTexels ? ng::vec2f{ aX, aY } : ng::vec2f{}; };
+        return {
+            triangle(ng::vec2f{ aLeft, aTop }, ng::vec2f{ aRight, aTop }, ng::vec2f{ aRight, aBottom }, uv(aLeft, aTop), uv(aRight, aTop), uv(aRight, aBottom)),
+            triangle(ng::vec2f{ aLeft, aTop }, ng::vec2f{ aRight, aBottom }, ng::vec2f{ aLeft, aBottom }, uv(aLeft, aTop), uv(aRight, aBottom), uv(aLeft, aBottom)) };
+    }
+
+    rasterizer::paint solid(ng::color const& aColor)
+    {
+        rasterizer::paint result;
+        result.color = ng::vec4f{ aColor.red<float>(), aColor.green<float>(), aColor.blue<float>(), aColor.alpha<float>() };
+        return result;
+    }
+
+    void fill(rasterizer& aRasterizer, std::vector<rasterizer::triangle> const& aTriangles, rasterizer::paint const& aPaint)
+    {
+        aRasterizer.fill(aTriangles.data(), aTriangles.data() + aTriangles.size(), &aPaint);
+    }
+
+    rasterizer::texel const& pixel(ng::image const& aImage, int32_t aX, int32_t aY)
+    {
+        return static_cast<rasterizer::texel const*>(aImage.pixels())[aY * SceneSize + aX];
+    }
+
+    std::string art(ng::image const& aImage, ng::color const& aInk, ng::color const& aBackground)
+    {
+        auto matches = [](rasterizer::texel const& aTexel, ng::color const& aColor)
+        {
+            return aTexel == rasterizer::texel{ aColor.red(), aColor.green(), aColor.blue(), aColor.alpha() };
+        };
+        std::string result;
+        for (int32_t y = 0; y < SceneSize; ++y)
+            for (int32_t x = 0; x < SceneSize; ++x)
+            {
+                auto const& p = pixel(aImage, x, y);
+                result += matches(p, aInk) ? '#' : matches(p, aBackground) ? '.' : '?';
+            }
+        return result;
+    }
+
+    bool near(rasterizer::texel const& aActual, rasterizer::texel const& aExpected)
+    {
+        for (std::size_t c = 0u; c < 4u; ++c)
+            if (std::abs(static_cast<int>(aActual[c]) - static_cast<int>(aExpected[c])) > 1)
+                return false;
+        return true;
+    }
+}
+
+NEOGFX_TEST(software_rasterizer_line)
+{
+    // a one pixel thick line of slope 1/2 drawn as a parallelogram
+    ng::image target{ ng::size{ SceneSize, SceneSize } };
+    rasterizer r{ target };
+    r.clear(ng::color::Black);
+    fill(r, {
+        triangle(ng::vec2f{ 1.0f, 1.0f }, ng::vec2f{ 7.0f, 4.0f }, ng::vec2f{ 7.0f, 5.0f }),
+        triangle(ng::vec2f{ 1.0f, 1.0f }, ng::vec2f{ 7.0f, 5.0f }, ng::vec2f{ 1.0f, 2.0f }) }, solid(ng::color::White));
+    NEOGFX_CHECK(art(target, ng::color::White, ng::color::Black) ==
+        "........"
+        ".#......"
+        "..##...."
+        "....##.."
+        "......#."
+        "........"
+        "........"
+        "........");
+}
+
+NEOGFX_TEST(software_rasterizer_filled_rect)
+{
+    ng::image target{ ng::size{ SceneSize, SceneSize } };
+    rasterizer r{ target };
+    r.clear(ng::color::Black);
+    fill(r, quad(2.0f, 2.0f, 6.0f, 5.0f), solid(ng::color::Red));
+    NEOGFX_CHECK(art(target, ng::color::Red, ng::color::Black) ==
+        "........"
+        "........"
+        "..####.."
+        "..####.."
+        "..####.."
+        "........"
+        "........"
+        "........");
+}
+
+NEOGFX_TEST(software_rasterizer_anti_aliased_edge)
+{
+    // edges are anti-aliased with coverage textures, as glyphs are; this edge ramps up across the first row
+    ng::image target{ ng::size{ SceneSize, SceneSize } };
+    rasterizer r{ target };
+    r.clear(ng::color::Black);
+    auto coverage = std::make_shared<rasterizer::texel_block>();
+    coverage->region = ng::rect_i32{ ng::point_i32{ 0, 0 }, ng::size_i32{ SceneSize, 1 } };
+    for (uint8_t value : { 0, 32, 64, 128, 192, 255, 255, 255 })
+        coverage->data.push_back(rasterizer::texel{ value, value, value, 255 });
+    coverage->coverage = true;
+    auto paint = solid(ng::color::White);
+    paint.type = rasterizer::paint_type::Texture;
+    paint.texels = coverage;
+    fill(r, quad(0.0f, 0.0f, static_cast<float>(SceneSize), 1.0f, true), paint);
+    uint8_t const expected[SceneSize] = { 0, 32, 64, 128, 192, 255, 255, 255 };
+    for (int32_t x = 0; x < SceneSize; ++x)
+    {
+        NEOGFX_CHECK(near(pixel(target, x, 0), rasterizer::texel{ expected[x], expected[x], expected[x], 255 }));
+        NEOGFX_CHECK(pixel(target, x, 1) == (rasterizer::texel{ 0, 0, 0, 255 }));
+    }
+}
+
+NEOGFX_TEST(software_rasterizer_clipping)
+{
+    // geometry overhanging the target on every side is cut to the image and then to the clip rectangle
+    ng::image target{ ng::size{ SceneSize, SceneSize } };
+    rasterizer r{ target };
+    r.clear(ng::color::Black);
+    r.set_clip(ng::rect_i32{ ng::point_i32{ 2, 3 }, ng::size_i32{ 3, 4 } });
+    fill(r, quad(-4.0f, -4.0f, 12.0f, 12.0f), solid(ng::color::Green));
+    NEOGFX_CHECK(art(target, ng::color::Green, ng::color::Black) ==
+        "........"
+        "........"
+        "........"
+        "..###..."
+        "..###..."
+        "..###..."
+        "..###..."
+        "........");
+    r.set_clip(std::nullopt);
+    fill(r, quad(6.0f, 6.0f, 12.0f, 12.0f), solid(ng::color::Green));
+    NEOGFX_CHECK(art(target, ng::color::Green, ng::color::Black) ==
+        "........"
+        "........"
+        "........"
+        "..###..."
+        "..###..."
+        "..###..."
+        "..###.##"
+        "......##");
+}
+
+NEOGFX_TEST(software_rasterizer_blending)
+{
+    // half transparent red over opaque blue in each blending mode
+    ng::color const background{ 0, 0, 255, 255 };
+    ng::color const ink{ 255, 0, 0, 128 };
+    auto blend = [&](ng::blending_mode aMode)
+    {
+        ng::image target{ ng::size{ SceneSize, SceneSize } };
+        rasterizer r{ target };
+        r.clear(background);
+        r.set_blending_mode(aMode);
+        fill(r, quad(0.0f, 0.0f, 1.0f, 1.0f), solid(ink));
+        NEOGFX_CHECK(pixel(target, 1, 0) == (rasterizer::texel{ 0, 0, 255, 255 }));
+        return pixel(target, 0, 0);
+    };
+    NEOGFX_CHECK(near(blend(ng::blending_mode::Default), rasterizer::texel{ 128, 0, 127, 191 }));
+    NEOGFX_CHECK(near(blend(ng::blending_mode::Blit), rasterizer::texel{ 255, 0, 127, 255 }));
+    NEOGFX_CHECK(blend(ng::blending_mode::None) == (rasterizer::texel{ 255, 0, 0, 128 }));
+}
@@ -0,0 +1,136 @@
+// stroke.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <boost/math/constants/constants.hpp>
+#include <neogfx/gfx/stroke.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    ng::pen make_pen(ng::dimension aWidth, ng::line_cap aCap, ng::line_join aJoin = ng::line_join::Miter, ng::scalar aMiterLimit = 4.0)
+    {
+        ng::pen result{ ng::color::White, aWidth };
+        result.set_line_cap(aCap).set_line_join(aJoin).set_miter_limit(aMiterLimit);
+        return result;
+    }
+
+    std::vector<ng::vec3f> stroke(ng::vertices const& aPolyline, bool aClosed, ng::pen const& aPen)
+    {
+        std::vector<ng::vec3f> result;
+        ng::stroke_polyline(aPolyline, aClosed, aPen, result);
+        return result;
+    }
+
+    // sum of triangle areas; equals the covered area only where triangles do not overlap
+    double area(std::vector<ng::vec3f> const& aTriangles)
+    {
+        double result = 0.0;
+        for (std::size_t i = 0; i + 2 < aTriangles.size(); i += 3)
+        {
+            auto const& a = aTriangles[i];
+            auto const& b = aTriangles[i + 1];
+            auto const& c = aTriangles[i + 2];
+            result += std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2.0;
+        }
+        return result;
+    }
+
+    // furthest extent of the stroke in the direction (aDx, aDy)
+    float reach(std::vector<ng::vec3f> const& aTriangles, float aDx, float aDy)
+    {
+        float result = -std::numeric_limits<float>::infinity();
+        for (auto const& v : aTriangles)
+            result = std::max(result, v.x * aDx + v.y * aDy);
+        return result;
+    }
+
+    bool near(double aLhs, double aRhs, double aTolerance = 1.0e-4)
+    {
+        return std::abs(aLhs - aRhs) <= aTolerance;
+    }
+}
+
+NEOGFX_TEST(stroke_segment_caps_extend_as_expected)
+{
+    ng::vertices const segment{ ng::xyz{ 0.0, 0.0 }, ng::xyz{ 10.0, 0.0 } };
+    auto const butt = stroke(segment, false, make_pen(2.0, ng::line_cap::Butt));
+    NEOGFX_CHECK(butt.size() == 6u);
+    NEOGFX_CHECK(near(area(butt), 20.0));
+    NEOGFX_CHECK(near(reach(butt, 1.0f, 0.0f), 10.0) && near(reach(butt, -1.0f, 0.0f), 0.0));
+    auto const square = stroke(segment, false, make_pen(2.0, ng::line_cap::Square));
+    NEOGFX_CHECK(near(area(square), 24.0));
+    NEOGFX_CHECK(near(reach(square, 1.0f, 0.0f), 11.0) && near(reach(square, -1.0f, 0.0f), 1.0));
+    auto const round = stroke(segment, false, make_pen(2.0, ng::line_cap::Round));
+    NEOGFX_CHECK(near(reach(round, 1.0f, 0.0f), 11.0, 1.0e-3) && near(reach(round, -1.0f, 0.0f), 1.0, 1.0e-3));
+    // two half discs approximated by inscribed polygons
+    NEOGFX_CHECK(area(round) <= 20.0 + boost::math::constants::pi<double>() + 1.0e-4);
+    NEOGFX_CHECK(area(round) >= 20.0 + boost::math::constants::pi<double>() * 0.85);
+}
+
+NEOGFX_TEST(stroke_joins_follow_pen)
+{
+    // a right-angle turn at (10, 0); the outside of the corner is towards (+x, -y)
+    ng::vertices const corner{ ng::xyz{ 0.0, 0.0 }, ng::xyz{ 10.0, 0.0 }, ng::xyz{ 10.0, 10.0 } };
+    auto const miter = stroke(corner, false, make_pen(2.0, ng::line_cap::Butt, ng::line_join::Miter));
+    NEOGFX_CHECK(near(reach(miter, 1.0f, -1.0f), 12.0));
+    auto const bevel = stroke(corner, false, make_pen(2.0, ng::line_cap::Butt, ng::line_join::Bevel));
+    NEOGFX_CHECK(near(reach(bevel, 1.0f, -1.0f), 11.0));
+    auto const round = stroke(corner, false, make_pen(2.0, ng::line_cap::Butt, ng::line_join::Round));
+    NEOGFX_CHECK(reach(round, 1.0f, -1.0f) > 11.0f && reach(round, 1.0f, -1.0f) <= 10.0f + std::sqrt(2.0f) + 1.0e-4f);
+}
+
+NEOGFX_TEST(stroke_miter_limit_falls_back_to_bevel)
+{
+    // a turn of almost 180 degrees: the miter tip would be far beyond the limit
+    ng::vertices const spike{ ng::xyz{ 0.0, 0.0 }, ng::xyz{ 10.0, 0.0 }, ng::xyz{ 0.0, 1.0 } };
+    auto const limited = stroke(spike, false, make_pen(2.0, ng::line_cap::Butt, ng::line_join::Miter, 4.0));
+    NEOGFX_CHECK(reach(limited, 1.0f, 0.0f) <= 11.0f + 1.0e-4f);
+    auto const unlimited = stroke(spike, false, make_pen(2.0, ng::line_cap::Butt, ng::line_join::Miter, 1000.0));
+    NEOGFX_CHECK(reach(unlimited, 1.0f, 0.0f) > 15.0f);
+}
+
+NEOGFX_TEST(stroke_closed_polyline_has_no_caps)
+{
+    ng::vertices const square{ ng::xyz{ 0.0, 0.0 }, ng::xyz{ 10.0, 0.0 }, ng::xyz{ 10.0, 10.0 }, ng::xyz{ 0.0, 10.0 }, ng::xyz{ 0.0, 0.0 } };
+    auto const squareCaps = stroke(square, true, make_pen(2.0, ng::line_cap::Square, ng::line_join::Miter));
+    auto const roundCaps = stroke(square, true, make_pen(2.0, ng::line_cap::Round, ng::line_join::Miter));
+    NEOGFX_CHECK(squareCaps.size() == roundCaps.size());
+    NEOGFX_CHECK(near(reach(squareCaps, 1.0f, 0.0f), 11.0) && near(reach(squareCaps, -1.0f, 0.0f), 1.0));
+    NEOGFX_CHECK(near(reach(squareCaps, 0.0f, 1.0f), 11.0) && near(reach(squareCaps, 0.0f, -1.0f), 1.0));
+}
+
+NEOGFX_TEST(stroke_zero_length_draws_cap_shaped_dot)
+{
+    ng::vertices const dot{ ng::xyz{ 5.0, 5.0 }, ng::xyz{ 5.0, 5.0 } };
+    NEOGFX_CHECK(stroke(dot, false, make_pen(4.0, ng::line_cap::Butt)).empty());
+    auto const square = stroke(dot, false, make_pen(4.0, ng::line_cap::Square));
+    NEOGFX_CHECK(near(area(square), 16.0));
+    NEOGFX_CHECK(near(reach(square, 1.0f, 0.0f), 7.0) && near(reach(square, 0.0f, -1.0f), -3.0));
+    auto const round = stroke(dot, false, make_pen(4.0, ng::line_cap::Round));
+    NEOGFX_CHECK(near(reach(round, 1.0f, 0.0f), 7.0, 1.0e-3));
+    NEOGFX_CHECK(area(round) <= boost::math::constants::pi<double>() * 4.0 + 1.0e-4);
+    NEOGFX_CHECK(area(round) >= boost::math::constants::pi<double>() * 4.0 * 0.85);
+    NEOGFX_CHECK(stroke(dot, false, make_pen(0.0, ng::line_cap::Round)).empty());
+}
@@ -0,0 +1,183 @@
+// tessellator.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <cmath>
+#include <algorithm>
+#include <initializer_list>
+#include <boost/math/constants/constants.hpp>
+#include <neogfx/gfx/tessellator.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+namespace
+{
+    void add_contour(ng::path& aPath, std::initializer_list<ng::point> aPoints)
+    {
+        auto p = aPoints.begin();
+        aPath.move_to(*p);
+        for (++p; p != aPoints.end(); ++p)
+            aPath.line_to(*p);
+        aPath.line_to(*aPoints.begin());
+    }
+
+    ng::path square(ng::coordinate aLeft, ng::coordinate aTop, ng::coordinate aSize, ng::fill_rule aFillRule = ng::fill_rule::NonZero)
+    {
+        ng::path result{ ng::path_shape::Polygon };
+        result.set_fill_rule(aFillRule);
+        add_contour(result, { { aLeft, aTop }, { aLeft + aSize, aTop }, { aLeft + aSize, aTop + aSize }, { aLeft, aTop + aSize } });
+        return result;
+    }
+
+    ng::scalar area(const ng::vertices& aTriangles)
+    {
+        ng::scalar result = 0.0;
+        for (std::size_t i = 0; i + 2 < aTriangles.size(); i += 3)
+        {
+            auto const& a = aTriangles[i];
+            auto const& b = aTriangles[i + 1];
+            auto const& c = aTriangles[i + 2];
+            result += std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2.0;
+        }
+        return result;
+    }
+
+    bool near(ng::scalar aLhs, ng::scalar aRhs)
+    {
+        return std::abs(aLhs - aRhs) <= 1.0e-6 * std::max(1.0, std::abs(aRhs));
+    }
+
+    uint64_t colliding_hash(const ng::path&)
+    {
+        return 0u;
+    }
+}
+
+NEOGFX_TEST(tessellator_square_matches_analytic_area)
+{
+    auto const mesh = ng::tessellate(square(0.0, 0.0, 10.0));
+    NEOGFX_CHECK(mesh.size() % 3u == 0u);
+    NEOGFX_CHECK(near(area(mesh), 100.0));
+    for (auto const& v : mesh)
+        NEOGFX_CHECK(v.x >= 0.0 && v.x <= 10.0 && v.y >= 0.0 && v.y <= 10.0);
+}
+
+NEOGFX_TEST(tessellator_concave_and_regular_polygons_match_analytic_area)
+{
+    ng::path lShape{ ng::path_shape::Polygon };
+    add_contour(lShape, { { 0.0, 0.0 }, { 4.0, 0.0 }, { 4.0, 6.0 }, { 10.0, 6.0 }, { 10.0, 10.0 }, { 0.0, 10.0 } });
+    NEOGFX_CHECK(near(area(ng::tessellate(lShape)), 64.0));
+
+    auto const twoPi = boost::math::constants::two_pi<ng::scalar>();
+    ng::scalar const radius = 50.0;
+    uint32_t const sides = 37u;
+    ng::path polygon{ ng::path_shape::Polygon };
+    polygon.move_to(radius, 0.0);
+    for (uint32_t side = 1u; side < sides; ++side)
+        polygon.line_to(radius * std::cos(twoPi * side / sides), radius * std::sin(twoPi * side / sides));
+    polygon.line_to(radius, 0.0);
+    NEOGFX_CHECK(near(area(ng::tessellate(polygon)), sides / 2.0 * radius * radius * std::sin(twoPi / sides)));
+}
+
+NEOGFX_TEST(tessellator_fills_nested_holes)
+{
+    // an island inside a hole inside an outer contour; the hole runs the other way so both rules agree
+    for (auto fillRule : { ng::fill_rule::NonZero, ng::fill_rule::EvenOdd })
+    {
+        auto nested = square(0.0, 0.0, 10.0, fillRule);
+        add_contour(nested, { { 2.0, 2.0 }, { 2.0, 8.0 }, { 8.0, 8.0 }, { 8.0, 2.0 } });
+        add_contour(nested, { { 4.0, 4.0 }, { 6.0, 4.0 }, { 6.0, 6.0 }, { 4.0, 6.0 } });
+        NEOGFX_CHECK(near(area(ng::tessellate(nested)), 100.0 - 36.0 + 4.0));
+    }
+    // a hole running the same way as its outer contour is only a hole under EvenOdd
+    auto sameWay = square(0.0, 0.0, 10.0, ng::fill_rule::NonZero);
+    add_contour(sameWay, { { 2.0, 2.0 }, { 8.0, 2.0 }, { 8.0, 8.0 }, { 2.0, 8.0 } });
+    NEOGFX_CHECK(near(area(ng::tessellate(sameWay)), 100.0));
+    sameWay.set_fill_rule(ng::fill_rule::EvenOdd);
+    NEOGFX_CHECK(near(area(ng::tessellate(sameWay)), 64.0));
+}
+
+NEOGFX_TEST(tessellator_self_intersection_follows_fill_rule)
+{
+    // a pentagram: NonZero fills the inner pentagon, EvenOdd leaves it empty
+    auto const pi = boost::math::constants::pi<ng::scalar>();
+    ng::scalar const outer = 100.0;
+    ng::scalar const inner = outer * std::cos(2.0 * pi / 5.0) / std::cos(pi / 5.0);
+    ng::path star{ ng::path_shape::Polygon };
+    star.move_to(0.0, outer);
+    for (uint32_t point = 1u; point < 5u; ++point)
+    {
+        auto const theta = pi / 2.0 + point * 4.0 * pi / 5.0;
+        star.line_to(outer * std::cos(theta), outer * std::sin(theta));
+    }
+    star.line_to(0.0, outer);
+    ng::scalar const starArea = 5.0 * outer * inner * std::sin(pi / 5.0);
+    ng::scalar const pentagonArea = 2.5 * inner * inner * std::sin(2.0 * pi / 5.0);
+    star.set_fill_rule(ng::fill_rule::NonZero);
+    NEOGFX_CHECK(near(area(ng::tessellate(star)), starArea));
+    star.set_fill_rule(ng::fill_rule::EvenOdd);
+    NEOGFX_CHECK(near(area(ng::tessellate(star)), starArea - pentagonArea));
+}
+
+NEOGFX_TEST(tessellator_ignores_collinear_edge_points)
+{
+    ng::path path{ ng::path_shape::Polygon };
+    add_contour(path, { { 0.0, 0.0 }, { 5.0, 0.0 }, { 10.0, 0.0 }, { 10.0, 5.0 }, { 10.0, 10.0 }, { 5.0, 10.0 }, { 0.0, 10.0 }, { 0.0, 5.0 } });
+    auto const mesh = ng::tessellate(path);
+    NEOGFX_CHECK(near(area(mesh), 100.0));
+    // points along an edge may split a slab but must not produce degenerate triangles
+    for (std::size_t i = 0; i < mesh.size(); i += 3)
+        NEOGFX_CHECK(area(ng::vertices{ mesh[i], mesh[i + 1], mesh[i + 2] }) > 0.0);
+}
+
+NEOGFX_TEST(path_mesh_cache_returns_cached_mesh)
+{
+    ng::path_mesh_cache cache;
+    auto const first = cache.find(square(0.0, 0.0, 10.0));
+    auto const second = cache.find(square(0.0, 0.0, 10.0));
+    NEOGFX_CHECK(first == second);
+    NEOGFX_CHECK(cache.size() == 1u);
+    auto const evenOdd = cache.find(square(0.0, 0.0, 10.0, ng::fill_rule::EvenOdd));
+    NEOGFX_CHECK(evenOdd != first);
+    NEOGFX_CHECK(cache.size() == 2u);
+}
+
+NEOGFX_TEST(path_mesh_cache_replaces_hash_collisions)
+{
+    ng::path_mesh_cache cache{ ng::path_mesh_cache::DefaultCapacity, &colliding_hash };
+    auto const small = square(0.0, 0.0, 2.0);
+    auto const large = square(0.0, 0.0, 10.0);
+    NEOGFX_CHECK(near(area(*cache.find(small)), 4.0));
+    NEOGFX_CHECK(near(area(*cache.find(large)), 100.0));
+    NEOGFX_CHECK(cache.size() == 1u);
+    NEOGFX_CHECK(near(area(*cache.find(small)), 4.0));
+}
+
+NEOGFX_TEST(path_mesh_cache_evicts_least_recently_used)
+{
+    ng::path_mesh_cache cache{ 2u };
+    auto const a = cache.find(square(0.0, 0.0, 1.0));
+    auto const b = cache.find(square(0.0, 0.0, 2.0));
+    NEOGFX_CHECK(cache.find(square(0.0, 0.0, 1.0)) == a);
+    cache.find(square(0.0, 0.0, 3.0));
+    NEOGFX_CHECK(cache.size() == 2u);
+    NEOGFX_CHECK(cache.find(square(0.0, 0.0, 1.0)) == a);
+    NEOGFX_CHECK(cache.find(square(0.0, 0.0, 2.0)) != b);
+}
@@ -0,0 +1,62 @@
+// unit_test.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+namespace neogfx::unit_tests
+{
+    struct test_case
+    {
+        char const* name;
+        void(*function)();
+    };
+
+    inline std::vector<test_case>& test_cases()
+    {
+        static std::vector<test_case> sTestCases;
+        return sTestCases;
+    }
+
+    struct test_registrar
+    {
+        test_registrar(char const* aName, void(*aFunction)())
+        {
+            test_cases().push_back(test_case{ aName, aFunction });
+        }
+    };
+
+    struct check_failed : std::runtime_error
+    {
+        check_failed(char const* aFile, int aLine, char const* aExpression) :
+            std::runtime_error{ std::string{ aFile } + "(" + std::to_string(aLine) + "): check failed: " + aExpression } {}
+    };
+}
+
+#define NEOGFX_TEST(name) \
+    static void name(); \
+    static neogfx::unit_tests::test_registrar name##_registrar{ #name, &name }; \
+    static void name()
+
+#define NEOGFX_CHECK(expression) \
+    do { if (!(expression)) throw neogfx::unit_tests::check_failed{ __FILE__, __LINE__, #expression }; } while (false)
@@ -0,0 +1,77 @@
+// worker_pool.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <neogfx/core/worker_pool.hpp>
+#include "unit_test.hpp"
+
+namespace ng = neogfx;
+
+NEOGFX_TEST(worker_pool_runs_every_index_once)
+{
+    ng::worker_pool pool{ 3u };
+    NEOGFX_CHECK(pool.thread_count() == 3u);
+    for (std::size_t count : { 0u, 1u, 2u, 7u, 1000u })
+    {
+        std::vector<std::atomic<int>> calls(count);
+        pool.run(count, [&](std::size_t aIndex) { ++calls[aIndex]; });
+        for (auto const& c : calls)
+            NEOGFX_CHECK(c == 1);
+    }
+}
+
+NEOGFX_TEST(worker_pool_rethrows_task_exceptions)
+{
+    ng::worker_pool pool{ 2u };
+    std::atomic<std::size_t> completed = 0u;
+    bool rethrown = false;
+    try
+    {
+        pool.run(16u, [&](std::size_t aIndex)
+        {
+            if (aIndex == 5u)
+                throw std::runtime_error{ "task failed" };
+            ++completed;
+        });
+    }
+    catch (std::runtime_error const&)
+    {
+        rethrown = true;
+    }
+    NEOGFX_CHECK(rethrown);
+    // the other tasks still run and the pool remains usable
+    NEOGFX_CHECK(completed == 15u);
+    std::atomic<std::size_t> total = 0u;
+    pool.run(4u, [&](std::size_t aIndex) { total += aIndex; });
+    NEOGFX_CHECK(total == 6u);
+}
+
+NEOGFX_TEST(worker_pool_runs_nested_calls_inline)
+{
+    ng::worker_pool pool{ 2u };
+    std::atomic<std::size_t> inner = 0u;
+    pool.run(4u, [&](std::size_t)
+    {
+        pool.run(3u, [&](std::size_t) { ++inner; });
+    });
+    NEOGFX_CHECK(inner == 12u);
+}
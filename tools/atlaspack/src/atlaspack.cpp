@@ -0,0 +1,167 @@
+// atlaspack.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <neogfx/gfx/rect_pack.hpp>
+
+namespace ng = neogfx;
+
+// Packs glyph and icon sized rectangles into 1024x1024 atlas pages the way texture_atlas does (first fit across pages,
+// one pixel of padding around each element) and reports insert throughput and page occupancy, before and after a
+// churn phase that removes and replaces a random half of the elements.
+// Usage: atlaspack [glyph|icon|mixed] [elements] [churn rounds]
+
+namespace
+{
+    struct element
+    {
+        std::size_t page;
+        ng::rect space;
+    };
+
+    class size_source
+    {
+    public:
+        size_source(std::string const& aDistribution, std::mt19937& aPrng) :
+            iDistribution{ aDistribution }, iPrng{ aPrng }
+        {
+        }
+    public:
+        ng::size operator()()
+        {
+            if (iDistribution == "glyph" || (iDistribution == "mixed" && std::uniform_int_distribution<int>{ 0, 9 }(iPrng) != 0))
+                return glyph();
+            return icon();
+        }
+    private:
+        ng::size glyph()
+        {
+            // rasterized glyphs at typical UI point sizes: narrow, and taller than they are wide
+            auto const height = std::clamp(std::normal_distribution<double>{ 16.0, 4.0 }(iPrng), 6.0, 48.0);
+            auto const width = std::clamp(height * std::normal_distribution<double>{ 0.6, 0.15 }(iPrng), 1.0, 48.0);
+            return ng::size{ std::ceil(width), std::ceil(height) };
+        }
+        ng::size icon()
+        {
+            static double const sIconSizes[] = { 16.0, 16.0, 16.0, 24.0, 24.0, 32.0, 32.0, 48.0, 64.0, 128.0 };
+            auto const extent = sIconSizes[std::uniform_int_distribution<std::size_t>{ 0u, std::size(sIconSizes) - 1u }(iPrng)];
+            return ng::size{ extent, extent };
+        }
+    private:
+        std::string iDistribution;
+        std::mt19937& iPrng;
+    };
+
+    class atlas
+    {
+    public:
+        atlas(ng::size const& aPageSize) :
+            iPageSize{ aPageSize }
+        {
+        }
+    public:
+        element insert(ng::size const& aSize)
+        {
+            ng::rect space;
+            for (std::size_t page = 0u; page < iPages.size(); ++page)
+                if (iPages[page].insert(aSize + ng::size{ 2.0, 2.0 }, space))
+                    return element{ page, space };
+            iPages.emplace_back(iPageSize);
+            if (!iPages.back().insert(aSize + ng::size{ 2.0, 2.0 }, space))
+                throw std::runtime_error{ "element too big for page" };
+            return element{ iPages.size() - 1u, space };
+        }
+        void remove(element const& aElement)
+        {
+            iPages[aElement.page].remove(aElement.space);
+        }
+        void report(std::string const& aPhase) const
+        {
+            double totalOccupancy = 0.0;
+            std::cout << aPhase << ": " << iPages.size() << " page(s), occupancy";
+            for (auto const& page : iPages)
+            {
+                std::cout << " " << static_cast<int>(page.occupancy() * 100.0 + 0.5) << "%";
+                totalOccupancy += page.occupancy();
+            }
+            std::cout << ", mean " << (iPages.empty() ? 0.0 : totalOccupancy * 100.0 / iPages.size()) << "%" << std::endl;
+        }
+    private:
+        ng::size iPageSize;
+        std::vector<ng::rect_pack> iPages;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::string const distribution = argc > 1 ? argv[1] : "mixed";
+        std::size_t const elementCount = argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 20000u;
+        uint32_t const churnRounds = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 10u;
+        if (distribution != "glyph" && distribution != "icon" && distribution != "mixed")
+            throw std::invalid_argument{ "unknown distribution '" + distribution + "'" };
+
+        std::mt19937 prng{ 42u };
+        size_source nextSize{ distribution, prng };
+        atlas pages{ ng::size{ 1024.0, 1024.0 } };
+        std::vector<element> live;
+        live.reserve(elementCount);
+
+        auto const start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0u; i < elementCount; ++i)
+            live.push_back(pages.insert(nextSize()));
+        auto const elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << distribution << ": " << elementCount << " inserts in " << elapsed * 1000.0 << " ms (" << 
+            static_cast<uint64_t>(elementCount / std::max(elapsed, 1e-9)) << " inserts/s)" << std::endl;
+        pages.report("initial");
+
+        std::chrono::duration<double> churnElapsed{};
+        std::size_t churnOperations = 0u;
+        for (uint32_t round = 0u; round < churnRounds; ++round)
+        {
+            std::shuffle(live.begin(), live.end(), prng);
+            auto const replaced = live.size() / 2u;
+            auto const churnStart = std::chrono::high_resolution_clock::now();
+            for (std::size_t i = 0u; i < replaced; ++i)
+                pages.remove(live[live.size() - 1u - i]);
+            live.resize(live.size() - replaced);
+            for (std::size_t i = 0u; i < replaced; ++i)
+                live.push_back(pages.insert(nextSize()));
+            churnElapsed += std::chrono::high_resolution_clock::now() - churnStart;
+            churnOperations += replaced * 2u;
+        }
+        if (churnRounds != 0u)
+        {
+            std::cout << "churn: " << churnRounds << " round(s), " << churnOperations << " removes/inserts in " << churnElapsed.count() * 1000.0 << " ms" << std::endl;
+            pages.report("after churn");
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "atlaspack: terminating with exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,116 @@
+// ecschurn.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <neogfx/app/app.hpp>
+#include <neogfx/gfx/texture.hpp>
+#include <neogfx/gfx/graphics_context.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/game/ecs.hpp>
+#include <neogfx/game/standard_archetypes.hpp>
+#include <neogfx/game/mesh_renderer.hpp>
+
+namespace ng = neogfx;
+
+// Spawns and destroys mesh entities in waves, rendering after each wave, and reports how the ECS vertex buffer
+// fragments and how often it grows.
+// Usage: ecschurn [waves] [entities per wave] [compaction relocations per wave]
+
+namespace
+{
+    ng::game::sprite_archetype const churnEntity{ "ChurnEntity" };
+
+    ng::game::mesh make_fan(std::mt19937& aPrng)
+    {
+        auto const segments = std::uniform_int_distribution<uint32_t>{ 3u, 64u }(aPrng);
+        ng::game::mesh fan;
+        fan.vertices.push_back(ng::vec3{ 0.0, 0.0, 0.0 });
+        for (uint32_t segment = 0u; segment < segments; ++segment)
+            fan.vertices.push_back(ng::rotation_matrix(ng::vec3{ 0.0, 0.0, ng::to_rad(360.0 * segment / segments) }) * ng::vec3{ 8.0, 0.0, 0.0 });
+        for (uint32_t segment = 1u; segment < segments; ++segment)
+            fan.faces.push_back(ng::game::face{ 0u, segment, segment + 1u });
+        fan.faces.push_back(ng::game::face{ 0u, segments, 1u });
+        return fan;
+    }
+
+    void report(std::string const& aName, ng::buffer_allocation_statistics const& aStatistics)
+    {
+        std::cout << aName << ": size " << aStatistics.size << "/" << aStatistics.capacity <<
+            ", free " << aStatistics.freeElements << " in " << aStatistics.freeBlocks << " block(s)" <<
+            ", largest free block " << aStatistics.largestFreeBlock <<
+            ", fragmentation " << aStatistics.fragmentation() <<
+            ", grows " << aStatistics.grows <<
+            ", coalesces " << aStatistics.coalesces << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ng::app app(argc, argv, "neoGFX ECS Vertex Buffer Churn");
+
+    try
+    {
+        uint32_t const waves = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 100u;
+        uint32_t const entitiesPerWave = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000u;
+        std::size_t const relocationsPerWave = argc > 3 ? static_cast<std::size_t>(std::stoul(argv[3])) : 0u;
+
+        std::mt19937 prng{ 42u };
+        ng::game::ecs ecs;
+        ng::texture target{ ng::size{ 512.0, 512.0 }, 1.0, ng::texture_sampling::Normal };
+        std::vector<ng::game::entity_id> live;
+
+        auto& vertexBuffer = ng::service<ng::i_rendering_engine>().vertex_buffer(ecs);
+        for (uint32_t wave = 0u; wave < waves; ++wave)
+        {
+            for (uint32_t spawn = 0u; spawn < entitiesPerWave; ++spawn)
+                live.push_back(ecs.create_entity(churnEntity,
+                    ng::game::mesh_renderer{ ng::game::material{ ng::to_ecs_component(ng::color::White) } },
+                    make_fan(prng)));
+            {
+                ng::graphics_context gc{ target };
+                gc.draw_entities(ecs);
+                gc.flush();
+            }
+            // destroy a random half of the live entities
+            std::shuffle(live.begin(), live.end(), prng);
+            for (auto destroyCount = live.size() / 2u; destroyCount > 0u; --destroyCount)
+            {
+                ecs.destroy_entity(live.back());
+                live.pop_back();
+            }
+            if (relocationsPerWave != 0u)
+                ecs.compact_vertex_buffer(relocationsPerWave);
+        }
+
+        std::cout << "waves: " << waves << ", entities per wave: " << entitiesPerWave << ", live entities: " << live.size() << std::endl;
+        report("vertices", vertexBuffer.vertex_statistics());
+        report("indices", vertexBuffer.index_statistics());
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception& e)
+    {
+        app.halt();
+        std::cerr << "ecschurn: terminating with exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,91 @@
+// gfxreplay.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <neogfx/app/app.hpp>
+#include <neogfx/gfx/texture.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/graphics_operations_archive.hpp>
+
+namespace ng = neogfx;
+
+// Replays a recorded graphics operation archive against an offscreen render target and reports flush throughput.
+// Usage: gfxreplay <archive> [iterations]
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <archive> [iterations]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ng::app app(argc, argv, "neoGFX Graphics Operation Replay");
+
+    try
+    {
+        std::ifstream input{ argv[1], std::ios::binary };
+        if (!input)
+            throw std::runtime_error(std::string{ "cannot open " } + argv[1]);
+        uint32_t const iterations = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 100u;
+
+        ng::graphics_operation::queue_reader reader{ input };
+        auto const frames = reader.read_all();
+
+        auto& renderingEngine = ng::service<ng::i_rendering_engine>();
+        renderingEngine.reset_statistics();
+
+        uint64_t operations = 0u;
+        std::chrono::duration<double> elapsed{};
+        for (auto const& frame : frames)
+        {
+            ng::texture target{ frame.extents, 1.0, ng::texture_sampling::Normal };
+            auto context = target.as_render_target().create_graphics_context();
+            ng::scoped_render_target srt{ *context };
+            for (uint32_t iteration = 0u; iteration < iterations; ++iteration)
+            {
+                context->enqueue(ng::graphics_operation::set_logical_coordinate_system{ frame.logicalCoordinateSystem });
+                for (auto const& op : frame.operations)
+                    context->enqueue(op);
+                operations += context->queue().size();
+                auto const start = std::chrono::high_resolution_clock::now();
+                context->flush();
+                elapsed += std::chrono::high_resolution_clock::now() - start;
+            }
+        }
+
+        auto const& statistics = renderingEngine.statistics();
+        std::cout << "frames: " << frames.size() << ", iterations: " << iterations << std::endl;
+        std::cout << "operations: " << operations << " (" << (elapsed.count() > 0.0 ? operations / elapsed.count() : 0.0) << " ops/s)" << std::endl;
+        std::cout << "flush time: " << elapsed.count() * 1000.0 << " ms" << std::endl;
+        std::cout << "reordered operations: " << statistics.reorderedOperations << std::endl;
+        std::cout << "batches: " << statistics.batches << ", draw calls: " << statistics.drawCalls << ", vertices: " << statistics.vertices << std::endl;
+        std::cout << "fence stalls: " << statistics.fenceStalls << " (" << std::chrono::duration<double, std::milli>{ statistics.fenceStallTime }.count() << " ms)" << std::endl;
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception& e)
+    {
+        app.halt();
+        std::cerr << "gfxreplay: terminating with exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}